@@ -1,14 +1,21 @@
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+#include <thread>
+
 #include <neaacdec.h>
 
 #include <audacious/audtag.h>
+#include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/runtime.h>
 
+#include "../index-common/index-file.h"
+
 class AACDecoder : public InputPlugin
 {
 public:
@@ -27,6 +34,8 @@ public:
     bool is_our_file (const char * filename, VFSFile & file);
     bool read_tag (const char * filename, VFSFile & file, Tuple & tuple, Index<char> * image);
     bool play (const char * filename, VFSFile & file);
+
+    void cleanup ();
 };
 
 EXPORT AACDecoder aud_plugin_instance;
@@ -147,6 +156,203 @@ static int aac_probe (unsigned char * buf, int len)
     return len;
 }
 
+/*
+ * Seek index for ADTS streams.  The frame headers are scanned once (without
+ * decoding anything) to count the raw data blocks, each of which holds 1024
+ * samples at the sample rate given in the header.  This gives the exact
+ * length, and the offsets recorded every SEEK_INTERVAL frames allow seeking to
+ * an exact sample.  The index is saved in the user's config directory, keyed
+ * by the path, size and modification time of the file.  It is built in the
+ * background, either when the tags of the file are read or during playback.
+ */
+
+#define SEEK_INTERVAL 64
+#define BLOCK_SAMPLES 1024
+#define INDEX_MAGIC "AACIDX01"
+
+struct SeekPoint {
+    int64_t offset;  /* byte offset of the frame */
+    int64_t block;   /* number of blocks before the frame */
+};
+
+struct SeekIndex {
+    int samplerate = 0;
+    int64_t blocks = 0;
+    int64_t bytes = 0;
+    Index<SeekPoint> points;
+
+    int length () const
+        { return blocks * BLOCK_SAMPLES * 1000 / samplerate; }
+};
+
+/* Reads the stream in large chunks, since the frames are only a few hundred
+ * bytes long. */
+class ADTSReader
+{
+public:
+    ADTSReader (VFSFile & file) :
+        m_file (file) {}
+
+    /* returns a pointer to 10 bytes at <pos>, or nullptr at the end */
+    const unsigned char * peek (int64_t pos)
+    {
+        if (pos >= m_start && pos + 10 <= m_start + m_len)
+            return m_buf + (pos - m_start);
+
+        int keep = 0;
+
+        if (pos >= m_start && pos < m_start + m_len)
+        {
+            keep = m_start + m_len - pos;
+            memmove (m_buf, m_buf + (pos - m_start), keep);
+        }
+        else if (pos != m_start + m_len && m_file.fseek (pos, VFS_SEEK_SET) < 0)
+            return nullptr;
+
+        m_start = pos;
+        m_len = keep + aud::max (0, (int) m_file.fread (m_buf + keep, 1, sizeof m_buf - keep));
+
+        return (m_len >= 10) ? m_buf : nullptr;
+    }
+
+    /* parses the header at <pos>; returns the frame size or 0 */
+    int frame (int64_t pos, int * srate, int * blocks)
+    {
+        const unsigned char * head = peek (pos);
+        if (! head)
+            return 0;
+
+        int num;
+        int size = aac_parse_frame ((unsigned char *) head, srate, & num);
+        * blocks = (head[6] & 0x03) + 1;
+
+        return (size >= 8) ? size : 0;
+    }
+
+private:
+    VFSFile & m_file;
+    unsigned char m_buf[65536];
+    int64_t m_start = -1;  /* forces a seek before the first read */
+    int m_len = 0;
+};
+
+/* returns the offset of the audio data, after any ID3v2 tag */
+static int64_t skip_id3 (VFSFile & file)
+{
+    unsigned char head[10];
+
+    if (file.fseek (0, VFS_SEEK_SET) < 0 || file.fread (head, 1, 10) != 10 ||
+     strncmp ((char *) head, "ID3", 3))
+        return 0;
+
+    return 10 + (head[6] << 21) + (head[7] << 14) + (head[8] << 7) + head[9];
+}
+
+static bool scan_adts (VFSFile & file, SeekIndex & index,
+ const std::atomic<bool> * abort = nullptr)
+{
+    int64_t start = skip_id3 (file);
+
+    /* find the first frame */
+    unsigned char buf[8192];
+    if (file.fseek (start, VFS_SEEK_SET) < 0)
+        return false;
+
+    int len = file.fread (buf, 1, sizeof buf);
+    int size;
+    int offset = find_aac_header (buf, len, & size);
+    if (offset < 0)
+        return false;
+
+    ADTSReader reader (file);
+    int64_t pos = start + offset;
+    int64_t frames = 0;
+
+    while (! (abort && * abort))
+    {
+        int srate, blocks;
+        int frame_size = reader.frame (pos, & srate, & blocks);
+
+        /* stop at the end or at anything that isn't a frame (e.g. a tag) */
+        if (! frame_size || (index.samplerate && srate != index.samplerate))
+            break;
+
+        index.samplerate = srate;
+
+        if (! (frames % SEEK_INTERVAL))
+            index.points.append (SeekPoint {pos, index.blocks});
+
+        index.blocks += blocks;
+        index.bytes += frame_size;
+        frames ++;
+        pos += frame_size;
+    }
+
+    return ! (abort && * abort) && index.blocks > 0;
+}
+
+static bool build_index (const char * filename);
+
+static IndexFile aac_index ("aac-index", INDEX_MAGIC, build_index);
+
+/* After the header, the index holds:
+ *   sample rate, block count, byte count, point count, points */
+static bool load_index (const char * filename, SeekIndex & index)
+{
+    FILE * file = aac_index.open (filename);
+    if (! file)
+        return false;
+
+    int count;
+    bool ok = (fread (& index.samplerate, sizeof index.samplerate, 1, file) == 1 &&
+     fread (& index.blocks, sizeof index.blocks, 1, file) == 1 &&
+     fread (& index.bytes, sizeof index.bytes, 1, file) == 1 &&
+     fread (& count, sizeof count, 1, file) == 1 &&
+     index.samplerate > 0 && index.blocks > 0 && count > 0 && count <= index.blocks);
+
+    if (ok)
+    {
+        index.points.resize (count);
+        ok = (fread (index.points.begin (), sizeof (SeekPoint), count, file) == (size_t) count);
+    }
+
+    fclose (file);
+
+    if (! ok)
+        index = SeekIndex ();
+
+    return ok;
+}
+
+static bool save_index (const char * filename, const SeekIndex & index)
+{
+    StringBuf temp;
+    FILE * file = aac_index.create (filename, temp);
+    if (! file)
+        return false;
+
+    int count = index.points.len ();
+
+    bool ok = (fwrite (& index.samplerate, sizeof index.samplerate, 1, file) == 1 &&
+     fwrite (& index.blocks, sizeof index.blocks, 1, file) == 1 &&
+     fwrite (& index.bytes, sizeof index.bytes, 1, file) == 1 &&
+     fwrite (& count, sizeof count, 1, file) == 1 &&
+     fwrite (index.points.begin (), sizeof (SeekPoint), count, file) == (size_t) count);
+
+    return aac_index.commit (filename, file, temp, ok);
+}
+
+/* Runs in the background for files whose tags were read before they were
+ * indexed, so that reading the tags never has to scan the whole file. */
+static bool build_index (const char * filename)
+{
+    VFSFile file (filename, "r");
+    SeekIndex index;
+
+    return file && scan_adts (file, index, & aac_index.stopping ()) &&
+     save_index (filename, index);
+}
+
 /* Gets info (some approximated) from an AAC/ADTS file.  <length> is
  * milliseconds, <bitrate> is kilobits per second.  Any parameters that cannot
  * be read are set to -1. */
@@ -265,6 +471,17 @@ bool AACDecoder::read_tag (const char * filename, VFSFile & file, Tuple & tuple,
     // TODO: error handling
     calc_aac_info (file, &length, &bitrate, &samplerate, &channels);
 
+    /* the estimates are replaced by exact values once the file is indexed */
+    SeekIndex index;
+    if (load_index (filename, index))
+    {
+        length = index.length ();
+        if (length > 0)
+            bitrate = index.bytes * 8 / length;
+    }
+    else
+        aac_index.queue (filename);
+
     if (length > 0)
         tuple.set_int (Tuple::Length, length);
     if (bitrate > 0)
@@ -334,6 +551,75 @@ static void aac_seek (VFSFile & file, NeAACDecHandle dec, int time, int len,
     }
 }
 
+/* Seeks to the frame containing the requested time, starting one frame
+ * earlier so that the decoder has the overlap it needs.  Returns the number of
+ * samples (per channel, at the output rate) to discard before the requested
+ * time, or -1 on error. */
+static int aac_seek_indexed (VFSFile & file, NeAACDecHandle dec,
+ const SeekIndex & index, int time, unsigned char * buf, int size, int * buflen)
+{
+    int64_t sample = (int64_t) time * index.samplerate / 1000;
+    int64_t target = aud::min (sample / BLOCK_SAMPLES, index.blocks - 1);
+    int64_t prime = aud::max (target - 1, (int64_t) 0);
+
+    /* last seek point at or before the frame to start from */
+    int lo = 0, hi = index.points.len () - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (index.points[mid].block <= prime)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    int64_t pos = index.points[lo].offset;
+    int64_t block = index.points[lo].block;
+
+    /* walk the frame headers up to the frame containing <prime> */
+    ADTSReader reader (file);
+
+    while (true)
+    {
+        int srate, blocks;
+        int frame_size = reader.frame (pos, & srate, & blocks);
+        if (! frame_size)
+            return -1;
+
+        if (block + blocks > prime)
+            break;
+
+        pos += frame_size;
+        block += blocks;
+    }
+
+    if (file.fseek (pos, VFS_SEEK_SET) < 0)
+        return -1;
+
+    * buflen = file.fread (buf, 1, size);
+
+    unsigned char chan;
+    unsigned long rate;
+    int used = NeAACDecInit (dec, buf, * buflen, & rate, & chan);
+
+    if (used < 0)
+    {
+        AUDERR ("Failed to initialize AAC decoder.\n");
+        * buflen = 0;
+        return -1;
+    }
+
+    if (used)
+    {
+        * buflen -= used;
+        memmove (buf, buf + used, * buflen);
+        * buflen += file.fread (buf + * buflen, 1, size - * buflen);
+    }
+
+    /* the output rate is higher than the header says if SBR is used */
+    return (sample - block * BLOCK_SAMPLES) * (int64_t) rate / index.samplerate;
+}
+
 bool AACDecoder::play (const char * filename, VFSFile & file)
 {
     NeAACDecHandle decoder = 0;
@@ -344,6 +630,14 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
     Tuple tuple = get_playback_tuple ();
     int bitrate = 1000 * aud::max (0, tuple.get_int (Tuple::Bitrate));
 
+    /* the seek index is built in the background if it is not saved yet;
+     * until it is ready, seeking is approximate */
+    SeekIndex index, scanned;
+    bool have_index = load_index (filename, index);
+    std::atomic<bool> scan_abort (false), scan_done (false);
+    std::thread scan_thread;
+    int discard = 0;
+
     if ((decoder = NeAACDecOpen ()) == nullptr)
     {
         AUDERR ("Open Decoder Error\n");
@@ -419,6 +713,18 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
 
     open_audio (FMT_FLOAT, samplerate, channels);
 
+    int64_t size, mtime;
+    if (! have_index && IndexFile::stamp (filename, size, mtime))
+    {
+        String path (filename);
+        scan_thread = std::thread ([path, & scanned, & scan_abort, & scan_done] () {
+            VFSFile scan_file (path, "r");
+            if (scan_file && scan_adts (scan_file, scanned, & scan_abort))
+                save_index (path, scanned);
+            scan_done = true;
+        });
+    }
+
     /* == MAIN LOOP == */
 
     while (! check_stop ())
@@ -429,8 +735,17 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
 
         if (seek_value >= 0)
         {
+            if (! have_index && scan_done && scanned.blocks > 0)
+            {
+                index = std::move (scanned);
+                have_index = true;
+            }
+
             int length = tuple.get_int (Tuple::Length);
-            if (length > 0)
+            if (have_index)
+                discard = channels * aud::max (0, aac_seek_indexed (file,
+                 decoder, index, seek_value, buf, sizeof buf, & buflen));
+            else if (length > 0)
                 aac_seek (file, decoder, seek_value, length, buf, sizeof buf, & buflen);
         }
 
@@ -473,10 +788,26 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
 
         /* == PLAY THE SOUND == */
 
-        if (audio && info.samples)
-            write_audio (audio, sizeof (float) * info.samples);
+        int samples = info.samples;
+
+        /* == DROP SAMPLES BEFORE THE SEEK POSITION == */
+
+        if (audio && discard)
+        {
+            int skip = aud::min (discard, samples);
+            audio = (float *) audio + skip;
+            samples -= skip;
+            discard -= skip;
+        }
+
+        if (audio && samples)
+            write_audio (audio, sizeof (float) * samples);
     }
 
+    scan_abort = true;
+    if (scan_thread.joinable ())
+        scan_thread.join ();
+
     NeAACDecClose (decoder);
     return true;
 
@@ -484,3 +815,8 @@ ERR_CLOSE_DECODER:
     NeAACDecClose (decoder);
     return false;
 }
+
+void AACDecoder::cleanup ()
+{
+    aac_index.cleanup ();
+}
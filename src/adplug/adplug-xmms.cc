@@ -18,7 +18,9 @@
 */
 
 #include <algorithm>
+#include <mutex>
 #include <sstream>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -39,6 +41,7 @@
 
 #include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
+#include <libaudcore/multihash.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/preferences.h>
@@ -107,6 +110,9 @@ const char * const AdPlugXMMS::exts[] = {
 // Default AdPlug user's configuration subdirectory
 #define ADPLUG_CONFDIR		".adplug"
 
+// File name of the song length cache, in Audacious' configuration directory
+#define LENGTH_CACHE_FILE	"adplug-lengths"
+
 /***** Global variables *****/
 
 // Player variables
@@ -142,6 +148,114 @@ dbg_printf (const char *fmt, ...)
 
 #endif
 
+/***** Song length cache *****/
+
+// Computing the length of a song means simulating all of it, which adds up
+// when scanning a large collection.  The lengths are kept in a cache, keyed
+// by a hash of the file contents (so that renamed or copied files are still
+// found) and the subsong.  The cache file is a list of lines "key length",
+// which is only ever appended to.
+
+static std::mutex length_mutex;
+static SimpleHash<String, int> length_cache;
+static bool length_cache_loaded = false;
+
+static StringBuf length_cache_path ()
+{
+  return str_concat ({aud_get_path (AudPath::UserDir), "/" LENGTH_CACHE_FILE});
+}
+
+// the player has already read from the file, so it is hashed from the start
+static String length_key (VFSFile & fd, unsigned subsong)
+{
+  if (fd.fseek (0, VFS_SEEK_SET) < 0)
+    return String ();
+
+  Index<char> data = fd.read_all ();
+  if (! data.len ())
+    return String ();
+
+  // 64-bit FNV-1a
+  uint64_t hash = 0xcbf29ce484222325;
+  for (char c : data)
+  {
+    hash ^= (unsigned char) c;
+    hash *= 0x100000001b3;
+  }
+
+  return String (str_printf ("%016llx-%d-%u", (unsigned long long) hash,
+   data.len (), subsong));
+}
+
+// called with length_mutex held
+static void load_length_cache ()
+{
+  length_cache_loaded = true;
+
+  FILE * f = fopen (length_cache_path (), "r");
+  if (! f)
+    return;
+
+  char key[64];
+  int length;
+
+  while (fscanf (f, "%63s %d", key, & length) == 2)
+  {
+    if (length >= 0)
+      length_cache.add (String (key), int (length));
+  }
+
+  fclose (f);
+}
+
+static bool lookup_length (const String & key, int & length)
+{
+  std::lock_guard<std::mutex> lock (length_mutex);
+
+  if (! length_cache_loaded)
+    load_length_cache ();
+
+  int * cached = length_cache.lookup (key);
+  if (! cached)
+    return false;
+
+  length = * cached;
+  return true;
+}
+
+static void store_length (const String & key, int length)
+{
+  std::lock_guard<std::mutex> lock (length_mutex);
+
+  if (length_cache.lookup (key))
+    return;
+
+  length_cache.add (key, int (length));
+
+  FILE * f = fopen (length_cache_path (), "a");
+  if (! f)
+    return;
+
+  fprintf (f, "%s %d\n", (const char *) key, length);
+  fclose (f);
+}
+
+static int get_songlength (CPlayer * p, VFSFile & fd, unsigned subsong)
+{
+  String key = length_key (fd, subsong);
+  int length;
+
+  if (key && lookup_length (key, length))
+    return length;
+
+  length = p->songlength (subsong);
+
+  if (key)
+    store_length (key, length);
+
+  return length;
+}
+
 /***** Main player (!! threaded !!) *****/
 
 bool AdPlugXMMS::read_tag (const char * filename, VFSFile & file, Tuple & tuple,
@@ -165,7 +279,7 @@ bool AdPlugXMMS::read_tag (const char * filename, VFSFile & file, Tuple & tuple,
 
   tuple.set_str (Tuple::Codec, p->gettype().c_str());
   tuple.set_str (Tuple::Quality, _("sequenced"));
-  tuple.set_int (Tuple::Length, p->songlength (plr.subsong));
+  tuple.set_int (Tuple::Length, get_songlength (p, file, plr.subsong));
   tuple.set_int (Tuple::Channels, 2);
   delete p;
 
@@ -244,7 +358,9 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
   dbg_printf ("rewind, ");
   plr.p->rewind (plr.subsong);
 
-  int time = 0;
+  // kept as a fraction, since the refresh rate rarely divides 1000 and the
+  // rounding would otherwise add up over a long seek
+  double time = 0;
 
   // main playback loop
   dbg_printf ("loop.\n");
@@ -262,12 +378,13 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
       if (seek < time)
       {
         plr.p->rewind (plr.subsong);
+        playing = true;
         time = 0;
       }
 
       // seek to requested position
-      while (time < seek && plr.p->update ())
-        time += (int) (1000 / plr.p->getrefresh ());
+      while (time < seek && (playing = plr.p->update ()))
+        time += 1000 / plr.p->getrefresh ();
     }
 
     // fill sound buffer
@@ -280,7 +397,7 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
         toadd += freq;
         playing = plr.p->update ();
         if (playing)
-          time += (int) (1000 / plr.p->getrefresh ());
+          time += 1000 / plr.p->getrefresh ();
       }
       i = std::min (towrite, (long) (toadd / plr.p->getrefresh () + 4) & ~3);
       opl->update ((short *) sndbufpos, i);
@@ -393,4 +510,7 @@ void AdPlugXMMS::cleanup ()
   dbg_printf ("db, ");
   plr.db.clear ();
   plr.filename = String ();
+
+  length_cache.clear ();
+  length_cache_loaded = false;
 }
@@ -28,6 +28,12 @@
 
 #include <gtk/gtk.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
@@ -75,6 +81,7 @@ private:
     void draw_to_cairo (cairo_t * cr);
     void draw ();
 
+    void free_buffers ();
     void blur ();
     void draw_vert_line (int x, int y1, int y2);
 
@@ -87,7 +94,19 @@ private:
 
     GtkWidget * area = nullptr;
     int width = 0, height = 0, stride = 0, image_size = 0;
+
+    /* The image is blurred from one buffer into the other, and the two are
+     * swapped on each frame.  Each buffer has a cairo surface that lives as
+     * long as the buffer itself. */
+    uint32_t * buffers[2] = {nullptr, nullptr};
+    cairo_surface_t * surfaces[2] = {nullptr, nullptr};
+    int current = 0;
+
     uint32_t * image = nullptr, * corner = nullptr;
+
+    /* for the frame time statistics in the debug output */
+    int64_t render_time = 0;
+    int render_count = 0;
 };
 
 EXPORT BlurScope aud_plugin_instance;
@@ -104,28 +123,55 @@ void BlurScope::cleanup ()
 {
     aud_set_int ("BlurScope", "color", bscope_color);
 
-    g_free (image);
-    image = nullptr;
+    free_buffers ();
+}
+
+void BlurScope::free_buffers ()
+{
+    for (int i = 0; i < 2; i ++)
+    {
+        if (surfaces[i])
+            cairo_surface_destroy (surfaces[i]);
+
+        g_free (buffers[i]);
+        surfaces[i] = nullptr;
+        buffers[i] = nullptr;
+    }
+
+    image = corner = nullptr;
 }
 
 void BlurScope::resize (int w, int h)
 {
+    free_buffers ();
+
     width = w;
     height = h;
     stride = width + 2;
     image_size = (stride << 2) * (height + 2);
-    image = (uint32_t *) g_realloc (image, image_size);
-    memset (image, 0, image_size);
+
+    /* the one-pixel border around the image stays black, so that the blur
+     * needs no special cases at the edges */
+    for (int i = 0; i < 2; i ++)
+    {
+        buffers[i] = (uint32_t *) g_malloc0 (image_size);
+        surfaces[i] = cairo_image_surface_create_for_data
+         ((unsigned char *) (buffers[i] + stride + 1), CAIRO_FORMAT_RGB24,
+         width, height, stride << 2);
+    }
+
+    current = 0;
+    image = buffers[0];
     corner = image + stride + 1;
 }
 
 void BlurScope::draw_to_cairo (cairo_t * cr)
 {
-    cairo_surface_t * surf = cairo_image_surface_create_for_data
-     ((unsigned char *) image, CAIRO_FORMAT_RGB24, width, height, stride << 2);
-    cairo_set_source_surface (cr, surf, 0, 0);
+    if (! image)
+        return;
+
+    cairo_set_source_surface (cr, surfaces[current], 0, 0);
     cairo_paint (cr);
-    cairo_surface_destroy (surf);
 }
 
 void BlurScope::draw ()
@@ -178,27 +224,81 @@ void * BlurScope::get_gtk_widget ()
 
 void BlurScope::clear ()
 {
-    memset (image, 0, image_size);
+    for (uint32_t * buf : buffers)
+    {
+        if (buf)
+            memset (buf, 0, image_size);
+    }
+
+    for (cairo_surface_t * surf : surfaces)
+    {
+        if (surf)
+            cairo_surface_mark_dirty (surf);
+    }
+
     draw ();
 }
 
-void BlurScope::blur ()
+/* We do a quick and dirty average of four color values, first masking off the
+ * lowest two bits.  Over a large area, this masking has the net effect of
+ * subtracting 1.5 from each value, which by a happy chance is just right for
+ * a gradual fade effect.  The sum cannot carry from one color into the next,
+ * so all three are averaged at once in a 32-bit integer.
+ *
+ * Each pixel of dest is computed from the pixels around it in src, which is
+ * the previous frame, so the pixels of a row are independent of each other
+ * and can be done several at a time. */
+static void blur_row (uint32_t * dest, const uint32_t * src, int stride, int width)
 {
-    for (int y = 0; y < height; y ++)
+    const uint32_t * above = src - stride;
+    const uint32_t * below = src + stride;
+    int x = 0;
+
+#if defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi32 (0xFCFCFC);
+
+    for (; x + 4 <= width; x += 4)
     {
-        uint32_t * p = corner + stride * y;
-        uint32_t * end = p + width;
-        uint32_t * plast = p - stride;
-        uint32_t * pnext = p + stride;
-
-        /* We do a quick and dirty average of four color values, first masking
-         * off the lowest two bits.  Over a large area, this masking has the net
-         * effect of subtracting 1.5 from each value, which by a happy chance
-         * is just right for a gradual fade effect. */
-        for (; p < end; p ++)
-            * p = ((* plast ++ & 0xFCFCFC) + (p[-1] & 0xFCFCFC) + (p[1] &
-             0xFCFCFC) + (* pnext ++ & 0xFCFCFC)) >> 2;
+        __m128i sum = _mm_add_epi32
+         (_mm_add_epi32 (_mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (above + x)), mask),
+         _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (src + x - 1)), mask)),
+         _mm_add_epi32 (_mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (src + x + 1)), mask),
+         _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (below + x)), mask)));
+
+        _mm_storeu_si128 ((__m128i *) (dest + x), _mm_srli_epi32 (sum, 2));
     }
+#elif defined(__ARM_NEON)
+    const uint32x4_t mask = vdupq_n_u32 (0xFCFCFC);
+
+    for (; x + 4 <= width; x += 4)
+    {
+        uint32x4_t sum = vaddq_u32
+         (vaddq_u32 (vandq_u32 (vld1q_u32 (above + x), mask),
+         vandq_u32 (vld1q_u32 (src + x - 1), mask)),
+         vaddq_u32 (vandq_u32 (vld1q_u32 (src + x + 1), mask),
+         vandq_u32 (vld1q_u32 (below + x), mask)));
+
+        vst1q_u32 (dest + x, vshrq_n_u32 (sum, 2));
+    }
+#endif
+
+    for (; x < width; x ++)
+        dest[x] = ((above[x] & 0xFCFCFC) + (src[x - 1] & 0xFCFCFC) +
+         (src[x + 1] & 0xFCFCFC) + (below[x] & 0xFCFCFC)) >> 2;
+}
+
+void BlurScope::blur ()
+{
+    const uint32_t * src = corner;
+
+    current ^= 1;
+    image = buffers[current];
+    corner = image + stride + 1;
+
+    cairo_surface_flush (surfaces[current]);
+
+    for (int y = 0; y < height; y ++)
+        blur_row (corner + stride * y, src + stride * y, stride, width);
 }
 
 void BlurScope::draw_vert_line (int x, int y1, int y2)
@@ -217,6 +317,11 @@ void BlurScope::draw_vert_line (int x, int y1, int y2)
 
 void BlurScope::render_mono_pcm (const float * pcm)
 {
+    if (! image)
+        return;
+
+    int64_t start = g_get_monotonic_time ();
+
     blur ();
 
     int prev_y = (0.5 + pcm[0]) * height;
@@ -230,6 +335,16 @@ void BlurScope::render_mono_pcm (const float * pcm)
         prev_y = y;
     }
 
+    cairo_surface_mark_dirty (surfaces[current]);
+
+    render_time += g_get_monotonic_time () - start;
+    if (++ render_count == 256)
+    {
+        AUDDBG ("%dx%d: %d us per frame\n", width, height, (int) (render_time / render_count));
+        render_time = 0;
+        render_count = 0;
+    }
+
     draw ();
 }
 
@@ -25,62 +25,104 @@
 
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+#include <libaudcore/runtime.h>
 #include <libaudgui/gtk-compat.h>
 #include <libaudgui/libaudgui-gtk.h>
 
+#include "../spectrum-common/spectrum.h"
+
+#define CFG_ID "cairo-spectrum"
 #define MAX_BANDS   (256)
+#define DB_RANGE 40
 #define VIS_DELAY 2 /* delay before falloff in frames */
-#define VIS_FALLOFF 2 /* falloff in pixels per frame */
+#define VIS_FALLOFF 0.05f /* falloff in bar heights per frame */
 
 class CairoSpectrum : public VisPlugin
 {
 public:
+    static const char * const defaults[];
+    static const ComboItem interpolations[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
     static constexpr PluginInfo info = {
         N_("Spectrum Analyzer"),
         PACKAGE,
         nullptr, // about
-        nullptr, // prefs
+        & prefs,
         PluginGLibOnly
     };
 
-    constexpr CairoSpectrum () : VisPlugin (info, Visualizer::Freq) {}
+    constexpr CairoSpectrum () : VisPlugin (info, Visualizer::MonoPCM) {}
 
+    bool init ();
     void * get_gtk_widget ();
 
     void clear ();
-    void render_freq (const float * freq);
+    void render_mono_pcm (const float * pcm);
 };
 
 EXPORT CairoSpectrum aud_plugin_instance;
 
+const char * const CairoSpectrum::defaults[] = {
+    "interpolation", "1",
+    "constant_q", "FALSE",
+    nullptr
+};
+
+/* The core sends 512-sample blocks, so a larger FFT only zero-pads them,
+ * which interpolates the spectrum without adding resolution. */
+const ComboItem CairoSpectrum::interpolations[] = {
+    ComboItem (N_("None"), 1),
+    ComboItem ("2x", 2),
+    ComboItem ("4x", 4),
+    ComboItem ("8x", 8),
+    ComboItem ("16x", 16)
+};
+
+static void read_config ();
+
+const PreferencesWidget CairoSpectrum::widgets[] = {
+    WidgetCombo (N_("Interpolation:"),
+        WidgetInt (CFG_ID, "interpolation", read_config),
+        {{interpolations}}),
+    WidgetCheck (N_("Constant-Q bands"),
+        WidgetBool (CFG_ID, "constant_q", read_config))
+};
+
+const PluginPreferences CairoSpectrum::prefs = {{widgets}};
+
 static GtkWidget * spect_widget = nullptr;
-static float xscale[MAX_BANDS + 1];
+static SpectrumAnalyzer analyzer;
+static int fft_size;
+static SpectrumAnalyzer::Scale scale;
 static int width, height, bands;
-static int bars[MAX_BANDS + 1];
-static int delay[MAX_BANDS + 1];
+static float bars[MAX_BANDS];
 
-void CairoSpectrum::render_freq (const float * freq)
+/* the settings are kept here rather than read for every frame */
+static void read_config ()
 {
-    if (! bands)
-        return;
-
-    for (int i = 0; i < bands; i ++)
-    {
-        /* 40 dB range */
-        int x = 40 + compute_freq_band (freq, xscale, i, bands);
-        x = aud::clamp (x, 0, 40);
+    fft_size = SpectrumAnalyzer::block_size * aud_get_int (CFG_ID, "interpolation");
+    scale = aud_get_bool (CFG_ID, "constant_q") ? SpectrumAnalyzer::ConstantQ :
+     SpectrumAnalyzer::LogScale;
+}
 
-        bars[i] -= aud::max (0, VIS_FALLOFF - delay[i]);
+bool CairoSpectrum::init ()
+{
+    aud_config_set_defaults (CFG_ID, defaults);
+    read_config ();
+    analyzer.set_smoothing (VIS_DELAY, VIS_FALLOFF);
+    return true;
+}
 
-        if (delay[i])
-            delay[i] --;
+void CairoSpectrum::render_mono_pcm (const float * pcm)
+{
+    if (! bands)
+        return;
 
-        if (x > bars[i])
-        {
-            bars[i] = x;
-            delay[i] = VIS_DELAY;
-        }
-    }
+    analyzer.configure (bands, fft_size, scale, DB_RANGE);
+    analyzer.analyze (pcm, bars);
 
     if (spect_widget)
         gtk_widget_queue_draw (spect_widget);
@@ -89,7 +131,7 @@ void CairoSpectrum::render_freq (const float * freq)
 void CairoSpectrum::clear ()
 {
     memset (bars, 0, sizeof bars);
-    memset (delay, 0, sizeof delay);
+    analyzer.clear ();
 
     if (spect_widget)
         gtk_widget_queue_draw (spect_widget);
@@ -117,8 +159,8 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 
         audgui_vis_bar_color (c, i, bands, r, g, b);
         cairo_set_source_rgb (cr, r, g, b);
-        cairo_rectangle (cr, x + 1, height - (bars[i] * height / 40),
-         (width / bands) - 1, (bars[i] * height / 40));
+        cairo_rectangle (cr, x + 1, height - (int) (bars[i] * height),
+         (width / bands) - 1, (int) (bars[i] * height));
         cairo_fill (cr);
     }
 }
@@ -131,7 +173,6 @@ static gboolean configure_event (GtkWidget * widget, GdkEventConfigure * event)
 
     bands = width / 10;
     bands = aud::clamp (bands, 12, MAX_BANDS);
-    Visualizer::compute_log_xscale (xscale, bands);
 
     return true;
 }
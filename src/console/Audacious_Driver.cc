@@ -13,6 +13,7 @@
 #include <libaudcore/audstrings.h>
 #include <libaudcore/runtime.h>
 
+#include "../length-common/lengths.h"
 #include "configure.h"
 #include "plugin.h"
 #include "Music_Emu.h"
@@ -21,6 +22,10 @@
 static const int fade_threshold = 10 * 1000;
 static const int fade_length    = 8 * 1000;
 
+// length detection runs the emulator at a low rate and only looks at levels
+static const int detect_rate      = 22050;
+static const int detect_fade      = 1000; // fade over the silence after it
+
 static bool log_err(blargg_err_t err)
 {
     if (err)
@@ -158,6 +163,83 @@ static int get_track_length(const track_info_t &info)
     return length;
 }
 
+static bool length_known(const track_info_t &info, gme_type_t type)
+{
+    if (type == gme_spc_type && audcfg.ignore_spc_length)
+        return false;
+
+    return info.length > 0 || info.intro_length + info.loop_length > 0;
+}
+
+static int detect_track_length(const char *filename);
+
+LengthCache console_lengths(detect_track_length);
+
+/* Plays the track through as fast as possible, up to the default song length,
+ * and returns the time of the last sound before a run of silence, or -1 if
+ * the track does not fall silent.  Loops are not recognized as such; a track
+ * that loops forever simply runs into the limit.  Each emulator is a separate
+ * object, so this runs alongside playback. */
+static int detect_track_length(const char *filename)
+{
+    const char *sub;
+    uri_parse(filename, nullptr, nullptr, &sub, nullptr);
+
+    VFSFile file(str_copy(filename, sub - filename), "r");
+    if (!file)
+        return -1;
+
+    ConsoleFileHandler fh(filename, file);
+    if (fh.load(detect_rate))
+        return -1;
+
+    Music_Emu *emu = fh.m_emu;
+    if (log_err(emu->start_track(fh.m_track < 0 ? 0 : fh.m_track)))
+        return -1;
+
+    // we look for the silence ourselves
+    emu->ignore_silence(true);
+
+    int const buf_size = 2048;
+    Music_Emu::sample_t buf[buf_size];
+
+    int const limit = audcfg.loop_length * 1000;
+    SilenceDetector silence(detect_rate);
+
+    while (silence.position() < limit && !emu->track_ended())
+    {
+        if (console_lengths.stopping())
+            return LengthCache::Retry;
+
+        if (log_err(emu->play(buf_size, buf)))
+            return -1;
+
+        if (silence.process(buf, buf_size))
+            return silence.length();
+    }
+
+    // the emulator may stop by itself (e.g. end of a VGM log)
+    if (emu->track_ended())
+        return silence.length();
+
+    return -1;
+}
+
+// returns the detected length, or -1 if it is not known (yet)
+static int find_track_length(const char *filename, VFSFile &file, int track)
+{
+    String key = LengthCache::make_key(file, track);
+    if (!key)
+        return -1;
+
+    int length;
+    if (console_lengths.lookup(key, length))
+        return length;
+
+    console_lengths.queue(filename, key);
+    return -1;
+}
+
 bool ConsolePlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image)
 {
     ConsoleFileHandler fh(filename, file);
@@ -191,7 +273,16 @@ bool ConsolePlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple,
     else
         tuple.set_subtunes(info.track_count, nullptr);
 
-    tuple.set_int (Tuple::Length, get_track_length (info));
+    int length = -1;
+    if (audcfg.detect_length && !length_known(info, fh.m_type))
+        length = find_track_length(filename, file, fh.m_track < 0 ? 0 : fh.m_track);
+
+    if (length > 0)
+        length += detect_fade;
+    else
+        length = get_track_length(info);
+
+    tuple.set_int (Tuple::Length, length);
     tuple.set_int (Tuple::Channels, 2);
 
     return true;
@@ -199,7 +290,7 @@ bool ConsolePlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple,
 
 bool ConsolePlugin::play(const char *filename, VFSFile &file)
 {
-    int length, sample_rate;
+    int length, fade, sample_rate;
     track_info_t info;
 
     // identify file
@@ -244,12 +335,29 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
 
     // get info
     length = -1;
+    fade = fade_length;
     if (!log_err(fh.m_emu->track_info(&info, fh.m_track)))
     {
         if (fh.m_type == gme_spc_type && audcfg.ignore_spc_length)
             info.length = -1;
 
         length = get_track_length(info);
+
+        // use a length found earlier, fading out only the silence after it
+        if (audcfg.detect_length && !length_known(info, fh.m_type))
+        {
+            int detected = -1;
+            String key = LengthCache::make_key(file, fh.m_track);
+            if (key)
+                console_lengths.lookup(key, detected);
+
+            if (detected > 0)
+            {
+                length = detected;
+                fade = detect_fade;
+            }
+        }
+
         set_stream_bitrate(fh.m_emu->voice_count() * 1000);
     }
 
@@ -264,9 +372,9 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
     // set fade time
     if (length <= 0)
         length = audcfg.loop_length * 1000;
-    if (length >= fade_threshold + fade_length)
+    if (fade == fade_length && length >= fade_threshold + fade_length)
         length -= fade_length / 2;
-    fh.m_emu->set_fade(length, fade_length);
+    fh.m_emu->set_fade(length, fade);
 
     while (!check_stop())
     {
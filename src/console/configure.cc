@@ -8,6 +8,7 @@
  * Preferences GUI by Giacomo Lozito
  */
 
+#include "../length-common/lengths.h"
 #include "configure.h"
 #include "plugin.h"
 
@@ -26,6 +27,7 @@ const char * const ConsolePlugin::defaults[] = {
  "ignore_spc_length", "FALSE",
  "echo", "0",
  "inc_spc_reverb", "FALSE",
+ "detect_length", "FALSE",
  nullptr};
 
 bool ConsolePlugin::init ()
@@ -40,6 +42,7 @@ bool ConsolePlugin::init ()
     audcfg.ignore_spc_length = aud_get_bool (CON_CFGID, "ignore_spc_length");
     audcfg.echo = aud_get_int (CON_CFGID, "echo");
     audcfg.inc_spc_reverb = aud_get_bool (CON_CFGID, "inc_spc_reverb");
+    audcfg.detect_length = aud_get_bool (CON_CFGID, "detect_length");
 
     return true;
 }
@@ -54,4 +57,7 @@ void ConsolePlugin::cleanup ()
     aud_set_bool (CON_CFGID, "ignore_spc_length", audcfg.ignore_spc_length);
     aud_set_int (CON_CFGID, "echo", audcfg.echo);
     aud_set_bool (CON_CFGID, "inc_spc_reverb", audcfg.inc_spc_reverb);
+    aud_set_bool (CON_CFGID, "detect_length", audcfg.detect_length);
+
+    console_lengths.cleanup ();
 }
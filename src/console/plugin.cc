@@ -39,6 +39,8 @@ const PreferencesWidget ConsolePlugin::widgets[] = {
     WidgetSpin (N_("Default song length:"),
         WidgetInt (audcfg.loop_length),
         {1, 7200, 1, N_("seconds")}),
+    WidgetCheck (N_("Detect length of songs without timing information"),
+        WidgetBool (audcfg.detect_length)),
     WidgetLabel (N_("<b>Resampling</b>")),
     WidgetCheck (N_("Enable audio resampling"),
         WidgetBool (audcfg.resample)),
@@ -42,4 +42,7 @@ public:
     bool play (const char * filename, VFSFile & file);
 };
 
+class LengthCache;
+extern LengthCache console_lengths;
+
 #endif // CONSOLE_PLUGIN_H
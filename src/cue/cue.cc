@@ -17,16 +17,9 @@
  * the use of this software.
  */
 
+#include <limits.h>
+#include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
-
-#ifdef HAVE_LIBCUE2
-#include <libcue.h>
-#else
-extern "C" {
-#include <libcue/libcue.h>
-}
-#endif
 
 #include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
@@ -57,31 +50,237 @@ static bool is_year (const char * s)
            is_digit (s[2]) && is_digit (s[3]) && ! s[4];
 }
 
+/* The cue sheet is tokenized in place; only the values that are used are
+ * copied out.  Nothing is shared between calls, so any number of sheets can
+ * be parsed at once. */
+
+struct CueTrack {
+    String filename;
+    int start = -1;    /* INDEX 01, in frames (1/75 s) */
+    int index0 = -1;   /* INDEX 00 */
+
+    String performer, title, genre;
+    String gain, peak;
+};
+
+struct CueSheet {
+    String performer, title, genre, composer, date;
+    String album_gain, album_peak;
+    Index<CueTrack> tracks;
+};
+
+struct CueToken {
+    const char * str;
+    int len;
+
+    bool is (const char * keyword) const
+        { return len == (int) strlen (keyword) && ! strcmp_nocase (str, keyword, len); }
+    String to_string () const
+        { return String (str_to_utf8 (str, len)); }
+};
+
+/* Splits a line into whitespace-separated words; a quoted string is one
+ * word, with the quotes removed.  Returns the number of words found. */
+static int cue_tokenize (const char * line, const char * end, CueToken * tokens, int max)
+{
+    int n = 0;
+
+    while (n < max)
+    {
+        while (line < end && (* line == ' ' || * line == '\t'))
+            line ++;
+
+        if (line == end)
+            break;
+
+        const char * word_end;
+
+        if (* line == '"')
+        {
+            line ++;
+            word_end = (const char *) memchr (line, '"', end - line);
+            if (! word_end)
+                word_end = end;
+
+            tokens[n ++] = {line, (int) (word_end - line)};
+            line = (word_end < end) ? word_end + 1 : end;
+        }
+        else
+        {
+            word_end = line;
+            while (word_end < end && * word_end != ' ' && * word_end != '\t')
+                word_end ++;
+
+            tokens[n ++] = {line, (int) (word_end - line)};
+            line = word_end;
+        }
+    }
+
+    return n;
+}
+
+/* mm:ss:ff, where a frame is 1/75 second; minutes are limited so that the
+ * time fits in an int even in milliseconds, which is how it is stored */
+static int cue_parse_time (const CueToken & token)
+{
+    static const int limit[3] = {(INT_MAX / 1000 - 60) / 60, 59, 74};
+
+    int field[3] = {0, 0, 0};
+    int n = 0;
+
+    for (int i = 0; i < token.len; i ++)
+    {
+        char c = token.str[i];
+
+        if (c >= '0' && c <= '9')
+        {
+            field[n] = field[n] * 10 + (c - '0');
+
+            if (field[n] > limit[n])
+                return -1;
+        }
+        else if (c == ':' && n < 2)
+            n ++;
+        else
+            return -1;
+    }
+
+    if (n != 2)
+        return -1;
+
+    return (field[0] * 60 + field[1]) * 75 + field[2];
+}
+
+static void cue_parse_rem (const CueToken * tokens, int n_tokens, CueSheet & sheet, CueTrack * track)
+{
+    if (n_tokens < 3)
+        return;
+
+    const CueToken & key = tokens[1];
+    String value = tokens[2].to_string ();
+
+    if (key.is ("GENRE"))
+        (track ? track->genre : sheet.genre) = value;
+    else if (key.is ("DATE"))
+        sheet.date = value;
+    else if (key.is ("REPLAYGAIN_ALBUM_GAIN"))
+        sheet.album_gain = value;
+    else if (key.is ("REPLAYGAIN_ALBUM_PEAK"))
+        sheet.album_peak = value;
+    else if (key.is ("REPLAYGAIN_TRACK_GAIN") && track)
+        track->gain = value;
+    else if (key.is ("REPLAYGAIN_TRACK_PEAK") && track)
+        track->peak = value;
+}
+
+static bool cue_parse (const char * data, int len, CueSheet & sheet)
+{
+    const char * end = data + len;
+
+    /* skip UTF-8 byte order mark */
+    if (len >= 3 && ! memcmp (data, "\xef\xbb\xbf", 3))
+        data += 3;
+
+    String filename;
+    CueTrack * track = nullptr;
+
+    while (data < end)
+    {
+        const char * line_end = (const char *) memchr (data, '\n', end - data);
+        if (! line_end)
+            line_end = end;
+
+        const char * next = (line_end < end) ? line_end + 1 : end;
+
+        if (line_end > data && line_end[-1] == '\r')
+            line_end --;
+
+        CueToken tokens[4];
+        int n_tokens = cue_tokenize (data, line_end, tokens, aud::n_elems (tokens));
+        data = next;
+
+        if (! n_tokens)
+            continue;
+
+        const CueToken & cmd = tokens[0];
+
+        if (cmd.is ("REM"))
+            cue_parse_rem (tokens, n_tokens, sheet, track);
+        else if (n_tokens < 2)
+            continue;
+        else if (cmd.is ("FILE"))
+            filename = tokens[1].to_string ();
+        else if (cmd.is ("TRACK"))
+        {
+            if (! filename)
+            {
+                AUDWARN ("TRACK before FILE in cue sheet\n");
+                return false;
+            }
+
+            track = & sheet.tracks.append ();
+            track->filename = filename;
+        }
+        else if (cmd.is ("INDEX"))
+        {
+            if (! track || n_tokens < 3)
+                continue;
+
+            int number = atoi (String (str_copy (tokens[1].str, tokens[1].len)));
+            int time = cue_parse_time (tokens[2]);
+
+            if (time < 0)
+            {
+                AUDWARN ("Invalid INDEX time in cue sheet\n");
+                continue;
+            }
+
+            if (number == 0)
+                track->index0 = time;
+            else if (number == 1)
+            {
+                track->start = time;
+
+                /* the track may begin in a different file than its pregap */
+                track->filename = filename;
+            }
+        }
+        else if (cmd.is ("PERFORMER"))
+            (track ? track->performer : sheet.performer) = tokens[1].to_string ();
+        else if (cmd.is ("TITLE"))
+            (track ? track->title : sheet.title) = tokens[1].to_string ();
+        else if (cmd.is ("SONGWRITER") || cmd.is ("COMPOSER"))
+        {
+            if (! track)
+                sheet.composer = tokens[1].to_string ();
+        }
+
+        /* PREGAP and POSTGAP are silence that is not part of the file, so
+         * they do not affect where the tracks begin; CATALOG, ISRC, FLAGS
+         * and CDTEXTFILE are not used */
+    }
+
+    for (CueTrack & t : sheet.tracks)
+    {
+        if (t.start < 0)
+            t.start = aud::max (t.index0, 0);
+    }
+
+    return sheet.tracks.len () > 0;
+}
+
 bool CueLoader::load (const char * cue_filename, VFSFile & file, String & title,
  Index<PlaylistAddItem> & items)
 {
-    // XXX: cue_parse_string crashes if called concurrently
-    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-
     Index<char> buffer = file.read_all ();
     if (! buffer.len ())
         return false;
 
-    buffer.append (0);  /* null-terminate */
-
-    pthread_mutex_lock (& mutex);
-    Cd * cd = cue_parse_string (buffer.begin ());
-    pthread_mutex_unlock (& mutex);
-
-    int tracks = cd ? cd_get_ntrack (cd) : 0;
-    if (tracks < 1)
+    CueSheet cd;
+    if (! cue_parse (buffer.begin (), buffer.len (), cd))
         return false;
 
-    Track * cur = cd_get_track (cd, 1);
-    const char * cur_name = cur ? track_get_filename (cur) : nullptr;
-
-    if (! cur_name)
-        return false;
+    int tracks = cd.tracks.len ();
 
     bool same_file = false;
     String filename;
@@ -90,9 +289,11 @@ bool CueLoader::load (const char * cue_filename, VFSFile & file, String & title,
 
     for (int track = 1; track <= tracks; track ++)
     {
+        const CueTrack & cur = cd.tracks[track - 1];
+
         if (! same_file)
         {
-            filename = String (uri_construct (cur_name, cue_filename));
+            filename = String (uri_construct (cur.filename, cue_filename));
             decoder = nullptr;
             base_tuple = Tuple ();
 
@@ -102,51 +303,37 @@ bool CueLoader::load (const char * cue_filename, VFSFile & file, String & title,
                 decoder = aud_file_find_decoder (filename, false, file);
             else
                 AUDWARN ("Unable to construct URI for track '%s' in cuesheet '%s'\n",
-                 cur_name, cue_filename);
+                 (const char *) cur.filename, cue_filename);
 
             if (decoder && aud_file_read_tag (filename, decoder, file, base_tuple))
             {
-                Cdtext * cdtext = cd_get_cdtext (cd);
-
-                if (cdtext)
+                if (cd.performer)
+                    base_tuple.set_str (Tuple::AlbumArtist, cd.performer);
+                if (cd.title)
+                    base_tuple.set_str (Tuple::Album, cd.title);
+                if (cd.genre)
+                    base_tuple.set_str (Tuple::Genre, cd.genre);
+                if (cd.composer)
+                    base_tuple.set_str (Tuple::Composer, cd.composer);
+
+                if (cd.date)
                 {
-                    const char * s;
-                    if ((s = cdtext_get (PTI_PERFORMER, cdtext)))
-                        base_tuple.set_str (Tuple::AlbumArtist, s);
-                    if ((s = cdtext_get (PTI_TITLE, cdtext)))
-                        base_tuple.set_str (Tuple::Album, s);
-                    if ((s = cdtext_get (PTI_GENRE, cdtext)))
-                        base_tuple.set_str (Tuple::Genre, s);
-                    if ((s = cdtext_get (PTI_COMPOSER, cdtext)))
-                        base_tuple.set_str (Tuple::Composer, s);
+                    if (is_year (cd.date))
+                        base_tuple.set_int (Tuple::Year, str_to_int (cd.date));
+                    else
+                        base_tuple.set_str (Tuple::Date, cd.date);
                 }
 
-                Rem * rem = cd_get_rem (cd);
-
-                if (rem)
-                {
-                    const char * s;
-
-                    if ((s = rem_get (REM_DATE, rem)))
-                    {
-                        if (is_year (s))
-                            base_tuple.set_int (Tuple::Year, str_to_int (s));
-                        else
-                            base_tuple.set_str (Tuple::Date, s);
-                    }
-
-                    if ((s = rem_get (REM_REPLAYGAIN_ALBUM_GAIN, rem)))
-                        base_tuple.set_gain (Tuple::AlbumGain, Tuple::GainDivisor, s);
-                    if ((s = rem_get (REM_REPLAYGAIN_ALBUM_PEAK, rem)))
-                        base_tuple.set_gain (Tuple::AlbumPeak, Tuple::PeakDivisor, s);
-                }
+                if (cd.album_gain)
+                    base_tuple.set_gain (Tuple::AlbumGain, Tuple::GainDivisor, cd.album_gain);
+                if (cd.album_peak)
+                    base_tuple.set_gain (Tuple::AlbumPeak, Tuple::PeakDivisor, cd.album_peak);
             }
         }
 
-        Track * next = (track + 1 <= tracks) ? cd_get_track (cd, track + 1) : nullptr;
-        const char * next_name = next ? track_get_filename (next) : nullptr;
+        const CueTrack * next = (track + 1 <= tracks) ? & cd.tracks[track] : nullptr;
 
-        same_file = (next_name && ! strcmp (next_name, cur_name));
+        same_file = (next && ! strcmp (next->filename, cur.filename));
 
         if (base_tuple.valid ())
         {
@@ -156,12 +343,12 @@ bool CueLoader::load (const char * cue_filename, VFSFile & file, String & title,
             tuple.set_int (Tuple::Track, track);
             tuple.set_str (Tuple::AudioFile, filename);
 
-            int begin = (int64_t) track_get_start (cur) * 1000 / 75;
+            int begin = (int64_t) cur.start * 1000 / 75;
             tuple.set_int (Tuple::StartTime, begin);
 
             if (same_file)
             {
-                int end = (int64_t) track_get_start (next) * 1000 / 75;
+                int end = (int64_t) next->start * 1000 / 75;
                 tuple.set_int (Tuple::EndTime, end);
                 tuple.set_int (Tuple::Length, end - begin);
             }
@@ -172,38 +359,20 @@ bool CueLoader::load (const char * cue_filename, VFSFile & file, String & title,
                     tuple.set_int (Tuple::Length, length - begin);
             }
 
-            Cdtext * cdtext = track_get_cdtext (cur);
-
-            if (cdtext)
-            {
-                const char * s;
-                if ((s = cdtext_get (PTI_PERFORMER, cdtext)))
-                    tuple.set_str (Tuple::Artist, s);
-                if ((s = cdtext_get (PTI_TITLE, cdtext)))
-                    tuple.set_str (Tuple::Title, s);
-                if ((s = cdtext_get (PTI_GENRE, cdtext)))
-                    tuple.set_str (Tuple::Genre, s);
-            }
-
-            Rem * rem = track_get_rem (cur);
+            if (cur.performer)
+                tuple.set_str (Tuple::Artist, cur.performer);
+            if (cur.title)
+                tuple.set_str (Tuple::Title, cur.title);
+            if (cur.genre)
+                tuple.set_str (Tuple::Genre, cur.genre);
 
-            if (rem)
-            {
-                const char * s;
-                if ((s = rem_get (REM_REPLAYGAIN_TRACK_GAIN, rem)))
-                    tuple.set_gain (Tuple::TrackGain, Tuple::GainDivisor, s);
-                if ((s = rem_get (REM_REPLAYGAIN_TRACK_PEAK, rem)))
-                    tuple.set_gain (Tuple::TrackPeak, Tuple::PeakDivisor, s);
-            }
+            if (cur.gain)
+                tuple.set_gain (Tuple::TrackGain, Tuple::GainDivisor, cur.gain);
+            if (cur.peak)
+                tuple.set_gain (Tuple::TrackPeak, Tuple::PeakDivisor, cur.peak);
 
             items.append (String (tfilename), std::move (tuple), decoder);
         }
-
-        if (! next_name)
-            break;
-
-        cur = next;
-        cur_name = next_name;
     }
 
     return true;
@@ -1,9 +1,15 @@
+#include <atomic>
+
+#include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#define MIN_DELAY 10
 #define MAX_DELAY 1000
+#define MAX_TAPS 8
+#define BLOCK_FRAMES 256
 
 static const char echo_about[] =
  N_("Echo Plugin\n"
@@ -11,23 +17,71 @@ static const char echo_about[] =
     "Surround echo by Carl van Schaik, 1999\n"
     "Updated for Audacious by William Pitcock and John Lindgren, 2010-2014");
 
+/* The first tap keeps the settings of the original single-tap echo, so that
+ * with one tap the plugin behaves as it always has. */
 static const char * const echo_defaults[] = {
+ "taps", "1",
  "delay", "500",
  "feedback", "50",
  "volume", "50",
+ "pan", "0",
+ "damping", "0",
+ "tap2_delay", "250", "tap2_volume", "40", "tap2_feedback", "0", "tap2_pan", "-50", "tap2_damping", "0",
+ "tap3_delay", "375", "tap3_volume", "35", "tap3_feedback", "0", "tap3_pan", "50", "tap3_damping", "0",
+ "tap4_delay", "625", "tap4_volume", "30", "tap4_feedback", "0", "tap4_pan", "-50", "tap4_damping", "0",
+ "tap5_delay", "750", "tap5_volume", "25", "tap5_feedback", "0", "tap5_pan", "50", "tap5_damping", "0",
+ "tap6_delay", "875", "tap6_volume", "20", "tap6_feedback", "0", "tap6_pan", "-50", "tap6_damping", "0",
+ "tap7_delay", "1000", "tap7_volume", "15", "tap7_feedback", "0", "tap7_pan", "50", "tap7_damping", "0",
+ "tap8_delay", "125", "tap8_volume", "10", "tap8_feedback", "0", "tap8_pan", "0", "tap8_damping", "0",
  nullptr};
 
+static void taps_changed ();
+
+#define TAP_WIDGETS(name, delay, volume, feedback, pan, damping) \
+static const PreferencesWidget name[] = { \
+    WidgetSpin (N_("Delay:"), \
+        WidgetFloat ("echo_plugin", delay, taps_changed), \
+        {MIN_DELAY, MAX_DELAY, 0.1, N_("ms")}), \
+    WidgetSpin (N_("Volume:"), \
+        WidgetInt ("echo_plugin", volume, taps_changed), \
+        {0, 100, 1, "%"}), \
+    WidgetSpin (N_("Feedback:"), \
+        WidgetInt ("echo_plugin", feedback, taps_changed), \
+        {0, 100, 1, "%"}), \
+    WidgetSpin (N_("Pan:"), \
+        WidgetInt ("echo_plugin", pan, taps_changed), \
+        {-100, 100, 1}), \
+    WidgetSpin (N_("Damping:"), \
+        WidgetInt ("echo_plugin", damping, taps_changed), \
+        {0, 100, 1, "%"}) \
+};
+
+TAP_WIDGETS (tap1_widgets, "delay", "volume", "feedback", "pan", "damping")
+TAP_WIDGETS (tap2_widgets, "tap2_delay", "tap2_volume", "tap2_feedback", "tap2_pan", "tap2_damping")
+TAP_WIDGETS (tap3_widgets, "tap3_delay", "tap3_volume", "tap3_feedback", "tap3_pan", "tap3_damping")
+TAP_WIDGETS (tap4_widgets, "tap4_delay", "tap4_volume", "tap4_feedback", "tap4_pan", "tap4_damping")
+TAP_WIDGETS (tap5_widgets, "tap5_delay", "tap5_volume", "tap5_feedback", "tap5_pan", "tap5_damping")
+TAP_WIDGETS (tap6_widgets, "tap6_delay", "tap6_volume", "tap6_feedback", "tap6_pan", "tap6_damping")
+TAP_WIDGETS (tap7_widgets, "tap7_delay", "tap7_volume", "tap7_feedback", "tap7_pan", "tap7_damping")
+TAP_WIDGETS (tap8_widgets, "tap8_delay", "tap8_volume", "tap8_feedback", "tap8_pan", "tap8_damping")
+
+static const NotebookTab tap_tabs[] = {
+    {N_("Tap 1"), {tap1_widgets}},
+    {N_("Tap 2"), {tap2_widgets}},
+    {N_("Tap 3"), {tap3_widgets}},
+    {N_("Tap 4"), {tap4_widgets}},
+    {N_("Tap 5"), {tap5_widgets}},
+    {N_("Tap 6"), {tap6_widgets}},
+    {N_("Tap 7"), {tap7_widgets}},
+    {N_("Tap 8"), {tap8_widgets}}
+};
+
 static const PreferencesWidget echo_widgets[] = {
     WidgetLabel (N_("<b>Echo</b>")),
-    WidgetSpin (N_("Delay:"),
-        WidgetInt ("echo_plugin", "delay"),
-        {0, MAX_DELAY, 10, N_("ms")}),
-    WidgetSpin (N_("Feedback:"),
-        WidgetInt ("echo_plugin", "feedback"),
-        {0, 100, 1, "%"}),
-    WidgetSpin (N_("Volume:"),
-        WidgetInt ("echo_plugin", "volume"),
-        {0, 100, 1, "%"})
+    WidgetSpin (N_("Taps:"),
+        WidgetInt ("echo_plugin", "taps", taps_changed),
+        {1, MAX_TAPS, 1}),
+    WidgetNotebook ({{tap_tabs}})
 };
 
 static const PluginPreferences echo_prefs = {{echo_widgets}};
@@ -53,9 +107,34 @@ public:
 
 EXPORT EchoPlugin aud_plugin_instance;
 
+struct Tap {
+    int frames;         /* whole part of the delay */
+    float frac;         /* fractional part, interpolated linearly */
+    float volume, feedback, damping;
+    float gain[AUD_MAX_CHANNELS];  /* volume after panning */
+    float state[AUD_MAX_CHANNELS]; /* low-pass filter in the feedback path */
+};
+
+static Tap taps[MAX_TAPS];
+static int n_taps;
+
+/* set from the preferences window; the taps are then loaded again before the
+ * next block, so that the settings are not read for every block */
+static std::atomic<bool> reload_taps;
+
+static void taps_changed ()
+{
+    reload_taps = true;
+}
+
+/* The delay line holds what is fed back: the input plus the filtered output
+ * of each tap, scaled by its feedback. */
 static Index<float> buffer;
 static int w_ofs;
 
+/* scratch space for one block */
+static Index<float> tap_buf, feed_buf;
+
 bool EchoPlugin::init ()
 {
     aud_config_set_defaults ("echo_plugin", echo_defaults);
@@ -65,11 +144,49 @@ bool EchoPlugin::init ()
 void EchoPlugin::cleanup ()
 {
     buffer.clear ();
+    tap_buf.clear ();
+    feed_buf.clear ();
 }
 
 static int echo_channels = 0;
 static int echo_rate = 0;
 
+static void load_taps ()
+{
+    n_taps = aud::clamp (aud_get_int ("echo_plugin", "taps"), 1, MAX_TAPS);
+    int max_frames = buffer.len () / echo_channels - 1;
+
+    for (int t = 0; t < n_taps; t ++)
+    {
+        Tap & tap = taps[t];
+
+        auto get = [t] (const char * name) {
+            return t ? aud_get_double ("echo_plugin", str_printf ("tap%d_%s", t + 1, name))
+                     : aud_get_double ("echo_plugin", name);
+        };
+
+        /* the delay also bounds the length of the blocks (see process_block) */
+        double delay = aud::clamp (get ("delay"), (double) MIN_DELAY, (double) MAX_DELAY);
+        delay = aud::min (delay * echo_rate / 1000, (double) max_frames);
+        tap.frames = (int) delay;
+        tap.frac = delay - tap.frames;
+
+        tap.volume = get ("volume") / 100;
+        tap.feedback = get ("feedback") / 100;
+        tap.damping = aud::clamp (get ("damping") / 100, 0.0, 0.99);
+
+        for (int c = 0; c < echo_channels; c ++)
+            tap.gain[c] = tap.volume;
+
+        if (echo_channels == 2)
+        {
+            float pan = aud::clamp (get ("pan") / 100, -1.0, 1.0);
+            tap.gain[0] *= aud::min (1 - pan, 1.0f);
+            tap.gain[1] *= aud::min (1 + pan, 1.0f);
+        }
+    }
+}
+
 void EchoPlugin::start (int & channels, int & rate)
 {
     if (channels != echo_channels || rate != echo_rate)
@@ -77,38 +194,137 @@ void EchoPlugin::start (int & channels, int & rate)
         echo_channels = channels;
         echo_rate = rate;
 
-        buffer.resize (aud::rescale (MAX_DELAY, 1000, rate) * channels);
+        /* one extra frame for the interpolation at the maximum delay */
+        buffer.resize ((aud::rescale (MAX_DELAY, 1000, rate) + 1) * channels);
         buffer.erase (0, -1);
 
+        tap_buf.resize (BLOCK_FRAMES * channels);
+        feed_buf.resize (BLOCK_FRAMES * channels);
+
         w_ofs = 0;
+
+        for (Tap & tap : taps)
+        {
+            for (float & s : tap.state)
+                s = 0;
+        }
     }
+
+    reload_taps = false;
+    load_taps ();
 }
 
-Index<float> & EchoPlugin::process (Index<float> & data)
+/* Adds weight times count samples of the delay line, starting at from, to
+ * dest.  The loop is split where the delay line wraps around, so that each
+ * part is a plain vectorizable loop. */
+static void add_delayed (float * dest, int from, int count, float weight)
 {
-    int delay = aud_get_int ("echo_plugin", "delay");
-    float feedback = aud_get_int ("echo_plugin", "feedback") / 100.0f;
-    float volume = aud_get_int ("echo_plugin", "volume") / 100.0f;
+    while (count > 0)
+    {
+        int run = aud::min (count, buffer.len () - from);
+        const float * src = buffer.begin () + from;
+
+        for (int i = 0; i < run; i ++)
+            dest[i] += weight * src[i];
+
+        dest += run;
+        count -= run;
+        from = 0;
+    }
+}
+
+static void write_delayed (const float * src, int count)
+{
+    while (count > 0)
+    {
+        int run = aud::min (count, buffer.len () - w_ofs);
+        float * dest = buffer.begin () + w_ofs;
 
-    int interval = aud::rescale (delay, 1000, echo_rate) * echo_channels;
-    interval = aud::clamp (interval, 0, buffer.len ());  // sanity check
+        for (int i = 0; i < run; i ++)
+            dest[i] = src[i];
 
-    int r_ofs = w_ofs - interval;
-    if (r_ofs < 0)
-        r_ofs += buffer.len ();
+        src += run;
+        count -= run;
+        w_ofs = (w_ofs + run) % buffer.len ();
+    }
+}
+
+static int delayed_offset (int frames)
+{
+    int ofs = w_ofs - frames * echo_channels;
+    return (ofs < 0) ? ofs + buffer.len () : ofs;
+}
+
+/* Blocks are never longer than the shortest delay, so each block only reads
+ * from the delay line what was written before the block. */
+static void process_block (float * data, int frames)
+{
+    int samples = frames * echo_channels;
+    float * tap_out = tap_buf.begin ();
+    float * feed = feed_buf.begin ();
 
-    float * end = data.end ();
+    for (int i = 0; i < samples; i ++)
+        feed[i] = data[i];
 
-    for (float * f = data.begin (); f < end; f++)
+    for (int t = 0; t < n_taps; t ++)
     {
-        float in = * f;
-        float buf = buffer[r_ofs];
+        Tap & tap = taps[t];
 
-        * f = in + buf * volume;
-        buffer[w_ofs] = in + buf * feedback;
+        for (int i = 0; i < samples; i ++)
+            tap_out[i] = 0;
+
+        add_delayed (tap_out, delayed_offset (tap.frames), samples, 1 - tap.frac);
+        if (tap.frac > 0)
+            add_delayed (tap_out, delayed_offset (tap.frames + 1), samples, tap.frac);
+
+        for (int i = 0; i < samples; i += echo_channels)
+        {
+            for (int c = 0; c < echo_channels; c ++)
+                data[i + c] += tap.gain[c] * tap_out[i + c];
+        }
+
+        if (tap.feedback <= 0)
+            continue;
+
+        if (tap.damping > 0)
+        {
+            /* one-pole low-pass filter, which dulls each repeat a little more */
+            for (int i = 0; i < samples; i += echo_channels)
+            {
+                for (int c = 0; c < echo_channels; c ++)
+                {
+                    tap.state[c] += (1 - tap.damping) * (tap_out[i + c] - tap.state[c]);
+                    tap_out[i + c] = tap.state[c];
+                }
+            }
+        }
+
+        for (int i = 0; i < samples; i ++)
+            feed[i] += tap.feedback * tap_out[i];
+    }
+
+    write_delayed (feed, samples);
+}
+
+Index<float> & EchoPlugin::process (Index<float> & data)
+{
+    if (reload_taps.exchange (false))
+        load_taps ();
+
+    int block = BLOCK_FRAMES;
+    for (int t = 0; t < n_taps; t ++)
+        block = aud::min (block, taps[t].frames);
+
+    float * f = data.begin ();
+    int frames = data.len () / echo_channels;
+
+    while (frames > 0)
+    {
+        int count = aud::min (frames, block);
+        process_block (f, count);
 
-        r_ofs = (r_ofs + 1) % buffer.len ();
-        w_ofs = (w_ofs + 1) % buffer.len ();
+        f += count * echo_channels;
+        frames -= count;
     }
 
     return data;
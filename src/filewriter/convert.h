@@ -3,8 +3,19 @@
 
 #include "filewriter.h"
 
-void convert_init (int input_fmt, int output_fmt);
-const Index<char> & convert_process (const void * ptr, int length);
-void convert_free ();
+class Converter
+{
+public:
+    void init (int input_fmt, int output_fmt);
+    const Index<char> & process (const void * ptr, int length);
+    void free ();
+
+private:
+    int m_in_fmt = 0;
+    int m_out_fmt = 0;
+
+    Index<char> m_output;
+    Index<float> m_temp;
+};
 
 #endif
@@ -21,6 +21,7 @@
  */
 
 #include <glib.h>
+#include <pthread.h>
 #include <string.h>
 
 #include <libaudcore/audstrings.h>
@@ -54,6 +55,7 @@ public:
     constexpr FileWriter () : OutputPlugin (info, 0, true) {}
 
     bool init ();
+    void cleanup ();
 
     StereoVolume get_volume () { return {0, 0}; }
     void set_volume (StereoVolume v) {}
@@ -62,12 +64,11 @@ public:
     bool open_audio (int fmt, int rate, int nch, String & error);
     void close_audio ();
 
-    void period_wait () {}
+    void period_wait ();
     int write_audio (const void * ptr, int length);
-    void drain () {}
+    void drain ();
 
-    int get_delay ()
-        { return 0; }
+    int get_delay ();
 
     void pause (bool pause) {}
     void flush () {}
@@ -128,8 +129,25 @@ static const char *fileext_str[FILEEXT_MAX] =
 #endif
 };
 
-static FileWriterImpl *plugin;
 static VFSFile output_file;
+static SmartPtr<FileWriterEncoder> encoder;
+static Converter converter;
+
+/* The encoder runs in a separate thread, fed through a bounded queue of
+ * buffers that are recycled from one write to the next.  When the queue is
+ * full, write_audio() accepts nothing and period_wait() blocks until the
+ * encoder has caught up. */
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t encoder_thread;
+static bool encoder_quit;
+
+static Index<Index<char>> queue_bufs;
+static int queue_head, queue_count, queue_peak;
+static int64_t queue_bytes;
+
+static int in_fmt, in_rate, in_channels;
+static int64_t encoded_bytes, encode_time;
 
 FileWriterImpl *plugins[FILEEXT_MAX] = {
     &wav_plugin,
@@ -154,6 +172,7 @@ const char * const FileWriter::defaults[] = {
  "prependnumber", "FALSE",
  "save_original", "FALSE",
  "use_suffix", "FALSE",
+ "queue_buffers", "32",
  nullptr};
 
 bool FileWriter::init ()
@@ -291,6 +310,81 @@ static StringBuf format_filename (const char * suffix)
     return filename.settle ();
 }
 
+static void * encoder_loop (void *)
+{
+    pthread_mutex_lock (& queue_mutex);
+
+    while (true)
+    {
+        if (! queue_count)
+        {
+            if (encoder_quit)
+                break;
+
+            pthread_cond_wait (& queue_cond, & queue_mutex);
+            continue;
+        }
+
+        /* the buffer at the head of the queue is not touched by write_audio()
+         * until we release it, so it can be encoded without the lock */
+        const Index<char> & buf = queue_bufs[queue_head];
+        pthread_mutex_unlock (& queue_mutex);
+
+        int64_t start = g_get_monotonic_time ();
+
+        auto & out = converter.process (buf.begin (), buf.len ());
+        encoder->write (output_file, out.begin (), out.len ());
+
+        int64_t time = g_get_monotonic_time () - start;
+
+        pthread_mutex_lock (& queue_mutex);
+
+        encode_time += time;
+        encoded_bytes += buf.len ();
+        queue_bytes -= buf.len ();
+        queue_head = (queue_head + 1) % queue_bufs.len ();
+        queue_count --;
+
+        pthread_cond_broadcast (& queue_cond);
+    }
+
+    pthread_mutex_unlock (& queue_mutex);
+    return nullptr;
+}
+
+static bool encoder_start ()
+{
+    int n_bufs = aud::clamp (aud_get_int ("filewriter", "queue_buffers"), 2, 256);
+
+    queue_bufs.resize (n_bufs);
+    queue_head = queue_count = queue_peak = 0;
+    queue_bytes = 0;
+
+    encoded_bytes = encode_time = 0;
+    encoder_quit = false;
+
+    return pthread_create (& encoder_thread, nullptr, encoder_loop, nullptr) == 0;
+}
+
+static void encoder_stop ()
+{
+    pthread_mutex_lock (& queue_mutex);
+    encoder_quit = true;
+    pthread_cond_broadcast (& queue_cond);
+    pthread_mutex_unlock (& queue_mutex);
+
+    /* the encoder thread finishes the queue before exiting */
+    pthread_join (encoder_thread, nullptr);
+
+    int64_t frames = encoded_bytes / (FMT_SIZEOF (in_fmt) * in_channels);
+    double seconds = (double) frames / in_rate;
+
+    if (encode_time > 0)
+        AUDINFO ("Encoded %.1f s of audio at %.1fx real time, "
+         "peak queue depth %d of %d buffers.\n", seconds,
+         seconds * 1000000 / encode_time, queue_peak, queue_bufs.len ());
+}
+
 bool FileWriter::open_audio (int fmt, int rate, int nch, String & error)
 {
     int ext = aud_get_int ("filewriter", "fileext");
@@ -300,16 +394,29 @@ bool FileWriter::open_audio (int fmt, int rate, int nch, String & error)
     if (! filename)
         return false;
 
-    plugin = plugins[ext];
+    FileWriterImpl * plugin = plugins[ext];
 
     int out_fmt = plugin->format_required (fmt);
-    convert_init (fmt, out_fmt);
+    converter.init (fmt, out_fmt);
+
+    in_fmt = fmt;
+    in_rate = rate;
+    in_channels = nch;
 
     output_file = safe_create (filename);
     if (output_file)
     {
-        if (plugin->open (output_file, {out_fmt, rate, nch}, in_tuple))
-            return true;
+        encoder.capture (plugin->open (output_file, {out_fmt, rate, nch}, in_tuple));
+        if (encoder)
+        {
+            if (encoder_start ())
+                return true;
+
+            error = String (_("Error starting the encoder thread."));
+
+            encoder->close (output_file);
+            encoder.clear ();
+        }
     }
     else
     {
@@ -317,7 +424,7 @@ bool FileWriter::open_audio (int fmt, int rate, int nch, String & error)
          (const char *) filename, output_file.error ()));
     }
 
-    plugin = nullptr;
+    converter.free ();
     output_file = VFSFile ();
     in_filename = String ();
     in_tuple = Tuple ();
@@ -326,23 +433,80 @@ bool FileWriter::open_audio (int fmt, int rate, int nch, String & error)
 
 int FileWriter::write_audio (const void * ptr, int length)
 {
-    auto & buf = convert_process (ptr, length);
-    plugin->write (output_file, buf.begin (), buf.len ());
+    pthread_mutex_lock (& queue_mutex);
+
+    if (queue_count == queue_bufs.len ())
+    {
+        pthread_mutex_unlock (& queue_mutex);
+        return 0;
+    }
+
+    /* this buffer is not seen by the encoder thread until it is queued */
+    Index<char> & buf = queue_bufs[(queue_head + queue_count) % queue_bufs.len ()];
+    pthread_mutex_unlock (& queue_mutex);
+
+    buf.resize (length);
+    memcpy (buf.begin (), ptr, length);
+
+    pthread_mutex_lock (& queue_mutex);
+
+    queue_count ++;
+    queue_bytes += length;
+    queue_peak = aud::max (queue_peak, queue_count);
+
+    pthread_cond_broadcast (& queue_cond);
+    pthread_mutex_unlock (& queue_mutex);
 
     return length;
 }
 
+void FileWriter::period_wait ()
+{
+    pthread_mutex_lock (& queue_mutex);
+
+    while (queue_count == queue_bufs.len ())
+        pthread_cond_wait (& queue_cond, & queue_mutex);
+
+    pthread_mutex_unlock (& queue_mutex);
+}
+
+void FileWriter::drain ()
+{
+    pthread_mutex_lock (& queue_mutex);
+
+    while (queue_count)
+        pthread_cond_wait (& queue_cond, & queue_mutex);
+
+    pthread_mutex_unlock (& queue_mutex);
+}
+
+int FileWriter::get_delay ()
+{
+    pthread_mutex_lock (& queue_mutex);
+    int64_t frames = queue_bytes / (FMT_SIZEOF (in_fmt) * in_channels);
+    pthread_mutex_unlock (& queue_mutex);
+
+    return aud::rescale<int64_t> (frames, in_rate, 1000);
+}
+
 void FileWriter::close_audio ()
 {
-    plugin->close (output_file);
-    convert_free ();
+    encoder_stop ();
+
+    encoder->close (output_file);
+    encoder.clear ();
+    converter.free ();
 
-    plugin = nullptr;
     output_file = VFSFile ();
     in_filename = String ();
     in_tuple = Tuple ();
 }
 
+void FileWriter::cleanup ()
+{
+    queue_bufs.clear ();
+}
+
 static void save_original_cb ()
 {
     aud_set_bool ("filewriter", "save_original", save_original);
@@ -569,6 +733,26 @@ static const PreferencesWidget vorbis_widgets[] = {
 };
 #endif
 
+#ifdef FILEWRITER_FLAC
+static const PreferencesWidget flac_widgets[] = {
+    WidgetSpin(N_("Compression level (0-8):"),
+        WidgetInt("filewriter_flac", "compression_level"),
+        {0, 8, 1}),
+    WidgetSpin(N_("Block size (0 = default):"),
+        WidgetInt("filewriter_flac", "blocksize"),
+        {0, 65535, 1}),
+    WidgetEntry(N_("Apodization functions:"),
+        WidgetString("filewriter_flac", "apodization")),
+    WidgetCheck(N_("Verify encoded audio"),
+        WidgetBool("filewriter_flac", "verify")),
+#ifdef HAVE_FLAC_1_5
+    WidgetSpin(N_("Encoder threads:"),
+        WidgetInt("filewriter_flac", "threads"),
+        {1, 64, 1})
+#endif
+};
+#endif
+
 static const NotebookTab tabs[] = {
     {N_("General"), {main_widgets}}
 #ifdef FILEWRITER_MP3
@@ -577,6 +761,9 @@ static const NotebookTab tabs[] = {
 #ifdef FILEWRITER_VORBIS
     ,{"Vorbis", {vorbis_widgets}}
 #endif
+#ifdef FILEWRITER_FLAC
+    ,{"FLAC", {flac_widgets}}
+#endif
 };
 
 const PreferencesWidget FileWriter::widgets[] = {
@@ -34,12 +34,25 @@ struct format_info {
     int channels;
 };
 
+/* The state of a single encoding job.  Encoders share no state with each
+ * other, so several jobs may run at once in different threads.
+ *
+ * Only the output plugin creates jobs for now, one at a time.  A batch
+ * transcoder would need to decode files outside of playback, and input
+ * plugins can only deliver audio to the playback thread. */
+class FileWriterEncoder
+{
+public:
+    virtual ~FileWriterEncoder () {}
+
+    virtual void write (VFSFile & file, const void * data, int length) = 0;
+    virtual void close (VFSFile & file) = 0;
+};
+
 struct FileWriterImpl
 {
     void (* init) ();
-    bool (* open) (VFSFile & file, const format_info & info, const Tuple & tuple);
-    void (* write) (VFSFile & file, const void * data, int length);
-    void (* close) (VFSFile & file);
+    FileWriterEncoder * (* open) (VFSFile & file, const format_info & info, const Tuple & tuple);
     int (* format_required) (int fmt);
 };
 
@@ -26,10 +26,22 @@
 #include <FLAC/all.h>
 
 #include <libaudcore/audstrings.h>
+#include <libaudcore/runtime.h>
 
-static int channels;
-static FLAC__StreamEncoder *flac_encoder;
-static FLAC__StreamMetadata *flac_metadata;
+static const char * const flac_defaults[] = {
+ "compression_level", "5",
+ "blocksize", "0",
+ "apodization", "",
+ "verify", "FALSE",
+ "threads", "1",
+ nullptr};
+
+#define GET_INT(n) aud_get_int("filewriter_flac", n)
+
+static void flac_init ()
+{
+    aud_config_set_defaults ("filewriter_flac", flac_defaults);
+}
 
 static FLAC__StreamEncoderWriteStatus flac_write_cb(const FLAC__StreamEncoder *encoder,
     const FLAC__byte buffer[], size_t bytes, unsigned samples, unsigned current_frame, void * data)
@@ -94,13 +106,72 @@ static void insert_vorbis_comment (FLAC__StreamMetadata * meta,
      meta->data.vorbis_comment.num_comments, comment, true);
 }
 
-static bool flac_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+class FLACEncoder : public FileWriterEncoder
+{
+public:
+    ~FLACEncoder ();
+
+    bool open (VFSFile & file, const format_info & info, const Tuple & tuple);
+    void write (VFSFile & file, const void * data, int length);
+    void close (VFSFile & file);
+
+private:
+    int channels = 0;
+    int format = 0;
+    FLAC__StreamEncoder *flac_encoder = nullptr;
+    FLAC__StreamMetadata *flac_metadata = nullptr;
+
+    /* reused from one write to the next */
+    Index<FLAC__int32> encbuffer;
+};
+
+FLACEncoder::~FLACEncoder ()
+{
+    if (flac_encoder)
+        FLAC__stream_encoder_delete(flac_encoder);
+    if (flac_metadata)
+        FLAC__metadata_object_delete(flac_metadata);
+}
+
+bool FLACEncoder::open (VFSFile & file, const format_info & info, const Tuple & tuple)
 {
+    if (info.channels < 1 || info.channels > FLAC__MAX_CHANNELS)
+    {
+        AUDERR ("FLAC does not support %d channels.\n", info.channels);
+        return false;
+    }
+
     flac_encoder = FLAC__stream_encoder_new();
+    if (! flac_encoder)
+        return false;
+
+    int bits = (info.format == FMT_S16_NE) ? 16 : (info.format == FMT_S24_NE) ? 24 : 32;
 
     FLAC__stream_encoder_set_channels(flac_encoder, info.channels);
+    FLAC__stream_encoder_set_bits_per_sample(flac_encoder, bits);
     FLAC__stream_encoder_set_sample_rate(flac_encoder, info.frequency);
 
+    /* the compression level presets the other settings, so it goes first */
+    FLAC__stream_encoder_set_compression_level(flac_encoder,
+     aud::clamp (GET_INT("compression_level"), 0, 8));
+
+    int blocksize = GET_INT("blocksize");
+    if (blocksize > 0)
+        FLAC__stream_encoder_set_blocksize(flac_encoder, blocksize);
+
+    String apodization = aud_get_str ("filewriter_flac", "apodization");
+    if (apodization[0])
+        FLAC__stream_encoder_set_apodization(flac_encoder, apodization);
+
+    FLAC__stream_encoder_set_verify(flac_encoder, aud_get_bool ("filewriter_flac", "verify"));
+
+#ifdef HAVE_FLAC_1_5
+    int threads = GET_INT("threads");
+    if (threads > 1 && FLAC__stream_encoder_set_num_threads(flac_encoder,
+     threads) != FLAC__STREAM_ENCODER_SET_NUM_THREADS_OK)
+        AUDWARN ("Unable to use %d threads for FLAC encoding.\n", threads);
+#endif
+
     flac_metadata = FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT);
 
     insert_vorbis_comment (flac_metadata, "TITLE", tuple, Tuple::Title);
@@ -115,62 +186,43 @@ static bool flac_open (VFSFile & file, const format_info & info, const Tuple & t
 
     FLAC__stream_encoder_set_metadata(flac_encoder, &flac_metadata, 1);
 
-    FLAC__stream_encoder_init_stream(flac_encoder, flac_write_cb, flac_seek_cb,
-     flac_tell_cb, nullptr, &file);
+    FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_stream
+     (flac_encoder, flac_write_cb, flac_seek_cb, flac_tell_cb, nullptr, &file);
+
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+    {
+        AUDERR ("Error initializing FLAC encoder: %s\n",
+         FLAC__StreamEncoderInitStatusString[status]);
+        return false;
+    }
 
     channels = info.channels;
+    format = info.format;
     return true;
 }
 
-static void flac_write (VFSFile & file, const void * data, int length)
+void FLACEncoder::write (VFSFile & file, const void * data, int length)
 {
-#if 1
-    FLAC__int32 *encbuffer[2];
-    int16_t *tmpdata = (int16_t *) data;
-    int i;
+    int samples = length / FMT_SIZEOF (format);
+    auto encdata = (const FLAC__int32 *) data;
 
-    encbuffer[0] = new FLAC__int32[length / channels];
-    encbuffer[1] = new FLAC__int32[length / channels];
-
-    if (channels == 1)
-    {
-        for (i = 0; i < (length / 2); i++)
-        {
-            encbuffer[0][i] = tmpdata[i];
-            encbuffer[1][i] = tmpdata[i];
-        }
-    }
-    else
+    /* 24- and 32-bit audio is already in the layout libFLAC expects */
+    if (format == FMT_S16_NE)
     {
-        for (i = 0; i < (length / 4); i++)
-        {
-            encbuffer[0][i] = tmpdata[2 * i];
-            encbuffer[1][i] = tmpdata[2 * i + 1];
-        }
-    }
-
-    FLAC__stream_encoder_process(flac_encoder, (const FLAC__int32 **)encbuffer, length / (channels * 2));
-
-    delete[] encbuffer[0];
-    delete[] encbuffer[1];
-#else
-    FLAC__int32 *encbuffer;
-    int16_t *tmpdata = (int16_t *) data;
-    int i;
+        encbuffer.resize (samples);
 
-    encbuffer = new FLAC__int32[length];
+        auto in = (const int16_t *) data;
+        for (int i = 0; i < samples; i ++)
+            encbuffer[i] = in[i];
 
-    for (i=0; i < length; i++) {
-        encbuffer[i] = tmpdata[i];
+        encdata = encbuffer.begin ();
     }
 
-    FLAC__stream_encoder_process_interleaved(flac_encoder, encbuffer, length);
-
-    delete[] encbuffer;
-#endif
+    if (! FLAC__stream_encoder_process_interleaved(flac_encoder, encdata, samples / channels))
+        AUDERR ("Error while encoding FLAC: %s\n", FLAC__stream_encoder_get_resolved_state_string(flac_encoder));
 }
 
-static void flac_close (VFSFile & file)
+void FLACEncoder::close (VFSFile & file)
 {
     if (flac_encoder)
     {
@@ -184,18 +236,49 @@ static void flac_close (VFSFile & file)
         FLAC__metadata_object_delete(flac_metadata);
         flac_metadata = nullptr;
     }
+
+    encbuffer.clear ();
+}
+
+static FileWriterEncoder * flac_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+{
+    auto encoder = new FLACEncoder;
+    if (encoder->open (file, info, tuple))
+        return encoder;
+
+    delete encoder;
+    return nullptr;
 }
 
 static int flac_format_required (int fmt)
 {
-    return FMT_S16_NE;
+    switch (fmt)
+    {
+        case FMT_S8:
+        case FMT_U8:
+        case FMT_S16_LE:
+        case FMT_S16_BE:
+        case FMT_U16_LE:
+        case FMT_U16_BE:
+            return FMT_S16_NE;
+
+#if FLAC__REFERENCE_CODEC_MAX_BITS_PER_SAMPLE >= 32
+        case FMT_S32_LE:
+        case FMT_S32_BE:
+        case FMT_U32_LE:
+        case FMT_U32_BE:
+            return FMT_S32_NE;
+#endif
+
+        /* 24 bits hold floating point audio without audible loss */
+        default:
+            return FMT_S24_NE;
+    }
 }
 
 FileWriterImpl flac_plugin = {
-    nullptr,  // init
+    flac_init,
     flac_open,
-    flac_write,
-    flac_close,
     flac_format_required,
 };
 
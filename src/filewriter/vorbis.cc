@@ -30,23 +30,12 @@
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 
-static ogg_stream_state os;
-static ogg_page og;
-static ogg_packet op;
-
-static vorbis_dsp_state vd;
-static vorbis_block vb;
-static vorbis_info vi;
-static vorbis_comment vc;
-
 static const char * const vorbis_defaults[] = {
  "base_quality", "0.5",
  nullptr};
 
 #define GET_DOUBLE(n) aud_get_double("filewriter_vorbis", n)
 
-static int channels;
-
 static void vorbis_init ()
 {
     aud_config_set_defaults ("filewriter_vorbis", vorbis_defaults);
@@ -60,7 +49,29 @@ static void add_string_from_tuple (vorbis_comment * vc, const char * name,
         vorbis_comment_add_tag (vc, name, val);
 }
 
-static bool vorbis_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+class VorbisEncoder : public FileWriterEncoder
+{
+public:
+    bool open (VFSFile & file, const format_info & info, const Tuple & tuple);
+    void write (VFSFile & file, const void * data, int length);
+    void close (VFSFile & file);
+
+private:
+    ogg_stream_state os;
+    ogg_page og;
+    ogg_packet op;
+
+    vorbis_dsp_state vd;
+    vorbis_block vb;
+    vorbis_info vi;
+    vorbis_comment vc;
+
+    int channels = 0;
+
+    void write_real (VFSFile & file, const void * data, int length);
+};
+
+bool VorbisEncoder::open (VFSFile & file, const format_info & info, const Tuple & tuple)
 {
     ogg_packet header;
     ogg_packet header_comm;
@@ -92,6 +103,7 @@ static bool vorbis_open (VFSFile & file, const format_info & info, const Tuple &
     if (vorbis_encode_init_vbr(& vi, info.channels, info.frequency, GET_DOUBLE("base_quality")))
     {
         vorbis_info_clear(&vi);
+        vorbis_comment_clear(&vc);
         return false;
     }
 
@@ -117,7 +129,7 @@ static bool vorbis_open (VFSFile & file, const format_info & info, const Tuple &
     return true;
 }
 
-static void vorbis_write_real (VFSFile & file, const void * data, int length)
+void VorbisEncoder::write_real (VFSFile & file, const void * data, int length)
 {
     int samples = length / sizeof (float);
     int channel;
@@ -154,15 +166,15 @@ static void vorbis_write_real (VFSFile & file, const void * data, int length)
     }
 }
 
-static void vorbis_write (VFSFile & file, const void * data, int length)
+void VorbisEncoder::write (VFSFile & file, const void * data, int length)
 {
     if (length > 0) /* don't signal end of file yet */
-        vorbis_write_real (file, data, length);
+        write_real (file, data, length);
 }
 
-static void vorbis_close (VFSFile & file)
+void VorbisEncoder::close (VFSFile & file)
 {
-    vorbis_write_real (file, nullptr, 0); /* signal end of file */
+    write_real (file, nullptr, 0); /* signal end of file */
 
     while (ogg_stream_flush (& os, & og))
     {
@@ -176,6 +188,17 @@ static void vorbis_close (VFSFile & file)
     vorbis_block_clear(&vb);
     vorbis_dsp_clear(&vd);
     vorbis_info_clear(&vi);
+    vorbis_comment_clear(&vc);
+}
+
+static FileWriterEncoder * vorbis_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+{
+    auto encoder = new VorbisEncoder;
+    if (encoder->open (file, info, tuple))
+        return encoder;
+
+    delete encoder;
+    return nullptr;
 }
 
 static int vorbis_format_required (int fmt)
@@ -186,8 +209,6 @@ static int vorbis_format_required (int fmt)
 FileWriterImpl vorbis_plugin = {
     vorbis_init,
     vorbis_open,
-    vorbis_write,
-    vorbis_close,
     vorbis_format_required,
 };
 
@@ -46,15 +46,25 @@ struct wavhead
 };
 #pragma pack(pop)
 
-static struct wavhead header;
+class WavEncoder : public FileWriterEncoder
+{
+public:
+    bool open (VFSFile & file, const format_info & info);
+    void write (VFSFile & file, const void * data, int len);
+    void close (VFSFile & file);
+
+private:
+    struct wavhead header;
 
-static int format;
-static Index<char> packbuf;
+    int format = 0;
+    Index<char> packbuf;
 
-static uint64_t written;
+    uint64_t written = 0;
 
+    void pack24 (const void * * data, int * len);
+};
 
-static bool wav_open (VFSFile & file, const format_info & info, const Tuple &)
+bool WavEncoder::open (VFSFile & file, const format_info & info)
 {
     memcpy(&header.main_chunk, "RIFF", 4);
     header.length = TO_LE32(0);
@@ -87,7 +97,7 @@ static bool wav_open (VFSFile & file, const format_info & info, const Tuple &)
     return true;
 }
 
-static void pack24 (const void * * data, int * len)
+void WavEncoder::pack24 (const void * * data, int * len)
 {
     int samples = (* len) / sizeof (int32_t);
     auto data32 = (const int32_t *) * data;
@@ -106,7 +116,7 @@ static void pack24 (const void * * data, int * len)
     }
 }
 
-static void wav_write (VFSFile & file, const void * data, int len)
+void WavEncoder::write (VFSFile & file, const void * data, int len)
 {
     if (format == FMT_S24_LE)
         pack24 (& data, & len);
@@ -116,7 +126,7 @@ static void wav_write (VFSFile & file, const void * data, int len)
         AUDERR ("Error while writing to .wav output file.\n");
 }
 
-static void wav_close (VFSFile & file)
+void WavEncoder::close (VFSFile & file)
 {
     header.length = TO_LE32(written + sizeof (struct wavhead) - 8);
     header.data_length = TO_LE32(written);
@@ -128,6 +138,16 @@ static void wav_close (VFSFile & file)
     packbuf.clear ();
 }
 
+static FileWriterEncoder * wav_open (VFSFile & file, const format_info & info, const Tuple &)
+{
+    auto encoder = new WavEncoder;
+    if (encoder->open (file, info))
+        return encoder;
+
+    delete encoder;
+    return nullptr;
+}
+
 static int wav_format_required (int fmt)
 {
     switch (fmt)
@@ -145,7 +165,5 @@ static int wav_format_required (int fmt)
 FileWriterImpl wav_plugin = {
     nullptr,  // init
     wav_open,
-    wav_write,
-    wav_close,
     wav_format_required,
 };
@@ -26,6 +26,8 @@
 
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+#include <libaudcore/runtime.h>
 #include <libaudgui/gtk-compat.h>
 
 #include <gdk/gdk.h>
@@ -42,6 +44,9 @@
 #include <gdk/gdkwin32.h>
 #endif
 
+#include "../spectrum-common/spectrum.h"
+
+#define CFG_ID "gl-spectrum"
 #define NUM_BANDS 32
 #define DB_RANGE 40
 
@@ -59,27 +64,62 @@ static const char gl_about[] =
 class GLSpectrum : public VisPlugin
 {
 public:
+    static const char * const defaults[];
+    static const ComboItem interpolations[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
     static constexpr PluginInfo info = {
         N_("OpenGL Spectrum Analyzer"),
         PACKAGE,
         gl_about,
-        nullptr, // prefs
+        & prefs,
         PluginGLibOnly
     };
 
-    constexpr GLSpectrum () : VisPlugin (info, Visualizer::Freq) {}
+    constexpr GLSpectrum () : VisPlugin (info, Visualizer::MonoPCM) {}
 
     bool init ();
 
     void * get_gtk_widget ();
 
     void clear ();
-    void render_freq (const float * freq);
+    void render_mono_pcm (const float * pcm);
 };
 
 EXPORT GLSpectrum aud_plugin_instance;
 
-static float logscale[NUM_BANDS + 1];
+const char * const GLSpectrum::defaults[] = {
+    "interpolation", "1",
+    "constant_q", "FALSE",
+    nullptr
+};
+
+/* The core sends 512-sample blocks, so a larger FFT only zero-pads them,
+ * which interpolates the spectrum without adding resolution. */
+const ComboItem GLSpectrum::interpolations[] = {
+    ComboItem (N_("None"), 1),
+    ComboItem ("2x", 2),
+    ComboItem ("4x", 4),
+    ComboItem ("8x", 8),
+    ComboItem ("16x", 16)
+};
+
+static void read_config ();
+
+const PreferencesWidget GLSpectrum::widgets[] = {
+    WidgetCombo (N_("Interpolation:"),
+        WidgetInt (CFG_ID, "interpolation", read_config),
+        {{interpolations}}),
+    WidgetCheck (N_("Constant-Q bands"),
+        WidgetBool (CFG_ID, "constant_q", read_config))
+};
+
+const PluginPreferences GLSpectrum::prefs = {{widgets}};
+
+static SpectrumAnalyzer analyzer;
+static int fft_size;
+static SpectrumAnalyzer::Scale scale;
 static float colors[NUM_BANDS][NUM_BANDS][3];
 
 #ifdef GDK_WINDOWING_X11
@@ -100,10 +140,18 @@ static int s_pos = 0;
 static float s_angle = 25, s_anglespeed = 0.05f;
 static float s_bars[NUM_BANDS][NUM_BANDS];
 
+/* the settings are kept here rather than read for every frame */
+static void read_config ()
+{
+    fft_size = SpectrumAnalyzer::block_size * aud_get_int (CFG_ID, "interpolation");
+    scale = aud_get_bool (CFG_ID, "constant_q") ? SpectrumAnalyzer::ConstantQ :
+     SpectrumAnalyzer::LogScale;
+}
+
 bool GLSpectrum::init ()
 {
-    for (int i = 0; i <= NUM_BANDS; i ++)
-        logscale[i] = powf (256, (float) i / NUM_BANDS) - 0.5f;
+    aud_config_set_defaults (CFG_ID, defaults);
+    read_config ();
 
     for (int y = 0; y < NUM_BANDS; y ++)
     {
@@ -122,47 +170,10 @@ bool GLSpectrum::init ()
     return true;
 }
 
-/* stolen from the skins plugin */
-/* convert linear frequency graph to logarithmic one */
-static void make_log_graph (const float * freq, float * graph)
+void GLSpectrum::render_mono_pcm (const float * pcm)
 {
-    for (int i = 0; i < NUM_BANDS; i ++)
-    {
-        /* sum up values in freq array between logscale[i] and logscale[i + 1],
-           including fractional parts */
-        int a = ceilf (logscale[i]);
-        int b = floorf (logscale[i + 1]);
-        float sum = 0;
-
-        if (b < a)
-            sum += freq[b] * (logscale[i + 1] - logscale[i]);
-        else
-        {
-            if (a > 0)
-                sum += freq[a - 1] * (a - logscale[i]);
-            for (; a < b; a ++)
-                sum += freq[a];
-            if (b < 256)
-                sum += freq[b] * (logscale[i + 1] - b);
-        }
-
-        /* fudge factor to make the graph have the same overall height as a
-           12-band one no matter how many bands there are */
-        sum *= (float) NUM_BANDS / 12;
-
-        /* convert to dB */
-        float val = 20 * log10f (sum);
-
-        /* scale (-DB_RANGE, 0.0) to (0.0, 1.0) */
-        val = 1 + val / DB_RANGE;
-
-        graph[i] = aud::clamp (val, 0.0f, 1.0f);
-    }
-}
-
-void GLSpectrum::render_freq (const float * freq)
-{
-    make_log_graph (freq, s_bars[s_pos]);
+    analyzer.configure (NUM_BANDS, fft_size, scale, DB_RANGE);
+    analyzer.analyze (pcm, s_bars[s_pos]);
     s_pos = (s_pos + 1) % NUM_BANDS;
 
     s_angle += s_anglespeed;
@@ -181,56 +192,52 @@ void GLSpectrum::clear ()
         gtk_widget_queue_draw (s_widget);
 }
 
-static void draw_rectangle (float x1, float y1, float z1, float x2, float y2,
- float z2, float r, float g, float b)
+/* Each bar is made of four quads (the top, the two sides, and the front).
+ * The quads of all the bars are gathered into one vertex array and drawn with
+ * a single call, rather than one call per vertex. */
+#define VERTICES_PER_BAR 16
+
+struct Vertex
 {
-    glColor3f (r, g, b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y2, z2);
-    glVertex3f (x1, y2, z2);
-    glEnd ();
-
-    glColor3f (0.65f * r, 0.65f * g, 0.65f * b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x1, y2, z2);
-    glVertex3f (x1, y1, z2);
-    glEnd ();
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y1, z2);
-    glVertex3f (x2, y2, z2);
-    glEnd ();
-
-    glColor3f (0.8f * r, 0.8f * g, 0.8f * b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x1, y2, z1);
-    glEnd ();
+    float x, y, z;
+    float r, g, b;
+};
+
+static Vertex s_vertices[NUM_BANDS * NUM_BANDS * VERTICES_PER_BAR];
+
+static Vertex * add_quad (Vertex * v, const float (* corners)[3], float r,
+ float g, float b)
+{
+    for (int i = 0; i < 4; i ++)
+        * v ++ = {corners[i][0], corners[i][1], corners[i][2], r, g, b};
+
+    return v;
 }
 
-static void draw_bar (float x, float z, float h, float r, float g, float b)
+static Vertex * add_rectangle (Vertex * v, float x1, float y1, float z1,
+ float x2, float y2, float z2, float r, float g, float b)
 {
-    draw_rectangle (x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
+    const float top[4][3] = {{x1, y2, z1}, {x2, y2, z1}, {x2, y2, z2}, {x1, y2, z2}};
+    const float left[4][3] = {{x1, y1, z1}, {x1, y2, z1}, {x1, y2, z2}, {x1, y1, z2}};
+    const float right[4][3] = {{x2, y2, z1}, {x2, y1, z1}, {x2, y1, z2}, {x2, y2, z2}};
+    const float front[4][3] = {{x1, y1, z1}, {x2, y1, z1}, {x2, y2, z1}, {x1, y2, z1}};
+
+    v = add_quad (v, top, r, g, b);
+    v = add_quad (v, left, 0.65f * r, 0.65f * g, 0.65f * b);
+    v = add_quad (v, right, 0.65f * r, 0.65f * g, 0.65f * b);
+    return add_quad (v, front, 0.8f * r, 0.8f * g, 0.8f * b);
+}
+
+static Vertex * add_bar (Vertex * v, float x, float z, float h, float r,
+ float g, float b)
+{
+    return add_rectangle (v, x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
      r * (0.2f + 0.8f * h), g * (0.2f + 0.8f * h), b * (0.2f + 0.8f * h));
 }
 
 static void draw_bars ()
 {
-    glPushMatrix ();
-    glTranslatef (0.0f, -0.5f, -5.0f);
-    glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
-    glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
+    Vertex * v = s_vertices;
 
     for (int i = 0; i < NUM_BANDS; i ++)
     {
@@ -238,12 +245,27 @@ static void draw_bars ()
 
         for (int j = 0; j < NUM_BANDS; j ++)
         {
-            draw_bar (1.6f - BAR_SPACING * j, z,
+            v = add_bar (v, 1.6f - BAR_SPACING * j, z,
              s_bars[(s_pos + i) % NUM_BANDS][j] * 1.6,
              colors[i][j][0], colors[i][j][1], colors[i][j][2]);
         }
     }
 
+    glPushMatrix ();
+    glTranslatef (0.0f, -0.5f, -5.0f);
+    glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
+    glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
+
+    glEnableClientState (GL_VERTEX_ARRAY);
+    glEnableClientState (GL_COLOR_ARRAY);
+    glVertexPointer (3, GL_FLOAT, sizeof (Vertex), & s_vertices[0].x);
+    glColorPointer (3, GL_FLOAT, sizeof (Vertex), & s_vertices[0].r);
+
+    glDrawArrays (GL_QUADS, 0, v - s_vertices);
+
+    glDisableClientState (GL_COLOR_ARRAY);
+    glDisableClientState (GL_VERTEX_ARRAY);
+
     glPopMatrix ();
 }
 
@@ -265,8 +287,23 @@ static gboolean draw_cb (GtkWidget * widget)
 
     glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    int64_t start = g_get_monotonic_time ();
+
     draw_bars ();
 
+    /* the time to hand a frame to the driver, for comparing drivers (e.g.
+     * llvmpipe, with LIBGL_ALWAYS_SOFTWARE=1) */
+    static int64_t draw_time = 0;
+    static int draw_count = 0;
+
+    draw_time += g_get_monotonic_time () - start;
+    if (++ draw_count == 256)
+    {
+        AUDDBG ("%d us per frame\n", (int) (draw_time / draw_count));
+        draw_time = 0;
+        draw_count = 0;
+    }
+
 #ifdef GDK_WINDOWING_X11
     glXSwapBuffers (s_display, s_xwindow);
 #endif
@@ -0,0 +1,274 @@
+/*
+ * Seek index files shared by the input plugins
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/playlist.h>
+#include <libaudcore/runtime.h>
+
+#include "index-file.h"
+
+/* a temporary file this old was left behind by a crash */
+#define TEMP_MAX_AGE (24 * 3600)
+
+bool IndexFile::stamp (const char * filename, int64_t & size, int64_t & mtime)
+{
+    StringBuf path = uri_to_filename (filename);
+    struct stat st;
+
+    if (! path || stat (path, & st) < 0)
+        return false;
+
+    size = st.st_size;
+    mtime = st.st_mtime;
+    return true;
+}
+
+StringBuf IndexFile::dir_path ()
+{
+    return str_concat ({aud_get_path (AudPath::UserDir), "/", m_dir});
+}
+
+StringBuf IndexFile::index_path (const char * filename)
+{
+    return str_printf ("%s/%08x", (const char *) dir_path (), str_calc_hash (filename));
+}
+
+bool IndexFile::read_header (FILE * file, String & filename, int64_t stamp[2])
+{
+    char magic[8];
+    int path_len;
+
+    if (fread (magic, 1, 8, file) != 8 || memcmp (magic, m_magic, 8) ||
+     fread (stamp, sizeof (int64_t), 2, file) != 2 ||
+     fread (& path_len, sizeof path_len, 1, file) != 1 || path_len <= 0 || path_len > 65536)
+        return false;
+
+    StringBuf path (path_len);
+    if (fread (path, 1, path_len, file) != (size_t) path_len)
+        return false;
+
+    filename = String (path);
+    return true;
+}
+
+FILE * IndexFile::open (const char * filename)
+{
+    int64_t size, mtime;
+    if (! stamp (filename, size, mtime))
+        return nullptr;
+
+    FILE * file = fopen (index_path (filename), "rb");
+    if (! file)
+        return nullptr;
+
+    String path;
+    int64_t stamp[2];
+
+    /* the path is checked as well, since different paths can have the same hash */
+    if (! read_header (file, path, stamp) || strcmp (path, filename) ||
+     stamp[0] != size || stamp[1] != mtime)
+    {
+        fclose (file);
+        return nullptr;
+    }
+
+    return file;
+}
+
+FILE * IndexFile::create (const char * filename, StringBuf & temp)
+{
+    int64_t stamp[2];
+    if (! IndexFile::stamp (filename, stamp[0], stamp[1]))
+        return nullptr;
+
+    StringBuf dir = dir_path ();
+
+#ifdef _WIN32
+    mkdir (dir);
+#else
+    mkdir (dir, 0755);
+#endif
+
+    /* written to a temporary file and renamed, so that a reader never sees
+     * a partial index */
+    static std::atomic<int> serial (0);
+
+    temp = str_printf ("%s.tmp%d", (const char *) index_path (filename), serial ++);
+
+    FILE * file = fopen (temp, "wb");
+    if (! file)
+        return nullptr;
+
+    int path_len = strlen (filename);
+
+    if (fwrite (m_magic, 1, 8, file) != 8 ||
+     fwrite (stamp, sizeof stamp, 1, file) != 1 ||
+     fwrite (& path_len, sizeof path_len, 1, file) != 1 ||
+     fwrite (filename, 1, path_len, file) != (size_t) path_len)
+    {
+        fclose (file);
+        remove (temp);
+        return nullptr;
+    }
+
+    return file;
+}
+
+bool IndexFile::commit (const char * filename, FILE * file, const char * temp, bool ok)
+{
+    StringBuf path = index_path (filename);
+
+    if (fclose (file) < 0)
+        ok = false;
+
+    if (! ok || rename (temp, path) < 0)
+    {
+        AUDWARN ("Failed to write %s.\n", (const char *) path);
+        remove (temp);
+        return false;
+    }
+
+    if (! m_pruned.exchange (true))
+        prune ();
+
+    return true;
+}
+
+/* deletes the index files of files that have been changed or removed */
+void IndexFile::prune ()
+{
+    StringBuf dir_name = dir_path ();
+    DIR * dir = opendir (dir_name);
+    if (! dir)
+        return;
+
+    int removed = 0;
+    struct dirent * entry;
+
+    while ((entry = readdir (dir)))
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        StringBuf path = str_concat ({dir_name, "/", entry->d_name});
+
+        if (strstr (entry->d_name, ".tmp"))
+        {
+            struct stat st;
+            if (stat (path, & st) < 0 || time (nullptr) - st.st_mtime < TEMP_MAX_AGE)
+                continue;
+        }
+        else
+        {
+            FILE * file = fopen (path, "rb");
+            if (! file)
+                continue;
+
+            String filename;
+            int64_t stamp[2], size, mtime;
+            bool valid = read_header (file, filename, stamp) &&
+             IndexFile::stamp (filename, size, mtime) &&
+             stamp[0] == size && stamp[1] == mtime;
+
+            fclose (file);
+
+            if (valid)
+                continue;
+        }
+
+        if (remove (path) == 0)
+            removed ++;
+    }
+
+    closedir (dir);
+
+    if (removed)
+        AUDDBG ("Removed %d outdated files from %s.\n", removed, (const char *) dir_name);
+}
+
+void IndexFile::queue (const char * filename)
+{
+    int64_t size, mtime;
+    if (! m_build || ! stamp (filename, size, mtime))
+        return;
+
+    String key (filename);
+    std::lock_guard<std::mutex> lock (m_mutex);
+
+    if (m_queued.lookup (key))
+        return;
+
+    m_queued.add (key, true);
+    m_jobs.append (key);
+
+    if (! m_thread.joinable ())
+        m_thread = std::thread (& IndexFile::run, this);
+
+    m_cond.notify_one ();
+}
+
+void IndexFile::run ()
+{
+    std::unique_lock<std::mutex> lock (m_mutex);
+
+    while (! m_quit)
+    {
+        if (! m_jobs.len ())
+        {
+            m_cond.wait (lock);
+            continue;
+        }
+
+        String filename = std::move (m_jobs[0]);
+        m_jobs.remove (0, 1);
+
+        lock.unlock ();
+
+        if (m_build (filename) && ! m_quit)
+            Playlist::rescan_file (filename);
+
+        lock.lock ();
+        m_queued.remove (filename);
+    }
+}
+
+void IndexFile::cleanup ()
+{
+    {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_quit = true;
+        m_cond.notify_one ();
+    }
+
+    if (m_thread.joinable ())
+        m_thread.join ();
+
+    m_jobs.clear ();
+    m_queued.clear ();
+    m_quit = false;
+}
@@ -0,0 +1,114 @@
+/*
+ * Seek index files shared by the input plugins
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef INDEX_COMMON_H
+#define INDEX_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <libaudcore/index.h>
+#include <libaudcore/multihash.h>
+#include <libaudcore/objects.h>
+
+/* A directory of index files in the user's configuration directory, one file
+ * for each local file that has been indexed.  Each index file starts with a
+ * header of the format's magic, the size and modification time of the file
+ * it was made from, and that file's URI:
+ *
+ *   magic (8 bytes), size, mtime, URI length, URI
+ *
+ * An index is only used while the header still matches the file.  What
+ * follows the header is up to the plugin; it is stored in native byte order,
+ * as it never leaves the system.
+ *
+ * Index files whose file has been changed or removed are deleted once in
+ * each session, when the first index is saved.
+ *
+ * Indexes can also be built in a background thread, one file at a time.
+ * When one has been built, the playlist entries of the file are rescanned,
+ * so that read_tag() can pick it up. */
+class IndexFile
+{
+public:
+    /* runs in the background thread; builds and saves the index of a file
+     * and returns true if it was saved */
+    typedef bool (* BuildFunc) (const char * filename);
+
+    /* <dir> is the name of the directory, <magic> is exactly 8 characters */
+    IndexFile (const char * dir, const char * magic, BuildFunc build = nullptr) :
+        m_dir (dir), m_magic (magic), m_build (build) {}
+
+    /* gets the size and modification time of a local file; returns false
+     * for any other kind of URI */
+    static bool stamp (const char * filename, int64_t & size, int64_t & mtime);
+
+    /* opens the index of a file for reading and checks the header; returns
+     * the file positioned after the header, or nullptr if there is no index
+     * or it is out of date */
+    FILE * open (const char * filename);
+
+    /* creates a temporary file for a new index and writes the header;
+     * returns the file positioned after the header */
+    FILE * create (const char * filename, StringBuf & temp);
+
+    /* closes a file returned by create() and, if everything was written
+     * successfully, puts it in place of the old index; returns true if the
+     * index was saved */
+    bool commit (const char * filename, FILE * file, const char * temp, bool ok);
+
+    /* queues a local file for the BuildFunc, unless it is already queued */
+    void queue (const char * filename);
+
+    /* set when the background thread is to stop; the BuildFunc should then
+     * give up as soon as it can */
+    const std::atomic<bool> & stopping () const
+        { return m_quit; }
+
+    /* stops the background thread; to be called from the plugin's cleanup() */
+    void cleanup ();
+
+private:
+    StringBuf dir_path ();
+    StringBuf index_path (const char * filename);
+    bool read_header (FILE * file, String & filename, int64_t stamp[2]);
+    void prune ();
+    void run ();
+
+    const char * m_dir;
+    const char * m_magic;
+    BuildFunc m_build;
+
+    std::atomic<bool> m_pruned {false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    std::atomic<bool> m_quit {false};
+
+    Index<String> m_jobs;
+    SimpleHash<String, bool> m_queued; /* the jobs, and the current one */
+};
+
+#endif
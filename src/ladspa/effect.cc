@@ -18,6 +18,11 @@
  */
 
 #include <assert.h>
+#include <inttypes.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 #include "ladspa.h"
 #include "plugin.h"
@@ -26,6 +31,230 @@
 
 static int ladspa_channels, ladspa_rate;
 
+/* The audio is deinterleaved once on entering the chain and interleaved once
+ * on leaving it.  In between, each channel is kept in one of two planar
+ * buffers.  Plugins that can process in place read and write the same buffer;
+ * others write to the second buffer, which then holds the channel. */
+static Index<float> planar[2];
+static Index<char> current;
+
+static float * channel_buf (int which, int channel)
+{
+    return planar[which].begin () + LADSPA_BUFLEN * channel;
+}
+
+/* Optionally, the instances of a plugin (one for each group of channels) are
+ * run at the same time by a pool of threads, with the audio thread taking
+ * part.  The audio thread waits for all of them before going on to the next
+ * plugin.  Blocks shorter than PARALLEL_MIN_FRAMES are run serially, since
+ * handing them out would cost more than it saves. */
+#define PARALLEL_MIN_FRAMES 256
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done_cond = PTHREAD_COND_INITIALIZER;
+static Index<pthread_t> pool_threads;
+static bool pool_quit;
+
+static LoadedPlugin * job_loaded;
+static int job_frames, job_next, job_count, job_pending;
+
+/* statistics, logged when the pool is shut down */
+static int64_t pool_jobs, pool_wait_us;
+
+static void run_instance (LoadedPlugin & loaded, int i, int frames)
+{
+    PluginData & plugin = loaded.plugin;
+    const LADSPA_Descriptor & desc = plugin.desc;
+    LADSPA_Handle handle = loaded.instances[i];
+
+    int ports = plugin.in_ports.len ();
+    bool inplace = ! LADSPA_IS_INPLACE_BROKEN (desc.Properties);
+
+    for (int p = 0; p < ports; p ++)
+    {
+        int channel = ports * i + p;
+        int in = current[channel];
+        int out = inplace ? in : ! in;
+
+        desc.connect_port (handle, plugin.in_ports[p], channel_buf (in, channel));
+        desc.connect_port (handle, plugin.out_ports[p], channel_buf (out, channel));
+    }
+
+    desc.run (handle, frames);
+}
+
+/* called with pool_mutex locked */
+static void run_jobs_locked ()
+{
+    while (job_next < job_count)
+    {
+        int i = job_next ++;
+
+        pthread_mutex_unlock (& pool_mutex);
+        run_instance (* job_loaded, i, job_frames);
+        pthread_mutex_lock (& pool_mutex);
+
+        if (! -- job_pending)
+            pthread_cond_signal (& pool_done_cond);
+    }
+}
+
+static void * pool_worker (void *)
+{
+    pthread_mutex_lock (& pool_mutex);
+
+    while (! pool_quit)
+    {
+        if (job_next < job_count)
+            run_jobs_locked ();
+        else
+            pthread_cond_wait (& pool_work_cond, & pool_mutex);
+    }
+
+    pthread_mutex_unlock (& pool_mutex);
+    return nullptr;
+}
+
+static void run_parallel (LoadedPlugin & loaded, int frames)
+{
+    pthread_mutex_lock (& pool_mutex);
+
+    job_loaded = & loaded;
+    job_frames = frames;
+    job_next = 0;
+    job_count = job_pending = loaded.instances.len ();
+
+    pthread_cond_broadcast (& pool_work_cond);
+    run_jobs_locked ();
+
+    int64_t wait_start = g_get_monotonic_time ();
+
+    while (job_pending)
+        pthread_cond_wait (& pool_done_cond, & pool_mutex);
+
+    pool_jobs ++;
+    pool_wait_us += g_get_monotonic_time () - wait_start;
+
+    job_loaded = nullptr;
+    job_count = 0;
+
+    pthread_mutex_unlock (& pool_mutex);
+}
+
+static void start_pool (int threads)
+{
+    if (pool_threads.len () == threads)
+        return;
+
+    shutdown_pool ();
+
+    for (int i = 0; i < threads; i ++)
+    {
+        pthread_t thread;
+        if (pthread_create (& thread, nullptr, pool_worker, nullptr))
+        {
+            AUDERR ("Failed to create worker thread.\n");
+            break;
+        }
+
+        pool_threads.append (thread);
+    }
+}
+
+void shutdown_pool ()
+{
+    if (! pool_threads.len ())
+        return;
+
+    pthread_mutex_lock (& pool_mutex);
+    pool_quit = true;
+    pthread_cond_broadcast (& pool_work_cond);
+    pthread_mutex_unlock (& pool_mutex);
+
+    for (pthread_t thread : pool_threads)
+        pthread_join (thread, nullptr);
+
+    AUDDBG ("%d worker threads ran %" PRId64 " plugin blocks, waiting %d us "
+     "per block on average.\n", pool_threads.len (), pool_jobs,
+     pool_jobs ? (int) (pool_wait_us / pool_jobs) : 0);
+
+    pool_threads.clear ();
+    pool_quit = false;
+    pool_jobs = pool_wait_us = 0;
+}
+
+static void deinterleave (const float * data, int frames)
+{
+    for (int c = 0; c < ladspa_channels; c ++)
+        current[c] = 0;
+
+    int f = 0;
+
+#ifdef __SSE__
+    if (ladspa_channels == 2)
+    {
+        float * left = channel_buf (0, 0);
+        float * right = channel_buf (0, 1);
+
+        for (; f + 4 <= frames; f += 4)
+        {
+            __m128 a = _mm_loadu_ps (data + 2 * f);
+            __m128 b = _mm_loadu_ps (data + 2 * f + 4);
+            _mm_storeu_ps (left + f, _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+            _mm_storeu_ps (right + f, _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+        }
+    }
+#endif
+
+    for (int c = 0; c < ladspa_channels; c ++)
+    {
+        const float * get = data + ladspa_channels * f + c;
+        float * in = channel_buf (0, c) + f;
+        float * in_end = channel_buf (0, c) + frames;
+
+        while (in < in_end)
+        {
+            * in ++ = * get;
+            get += ladspa_channels;
+        }
+    }
+}
+
+static void interleave (float * data, int frames)
+{
+    int f = 0;
+
+#ifdef __SSE__
+    if (ladspa_channels == 2)
+    {
+        const float * left = channel_buf (current[0], 0);
+        const float * right = channel_buf (current[1], 1);
+
+        for (; f + 4 <= frames; f += 4)
+        {
+            __m128 l = _mm_loadu_ps (left + f);
+            __m128 r = _mm_loadu_ps (right + f);
+            _mm_storeu_ps (data + 2 * f, _mm_unpacklo_ps (l, r));
+            _mm_storeu_ps (data + 2 * f + 4, _mm_unpackhi_ps (l, r));
+        }
+    }
+#endif
+
+    for (int c = 0; c < ladspa_channels; c ++)
+    {
+        float * set = data + ladspa_channels * f + c;
+        const float * out = channel_buf (current[c], c) + f;
+        const float * out_end = channel_buf (current[c], c) + frames;
+
+        while (out < out_end)
+        {
+            * set = * out ++;
+            set += ladspa_channels;
+        }
+    }
+}
+
 static void start_plugin (LoadedPlugin & loaded)
 {
     if (loaded.active)
@@ -53,9 +282,6 @@ static void start_plugin (LoadedPlugin & loaded)
 
     int instances = ladspa_channels / ports;
 
-    loaded.in_bufs.insert (0, ladspa_channels);
-    loaded.out_bufs.insert (0, ladspa_channels);
-
     for (int i = 0; i < instances; i ++)
     {
         LADSPA_Handle handle = desc.instantiate (& desc, ladspa_rate);
@@ -65,17 +291,12 @@ static void start_plugin (LoadedPlugin & loaded)
         for (int c = 0; c < controls; c ++)
             desc.connect_port (handle, plugin.controls[c].port, & loaded.values[c]);
 
+        /* the audio ports are connected again before each run */
         for (int p = 0; p < ports; p ++)
         {
             int channel = ports * i + p;
-
-            Index<float> & in = loaded.in_bufs[channel];
-            in.insert (0, LADSPA_BUFLEN);
-            desc.connect_port (handle, plugin.in_ports[p], in.begin ());
-
-            Index<float> & out = loaded.out_bufs[channel];
-            out.insert (0, LADSPA_BUFLEN);
-            desc.connect_port (handle, plugin.out_ports[p], out.begin ());
+            desc.connect_port (handle, plugin.in_ports[p], channel_buf (0, channel));
+            desc.connect_port (handle, plugin.out_ports[p], channel_buf (1, channel));
         }
 
         if (desc.activate)
@@ -83,56 +304,55 @@ static void start_plugin (LoadedPlugin & loaded)
     }
 }
 
-static void run_plugin (LoadedPlugin & loaded, float * data, int samples)
+static void run_plugin (LoadedPlugin & loaded, int frames)
 {
     if (! loaded.instances.len ())
         return;
 
-    PluginData & plugin = loaded.plugin;
-    const LADSPA_Descriptor & desc = plugin.desc;
+    const LADSPA_Descriptor & desc = loaded.plugin.desc;
 
-    int ports = plugin.in_ports.len ();
     int instances = loaded.instances.len ();
-    assert (ports * instances == ladspa_channels);
+    assert (loaded.plugin.in_ports.len () * instances == ladspa_channels);
+
+    if (instances > 1 && pool_threads.len () && frames >= PARALLEL_MIN_FRAMES)
+        run_parallel (loaded, frames);
+    else
+    {
+        for (int i = 0; i < instances; i ++)
+            run_instance (loaded, i, frames);
+    }
+
+    if (LADSPA_IS_INPLACE_BROKEN (desc.Properties))
+    {
+        for (int c = 0; c < ladspa_channels; c ++)
+            current[c] = ! current[c];
+    }
+}
+
+static void run_chain (float * data, int samples)
+{
+    bool any = false;
+
+    for (auto & loaded : loadeds)
+    {
+        start_plugin (* loaded);
+        if (loaded->instances.len ())
+            any = true;
+    }
+
+    if (! any)
+        return;
 
     while (samples / ladspa_channels > 0)
     {
         int frames = aud::min (samples / ladspa_channels, LADSPA_BUFLEN);
 
-        for (int i = 0; i < instances; i ++)
-        {
-            LADSPA_Handle handle = loaded.instances[i];
-
-            for (int p = 0; p < ports; p ++)
-            {
-                int channel = ports * i + p;
-                float * get = data + channel;
-                float * in = loaded.in_bufs[channel].begin ();
-                float * in_end = in + frames;
-
-                while (in < in_end)
-                {
-                    * in ++ = * get;
-                    get += ladspa_channels;
-                }
-            }
-
-            desc.run (handle, frames);
-
-            for (int p = 0; p < ports; p ++)
-            {
-                int channel = ports * i + p;
-                float * set = data + channel;
-                float * out = loaded.out_bufs[channel].begin ();
-                float * out_end = out + frames;
-
-                while (out < out_end)
-                {
-                    * set = * out ++;
-                    set += ladspa_channels;
-                }
-            }
-        }
+        deinterleave (data, frames);
+
+        for (auto & loaded : loadeds)
+            run_plugin (* loaded, frames);
+
+        interleave (data, frames);
 
         data += ladspa_channels * frames;
         samples -= ladspa_channels * frames;
@@ -181,8 +401,6 @@ void shutdown_plugin_locked (LoadedPlugin & loaded)
     }
 
     loaded.instances.clear ();
-    loaded.in_bufs.clear ();
-    loaded.out_bufs.clear ();
 }
 
 void LADSPAHost::start (int & channels, int & rate)
@@ -195,6 +413,21 @@ void LADSPAHost::start (int & channels, int & rate)
     ladspa_channels = channels;
     ladspa_rate = rate;
 
+    for (auto & buf : planar)
+    {
+        buf.clear ();
+        buf.insert (0, LADSPA_BUFLEN * channels);
+    }
+
+    current.clear ();
+    current.insert (0, channels);
+
+    /* the audio thread counts as one of the threads */
+    if (aud_get_bool ("ladspa", "parallel"))
+        start_pool (aud::min (channels, (int) g_get_num_processors ()) - 1);
+    else
+        shutdown_pool ();
+
     pthread_mutex_unlock (& mutex);
 }
 
@@ -202,11 +435,7 @@ Index<float> & LADSPAHost::process (Index<float> & data)
 {
     pthread_mutex_lock (& mutex);
 
-    for (auto & loaded : loadeds)
-    {
-        start_plugin (* loaded);
-        run_plugin (* loaded, data.begin (), data.len ());
-    }
+    run_chain (data.begin (), data.len ());
 
     pthread_mutex_unlock (& mutex);
     return data;
@@ -227,12 +456,11 @@ Index<float> & LADSPAHost::finish (Index<float> & data, bool end_of_playlist)
 {
     pthread_mutex_lock (& mutex);
 
-    for (auto & loaded : loadeds)
-    {
-        start_plugin (* loaded);
-        run_plugin (* loaded, data.begin (), data.len ());
+    run_chain (data.begin (), data.len ());
 
-        if (end_of_playlist)
+    if (end_of_playlist)
+    {
+        for (auto & loaded : loadeds)
             shutdown_plugin_locked (* loaded);
     }
 
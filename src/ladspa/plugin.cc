@@ -37,6 +37,7 @@
 
 const char * const LADSPAHost::defaults[] = {
  "plugin_count", "0",
+ "parallel", "FALSE",
  nullptr};
 
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -329,6 +330,8 @@ void LADSPAHost::cleanup ()
 
     module_path = String ();
 
+    shutdown_pool ();
+
     pthread_mutex_unlock (& mutex);
 }
 
@@ -561,7 +564,9 @@ const char LADSPAHost::about[] =
     "Copyright 2011 John Lindgren");
 
 const PreferencesWidget LADSPAHost::widgets[] = {
-    WidgetCustomGTK (make_config_widget)
+    WidgetCustomGTK (make_config_widget),
+    WidgetCheck (N_("Run the channels of each plugin in parallel"),
+        WidgetBool ("ladspa", "parallel"))
 };
 
 const PluginPreferences LADSPAHost::prefs = {{widgets}};
@@ -59,7 +59,6 @@ struct LoadedPlugin
     bool selected = false;
     bool active = false;
     Index<LADSPA_Handle> instances;
-    Index<Index<float>> in_bufs, out_bufs;
     GtkWidget * settings_win = nullptr;
 
     LoadedPlugin (PluginData & plugin) :
@@ -113,6 +112,7 @@ void disable_plugin_locked (LoadedPlugin & loaded);
 /* effect.c */
 
 void shutdown_plugin_locked (LoadedPlugin & loaded);
+void shutdown_pool ();
 
 /* plugin-list.c */
 
@@ -0,0 +1,230 @@
+/*
+ * Song length detection shared by the emulated input plugins
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/playlist.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/templates.h>
+#include <libaudcore/vfs.h>
+
+#include "lengths.h"
+
+/* The cache file is a list of lines "key length", which is only ever appended
+ * to.  The lines are short enough to be written in one go, so several
+ * plugins can append to it at once. */
+#define CACHE_FILE "detected-lengths"
+
+#define SILENCE_TIME 6 /* seconds */
+#define SILENCE_LEVEL 16
+
+bool SilenceDetector::process (const int16_t * samples, int count, int channels)
+{
+    if (m_ended)
+        return true;
+
+    int peak = 0;
+    for (int i = 0; i < count; i ++)
+        peak = aud::max (peak, abs (samples[i]));
+
+    m_frames += count / channels;
+
+    if (peak > SILENCE_LEVEL)
+        m_last_sound = m_frames;
+    else if (m_last_sound >= 0 && m_frames - m_last_sound >= (int64_t) SILENCE_TIME * m_rate)
+        m_ended = true;
+
+    return m_ended;
+}
+
+void SilenceDetector::seek (int time)
+{
+    m_frames = (int64_t) time * m_rate / 1000;
+    m_last_sound = m_frames;
+    m_seeked = true;
+}
+
+static StringBuf cache_path ()
+{
+    return str_concat ({aud_get_path (AudPath::UserDir), "/" CACHE_FILE});
+}
+
+String LengthCache::make_key (const Index<char> & data, int track)
+{
+    if (! data.len ())
+        return String ();
+
+    /* 64-bit FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char c : data)
+    {
+        hash ^= (unsigned char) c;
+        hash *= 0x100000001b3;
+    }
+
+    return String (str_printf ("%016llx-%d-%d", (unsigned long long) hash,
+     data.len (), track));
+}
+
+String LengthCache::make_key (VFSFile & file, int track)
+{
+    if (file.fseek (0, VFS_SEEK_SET) < 0)
+        return String ();
+
+    return make_key (file.read_all (), track);
+}
+
+/* called with m_mutex held */
+void LengthCache::load ()
+{
+    m_loaded = true;
+
+    FILE * f = fopen (cache_path (), "r");
+    if (! f)
+        return;
+
+    char key[64];
+    int length;
+
+    while (fscanf (f, "%63s %d", key, & length) == 2)
+        m_lengths.add (String (key), aud::max (length, -1));
+
+    fclose (f);
+}
+
+bool LengthCache::lookup (const String & key, int & length)
+{
+    std::lock_guard<std::mutex> lock (m_mutex);
+
+    if (! m_loaded)
+        load ();
+
+    int * cached = m_lengths.lookup (key);
+    if (! cached)
+        return false;
+
+    length = * cached;
+    return true;
+}
+
+void LengthCache::store (const String & key, int length)
+{
+    if (! key)
+        return;
+
+    std::lock_guard<std::mutex> lock (m_mutex);
+
+    if (! m_loaded)
+        load ();
+
+    length = aud::max (length, -1);
+
+    int * cached = m_lengths.lookup (key);
+    if (cached && * cached == length)
+        return;
+
+    m_lengths.add (key, int (length));
+
+    FILE * f = fopen (cache_path (), "a");
+    if (! f)
+        return;
+
+    fprintf (f, "%s %d\n", (const char *) key, length);
+    fclose (f);
+}
+
+void LengthCache::queue (const char * filename, const String & key)
+{
+    if (! key)
+        return;
+
+    std::lock_guard<std::mutex> lock (m_mutex);
+
+    if (m_queued.lookup (key))
+        return;
+
+    m_queued.add (key, true);
+
+    Job & job = m_jobs.append ();
+    job.filename = String (filename);
+    job.key = key;
+
+    if (! m_thread.joinable ())
+        m_thread = std::thread (& LengthCache::run, this);
+
+    m_cond.notify_one ();
+}
+
+void LengthCache::run ()
+{
+    std::unique_lock<std::mutex> lock (m_mutex);
+
+    while (! m_quit)
+    {
+        if (! m_jobs.len ())
+        {
+            m_cond.wait (lock);
+            continue;
+        }
+
+        Job job = std::move (m_jobs[0]);
+        m_jobs.remove (0, 1);
+
+        lock.unlock ();
+
+        int length = m_detect (job.filename);
+
+        if (length != Retry)
+        {
+            AUDDBG ("Detected length of %s: %d ms\n", (const char *) job.filename, length);
+            store (job.key, length);
+
+            if (length >= 0)
+                Playlist::rescan_file (job.filename);
+        }
+
+        lock.lock ();
+
+        /* an interrupted job goes to the back of the queue */
+        if (length == Retry)
+            m_jobs.append (std::move (job));
+        else
+            m_queued.remove (job.key);
+    }
+}
+
+void LengthCache::cleanup ()
+{
+    {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_quit = true;
+        m_cond.notify_one ();
+    }
+
+    if (m_thread.joinable ())
+        m_thread.join ();
+
+    m_jobs.clear ();
+    m_queued.clear ();
+    m_lengths.clear ();
+    m_loaded = false;
+    m_quit = false;
+}
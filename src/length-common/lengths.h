@@ -0,0 +1,142 @@
+/*
+ * Song length detection shared by the emulated input plugins
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef LENGTH_COMMON_H
+#define LENGTH_COMMON_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <libaudcore/index.h>
+#include <libaudcore/multihash.h>
+#include <libaudcore/objects.h>
+
+class VFSFile;
+
+/* Finds the end of a song that has no length information from the level of
+ * its audio: the song ends with the last sound before six seconds of silence.
+ * Only the peak of each block is looked at, which costs next to nothing
+ * compared to the emulation. */
+class SilenceDetector
+{
+public:
+    explicit SilenceDetector (int rate) : m_rate (rate) {}
+
+    /* feeds a block of 16-bit samples (count is in samples, not frames);
+     * returns true once the silence is long enough to end the song */
+    bool process (const int16_t * samples, int count, int channels = 2);
+
+    /* continues counting from a new position (in milliseconds); the end of
+     * the song is then no longer known exactly */
+    void seek (int time);
+
+    bool ended () const
+        { return m_ended; }
+    bool exact () const
+        { return ! m_seeked; }
+
+    /* in milliseconds */
+    int position () const
+        { return m_frames * 1000 / m_rate; }
+    int length () const
+        { return (m_last_sound >= 0) ? m_last_sound * 1000 / m_rate : -1; }
+
+private:
+    int m_rate;
+    int64_t m_frames = 0, m_last_sound = -1;
+    bool m_ended = false, m_seeked = false;
+};
+
+/* A cache of detected song lengths, kept in the user's configuration
+ * directory and shared by all the plugins that use it.  Songs are keyed by a
+ * hash of the file contents and the track number, so that a renamed or
+ * copied file is still found and a changed one is analyzed again.
+ *
+ * Songs that are not in the cache can be queued for analysis, which happens
+ * in a background thread, one song at a time.  When a length is found, the
+ * playlist entries of the file are rescanned, so that read_tag() picks it up
+ * from the cache. */
+class LengthCache
+{
+public:
+    /* returned by a DetectFunc that was interrupted and should be run again
+     * later; any other negative result means that the song has no length */
+    static constexpr int Retry = -2;
+
+    /* how far to look for the end of a song, in milliseconds, for formats
+     * that have no default song length of their own */
+    static constexpr int Limit = 10 * 60 * 1000;
+
+    /* runs in the background thread; returns the length in milliseconds */
+    typedef int (* DetectFunc) (const char * filename);
+
+    explicit LengthCache (DetectFunc detect) : m_detect (detect) {}
+
+    /* the key of a track of a file, or an empty string if the file cannot be
+     * read; the VFSFile version reads the file from the beginning */
+    static String make_key (const Index<char> & data, int track);
+    static String make_key (VFSFile & file, int track);
+
+    /* returns false if the track is not in the cache; otherwise, length is
+     * set to the cached length, or to -1 if the track has been analyzed and
+     * no length was found */
+    bool lookup (const String & key, int & length);
+
+    /* adds a length found some other way (e.g. during playback) */
+    void store (const String & key, int length);
+
+    /* queues a track for analysis, unless it is already queued */
+    void queue (const char * filename, const String & key);
+
+    /* true when the background thread is to stop; a DetectFunc should then
+     * return Retry as soon as it can */
+    bool stopping () const
+        { return m_quit; }
+
+    /* stops the background thread and forgets the cache; to be called from
+     * the plugin's cleanup() */
+    void cleanup ();
+
+private:
+    struct Job {
+        String filename, key;
+    };
+
+    void load ();
+    void run ();
+
+    DetectFunc m_detect;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    std::atomic<bool> m_quit {false};
+
+    bool m_loaded = false;
+    SimpleHash<String, int> m_lengths;
+
+    Index<Job> m_jobs;
+    SimpleHash<String, bool> m_queued; /* keys of the jobs, and the current one */
+};
+
+#endif
@@ -17,8 +17,7 @@
  * the use of this software.
  */
 
-/* TODO: implement more surround converters.
-         There should be more options for in * out cases (for example,
+/* TODO: There should be more options for in * out cases (for example,
          the user may wish to mix stereo up to quadro but keep 5.1 as-is,
          rather than downmixing 5.1 to quadro). A possible design might
          be a choice of output channels for each input channel count that
@@ -26,6 +25,7 @@
 
 #include <stdlib.h>
 
+#include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
@@ -58,186 +58,304 @@ public:
 
 EXPORT ChannelMixer aud_plugin_instance;
 
-typedef Index<float> & (* Converter) (Index<float> & data);
+/* Every conversion is a matrix multiplication: each output channel is a
+ * weighted sum of the input channels.  The matrix is stored row by row, one
+ * row for each output channel. */
 
-static Index<float> mixer_buf;
+typedef void (* MixFunc) (const float * get, float * set, int frames,
+ const float * matrix);
 
-static Index<float> & mono_to_stereo (Index<float> & data)
-{
-    int frames = data.len ();
-    mixer_buf.resize (2 * frames);
+struct MixPreset {
+    int in, out;
+    const float * matrix;
+};
 
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+static const float mono_to_stereo[] = {
+    1,
+    1
+};
 
-    while (frames --)
+static const float stereo_to_mono[] = {
+    0.5, 0.5
+};
+
+static const float stereo_to_quadro[] = {
+    1, 0,  // front left
+    0, 1,  // front right
+    1, 0,  // rear left
+    0, 1   // rear right
+};
+
+static const float quadro_to_stereo[] = {
+    1, 0, 0.7, 0,
+    0, 1, 0, 0.7
+};
+
+/* 5 channels case. Quad + center channel */
+static const float quadro_5_to_stereo[] = {
+    1, 0, 0.5, 1, 0,
+    0, 1, 0.5, 0, 1
+};
+
+static const float stereo_to_surround_5p1[] = {
+    1, 0,      // front left
+    0, 1,      // front right
+    0.5, 0.5,  // center
+    0, 0,      // LFE
+    1, 0,      // rear left
+    0, 1       // rear right
+};
+
+static const float surround_5p1_to_stereo[] = {
+    1, 0, 0.5, 0.5, 0.5, 0,
+    0, 1, 0.5, 0.5, 0, 0.5
+};
+
+static const float surround_7p1_to_stereo[] = {
+    1, 0, 0.5, 0.5, 0.5, 0, 0.5, 0,
+    0, 1, 0.5, 0.5, 0, 0.5, 0, 0.5
+};
+
+/* ITU-R BS.775 downmix: center and surrounds at -3 dB, LFE discarded */
+static const float itu_5p1_to_stereo[] = {
+    1, 0, 0.7071, 0, 0.7071, 0,
+    0, 1, 0.7071, 0, 0, 0.7071
+};
+
+static const float itu_7p1_to_stereo[] = {
+    1, 0, 0.7071, 0, 0.7071, 0, 0.7071, 0,
+    0, 1, 0.7071, 0, 0, 0.7071, 0, 0.7071
+};
+
+static const float surround_7p1_to_5p1[] = {
+    1, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 0, 0, 0, 0, 0, 0,
+    0, 0, 1, 0, 0, 0, 0, 0,
+    0, 0, 0, 1, 0, 0, 0, 0,
+    0, 0, 0, 0, 0.7071, 0, 0.7071, 0,
+    0, 0, 0, 0, 0, 0.7071, 0, 0.7071
+};
+
+static const MixPreset presets[] = {
+    {1, 2, mono_to_stereo},
+    {2, 1, stereo_to_mono},
+    {2, 4, stereo_to_quadro},
+    {4, 2, quadro_to_stereo},
+    {5, 2, quadro_5_to_stereo},
+    {2, 6, stereo_to_surround_5p1},
+    {6, 2, surround_5p1_to_stereo},
+    {8, 2, surround_7p1_to_stereo},
+    {8, 6, surround_7p1_to_5p1}
+};
+
+static const MixPreset itu_presets[] = {
+    {6, 2, itu_5p1_to_stereo},
+    {8, 2, itu_7p1_to_stereo}
+};
+
+/* With the channel counts known at compile time, the compiler can unroll the
+ * inner loops and keep the whole matrix in registers. */
+template<int In, int Out>
+static void mix_fixed (const float * get, float * set, int frames,
+ const float * matrix)
+{
+    float m[Out][In];
+    for (int o = 0; o < Out; o ++)
     {
-        float val = * get ++;
-        * set ++ = val;
-        * set ++ = val;
+        for (int i = 0; i < In; i ++)
+            m[o][i] = matrix[In * o + i];
     }
 
-    return mixer_buf;
-}
+    while (frames --)
+    {
+        for (int o = 0; o < Out; o ++)
+        {
+            float sum = 0;
+            for (int i = 0; i < In; i ++)
+                sum += m[o][i] * get[i];
 
-static Index<float> & stereo_to_mono (Index<float> & data)
-{
-    int frames = data.len () / 2;
-    mixer_buf.resize (frames);
+            set[o] = sum;
+        }
 
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+        get += In;
+        set += Out;
+    }
+}
 
+static int input_channels, output_channels;
+
+static void mix_generic (const float * get, float * set, int frames,
+ const float * matrix)
+{
     while (frames --)
     {
-        float val = * get ++;
-        val += * get ++;
-        * set ++ = val / 2;
-    }
+        const float * row = matrix;
 
-    return mixer_buf;
+        for (int o = 0; o < output_channels; o ++)
+        {
+            float sum = 0;
+            for (int i = 0; i < input_channels; i ++)
+                sum += row[i] * get[i];
+
+            set[o] = sum;
+            row += input_channels;
+        }
+
+        get += input_channels;
+        set += output_channels;
+    }
 }
 
-static Index<float> & quadro_to_stereo (Index<float> & data)
+static MixFunc get_mix_func (int in, int out)
 {
-    int frames = data.len () / 4;
-    mixer_buf.resize (2 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+    static const struct {
+        int in, out;
+        MixFunc func;
+    } funcs[] = {
+        {1, 2, mix_fixed<1, 2>},
+        {2, 1, mix_fixed<2, 1>},
+        {2, 4, mix_fixed<2, 4>},
+        {4, 2, mix_fixed<4, 2>},
+        {5, 2, mix_fixed<5, 2>},
+        {2, 6, mix_fixed<2, 6>},
+        {6, 2, mix_fixed<6, 2>},
+        {8, 2, mix_fixed<8, 2>},
+        {8, 6, mix_fixed<8, 6>}
+    };
 
-    while (frames --)
+    for (auto & f : funcs)
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float back_left   = * get ++;
-        float back_right  = * get ++;
-        * set ++ = front_left + (back_left * 0.7);
-        * set ++ = front_right + (back_right * 0.7);
+        if (f.in == in && f.out == out)
+            return f.func;
     }
 
-    return mixer_buf;
+    return mix_generic;
 }
 
-static Index<float> & stereo_to_quadro (Index<float> & data)
+/* checks that a weight is a plain decimal number, since str_to_double()
+ * stops at the first character it doesn't understand */
+static bool is_weight (const char * text)
 {
-    int frames = data.len () / 2;
-    mixer_buf.resize (4 * frames);
+    if (* text == '-' || * text == '+')
+        text ++;
 
-    float * get = data.begin ();
-    float * set = mixer_buf.begin();
+    bool digits = false, point = false;
 
-    while (frames --)
+    for (; * text; text ++)
     {
-        float left  = * get ++;
-        float right = * get ++;
-        * set ++ = left;   // front left
-        * set ++ = right;  // front right
-        * set ++ = left;   // rear left
-        * set ++ = right;  // rear right
+        if (* text >= '0' && * text <= '9')
+            digits = true;
+        else if (* text == '.' && ! point)
+            point = true;
+        else
+            return false;
     }
 
-    return mixer_buf;
+    return digits;
 }
 
-static Index<float> & surround_5p1_to_stereo (Index<float> & data)
+/* The custom matrix is given as one row per output channel, separated by
+ * semicolons, each with one comma-separated weight per input channel.
+ * Spaces around the weights are allowed. */
+static bool parse_matrix (const char * text, int in, int out, Index<float> & matrix)
 {
-    int frames = data.len () / 6;
-    mixer_buf.resize (2 * frames);
+    Index<String> rows = str_list_to_index (text, ";");
+    if (rows.len () != out)
+        return false;
 
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+    matrix.clear ();
 
-    while (frames --)
+    for (const String & row : rows)
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float center = * get ++;
-        float lfe    = * get ++;
-        float rear_left   = * get ++;
-        float rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + (lfe * 0.5) + (rear_left * 0.5);
-        * set ++ = front_right + (center * 0.5) + (lfe * 0.5) + (rear_right * 0.5);
+        Index<String> weights = str_list_to_index (row, ", ");
+        if (weights.len () != in)
+            return false;
+
+        for (const String & weight : weights)
+        {
+            if (! is_weight (weight))
+            {
+                AUDWARN ("Invalid weight in custom matrix: %s\n", (const char *) weight);
+                return false;
+            }
+
+            matrix.append (str_to_double (weight));
+        }
     }
 
-    return mixer_buf;
+    return true;
 }
 
-/* 5 channels case. Quad + center channel */
-static Index<float> & quadro_5_to_stereo (Index<float> & data)
+static bool find_preset (const MixPreset * list, int count, int in, int out,
+ Index<float> & matrix)
 {
-    int frames = data.len () / 5;
-    mixer_buf.resize (2 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
-
-    while (frames --)
+    for (int i = 0; i < count; i ++)
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float center = * get ++;
-        float rear_left   = * get ++;
-        float rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + rear_left;
-        * set ++ = front_right + (center * 0.5) + rear_right;
+        if (list[i].in == in && list[i].out == out)
+        {
+            matrix.clear ();
+            matrix.insert (list[i].matrix, 0, in * out);
+            return true;
+        }
     }
 
-    return mixer_buf;
+    return false;
 }
 
-static Converter get_converter (int in, int out)
+static bool find_matrix (int in, int out, Index<float> & matrix)
 {
-    if (in == 1 && out == 2)
-        return mono_to_stereo;
-    if (in == 2 && out == 1)
-        return stereo_to_mono;
-    if (in == 2 && out == 4)
-        return stereo_to_quadro;
-    if (in == 4 && out == 2)
-        return quadro_to_stereo;
-    if (in == 5 && out == 2)
-        return quadro_5_to_stereo;
-    if (in == 6 && out == 2)
-        return surround_5p1_to_stereo;
-
-    return nullptr;
+    String custom = aud_get_str ("mixer", "custom_matrix");
+    if (custom[0] && parse_matrix (custom, in, out, matrix))
+        return true;
+
+    if (aud_get_bool ("mixer", "itu_downmix") && find_preset (itu_presets,
+     aud::n_elems (itu_presets), in, out, matrix))
+        return true;
+
+    return find_preset (presets, aud::n_elems (presets), in, out, matrix);
 }
 
-static int input_channels, output_channels;
+static Index<float> mixer_buf;
+static Index<float> mix_matrix;
+static MixFunc mix_func;
 
 void ChannelMixer::start (int & channels, int & rate)
 {
     input_channels = channels;
     output_channels = aud_get_int ("mixer", "channels");
+    mix_func = nullptr;
 
     if (input_channels == output_channels)
         return;
 
-    if (! get_converter (input_channels, output_channels))
+    if (! find_matrix (input_channels, output_channels, mix_matrix))
     {
         AUDERR ("Converting %d to %d channels is not implemented.\n",
          input_channels, output_channels);
         return;
     }
 
+    mix_func = get_mix_func (input_channels, output_channels);
     channels = output_channels;
 }
 
 Index<float> & ChannelMixer::process (Index<float> & data)
 {
-    if (input_channels == output_channels)
+    if (! mix_func)
         return data;
 
-    Converter converter = get_converter (input_channels, output_channels);
-    if (converter)
-        return converter (data);
+    int frames = data.len () / input_channels;
+    mixer_buf.resize (output_channels * frames);
 
-    return data;
+    mix_func (data.begin (), mixer_buf.begin (), frames, mix_matrix.begin ());
+
+    return mixer_buf;
 }
 
 const char * const ChannelMixer::defaults[] = {
  "channels", "2",
+ "itu_downmix", "FALSE",
+ "custom_matrix", "",
   nullptr};
 
 bool ChannelMixer::init ()
@@ -249,6 +367,7 @@ bool ChannelMixer::init ()
 void ChannelMixer::cleanup ()
 {
     mixer_buf.clear ();
+    mix_matrix.clear ();
 }
 
 const char ChannelMixer::about[] =
@@ -259,7 +378,14 @@ const PreferencesWidget ChannelMixer::widgets[] = {
     WidgetLabel (N_("<b>Channel Mixer</b>")),
     WidgetSpin (N_("Output channels:"),
         WidgetInt ("mixer", "channels"),
-        {1, AUD_MAX_CHANNELS, 1})
+        {1, AUD_MAX_CHANNELS, 1}),
+    WidgetCheck (N_("Use ITU-R BS.775 coefficients to downmix surround"),
+        WidgetBool ("mixer", "itu_downmix")),
+    WidgetEntry (N_("Custom matrix:"),
+        WidgetString ("mixer", "custom_matrix")),
+    WidgetLabel (N_("<small>One row for each output channel, separated by "
+     "semicolons,\nwith one comma-separated weight for each input "
+     "channel.</small>"))
 };
 
 const PluginPreferences ChannelMixer::prefs = {{widgets}};
@@ -19,6 +19,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
 #undef EXPORT
@@ -42,6 +44,8 @@
 #include <libaudcore/preferences.h>
 #include <libaudcore/runtime.h>
 
+#include "../index-common/index-file.h"
+
 class MPG123Plugin : public InputPlugin
 {
 public:
@@ -125,6 +129,111 @@ void MPG123Plugin::cleanup()
     mpg123_exit();
 }
 
+/*
+ * Cache of seek indexes.  A full scan (mpg123_scan) reads every frame header
+ * in the file, which is slow for large files.  The resulting frame index and
+ * exact sample count are saved in the user's config directory, keyed by the
+ * file name, size and modification time, so that each file is scanned only
+ * once.  Tag reading (which happens in the background when a file is added
+ * to the playlist) normally does the scan; playback then just loads it.
+ */
+
+#define INDEX_MAGIC "MPGIDX01"
+#define INDEX_MAX_POINTS (1 << 20)
+
+struct SeekIndex
+{
+    int64_t samples = 0; // exact length of the decoded stream
+    int64_t step = 0;    // frames between index points
+    Index<int64_t> offsets;
+};
+
+static IndexFile mpg123_index("mpg123-index", INDEX_MAGIC);
+
+/* After the header, the index holds:
+ *   sample count, step, point count, points */
+static bool load_index(const char * filename, SeekIndex & index)
+{
+    FILE * file = mpg123_index.open(filename);
+    if (!file)
+        return false;
+
+    int count;
+    bool ok = (fread(&index.samples, sizeof index.samples, 1, file) == 1 &&
+               fread(&index.step, sizeof index.step, 1, file) == 1 &&
+               fread(&count, sizeof count, 1, file) == 1 &&
+               index.samples > 0 && index.step > 0 && count > 0 &&
+               count <= INDEX_MAX_POINTS);
+
+    if (ok)
+    {
+        index.offsets.resize(count);
+        ok = (fread(index.offsets.begin(), sizeof(int64_t), count, file) ==
+              (size_t)count);
+    }
+
+    fclose(file);
+
+    if (!ok)
+        index = SeekIndex();
+
+    return ok;
+}
+
+static void save_index(const char * filename, const SeekIndex & index)
+{
+    StringBuf temp;
+    FILE * file = mpg123_index.create(filename, temp);
+    if (!file)
+        return;
+
+    int count = index.offsets.len();
+
+    bool ok =
+        (fwrite(&index.samples, sizeof index.samples, 1, file) == 1 &&
+         fwrite(&index.step, sizeof index.step, 1, file) == 1 &&
+         fwrite(&count, sizeof count, 1, file) == 1 &&
+         fwrite(index.offsets.begin(), sizeof(int64_t), count, file) ==
+             (size_t)count);
+
+    mpg123_index.commit(filename, file, temp, ok);
+}
+
+// hands a cached index over to the decoder
+static bool apply_index(mpg123_handle * dec, SeekIndex & index)
+{
+    Index<off_t> offsets;
+    offsets.resize(index.offsets.len());
+
+    for (int i = 0; i < offsets.len(); i++)
+        offsets[i] = index.offsets[i];
+
+    return mpg123_set_index(dec, offsets.begin(), index.step,
+                            offsets.len()) == MPG123_OK;
+}
+
+// takes the index built by mpg123_scan() out of the decoder
+static bool extract_index(mpg123_handle * dec, SeekIndex & index)
+{
+    off_t * offsets;
+    off_t step;
+    size_t fill;
+
+    index.samples = mpg123_length(dec);
+
+    if (mpg123_index(dec, &offsets, &step, &fill) != MPG123_OK ||
+        index.samples <= 0 || step <= 0 || !fill || fill > INDEX_MAX_POINTS)
+        return false;
+
+    index.step = step;
+    index.offsets.resize(fill);
+
+    for (size_t i = 0; i < fill; i++)
+        index.offsets[i] = offsets[i];
+
+    return true;
+}
+
 struct DecodeState
 {
     mpg123_handle * dec = nullptr;
@@ -135,6 +244,7 @@ struct DecodeState
 
     bool valid() const { return dec != nullptr; }
 
+    int64_t length = -1; // exact sample count, if known
     long rate;
     int channels, encoding;
     mpg123_frameinfo info;
@@ -165,8 +275,28 @@ DecodeState::DecodeState(const char * filename, VFSFile & file, bool probing,
     if (mpg123_open_handle(dec, &file) < 0)
         goto err;
 
-    if (!stream && aud_get_bool("mpg123", "full_scan") && mpg123_scan(dec) < 0)
-        goto err;
+    /* a cached index is always used, since it costs next to nothing; a new
+     * one is built only if accurate lengths are wanted, and never while
+     * probing, which needs just the first frames */
+    if (!stream && !probing)
+    {
+        SeekIndex index;
+
+        if (load_index(filename, index) && apply_index(dec, index))
+            length = index.samples;
+        else if (aud_get_bool("mpg123", "full_scan"))
+        {
+            if (mpg123_scan(dec) < 0)
+                goto err;
+
+            index = SeekIndex();
+            if (extract_index(dec, index))
+            {
+                length = index.samples;
+                save_index(filename, index);
+            }
+        }
+    }
 
     while (1)
     {
@@ -263,7 +393,7 @@ static bool read_mpg123_info(const char * filename, VFSFile & file,
 
     if (!stream && s.rate > 0)
     {
-        int64_t samples = mpg123_length(s.dec);
+        int64_t samples = (s.length > 0) ? s.length : mpg123_length(s.dec);
         int length = aud::rescale<int64_t>(samples, s.rate, 1000);
 
         if (length > 0)
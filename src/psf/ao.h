@@ -20,6 +20,15 @@
 #define MAX_DISP_INFO_LENGTH		256
 #define AUDIO_RATE					(44100)
 
+// the engine state of the current thread is reached through pointers of this
+// kind (see PSXContext).  __thread needs no check for a dynamic initializer,
+// and initial-exec no function call, on each access
+#if defined(__GNUC__) && defined(__ELF__)
+#define AO_THREAD __thread __attribute__((tls_model("initial-exec")))
+#else
+#define AO_THREAD thread_local
+#endif
+
 enum
 {
 	COMMAND_NONE = 0,
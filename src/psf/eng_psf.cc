@@ -45,11 +45,27 @@
 
 #define LE32(x) FROM_LE32(x)
 
-static corlett_t	*c = nullptr;
-static char 		psfby[256];
-int			psf_refresh  = -1;
+// loader state of one emulated system
+struct psf_context
+{
+	corlett_t	*c;
+	char 		psfby[256];
+
+	uint32_t initialPC, initialGP, initialSP;
+};
+
+AO_THREAD psf_context *psf;
+
+psf_context *psf_new_context(void)
+{
+	return new psf_context();
+}
 
-static uint32_t initialPC, initialGP, initialSP;
+void psf_free_context(psf_context *context)
+{
+	free(context->c);
+	delete context;
+}
 
 int32_t psf_start(uint8_t *buffer, uint32_t length)
 {
@@ -61,12 +77,12 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	union cpuinfo mipsinfo;
 
 	// clear PSX work RAM before we start scribbling in it
-	memset(psx_ram, 0, 2*1024*1024);
+	memset(psx->psx_ram, 0, 2*1024*1024);
 
 //	printf("Length = %d\n", length);
 
 	// Decode the current GSF
-	if (corlett_decode(buffer, length, &file, &file_len, &c) != AO_SUCCESS)
+	if (corlett_decode(buffer, length, &file, &file_len, &psf->c) != AO_SUCCESS)
 	{
 		return AO_FAIL;
 	}
@@ -85,16 +101,16 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	offset = file[0x1c] | file[0x1d]<<8 | file[0x1e]<<16 | file[0x1f]<<24;
 	printf("Text section size: %x\n", offset);
 	printf("Region: [%s]\n", &file[0x4c]);
-	printf("refresh: [%s]\n", c->inf_refresh);
+	printf("refresh: [%s]\n", psf->c->inf_refresh);
 	#endif
 
-	if (c->inf_refresh[0] == '5')
+	if (psf->c->inf_refresh[0] == '5')
 	{
-		psf_refresh = 50;
+		psx->psf_refresh = 50;
 	}
-	if (c->inf_refresh[0] == '6')
+	if (psf->c->inf_refresh[0] == '6')
 	{
-		psf_refresh = 60;
+		psx->psf_refresh = 60;
 	}
 
 	PC = file[0x10] | file[0x11]<<8 | file[0x12]<<16 | file[0x13]<<24;
@@ -106,13 +122,13 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	#endif
 
 	// Get the library file, if any
-	if (c->lib[0] != 0)
+	if (psf->c->lib[0] != 0)
 	{
 		#if DEBUG_LOADER
-		printf("Loading library: %s\n", c->lib);
+		printf("Loading library: %s\n", psf->c->lib);
 		#endif
 
-		Index<char> buf = ao_get_lib(c->lib);
+		Index<char> buf = ao_get_lib(psf->c->lib);
 
 		if (!buf.len())
 			return AO_FAIL;
@@ -137,15 +153,15 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 		#endif
 
 		// if the original file had no refresh tag, give the lib a shot
-		if (psf_refresh == -1)
+		if (psx->psf_refresh == -1)
 		{
 			if (lib->inf_refresh[0] == '5')
 			{
-				psf_refresh = 50;
+				psx->psf_refresh = 50;
 			}
 			if (lib->inf_refresh[0] == '6')
 			{
-				psf_refresh = 60;
+				psx->psf_refresh = 60;
 			}
 		}
 
@@ -171,7 +187,7 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 		#if DEBUG_LOADER
 		printf("library offset: %x plength: %d\n", offset, plength);
 		#endif
-		memcpy(&psx_ram[offset/4], lib_decoded + 2048, plength);
+		memcpy(&psx->psx_ram[offset/4], lib_decoded + 2048, plength);
 
 		// Dispose the corlett structure for the lib - we don't use it
 		free(lib);
@@ -186,18 +202,18 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	else
 		plength = file_len - 2048;
 
-	memcpy(&psx_ram[offset/4], file + 2048, plength);
+	memcpy(&psx->psx_ram[offset/4], file + 2048, plength);
 
 	// load any auxiliary libraries now
 	for (i = 0; i < 8; i++)
 	{
-		if (c->libaux[i][0] != 0)
+		if (psf->c->libaux[i][0] != 0)
 		{
 			#if DEBUG_LOADER
-			printf("Loading aux library: %s\n", c->libaux[i]);
+			printf("Loading aux library: %s\n", psf->c->libaux[i]);
 			#endif
 
-			Index<char> buf = ao_get_lib(c->libaux[i]);
+			Index<char> buf = ao_get_lib(psf->c->libaux[i]);
 
 			if (!buf.len())
 				return AO_FAIL;
@@ -229,7 +245,7 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 			else
 				plength = alib_len - 2048;
 
-			memcpy(&psx_ram[offset/4], alib_decoded + 2048, plength);
+			memcpy(&psx->psx_ram[offset/4], alib_decoded + 2048, plength);
 
 			// Dispose the corlett structure for the lib - we don't use it
 			free(lib);
@@ -240,14 +256,14 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 //	free(lib_decoded);
 
 	// Finally, set psfby tag
-	strcpy(psfby, "n/a");
-	if (c)
+	strcpy(psf->psfby, "n/a");
+	if (psf->c)
 	{
 		int i;
 		for (i = 0; i < MAX_UNKNOWN_TAGS; i++)
 		{
-			if (!strcmp_nocase(c->tag_name[i], "psfby"))
-				strcpy(psfby, c->tag_data[i]);
+			if (!strcmp_nocase(psf->c->tag_name[i], "psfby"))
+				strcpy(psf->psfby, psf->c->tag_data[i]);
 		}
 	}
 
@@ -257,7 +273,7 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	// set the initial PC, SP, GP
 	#if DEBUG_LOADER
 	printf("Initial PC %x, GP %x, SP %x\n", PC, GP, SP);
-	printf("Refresh = %d\n", psf_refresh);
+	printf("Refresh = %d\n", psx->psf_refresh);
 	#endif
 	mipsinfo.i = PC;
 	mips_set_info(CPUINFO_INT_PC, &mipsinfo);
@@ -280,7 +296,7 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 		FILE *f;
 
 		f = fopen("psxram.bin", "wb");
-		fwrite(psx_ram, 2*1024*1024, 1, f);
+		fwrite(psx->psx_ram, 2*1024*1024, 1, f);
 		fclose(f);
 	}
 	#endif
@@ -289,8 +305,8 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	SPUinit();
 	SPUopen();
 
-	lengthMS = psfTimeToMS(c->inf_length);
-	fadeMS = psfTimeToMS(c->inf_fade);
+	lengthMS = psfTimeToMS(psf->c->inf_length);
+	fadeMS = psfTimeToMS(psf->c->inf_fade);
 
 	#if DEBUG_LOADER
 	printf("length %d fade %d\n", lengthMS, fadeMS);
@@ -306,24 +322,24 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	// patch illegal Chocobo Dungeon 2 code - CaitSith2 put a jump in the delay slot from a BNE
 	// and rely on Highly Experimental's buggy-ass CPU to rescue them.  Verified on real hardware
 	// that the initial code is wrong.
-	if (!strcmp(c->inf_game, "Chocobo Dungeon 2"))
+	if (!strcmp(psf->c->inf_game, "Chocobo Dungeon 2"))
 	{
-		if (psx_ram[0xbc090/4] == LE32(0x0802f040))
+		if (psx->psx_ram[0xbc090/4] == LE32(0x0802f040))
 		{
-			psx_ram[0xbc090/4] = LE32(0);
-			psx_ram[0xbc094/4] = LE32(0x0802f040);
-			psx_ram[0xbc098/4] = LE32(0);
+			psx->psx_ram[0xbc090/4] = LE32(0);
+			psx->psx_ram[0xbc094/4] = LE32(0x0802f040);
+			psx->psx_ram[0xbc098/4] = LE32(0);
 		}
 	}
 
 //	psx_ram[0x118b8/4] = LE32(0);	// crash 2 hack
 
 	// backup the initial state for restart
-	memcpy(initial_ram, psx_ram, 2*1024*1024);
-	memcpy(initial_scratch, psx_scratch, 0x400);
-	initialPC = PC;
-	initialGP = GP;
-	initialSP = SP;
+	memcpy(psx->initial_ram, psx->psx_ram, 2*1024*1024);
+	memcpy(psx->initial_scratch, psx->psx_scratch, 0x400);
+	psf->initialPC = PC;
+	psf->initialGP = GP;
+	psf->initialSP = SP;
 
 	mips_execute(5000);
 
@@ -334,7 +350,7 @@ int32_t psf_execute(void (*update)(const void *, int))
 {
 	int i;
 
-	while (!stop_flag) {
+	while (!psx->stop_flag) {
 		for (i = 0; i < 44100 / 60; i++) {
 			psx_hw_slice();
 			SPUasync(384, update);
@@ -349,7 +365,8 @@ int32_t psf_execute(void (*update)(const void *, int))
 int32_t psf_stop(void)
 {
 	SPUclose();
-	free(c);
+	free(psf->c);
+	psf->c = nullptr;
 
 	return AO_SUCCESS;
 }
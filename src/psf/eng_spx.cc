@@ -44,10 +44,26 @@
 #include "peops/registers.h"
 #include "peops/spu.h"
 
-static uint8_t *start_of_file, *song_ptr;
-static uint32_t cur_tick, cur_event, num_events, next_tick, end_tick;
-static int old_fmt;
-static char name[128], song[128], company[128];
+// sequencer state of one emulated system
+struct spx_context
+{
+	uint8_t *start_of_file, *song_ptr;
+	uint32_t cur_tick, cur_event, num_events, next_tick, end_tick;
+	int old_fmt;
+	char name[128], song[128], company[128];
+};
+
+AO_THREAD spx_context *spx;
+
+spx_context *spx_new_context(void)
+{
+	return new spx_context();
+}
+
+void spx_free_context(spx_context *context)
+{
+	delete context;
+}
 
 int32_t spx_start(uint8_t *buffer, uint32_t length)
 {
@@ -59,7 +75,7 @@ int32_t spx_start(uint8_t *buffer, uint32_t length)
 		return AO_FAIL;
 	}
 
-	start_of_file = buffer;
+	spx->start_of_file = buffer;
 
 	SPUinit();
 	SPUopen();
@@ -76,40 +92,40 @@ int32_t spx_start(uint8_t *buffer, uint32_t length)
 		SPUwriteRegister((i/2)+0x1f801c00, reg);
 	}
 
-	old_fmt = 1;
+	spx->old_fmt = 1;
 
 	if ((buffer[0x80200] != 0x44) || (buffer[0x80201] != 0xac) || (buffer[0x80202] != 0x00) || (buffer[0x80203] != 0x00))
 	{
-		old_fmt = 0;
+		spx->old_fmt = 0;
 	}
 
-	if (old_fmt)
+	if (spx->old_fmt)
 	{
-		num_events = buffer[0x80204] | buffer[0x80205]<<8 | buffer[0x80206]<<16 | buffer[0x80207]<<24;
+		spx->num_events = buffer[0x80204] | buffer[0x80205]<<8 | buffer[0x80206]<<16 | buffer[0x80207]<<24;
 
-		if (((num_events * 12) + 0x80208) > length)
+		if (((spx->num_events * 12) + 0x80208) > length)
 		{
-			old_fmt = 0;
+			spx->old_fmt = 0;
 		}
 		else
 		{
-			cur_tick = 0;
+			spx->cur_tick = 0;
 		}
 	}
 
-	if (!old_fmt)
+	if (!spx->old_fmt)
 	{
-		end_tick = buffer[0x80200] | buffer[0x80201]<<8 | buffer[0x80202]<<16 | buffer[0x80203]<<24;
-		cur_tick = buffer[0x80204] | buffer[0x80205]<<8 | buffer[0x80206]<<16 | buffer[0x80207]<<24;
-		next_tick = cur_tick;
+		spx->end_tick = buffer[0x80200] | buffer[0x80201]<<8 | buffer[0x80202]<<16 | buffer[0x80203]<<24;
+		spx->cur_tick = buffer[0x80204] | buffer[0x80205]<<8 | buffer[0x80206]<<16 | buffer[0x80207]<<24;
+		spx->next_tick = spx->cur_tick;
 	}
 
-	song_ptr = &buffer[0x80208];
-	cur_event = 0;
+	spx->song_ptr = &buffer[0x80208];
+	spx->cur_event = 0;
 
-	strncpy((char *)&buffer[4], name, 128);
-	strncpy((char *)&buffer[0x44], song, 128);
-	strncpy((char *)&buffer[0x84], company, 128);
+	strncpy((char *)&buffer[4], spx->name, 128);
+	strncpy((char *)&buffer[0x44], spx->song, 128);
+	strncpy((char *)&buffer[0x84], spx->company, 128);
 
 	return AO_SUCCESS;
 }
@@ -120,74 +136,74 @@ static void spx_tick(void)
 	uint16_t rdata;
 	uint8_t opcode;
 
-	if (old_fmt)
+	if (spx->old_fmt)
 	{
-		time = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
+		time = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
 
-		while ((time == cur_tick) && (cur_event < num_events))
+		while ((time == spx->cur_tick) && (spx->cur_event < spx->num_events))
 		{
-			reg = song_ptr[4] | song_ptr[5]<<8 | song_ptr[6]<<16 | song_ptr[7]<<24;
-			rdata = song_ptr[8] | song_ptr[9]<<8;
+			reg = spx->song_ptr[4] | spx->song_ptr[5]<<8 | spx->song_ptr[6]<<16 | spx->song_ptr[7]<<24;
+			rdata = spx->song_ptr[8] | spx->song_ptr[9]<<8;
 
 			SPUwriteRegister(reg, rdata);
 
-			cur_event++;
-			song_ptr += 12;
+			spx->cur_event++;
+			spx->song_ptr += 12;
 
-			time = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
+			time = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
 		}
 	}
 	else
 	{
-		if (cur_tick < end_tick)
+		if (spx->cur_tick < spx->end_tick)
 		{
-			while (cur_tick == next_tick)
+			while (spx->cur_tick == spx->next_tick)
 			{
-				opcode = song_ptr[0];
-				song_ptr++;
+				opcode = spx->song_ptr[0];
+				spx->song_ptr++;
 
 				switch (opcode)
 				{
 					case 0:	// write register
-						reg = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
-						rdata = song_ptr[4] | song_ptr[5]<<8;
+						reg = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
+						rdata = spx->song_ptr[4] | spx->song_ptr[5]<<8;
 
 						SPUwriteRegister(reg, rdata);
 
-						next_tick = song_ptr[6] | song_ptr[7]<<8 | song_ptr[8]<<16 | song_ptr[9]<<24;
-						song_ptr += 10;
+						spx->next_tick = spx->song_ptr[6] | spx->song_ptr[7]<<8 | spx->song_ptr[8]<<16 | spx->song_ptr[9]<<24;
+						spx->song_ptr += 10;
 						break;
 
 					case 1:	// read register
-				 		reg = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
+				 		reg = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
 						SPUreadRegister(reg);
-						next_tick = song_ptr[4] | song_ptr[5]<<8 | song_ptr[6]<<16 | song_ptr[7]<<24;
-						song_ptr += 8;
+						spx->next_tick = spx->song_ptr[4] | spx->song_ptr[5]<<8 | spx->song_ptr[6]<<16 | spx->song_ptr[7]<<24;
+						spx->song_ptr += 8;
 						break;
 
 					case 2: // dma write
-						size = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
-						song_ptr += (4 + size);
-						next_tick = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
-						song_ptr += 4;
+						size = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
+						spx->song_ptr += (4 + size);
+						spx->next_tick = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
+						spx->song_ptr += 4;
 						break;
 
 					case 3: // dma read
-						next_tick = song_ptr[4] | song_ptr[5]<<8 | song_ptr[6]<<16 | song_ptr[7]<<24;
-						song_ptr += 8;
+						spx->next_tick = spx->song_ptr[4] | spx->song_ptr[5]<<8 | spx->song_ptr[6]<<16 | spx->song_ptr[7]<<24;
+						spx->song_ptr += 8;
 						break;
 
 					case 4: // xa play
-						song_ptr += (32 + 16384);
-						next_tick = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
-						song_ptr += 4;
+						spx->song_ptr += (32 + 16384);
+						spx->next_tick = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
+						spx->song_ptr += 4;
 						break;
 
 					case 5: // cdda play
-						size = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
-						song_ptr += (4 + size);
-						next_tick = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
-						song_ptr += 4;
+						size = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
+						spx->song_ptr += (4 + size);
+						spx->next_tick = spx->song_ptr[0] | spx->song_ptr[1]<<8 | spx->song_ptr[2]<<16 | spx->song_ptr[3]<<24;
+						spx->song_ptr += 4;
 						break;
 
 					default:
@@ -199,18 +215,18 @@ static void spx_tick(void)
 		}
 	}
 
-	cur_tick++;
+	spx->cur_tick++;
 }
 
 int32_t spx_execute(void (*update)(const void *, int))
 {
 	int i, run = 1;
 
-	while (!stop_flag)
+	while (!psx->stop_flag)
 	{
-		if (old_fmt && (cur_event >= num_events))
+		if (spx->old_fmt && (spx->cur_event >= spx->num_events))
 			run = 0;
-		else if (cur_tick >= end_tick)
+		else if (spx->cur_tick >= spx->end_tick)
 			run = 0;
 
 		if (run)
@@ -96,29 +96,64 @@
 // globals
 ////////////////////////////////////////////////////////////////////////
 
-// psx buffer / addresses
+// the SPU state of one emulated system (see PSXContext)
 
-static u16  regArea[0x200];
-static u16  spuMem[256*1024];
-static u8 * spuMemC;
-static u8 * pSpuIrq=0;
-static u8 * pSpuBuffer;
+struct spu_context
+{
+ // psx buffer / addresses
+
+ u16  regArea[0x200];
+ u16  spuMem[256*1024];
+ u8 * spuMemC;
+ u8 * pSpuIrq;
+ u8 * pSpuBuffer;
+
+ // user settings
+ int             iVolume;
+
+ // MAIN infos struct for each channel
+
+ SPUCHAN         s_chan[MAXCHAN+1];                     // channel + 1 infos (1 is security for fmod handling)
+ REVERBInfo      rvb;
+
+ u32   dwNoiseVal=1;                          // global noise generator
+
+ u16  spuCtrl;                             // some vars to store psx reg infos
+ u16  spuStat;
+ u16  spuIrq;
+ u32  spuAddr=0xffffffff;                    // address into spu mem
+ int  bSPUIsOpen;
 
-// user settings
-static int             iVolume;
+ s16 * pS;
+ s32 ttemp;
 
-// MAIN infos struct for each channel
+ // ADSR rates
+ u32 RateTable[160];
 
-static SPUCHAN         s_chan[MAXCHAN+1];                     // channel + 1 infos (1 is security for fmod handling)
-static REVERBInfo      rvb;
+ // reverb down/upsampling
+ s32 downbuf[2][8];
+ s32 upbuf[2][8];
+ int dbpos,ubpos;
 
-static u32   dwNoiseVal=1;                          // global noise generator
+ // song position and fade
+ u32 sampcount;
+ u32 decaybegin;
+ u32 decayend;
+ u32 seektime;
+ int endless;
+};
 
-static u16  spuCtrl=0;                             // some vars to store psx reg infos
-static u16  spuStat=0;
-static u16  spuIrq=0;
-static u32  spuAddr=0xffffffff;                    // address into spu mem
-static int  bSPUIsOpen=0;
+AO_THREAD spu_context *spu;
+
+spu_context *SPUnewContext(void)
+{
+ return new spu_context();
+}
+
+void SPUfreeContext(spu_context *context)
+{
+ delete context;
+}
 
 static const int f[5][2] = {
 			{    0,  0  },
@@ -126,8 +161,6 @@ static const int f[5][2] = {
                         {  115, -52 },
                         {   98, -55 },
                         {  122, -60 } };
-static s16 * pS;
-static s32 ttemp;
 
 ////////////////////////////////////////////////////////////////////////
 // CODE AREA
@@ -145,8 +178,8 @@ static s32 ttemp;
 ////////////////////////////////////////////////////////////////////////
 // helpers for so-called "gauss interpolation"
 
-#define gval0 (((int *)(&s_chan[ch].SB[29]))[gpos])
-#define gval(x) (((int *)(&s_chan[ch].SB[29]))[(gpos+x)&3])
+#define gval0 (((int *)(&spu->s_chan[ch].SB[29]))[gpos])
+#define gval(x) (((int *)(&spu->s_chan[ch].SB[29]))[(gpos+x)&3])
 
 #include "gauss_i.h"
 
@@ -160,20 +193,20 @@ static inline void StartSound(int ch)
 {
  StartADSR(ch);
 
- s_chan[ch].pCurr=s_chan[ch].pStart;                   // set sample start
+ spu->s_chan[ch].pCurr=spu->s_chan[ch].pStart;                   // set sample start
 
- s_chan[ch].s_1=0;                                     // init mixing vars
- s_chan[ch].s_2=0;
- s_chan[ch].iSBPos=28;
+ spu->s_chan[ch].s_1=0;                                     // init mixing vars
+ spu->s_chan[ch].s_2=0;
+ spu->s_chan[ch].iSBPos=28;
 
- s_chan[ch].bNew=0;                                    // init channel flags
- s_chan[ch].bStop=0;
- s_chan[ch].bOn=1;
+ spu->s_chan[ch].bNew=0;                                    // init channel flags
+ spu->s_chan[ch].bStop=0;
+ spu->s_chan[ch].bOn=1;
 
- s_chan[ch].SB[29]=0;                                  // init our interpolation helpers
- s_chan[ch].SB[30]=0;
+ spu->s_chan[ch].SB[29]=0;                                  // init our interpolation helpers
+ spu->s_chan[ch].SB[30]=0;
 
- s_chan[ch].spos=0x40000L;s_chan[ch].SB[28]=0;  // -> start with more decoding
+ spu->s_chan[ch].spos=0x40000L;spu->s_chan[ch].SB[28]=0;  // -> start with more decoding
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -182,52 +215,46 @@ static inline void StartSound(int ch)
 // basically the whole sound processing is done in this fat func!
 ////////////////////////////////////////////////////////////////////////
 
-static u32 sampcount;
-static u32 decaybegin;
-static u32 decayend;
-
-static u32 seektime;
 int psf_seek(u32 t)
 {
- seektime=t*441/10;
- if(seektime>=sampcount) return(1);
+ spu->seektime=t*441/10;
+ if(spu->seektime>=spu->sampcount) return(1);
  return(0);
 }
 
-static int endless;
 void setendless(int e)
 {
- endless=e;
+ spu->endless=e;
 }
 
 // Counting to 65536 results in full volume offage.
 void setlength(s32 stop, s32 fade)
 {
- if(stop==~0 || endless)
+ if(stop==~0 || spu->endless)
  {
-  decaybegin=~0;
+  spu->decaybegin=~0;
  }
  else
  {
   stop=(stop*441)/10;
   fade=(fade*441)/10;
 
-  decaybegin=stop;
-  decayend=stop+fade;
+  spu->decaybegin=stop;
+  spu->decayend=stop+fade;
  }
 }
 
 #define CLIP(_x) {if(_x>32767) _x=32767; if(_x<-32767) _x=-32767;}
 int SPUasync(u32 cycles, void (*update)(const void *, int))
 {
- int volmul=iVolume;
- static s32 dosampies;
+ int volmul=spu->iVolume;
+ s32 dosampies;
  s32 temp;
 
- ttemp+=cycles;
- dosampies=ttemp/384;
+ spu->ttemp+=cycles;
+ dosampies=spu->ttemp/384;
  if(!dosampies) return(1);
- ttemp-=dosampies*384;
+ spu->ttemp-=dosampies*384;
  temp=dosampies;
 
  while(temp)
@@ -243,41 +270,41 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
     {
      for(ch=0;ch<MAXCHAN;ch++)                         // loop em all.
       {
-       if(s_chan[ch].bNew) StartSound(ch);             // start new sound
-       if(!s_chan[ch].bOn) continue;                   // channel not playing? next
+       if(spu->s_chan[ch].bNew) StartSound(ch);             // start new sound
+       if(!spu->s_chan[ch].bOn) continue;                   // channel not playing? next
 
 
-       if(s_chan[ch].iActFreq!=s_chan[ch].iUsedFreq)   // new psx frequency?
+       if(spu->s_chan[ch].iActFreq!=spu->s_chan[ch].iUsedFreq)   // new psx frequency?
         {
-         s_chan[ch].iUsedFreq=s_chan[ch].iActFreq;     // -> take it and calc steps
-         s_chan[ch].sinc=s_chan[ch].iRawPitch<<4;
-         if(!s_chan[ch].sinc) s_chan[ch].sinc=1;
+         spu->s_chan[ch].iUsedFreq=spu->s_chan[ch].iActFreq;     // -> take it and calc steps
+         spu->s_chan[ch].sinc=spu->s_chan[ch].iRawPitch<<4;
+         if(!spu->s_chan[ch].sinc) spu->s_chan[ch].sinc=1;
         }
 
-         while(s_chan[ch].spos>=0x10000L)
+         while(spu->s_chan[ch].spos>=0x10000L)
           {
-           if(s_chan[ch].iSBPos==28)                   // 28 reached?
+           if(spu->s_chan[ch].iSBPos==28)                   // 28 reached?
             {
 	     int predict_nr,shift_factor,flags,d,s;
 	     u8* start;unsigned int nSample;
 	     int s_1,s_2;
 
-             start=s_chan[ch].pCurr;                   // set up the current pos
+             start=spu->s_chan[ch].pCurr;                   // set up the current pos
 
              if (start == (u8*)-1)          // special "stop" sign
               {
-               s_chan[ch].bOn=0;                       // -> turn everything off
-               s_chan[ch].ADSRX.lVolume=0;
-               s_chan[ch].ADSRX.EnvelopeVol=0;
+               spu->s_chan[ch].bOn=0;                       // -> turn everything off
+               spu->s_chan[ch].ADSRX.lVolume=0;
+               spu->s_chan[ch].ADSRX.EnvelopeVol=0;
                goto ENDX;                              // -> and done for this channel
               }
 
-             s_chan[ch].iSBPos=0;	// Reset buffer play index.
+             spu->s_chan[ch].iSBPos=0;	// Reset buffer play index.
 
              //////////////////////////////////////////// spu irq handler here? mmm... do it later
 
-             s_1=s_chan[ch].s_1;
-             s_2=s_chan[ch].s_2;
+             s_1=spu->s_chan[ch].s_1;
+             s_2=spu->s_chan[ch].s_2;
 
              predict_nr=(int)*start;start++;
              shift_factor=predict_nr&0xf;
@@ -297,28 +324,28 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
                s_2=s_1;s_1=fa;
                s=((d & 0xf0) << 8);
 
-               s_chan[ch].SB[nSample++]=fa;
+               spu->s_chan[ch].SB[nSample++]=fa;
 
                if(s&0x8000) s|=0xffff0000;
                fa=(s>>shift_factor);
                fa=fa + ((s_1 * f[predict_nr][0])>>6) + ((s_2 * f[predict_nr][1])>>6);
                s_2=s_1;s_1=fa;
 
-               s_chan[ch].SB[nSample++]=fa;
+               spu->s_chan[ch].SB[nSample++]=fa;
               }
 
              //////////////////////////////////////////// irq check
 
-             if(spuCtrl&0x40)         			// irq active?
+             if(spu->spuCtrl&0x40)         			// irq active?
               {
-               if((pSpuIrq >  start-16 &&              // irq address reached?
-                   pSpuIrq <= start) ||
+               if((spu->pSpuIrq >  start-16 &&              // irq address reached?
+                   spu->pSpuIrq <= start) ||
                   ((flags&1) &&                        // special: irq on looping addr, when stop/loop flag is set
-                   (pSpuIrq >  s_chan[ch].pLoop-16 &&
-                    pSpuIrq <= s_chan[ch].pLoop)))
+                   (spu->pSpuIrq >  spu->s_chan[ch].pLoop-16 &&
+                    spu->pSpuIrq <= spu->s_chan[ch].pLoop)))
                {
 		 //extern s32 spuirqvoodoo;
-                 s_chan[ch].iIrqDone=1;                // -> debug flag
+                 spu->s_chan[ch].iIrqDone=1;                // -> debug flag
 		 SPUirq();
 		//puts("IRQ");
 		 //if(spuirqvoodoo!=-1)
@@ -331,43 +358,43 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
 
              //////////////////////////////////////////// flag handler
 
-             if((flags&4) && (!s_chan[ch].bIgnoreLoop))
-              s_chan[ch].pLoop=start-16;               // loop adress
+             if((flags&4) && (!spu->s_chan[ch].bIgnoreLoop))
+              spu->s_chan[ch].pLoop=start-16;               // loop adress
 
              if(flags&1)                               // 1: stop/loop
               {
                // We play this block out first...
                //if(!(flags&2))                          // 1+2: do loop... otherwise: stop
-               if(flags!=3 || s_chan[ch].pLoop==nullptr)  // PETE: if we don't check exactly for 3, loop hang ups will happen (DQ4, for example)
+               if(flags!=3 || spu->s_chan[ch].pLoop==nullptr)  // PETE: if we don't check exactly for 3, loop hang ups will happen (DQ4, for example)
                 {                                      // and checking if pLoop is set avoids crashes, yeah
                  start = (u8*)-1;
                 }
                else
                 {
-                 start = s_chan[ch].pLoop;
+                 start = spu->s_chan[ch].pLoop;
                 }
               }
 
-             s_chan[ch].pCurr=start;                   // store values for next cycle
-             s_chan[ch].s_1=s_1;
-             s_chan[ch].s_2=s_2;
+             spu->s_chan[ch].pCurr=start;                   // store values for next cycle
+             spu->s_chan[ch].s_1=s_1;
+             spu->s_chan[ch].s_2=s_2;
 
              ////////////////////////////////////////////
             }
 
-           fa=s_chan[ch].SB[s_chan[ch].iSBPos++];      // get sample data
+           fa=spu->s_chan[ch].SB[spu->s_chan[ch].iSBPos++];      // get sample data
 
-           if((spuCtrl&0x4000)==0) fa=0;               // muted?
+           if((spu->spuCtrl&0x4000)==0) fa=0;               // muted?
 	   else CLIP(fa);
 
 	    {
 	     int gpos;
-             gpos = s_chan[ch].SB[28];
+             gpos = spu->s_chan[ch].SB[28];
              gval0 = fa;
              gpos = (gpos+1) & 3;
-             s_chan[ch].SB[28] = gpos;
+             spu->s_chan[ch].SB[28] = gpos;
 	    }
-           s_chan[ch].spos -= 0x10000L;
+           spu->s_chan[ch].spos -= 0x10000L;
           }
 
          ////////////////////////////////////////////////
@@ -375,29 +402,29 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
          // surely wrong... and no noise frequency (spuCtrl&0x3f00) will be used...
          // and sometimes the noise will be used as fmod modulation... pfff
 
-         if(s_chan[ch].bNoise)
+         if(spu->s_chan[ch].bNoise)
           {
 	   //puts("Noise");
-           if((dwNoiseVal<<=1)&0x80000000L)
+           if((spu->dwNoiseVal<<=1)&0x80000000L)
             {
-             dwNoiseVal^=0x0040001L;
-             fa=((dwNoiseVal>>2)&0x7fff);
+             spu->dwNoiseVal^=0x0040001L;
+             fa=((spu->dwNoiseVal>>2)&0x7fff);
              fa=-fa;
             }
-           else fa=(dwNoiseVal>>2)&0x7fff;
+           else fa=(spu->dwNoiseVal>>2)&0x7fff;
 
            // mmm... depending on the noise freq we allow bigger/smaller changes to the previous val
-           fa=s_chan[ch].iOldNoise+((fa-s_chan[ch].iOldNoise)/((0x001f-((spuCtrl&0x3f00)>>9))+1));
+           fa=spu->s_chan[ch].iOldNoise+((fa-spu->s_chan[ch].iOldNoise)/((0x001f-((spu->spuCtrl&0x3f00)>>9))+1));
            if(fa>32767L)  fa=32767L;
            if(fa<-32767L) fa=-32767L;
-           s_chan[ch].iOldNoise=fa;
+           spu->s_chan[ch].iOldNoise=fa;
 
           }                                            //----------------------------------------
          else                                         // NO NOISE (NORMAL SAMPLE DATA) HERE
           {
              int vl, vr, gpos;
-             vl = (s_chan[ch].spos >> 6) & ~3;
-             gpos = s_chan[ch].SB[28];
+             vl = (spu->s_chan[ch].spos >> 6) & ~3;
+             gpos = spu->s_chan[ch].SB[28];
              vr=(gauss[vl]*gval0)>>9;
              vr+=(gauss[vl+1]*gval(1))>>9;
              vr+=(gauss[vl+2]*gval(2))>>9;
@@ -405,11 +432,11 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
              fa = vr>>2;
           }
 
-         s_chan[ch].sval = (MixADSR(ch) * fa)>>10;     // / 1023;  // add adsr
-         if(s_chan[ch].bFMod==2)                       // fmod freq channel
+         spu->s_chan[ch].sval = (MixADSR(ch) * fa)>>10;     // / 1023;  // add adsr
+         if(spu->s_chan[ch].bFMod==2)                       // fmod freq channel
          {
-           int NP=s_chan[ch+1].iRawPitch;
-           NP=((32768L+s_chan[ch].sval)*NP)>>15; ///32768L;
+           int NP=spu->s_chan[ch+1].iRawPitch;
+           NP=((32768L+spu->s_chan[ch].sval)*NP)>>15; ///32768L;
 
            if(NP>0x3fff) NP=0x3fff;
            if(NP<0x1)    NP=0x1;
@@ -419,10 +446,10 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
 
            NP=(44100L*NP)/(4096L);                     // calc frequency
 
-           s_chan[ch+1].iActFreq=NP;
-           s_chan[ch+1].iUsedFreq=NP;
-           s_chan[ch+1].sinc=(((NP/10)<<16)/4410);
-           if(!s_chan[ch+1].sinc) s_chan[ch+1].sinc=1;
+           spu->s_chan[ch+1].iActFreq=NP;
+           spu->s_chan[ch+1].iUsedFreq=NP;
+           spu->s_chan[ch+1].sinc=(((NP/10)<<16)/4410);
+           if(!spu->s_chan[ch+1].sinc) spu->s_chan[ch+1].sinc=1;
 
 		// mmmm... set up freq decoding positions?
 		//           s_chan[ch+1].iSBPos=28;
@@ -436,8 +463,8 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
 
 		if (1) //ao_channel_enable[ch+PSF_1]) {
 		{
-			tmpl=(s_chan[ch].sval*s_chan[ch].iLeftVolume)>>14;
-			tmpr=(s_chan[ch].sval*s_chan[ch].iRightVolume)>>14;
+			tmpl=(spu->s_chan[ch].sval*spu->s_chan[ch].iLeftVolume)>>14;
+			tmpr=(spu->s_chan[ch].sval*spu->s_chan[ch].iRightVolume)>>14;
 		} else {
 			tmpl = 0;
 			tmpr = 0;
@@ -445,14 +472,14 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
 	   sl+=tmpl;
 	   sr+=tmpr;
 
-	   if(((rvb.Enabled>>ch)&1) && (spuCtrl&0x80))
+	   if(((spu->rvb.Enabled>>ch)&1) && (spu->spuCtrl&0x80))
 	   {
 	    revLeft+=tmpl;
 	    revRight+=tmpr;
 	   }
           }
 
-         s_chan[ch].spos += s_chan[ch].sinc;
+         spu->s_chan[ch].spos += spu->s_chan[ch].sinc;
  ENDX:   ;
       }
     }
@@ -461,24 +488,24 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
   // mix all channels (including reverb) into one buffer
   MixREVERBLeftRight(&sl,&sr,revLeft,revRight);
 //  printf("sampcount %d decaybegin %d decayend %d\n", sampcount, decaybegin, decayend);
-  if(sampcount>=decaybegin)
+  if(spu->sampcount>=spu->decaybegin)
   {
    s32 dmul;
-   if(decaybegin!=~0U) // Is anyone REALLY going to be playing a song
+   if(spu->decaybegin!=~0U) // Is anyone REALLY going to be playing a song
 		      // for 13 hours?
    {
-    if(sampcount>=decayend)
+    if(spu->sampcount>=spu->decayend)
     {
       update(nullptr, 0);
       return(0);
     }
-    dmul=256-(256*(sampcount-decaybegin)/(decayend-decaybegin));
+    dmul=256-(256*(spu->sampcount-spu->decaybegin)/(spu->decayend-spu->decaybegin));
     sl=(sl*dmul)>>8;
     sr=(sr*dmul)>>8;
    }
   }
 
-  sampcount++;
+  spu->sampcount++;
   sl=(sl*volmul)>>8;
   sr=(sr*volmul)>>8;
 
@@ -501,21 +528,21 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
   if(sr>32767) sr=32767;
   if(sr<-32767) sr=-32767;
 
-  *pS++=sl;
-  *pS++=sr;
+  *spu->pS++=sl;
+  *spu->pS++=sr;
  }
 
- if (seektime != 0 && sampcount < seektime)
+ if (spu->seektime != 0 && spu->sampcount < spu->seektime)
  {
-   pS=(short *)pSpuBuffer;
+   spu->pS=(short *)spu->pSpuBuffer;
  }
- else if ((((unsigned char *)pS)-((unsigned char *)pSpuBuffer)) == (735*4))
+ else if ((((unsigned char *)spu->pS)-((unsigned char *)spu->pSpuBuffer)) == (735*4))
  {
 #ifdef ENABLE_SILENCE_SKIPPING
-   short *pSilenceIter = (short *)pSpuBuffer;
+   short *pSilenceIter = (short *)spu->pSpuBuffer;
    int iSilenceCount = 0;
 
-   for (; pSilenceIter < pS; pSilenceIter++)
+   for (; pSilenceIter < spu->pS; pSilenceIter++)
    {
       if (*pSilenceIter == 0)
         iSilenceCount++;
@@ -526,9 +553,9 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
 
    if (iSilenceCount < 20)
 #endif
-     update((u8*)pSpuBuffer,(u8*)pS-(u8*)pSpuBuffer);
+     update((u8*)spu->pSpuBuffer,(u8*)spu->pS-(u8*)spu->pSpuBuffer);
 
-   pS=(short *)pSpuBuffer;
+   spu->pS=(short *)spu->pSpuBuffer;
  }
 
  return(1);
@@ -558,14 +585,14 @@ static u64 gettime64(void)
 
 int SPUinit(void)
 {
- spuMemC=(u8*)spuMem;                      // just small setup
- memset((void *)s_chan,0,MAXCHAN*sizeof(SPUCHAN));
- memset((void *)&rvb,0,sizeof(REVERBInfo));
- memset(regArea,0,sizeof(regArea));
- memset(spuMem,0,sizeof(spuMem));
+ spu->spuMemC=(u8*)spu->spuMem;                      // just small setup
+ memset((void *)spu->s_chan,0,MAXCHAN*sizeof(SPUCHAN));
+ memset((void *)&spu->rvb,0,sizeof(REVERBInfo));
+ memset(spu->regArea,0,sizeof(spu->regArea));
+ memset(spu->spuMem,0,sizeof(spu->spuMem));
  InitADSR();
- sampcount=ttemp=0;
- seektime=0;
+ spu->sampcount=spu->ttemp=0;
+ spu->seektime=0;
  #ifdef TIMEO
  begintime=gettime64();
  #endif
@@ -580,16 +607,16 @@ static void SetupStreams(void)
 {
  int i;
 
- pSpuBuffer=(u8*)malloc(32768);            // alloc mixing buffer
- pS=(s16 *)pSpuBuffer;
+ spu->pSpuBuffer=(u8*)malloc(32768);            // alloc mixing buffer
+ spu->pS=(s16 *)spu->pSpuBuffer;
 
  for(i=0;i<MAXCHAN;i++)                                // loop sound channels
   {
-   s_chan[i].ADSRX.SustainLevel = 1024;                // -> init sustain
-   s_chan[i].iIrqDone=0;
-   s_chan[i].pLoop=spuMemC;
-   s_chan[i].pStart=spuMemC;
-   s_chan[i].pCurr=spuMemC;
+   spu->s_chan[i].ADSRX.SustainLevel = 1024;                // -> init sustain
+   spu->s_chan[i].iIrqDone=0;
+   spu->s_chan[i].pLoop=spu->spuMemC;
+   spu->s_chan[i].pStart=spu->spuMemC;
+   spu->s_chan[i].pCurr=spu->spuMemC;
   }
 }
 
@@ -599,8 +626,8 @@ static void SetupStreams(void)
 
 static void RemoveStreams(void)
 {
- free(pSpuBuffer);                                     // free mixing buffer
- pSpuBuffer=nullptr;
+ free(spu->pSpuBuffer);                                     // free mixing buffer
+ spu->pSpuBuffer=nullptr;
 
  #ifdef TIMEO
  {
@@ -608,7 +635,7 @@ static void RemoveStreams(void)
   tmp=gettime64();
   tmp-=begintime;
   if(tmp)
-   tmp=(u64)sampcount*1000000/tmp;
+   tmp=(u64)spu->sampcount*1000000/tmp;
   printf("%lld samples per second\n",tmp);
  }
  #endif
@@ -621,21 +648,21 @@ static void RemoveStreams(void)
 
 int SPUopen(void)
 {
- if(bSPUIsOpen) return 0;                              // security for some stupid main emus
- spuIrq=0;
+ if(spu->bSPUIsOpen) return 0;                              // security for some stupid main emus
+ spu->spuIrq=0;
 
- spuStat=spuCtrl=0;
- spuAddr=0xffffffff;
- dwNoiseVal=1;
+ spu->spuStat=spu->spuCtrl=0;
+ spu->spuAddr=0xffffffff;
+ spu->dwNoiseVal=1;
 
- spuMemC=(u8*)spuMem;
- memset((void *)s_chan,0,(MAXCHAN+1)*sizeof(SPUCHAN));
- pSpuIrq=0;
+ spu->spuMemC=(u8*)spu->spuMem;
+ memset((void *)spu->s_chan,0,(MAXCHAN+1)*sizeof(SPUCHAN));
+ spu->pSpuIrq=0;
 
- iVolume=255; //85;
+ spu->iVolume=255; //85;
  SetupStreams();                                       // prepare streaming
 
- bSPUIsOpen=1;
+ spu->bSPUIsOpen=1;
 
  return 1;
 }
@@ -648,9 +675,9 @@ int SPUopen(void)
 
 int SPUclose(void)
 {
- if(!bSPUIsOpen) return 0;                             // some security
+ if(!spu->bSPUIsOpen) return 0;                             // some security
 
- bSPUIsOpen=0;                                         // no more open
+ spu->bSPUIsOpen=0;                                         // no more open
 
  RemoveStreams();                                      // no more streaming
 
@@ -672,6 +699,6 @@ void SPUinjectRAMImage(u16 *pIncoming)
 
 	for (i = 0; i < (256*1024); i++)
 	{
-		spuMem[i] = pIncoming[i];
+		spu->spuMem[i] = pIncoming[i];
 	}
 }
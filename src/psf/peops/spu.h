@@ -24,6 +24,12 @@
 //
 //*************************************************************************//
 
+struct spu_context;
+extern AO_THREAD spu_context *spu;
+
+spu_context *SPUnewContext(void);
+void SPUfreeContext(spu_context *context);
+
 void SPUirq(void);
 
 int psf_seek(uint32_t t);
@@ -41,13 +41,11 @@
 // ADSR func
 ////////////////////////////////////////////////////////////////////////
 
-unsigned long RateTable[160];
-
 static void InitADSR(void)                                    // INIT ADSR
 {
  unsigned long r,rs,rd;int i;
 
- memset(RateTable,0,sizeof(unsigned long)*160);        // build the rate table according to Neill's rules (see at bottom of file)
+ memset(spu2->RateTable,0,sizeof(unsigned long)*160);        // build the rate table according to Neill's rules (see at bottom of file)
 
  r=3;rs=1;rd=0;
 
@@ -60,7 +58,7 @@ static void InitADSR(void)                                    // INIT ADSR
     }
    if(r>0x3FFFFFFF) r=0x3FFFFFFF;
 
-   RateTable[i]=r;
+   spu2->RateTable[i]=r;
   }
 }
 
@@ -68,146 +66,146 @@ static void InitADSR(void)                                    // INIT ADSR
 
 static void StartADSR(int ch)                          // MIX ADSR
 {
- s_chan[ch].ADSRX.lVolume=1;                           // and init some adsr vars
- s_chan[ch].ADSRX.State=0;
- s_chan[ch].ADSRX.EnvelopeVol=0;
+ spu2->s_chan[ch].ADSRX.lVolume=1;                           // and init some adsr vars
+ spu2->s_chan[ch].ADSRX.State=0;
+ spu2->s_chan[ch].ADSRX.EnvelopeVol=0;
 }
 
 ////////////////////////////////////////////////////////////////////////
 
 static int MixADSR(int ch)                             // MIX ADSR
 {
- if(s_chan[ch].bStop)                                  // should be stopped:
+ if(spu2->s_chan[ch].bStop)                                  // should be stopped:
   {                                                    // do release
-   if(s_chan[ch].ADSRX.ReleaseModeExp)
+   if(spu2->s_chan[ch].ADSRX.ReleaseModeExp)
     {
-     switch((s_chan[ch].ADSRX.EnvelopeVol>>28)&0x7)
+     switch((spu2->s_chan[ch].ADSRX.EnvelopeVol>>28)&0x7)
       {
-       case 0: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +0 + 32]; break;
-       case 1: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +4 + 32]; break;
-       case 2: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +6 + 32]; break;
-       case 3: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +8 + 32]; break;
-       case 4: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +9 + 32]; break;
-       case 5: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +10+ 32]; break;
-       case 6: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +11+ 32]; break;
-       case 7: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +12+ 32]; break;
+       case 0: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +0 + 32]; break;
+       case 1: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +4 + 32]; break;
+       case 2: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +6 + 32]; break;
+       case 3: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +8 + 32]; break;
+       case 4: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +9 + 32]; break;
+       case 5: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +10+ 32]; break;
+       case 6: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +11+ 32]; break;
+       case 7: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x18 +12+ 32]; break;
       }
     }
    else
     {
-     s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x0C + 32];
+     spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.ReleaseRate^0x1F))-0x0C + 32];
     }
 
-   if(s_chan[ch].ADSRX.EnvelopeVol<0)
+   if(spu2->s_chan[ch].ADSRX.EnvelopeVol<0)
     {
-     s_chan[ch].ADSRX.EnvelopeVol=0;
-     s_chan[ch].bOn=0;
+     spu2->s_chan[ch].ADSRX.EnvelopeVol=0;
+     spu2->s_chan[ch].bOn=0;
      //s_chan[ch].bReverb=0;
      //s_chan[ch].bNoise=0;
     }
 
-   s_chan[ch].ADSRX.lVolume=s_chan[ch].ADSRX.EnvelopeVol>>21;
-   return s_chan[ch].ADSRX.lVolume;
+   spu2->s_chan[ch].ADSRX.lVolume=spu2->s_chan[ch].ADSRX.EnvelopeVol>>21;
+   return spu2->s_chan[ch].ADSRX.lVolume;
   }
  else                                                  // not stopped yet?
   {
-   if(s_chan[ch].ADSRX.State==0)                       // -> attack
+   if(spu2->s_chan[ch].ADSRX.State==0)                       // -> attack
     {
-     if(s_chan[ch].ADSRX.AttackModeExp)
+     if(spu2->s_chan[ch].ADSRX.AttackModeExp)
       {
-       if(s_chan[ch].ADSRX.EnvelopeVol<0x60000000)
-        s_chan[ch].ADSRX.EnvelopeVol+=RateTable[(s_chan[ch].ADSRX.AttackRate^0x7F)-0x10 + 32];
+       if(spu2->s_chan[ch].ADSRX.EnvelopeVol<0x60000000)
+        spu2->s_chan[ch].ADSRX.EnvelopeVol+=spu2->RateTable[(spu2->s_chan[ch].ADSRX.AttackRate^0x7F)-0x10 + 32];
        else
-        s_chan[ch].ADSRX.EnvelopeVol+=RateTable[(s_chan[ch].ADSRX.AttackRate^0x7F)-0x18 + 32];
+        spu2->s_chan[ch].ADSRX.EnvelopeVol+=spu2->RateTable[(spu2->s_chan[ch].ADSRX.AttackRate^0x7F)-0x18 + 32];
       }
      else
       {
-       s_chan[ch].ADSRX.EnvelopeVol+=RateTable[(s_chan[ch].ADSRX.AttackRate^0x7F)-0x10 + 32];
+       spu2->s_chan[ch].ADSRX.EnvelopeVol+=spu2->RateTable[(spu2->s_chan[ch].ADSRX.AttackRate^0x7F)-0x10 + 32];
       }
 
-     if(s_chan[ch].ADSRX.EnvelopeVol<0)
+     if(spu2->s_chan[ch].ADSRX.EnvelopeVol<0)
       {
-       s_chan[ch].ADSRX.EnvelopeVol=0x7FFFFFFF;
-       s_chan[ch].ADSRX.State=1;
+       spu2->s_chan[ch].ADSRX.EnvelopeVol=0x7FFFFFFF;
+       spu2->s_chan[ch].ADSRX.State=1;
       }
 
-     s_chan[ch].ADSRX.lVolume=s_chan[ch].ADSRX.EnvelopeVol>>21;
-     return s_chan[ch].ADSRX.lVolume;
+     spu2->s_chan[ch].ADSRX.lVolume=spu2->s_chan[ch].ADSRX.EnvelopeVol>>21;
+     return spu2->s_chan[ch].ADSRX.lVolume;
     }
    //--------------------------------------------------//
-   if(s_chan[ch].ADSRX.State==1)                       // -> decay
+   if(spu2->s_chan[ch].ADSRX.State==1)                       // -> decay
     {
-     switch((s_chan[ch].ADSRX.EnvelopeVol>>28)&0x7)
+     switch((spu2->s_chan[ch].ADSRX.EnvelopeVol>>28)&0x7)
       {
-       case 0: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+0 + 32]; break;
-       case 1: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+4 + 32]; break;
-       case 2: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+6 + 32]; break;
-       case 3: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+8 + 32]; break;
-       case 4: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+9 + 32]; break;
-       case 5: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+10+ 32]; break;
-       case 6: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+11+ 32]; break;
-       case 7: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[(4*(s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+12+ 32]; break;
+       case 0: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+0 + 32]; break;
+       case 1: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+4 + 32]; break;
+       case 2: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+6 + 32]; break;
+       case 3: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+8 + 32]; break;
+       case 4: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+9 + 32]; break;
+       case 5: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+10+ 32]; break;
+       case 6: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+11+ 32]; break;
+       case 7: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[(4*(spu2->s_chan[ch].ADSRX.DecayRate^0x1F))-0x18+12+ 32]; break;
       }
 
-     if(s_chan[ch].ADSRX.EnvelopeVol<0) s_chan[ch].ADSRX.EnvelopeVol=0;
-     if(((s_chan[ch].ADSRX.EnvelopeVol>>27)&0xF) <= s_chan[ch].ADSRX.SustainLevel)
+     if(spu2->s_chan[ch].ADSRX.EnvelopeVol<0) spu2->s_chan[ch].ADSRX.EnvelopeVol=0;
+     if(((spu2->s_chan[ch].ADSRX.EnvelopeVol>>27)&0xF) <= spu2->s_chan[ch].ADSRX.SustainLevel)
       {
-       s_chan[ch].ADSRX.State=2;
+       spu2->s_chan[ch].ADSRX.State=2;
       }
 
-     s_chan[ch].ADSRX.lVolume=s_chan[ch].ADSRX.EnvelopeVol>>21;
-     return s_chan[ch].ADSRX.lVolume;
+     spu2->s_chan[ch].ADSRX.lVolume=spu2->s_chan[ch].ADSRX.EnvelopeVol>>21;
+     return spu2->s_chan[ch].ADSRX.lVolume;
     }
    //--------------------------------------------------//
-   if(s_chan[ch].ADSRX.State==2)                       // -> sustain
+   if(spu2->s_chan[ch].ADSRX.State==2)                       // -> sustain
     {
-     if(s_chan[ch].ADSRX.SustainIncrease)
+     if(spu2->s_chan[ch].ADSRX.SustainIncrease)
       {
-       if(s_chan[ch].ADSRX.SustainModeExp)
+       if(spu2->s_chan[ch].ADSRX.SustainModeExp)
         {
-         if(s_chan[ch].ADSRX.EnvelopeVol<0x60000000)
-          s_chan[ch].ADSRX.EnvelopeVol+=RateTable[(s_chan[ch].ADSRX.SustainRate^0x7F)-0x10 + 32];
+         if(spu2->s_chan[ch].ADSRX.EnvelopeVol<0x60000000)
+          spu2->s_chan[ch].ADSRX.EnvelopeVol+=spu2->RateTable[(spu2->s_chan[ch].ADSRX.SustainRate^0x7F)-0x10 + 32];
          else
-          s_chan[ch].ADSRX.EnvelopeVol+=RateTable[(s_chan[ch].ADSRX.SustainRate^0x7F)-0x18 + 32];
+          spu2->s_chan[ch].ADSRX.EnvelopeVol+=spu2->RateTable[(spu2->s_chan[ch].ADSRX.SustainRate^0x7F)-0x18 + 32];
         }
        else
         {
-         s_chan[ch].ADSRX.EnvelopeVol+=RateTable[(s_chan[ch].ADSRX.SustainRate^0x7F)-0x10 + 32];
+         spu2->s_chan[ch].ADSRX.EnvelopeVol+=spu2->RateTable[(spu2->s_chan[ch].ADSRX.SustainRate^0x7F)-0x10 + 32];
         }
 
-       if(s_chan[ch].ADSRX.EnvelopeVol<0)
+       if(spu2->s_chan[ch].ADSRX.EnvelopeVol<0)
         {
-         s_chan[ch].ADSRX.EnvelopeVol=0x7FFFFFFF;
+         spu2->s_chan[ch].ADSRX.EnvelopeVol=0x7FFFFFFF;
         }
       }
      else
       {
-       if(s_chan[ch].ADSRX.SustainModeExp)
+       if(spu2->s_chan[ch].ADSRX.SustainModeExp)
         {
-         switch((s_chan[ch].ADSRX.EnvelopeVol>>28)&0x7)
+         switch((spu2->s_chan[ch].ADSRX.EnvelopeVol>>28)&0x7)
           {
-           case 0: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +0 + 32];break;
-           case 1: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +4 + 32];break;
-           case 2: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +6 + 32];break;
-           case 3: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +8 + 32];break;
-           case 4: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +9 + 32];break;
-           case 5: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +10+ 32];break;
-           case 6: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +11+ 32];break;
-           case 7: s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +12+ 32];break;
+           case 0: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +0 + 32];break;
+           case 1: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +4 + 32];break;
+           case 2: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +6 + 32];break;
+           case 3: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +8 + 32];break;
+           case 4: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +9 + 32];break;
+           case 5: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +10+ 32];break;
+           case 6: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +11+ 32];break;
+           case 7: spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x1B +12+ 32];break;
           }
         }
        else
         {
-         s_chan[ch].ADSRX.EnvelopeVol-=RateTable[((s_chan[ch].ADSRX.SustainRate^0x7F))-0x0F + 32];
+         spu2->s_chan[ch].ADSRX.EnvelopeVol-=spu2->RateTable[((spu2->s_chan[ch].ADSRX.SustainRate^0x7F))-0x0F + 32];
         }
 
-       if(s_chan[ch].ADSRX.EnvelopeVol<0)
+       if(spu2->s_chan[ch].ADSRX.EnvelopeVol<0)
         {
-         s_chan[ch].ADSRX.EnvelopeVol=0;
+         spu2->s_chan[ch].ADSRX.EnvelopeVol=0;
         }
       }
-     s_chan[ch].ADSRX.lVolume=s_chan[ch].ADSRX.EnvelopeVol>>21;
-     return s_chan[ch].ADSRX.lVolume;
+     spu2->s_chan[ch].ADSRX.lVolume=spu2->s_chan[ch].ADSRX.EnvelopeVol>>21;
+     return spu2->s_chan[ch].ADSRX.lVolume;
     }
   }
  return 0;
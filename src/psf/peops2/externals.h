@@ -247,65 +247,86 @@ typedef struct
 #endif
 
 ///////////////////////////////////////////////////////////
-// SPU.C globals
+// SPU state
 ///////////////////////////////////////////////////////////
 
-#ifndef _IN_SPU
-
-// psx buffers / addresses
-
-extern unsigned short  regArea[];
-extern unsigned short  spuMem[];
-extern unsigned char * spuMemC;
-extern unsigned char * pSpuIrq[];
-extern unsigned char * pSpuBuffer;
-
-// user settings
-
-extern int        iUseXA;
-extern int        iVolume;
-extern int        iXAPitch;
-extern int        iUseTimer;
-extern int        iSPUIRQWait;
-extern int        iDebugMode;
-extern int        iRecordMode;
-extern int        iUseReverb;
-extern int        iUseInterpolation;
-extern int        iDisStereo;
-// MISC
-
-extern SPUCHAN2 s_chan[];
-extern REVERBInfo2 rvb[];
-
-extern unsigned long dwNoiseVal;
-extern unsigned short spuCtrl2[];
-extern unsigned short spuStat2[];
-extern unsigned long  spuIrq2[];
-extern unsigned long  spuAddr2[];
-extern unsigned long   spuRvbAddr2[];
-extern unsigned long   spuRvbAEnd2[];
-
-extern int      bEndThread;
-extern int      bThreadEnded;
-extern int      bSpuInit;
-
-extern int      SSumR[];
-extern int      SSumL[];
-extern int      iCycle;
-extern short *  pS;
-extern unsigned long dwNewChannel2[];
-extern unsigned long dwEndChannel2[];
-
-extern int iSpuAsyncWait;
+// the SPU2 state of one emulated system (see PSXContext)
 
-#ifdef _WINDOWS
-//extern HWND    hWMain;                               // window handle
-//extern HWND    hWDebug;
-#endif
+struct spu2_context
+{
+ // psx buffers / addresses
 
-extern void (CALLBACK *cddavCallback)(unsigned short,unsigned short);
+ unsigned short  regArea[32*1024];
+ unsigned short  spuMem[1*1024*1024];
+ unsigned char * spuMemC;
+ unsigned char * pSpuIrq[2];
+ unsigned char * pSpuBuffer;
 
-#endif
+ // user settings
+
+ int             iUseXA=0;
+ int             iXAPitch=1;
+ int             iUseTimer=2;
+ int             iSPUIRQWait=1;
+ int             iDebugMode=0;
+ int             iRecordMode=0;
+ int             iUseReverb=1;
+ int             iUseInterpolation=2;
+
+ // MAIN infos struct for each channel
+
+ SPUCHAN2         s_chan[MAXCHAN+1];                     // channel + 1 infos (1 is security for fmod handling)
+ REVERBInfo2      rvb[2];
+
+ unsigned long   dwNoiseVal=1;                          // global noise generator
+
+ unsigned short  spuCtrl2[2];                           // some vars to store psx reg infos
+ unsigned short  spuStat2[2];
+ unsigned long   spuIrq2[2];
+ unsigned long   spuAddr2[2];                           // address into spu mem
+ unsigned long   spuRvbAddr2[2];
+ unsigned long   spuRvbAEnd2[2];
+ int             bEndThread=0;                          // thread handlers
+ int             bThreadEnded=0;
+ int             bSpuInit=0;
+ int             bSPUIsOpen=0;
+
+ unsigned long dwNewChannel2[2];                        // flags for faster testing, if new channel starts
+ unsigned long dwEndChannel2[2];
+
+ // UNUSED IN PS2 YET
+ void (CALLBACK *irqCallback)(void)=0;                  // func of main emu, called on spu irq
+ void (CALLBACK *cddavCallback)(unsigned short,unsigned short)=0;
+
+ // certain globals (were local before, but with the new timeproc I need em global)
+
+ int SSumR[NSSIZE];
+ int SSumL[NSSIZE];
+ int iCycle=0;
+ short * pS;
+
+ int lastch=-1;      // last channel processed on spu irq in timer mode
+ int iSecureStart=0; // secure start counter
+
+ // ADSR rates
+ unsigned long RateTable[160];
+
+ // REVERB info and timing vars...
+ int *          sRVBPlay[2];
+ int *          sRVBEnd[2];
+ int *          sRVBStart[2];
+
+ // song position and fade
+ u32 sampcount;
+ u32 decaybegin;
+ u32 decayend;
+ u32 seektime;
+ int endless;
+
+ int iSpuAsyncWait=0;
+};
+
+extern AO_THREAD spu2_context *spu2;
 
 ///////////////////////////////////////////////////////////
 // CFG.C globals
@@ -365,16 +386,4 @@ extern int           iRightXAVol;
 
 #endif
 
-///////////////////////////////////////////////////////////
-// REVERB.C globals
-///////////////////////////////////////////////////////////
-
-#ifndef _IN_REVERB
-
-extern int *          sRVBPlay[];
-extern int *          sRVBEnd[];
-extern int *          sRVBStart[];
-
-#endif
-
 #endif // PEOPS2_EXTERNALS
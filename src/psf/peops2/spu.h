@@ -27,6 +27,12 @@
 //
 //*************************************************************************//
 
+struct spu2_context;
+extern AO_THREAD spu2_context *spu2;
+
+spu2_context *SPU2newContext(void);
+void SPU2freeContext(spu2_context *context);
+
 void setendless2(int e);
 void setlength2(int32_t stop, int32_t fade);
 
@@ -34,6 +34,7 @@
 #include <libaudcore/audstrings.h>
 #include <libaudcore/runtime.h>
 
+#include "../length-common/lengths.h"
 #include "ao.h"
 #include "corlett.h"
 #include "psx.h"
@@ -61,6 +62,7 @@ public:
         .with_exts(exts)) {}
 
     bool init();
+    void cleanup();
 
     bool is_our_file(const char *filename, VFSFile &file);
     bool read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image);
@@ -97,6 +99,7 @@ static PSFEngineFunctors psf_functor_map[ENG_COUNT] = {
 const char* const PSFPlugin::defaults[] =
 {
     "ignore_length", "FALSE",
+    "detect_length", "FALSE",
     nullptr
 };
 
@@ -106,15 +109,55 @@ bool PSFPlugin::init()
     return true;
 }
 
-static PSFEngineFunctors *f;
-static String dirpath;
+/* The state of one play() or detect_length() call.  Each call emulates its
+ * file in a PSXContext of its own, so that a song can be played while others
+ * are scanned.  The callbacks and ao_get_lib() find the call running in their
+ * thread through "current". */
+struct PSFCall
+{
+    PSFCall(const char *filename, PSFEngine eng);
+    ~PSFCall();
+
+    SmartPtr<PSXContext> context;
+    PSFEngineFunctors *f;
+    String dirpath;
+
+    /* The emulation engine can only seek forward, not back.  This variable is
+     * set a non-negative time (milliseconds) when the song is to be restarted
+     * in order to seek backward. */
+    int reverse_seek = -1;
+
+    /* Songs without a usable length are ended after a run of silence.  The
+     * time of the last sound is then taken as the length of the song. */
+    SilenceDetector *silence = nullptr;
+};
+
+static thread_local PSFCall *current;
+
+/* <filename> must contain a slash */
+PSFCall::PSFCall(const char *filename, PSFEngine eng) :
+    context(new PSXContext),
+    f(&psf_functor_map[eng]),
+    dirpath(str_copy(filename, strrchr(filename, '/') + 1 - filename))
+{
+    context->make_current();
+    current = this;
+}
+
+PSFCall::~PSFCall()
+{
+    current = nullptr;
+    PSXContext::release();
+}
 
-bool stop_flag = false;
+static int detect_length(const char *filename);
 
-/* The emulation engine can only seek forward, not back.  This variable is set
- * a non-negative time (milliseconds) when the song is to be restarted in order
- * to seek backward. */
-static int reverse_seek;
+static LengthCache psf_lengths(detect_length);
+
+void PSFPlugin::cleanup()
+{
+    psf_lengths.cleanup();
+}
 
 static PSFEngine psf_probe(const char *buf, int len)
 {
@@ -139,7 +182,7 @@ static PSFEngine psf_probe(const char *buf, int len)
 /* ao_get_lib: called to load secondary files */
 Index<char> ao_get_lib(char *filename)
 {
-    VFSFile file(filename_build({dirpath, filename}), "r");
+    VFSFile file(filename_build({current->dirpath, filename}), "r");
     return file ? file.read_all() : Index<char>();
 }
 
@@ -153,7 +196,20 @@ bool PSFPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Inde
     if (corlett_decode((uint8_t *)buf.begin(), buf.len(), nullptr, nullptr, &c) != AO_SUCCESS)
         return false;
 
-    tuple.set_int(Tuple::Length, psfTimeToMS(c->inf_length) + psfTimeToMS(c->inf_fade));
+    int length = psfTimeToMS(c->inf_length);
+    int detected = -1;
+    if (!length || aud_get_bool("psf", "ignore_length"))
+    {
+        String key = LengthCache::make_key(buf, 0);
+        if (key && !psf_lengths.lookup(key, detected) &&
+         aud_get_bool("psf", "detect_length"))
+            psf_lengths.queue(filename, key);
+    }
+
+    if (detected > 0)
+        tuple.set_int(Tuple::Length, detected);
+    else
+        tuple.set_int(Tuple::Length, length + psfTimeToMS(c->inf_fade));
     tuple.set_str(Tuple::Artist, c->inf_artist);
     tuple.set_str(Tuple::Album, c->inf_game);
     tuple.set_str(Tuple::Title, c->inf_title);
@@ -169,24 +225,20 @@ bool PSFPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Inde
 
 bool PSFPlugin::play(const char *filename, VFSFile &file)
 {
-    bool error = false;
-
-    const char * slash = strrchr (filename, '/');
-    if (! slash)
+    if (!strrchr(filename, '/'))
         return false;
 
-    dirpath = String (str_copy (filename, slash + 1 - filename));
-
     Index<char> buf = file.read_all ();
 
-    bool ignore_len = aud_get_bool("psf", "ignore_length");
-
     PSFEngine eng = psf_probe(buf.begin(), buf.len());
     if (eng == ENG_NONE || eng == ENG_COUNT)
-    {
-        error = true;
-        goto cleanup;
-    }
+        return false;
+
+    PSFCall call(filename, eng);
+
+    bool ignore_len = aud_get_bool("psf", "ignore_length");
+    bool detect_silence = ignore_len;
+    SilenceDetector detector(44100);
 
     if(eng == ENG_PSF1 || eng == ENG_SPX)
         setendless(ignore_len);
@@ -194,48 +246,59 @@ bool PSFPlugin::play(const char *filename, VFSFile &file)
     if(eng == ENG_PSF2)
         setendless2(ignore_len);
 
-    f = &psf_functor_map[eng];
+    if (!detect_silence)
+    {
+        corlett_t *c;
+        if (corlett_decode((uint8_t *)buf.begin(), buf.len(), nullptr, nullptr, &c) == AO_SUCCESS)
+        {
+            detect_silence = !psfTimeToMS(c->inf_length);
+            free(c);
+        }
+    }
+
+    call.silence = detect_silence ? &detector : nullptr;
 
     set_stream_bitrate(44100*2*2*8);
     open_audio(FMT_S16_NE, 44100, 2);
 
-    reverse_seek = -1;
-
     /* This loop will restart playback from the beginning when necessary to seek
      * backwards in the file (reverse_seek >= 0). */
     do
     {
-        if (f->start((uint8_t *)buf.begin(), buf.len()) != AO_SUCCESS)
-        {
-            error = true;
-            goto cleanup;
-        }
+        if (call.f->start((uint8_t *)buf.begin(), buf.len()) != AO_SUCCESS)
+            return false;
 
-        if (reverse_seek >= 0)
+        if (call.reverse_seek >= 0)
         {
-            f->seek(reverse_seek); /* should never fail here */
-            reverse_seek = -1;
+            call.f->seek(call.reverse_seek); /* should never fail here */
+            call.reverse_seek = -1;
         }
 
-        stop_flag = false;
+        psx->stop_flag = false;
 
-        f->execute(update);
-        f->stop();
+        call.f->execute(update);
+        call.f->stop();
     }
-    while (reverse_seek >= 0);
+    while (call.reverse_seek >= 0);
 
-cleanup:
-    f = nullptr;
-    dirpath = String ();
+    if (detect_silence && detector.ended() && detector.exact())
+    {
+        int length = detector.length();
+        psf_lengths.store(LengthCache::make_key(buf, 0), length);
+
+        Tuple tuple = get_playback_tuple();
+        tuple.set_int(Tuple::Length, length);
+        set_playback_tuple(tuple.ref());
+    }
 
-    return ! error;
+    return true;
 }
 
 void PSFPlugin::update(const void *data, int bytes)
 {
     if (!data || check_stop())
     {
-        stop_flag = true;
+        psx->stop_flag = true;
         return;
     }
 
@@ -243,16 +306,74 @@ void PSFPlugin::update(const void *data, int bytes)
 
     if (seek >= 0)
     {
-        if (!f->seek(seek))
+        if (!current->f->seek(seek))
         {
-            reverse_seek = seek;
-            stop_flag = true;
+            current->reverse_seek = seek;
+            psx->stop_flag = true;
         }
 
+        if (current->silence)
+            current->silence->seek(seek);
+
         return;
     }
 
     write_audio(data, bytes);
+
+    if (current->silence && current->silence->process((const int16_t *)data, bytes / 2))
+        psx->stop_flag = true;
+}
+
+/* update callback of the length detection, which discards the audio */
+static void detect_update(const void *data, int bytes)
+{
+    SilenceDetector *silence = current->silence;
+
+    if (!data || psf_lengths.stopping() ||
+     silence->process((const int16_t *)data, bytes / 2) ||
+     silence->position() >= LengthCache::Limit)
+        psx->stop_flag = true;
+}
+
+/* Plays the song through as fast as possible, up to LengthCache::Limit, and
+ * returns the time of the last sound before a run of silence. */
+static int detect_length(const char *filename)
+{
+    if (!strrchr(filename, '/'))
+        return -1;
+
+    VFSFile file(filename, "r");
+    if (!file)
+        return -1;
+
+    Index<char> buf = file.read_all ();
+
+    PSFEngine eng = psf_probe(buf.begin(), buf.len());
+    if (eng == ENG_NONE || eng == ENG_COUNT)
+        return -1;
+
+    PSFCall call(filename, eng);
+
+    /* the song should not end or fade out at the length from its tag */
+    if(eng == ENG_PSF1 || eng == ENG_SPX)
+        setendless(true);
+    if(eng == ENG_PSF2)
+        setendless2(true);
+
+    SilenceDetector detector(44100);
+    call.silence = &detector;
+
+    if (call.f->start((uint8_t *)buf.begin(), buf.len()) != AO_SUCCESS)
+        return -1;
+
+    psx->stop_flag = false;
+    call.f->execute(detect_update);
+    call.f->stop();
+
+    if (psf_lengths.stopping())
+        return LengthCache::Retry;
+
+    return detector.ended() ? detector.length() : -1;
 }
 
 bool PSFPlugin::is_our_file(const char *filename, VFSFile &file)
@@ -269,6 +390,8 @@ const char *const PSFPlugin::exts[] = { "psf", "minipsf", "psf2", "minipsf2", "s
 const PreferencesWidget PSFPlugin::widgets[] = {
     WidgetLabel(N_("<b>OpenPSF Configuration</b>")),
     WidgetCheck(N_("Ignore length from file"), WidgetBool("psf", "ignore_length")),
+    WidgetCheck(N_("Detect length of songs without length information"),
+        WidgetBool("psf", "detect_length")),
 };
 
 const PluginPreferences PSFPlugin::prefs = {{widgets}};
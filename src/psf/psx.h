@@ -285,14 +285,68 @@ extern unsigned DasmMIPS(char *buff, unsigned _pc);
 extern void psxcpu_get_info(uint32_t state, union cpuinfo *info);
 #endif
 
+/* context */
+struct mips_cpu_context;
+struct psx_hw_context;
+struct spu_context;
+struct spu2_context;
+struct psf_context;
+struct psf2_context;
+struct spx_context;
+
+/* The state of one emulated system.  Each file that is played or scanned has
+ * a context of its own, so that several can be emulated at once.  The engine
+ * code finds the parts of the current context through thread-local pointers,
+ * which make_current() sets for the calling thread. */
+struct PSXContext
+{
+	PSXContext();
+	~PSXContext();
+
+	PSXContext(const PSXContext &) = delete;
+	PSXContext &operator=(const PSXContext &) = delete;
+
+	void make_current();
+	static void release();
+
+	// PSX main RAM
+	uint32_t psx_ram[(2*1024*1024)/4+4];
+	uint32_t psx_scratch[0x400];
+	// backup image to restart songs
+	uint32_t initial_ram[(2*1024*1024)/4+4];
+	uint32_t initial_scratch[0x400];
+
+	int psf_refresh;
+	bool stop_flag;
+
+private:
+	mips_cpu_context *mips_ctx;
+	psx_hw_context *hw_ctx;
+	spu_context *spu_ctx;
+	spu2_context *spu2_ctx;
+	psf_context *psf_ctx;
+	psf2_context *psf2_ctx;
+	spx_context *spx_ctx;
+};
+
+extern AO_THREAD PSXContext *psx;
+
 /* eng_psf.cc */
-extern int psf_refresh;
+extern AO_THREAD psf_context *psf;
+
+psf_context *psf_new_context(void);
+void psf_free_context(psf_context *context);
 
 int32_t psf_start(uint8_t *buffer, uint32_t length);
 int32_t psf_execute(void (*update)(const void *, int));
 int32_t psf_stop(void);
 
 /* eng_psf2.cc */
+extern AO_THREAD psf2_context *psf2;
+
+psf2_context *psf2_new_context(void);
+void psf2_free_context(psf2_context *context);
+
 uint32_t psf2_load_elf(uint8_t *start, uint32_t len);
 uint32_t psf2_load_file(const char *file, uint8_t *buf, uint32_t buflen);
 int32_t psf2_start(uint8_t *, uint32_t length);
@@ -303,14 +357,21 @@ uint32_t psf2_get_loadaddr(void);
 void psf2_set_loadaddr(uint32_t addr);
 
 /* eng_spx.cc */
+extern AO_THREAD spx_context *spx;
+
+spx_context *spx_new_context(void);
+void spx_free_context(spx_context *context);
+
 int32_t spx_start(uint8_t *buffer, uint32_t length);
 int32_t spx_execute(void (*update)(const void *, int));
 int32_t spx_stop(void);
 
-/* plugin.cc */
-extern bool stop_flag;
-
 /* psx.cc */
+extern AO_THREAD mips_cpu_context *mipscpu;
+
+mips_cpu_context *mips_new_context(void);
+void mips_free_context(mips_cpu_context *context);
+
 void mips_init(void);
 void mips_reset(void *param);
 void mips_shorten_frame(void);
@@ -325,10 +386,10 @@ int mips_get_icount(void);
 void mips_set_icount(int count);
 
 /* psx_hw.cc */
-extern uint32_t psx_ram[((2*1024*1024)/4)+4];
-extern uint32_t psx_scratch[0x400];
-extern uint32_t initial_ram[((2*1024*1024)/4)+4];
-extern uint32_t initial_scratch[0x400];
+extern AO_THREAD psx_hw_context *hw;
+
+psx_hw_context *psx_hw_new_context(void);
+void psx_hw_free_context(psx_hw_context *context);
 
 void psx_hw_slice(void);
 void ps2_hw_slice(void);
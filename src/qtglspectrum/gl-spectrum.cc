@@ -23,11 +23,14 @@
  */
 
 #include <math.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
+#include <libaudcore/runtime.h>
 
+#include <QElapsedTimer>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions_2_0>
 
@@ -88,9 +91,12 @@ private:
     void initializeGL ();
 
     void draw_bars ();
-    void draw_bar (float x, float z, float h, float r, float g, float b);
-    void draw_rectangle (float x1, float y1, float z1, float x2, float y2,
-                         float z2, float r, float g, float b);
+
+    GLuint m_vbo = 0;
+
+    QElapsedTimer m_timer;
+    qint64 m_draw_time = 0;
+    int m_draw_count = 0;
 };
 
 GLSpectrumWidget * s_widget = nullptr;
@@ -176,57 +182,52 @@ void GLSpectrumQt::clear ()
         s_widget->update ();
 }
 
-void GLSpectrumWidget::draw_rectangle (float x1, float y1, float z1, float x2, float y2,
- float z2, float r, float g, float b)
+/* Each bar is made of four quads (the top, the two sides, and the front).
+ * The quads of all the bars are gathered into one vertex buffer and drawn with
+ * a single call, rather than one call per vertex. */
+#define VERTICES_PER_BAR 16
+
+struct Vertex
+{
+    float x, y, z;
+    float r, g, b;
+};
+
+static Vertex s_vertices[NUM_BANDS * NUM_BANDS * VERTICES_PER_BAR];
+
+static Vertex * add_quad (Vertex * v, const float (* corners)[3], float r,
+ float g, float b)
+{
+    for (int i = 0; i < 4; i ++)
+        * v ++ = {corners[i][0], corners[i][1], corners[i][2], r, g, b};
+
+    return v;
+}
+
+static Vertex * add_rectangle (Vertex * v, float x1, float y1, float z1,
+ float x2, float y2, float z2, float r, float g, float b)
 {
-    glColor4f (r, g, b, 1.0f);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y2, z2);
-    glVertex3f (x1, y2, z2);
-    glEnd ();
-
-    glColor4f (0.65f * r, 0.65f * g, 0.65f * b, 1.0f);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x1, y2, z2);
-    glVertex3f (x1, y1, z2);
-    glEnd ();
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y1, z2);
-    glVertex3f (x2, y2, z2);
-    glEnd ();
-
-    glColor4f (0.8f * r, 0.8f * g, 0.8f * b, 1.0f);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x1, y2, z1);
-    glEnd ();
+    const float top[4][3] = {{x1, y2, z1}, {x2, y2, z1}, {x2, y2, z2}, {x1, y2, z2}};
+    const float left[4][3] = {{x1, y1, z1}, {x1, y2, z1}, {x1, y2, z2}, {x1, y1, z2}};
+    const float right[4][3] = {{x2, y2, z1}, {x2, y1, z1}, {x2, y1, z2}, {x2, y2, z2}};
+    const float front[4][3] = {{x1, y1, z1}, {x2, y1, z1}, {x2, y2, z1}, {x1, y2, z1}};
+
+    v = add_quad (v, top, r, g, b);
+    v = add_quad (v, left, 0.65f * r, 0.65f * g, 0.65f * b);
+    v = add_quad (v, right, 0.65f * r, 0.65f * g, 0.65f * b);
+    return add_quad (v, front, 0.8f * r, 0.8f * g, 0.8f * b);
 }
 
-void GLSpectrumWidget::draw_bar (float x, float z, float h, float r, float g, float b)
+static Vertex * add_bar (Vertex * v, float x, float z, float h, float r,
+ float g, float b)
 {
-    draw_rectangle (x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
+    return add_rectangle (v, x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
      r * (0.2f + 0.8f * h), g * (0.2f + 0.8f * h), b * (0.2f + 0.8f * h));
 }
 
 void GLSpectrumWidget::draw_bars ()
 {
-    glPushMatrix ();
-    glTranslatef (0.0f, -0.5f, -5.0f);
-    glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
-    glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
-    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+    Vertex * v = s_vertices;
 
     for (int i = 0; i < NUM_BANDS; i ++)
     {
@@ -234,13 +235,34 @@ void GLSpectrumWidget::draw_bars ()
 
         for (int j = 0; j < NUM_BANDS; j ++)
         {
-            draw_bar (1.6f - BAR_SPACING * j, z,
+            v = add_bar (v, 1.6f - BAR_SPACING * j, z,
              s_bars[(s_pos + i) % NUM_BANDS][j] * 1.6,
              colors[i][j][0], colors[i][j][1], colors[i][j][2]);
         }
     }
 
+    glPushMatrix ();
+    glTranslatef (0.0f, -0.5f, -5.0f);
+    glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
+    glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
     glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+
+    /* the whole buffer is replaced every frame */
+    glBindBuffer (GL_ARRAY_BUFFER, m_vbo);
+    glBufferData (GL_ARRAY_BUFFER, (v - s_vertices) * sizeof (Vertex),
+     s_vertices, GL_STREAM_DRAW);
+
+    glEnableClientState (GL_VERTEX_ARRAY);
+    glEnableClientState (GL_COLOR_ARRAY);
+    glVertexPointer (3, GL_FLOAT, sizeof (Vertex), (void *) offsetof (Vertex, x));
+    glColorPointer (3, GL_FLOAT, sizeof (Vertex), (void *) offsetof (Vertex, r));
+
+    glDrawArrays (GL_QUADS, 0, v - s_vertices);
+
+    glDisableClientState (GL_COLOR_ARRAY);
+    glDisableClientState (GL_VERTEX_ARRAY);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+
     glPopMatrix ();
 }
 
@@ -254,6 +276,13 @@ GLSpectrumWidget::GLSpectrumWidget (QWidget * parent) : QOpenGLWidget (parent)
 
 GLSpectrumWidget::~GLSpectrumWidget ()
 {
+    if (m_vbo)
+    {
+        makeCurrent ();
+        glDeleteBuffers (1, & m_vbo);
+        doneCurrent ();
+    }
+
     s_widget = nullptr;
 }
 
@@ -276,8 +305,20 @@ void GLSpectrumWidget::paintGL ()
     glClearColor (0, 0, 0, 1);
     glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    m_timer.start ();
+
     draw_bars ();
 
+    /* the time to hand a frame to the driver, for comparing drivers (e.g.
+     * llvmpipe, with LIBGL_ALWAYS_SOFTWARE=1) */
+    m_draw_time += m_timer.nsecsElapsed () / 1000;
+    if (++ m_draw_count == 256)
+    {
+        AUDDBG ("%d us per frame\n", (int) (m_draw_time / m_draw_count));
+        m_draw_time = 0;
+        m_draw_count = 0;
+    }
+
     glPopMatrix ();
     glMatrixMode (GL_PROJECTION);
     glPopMatrix ();
@@ -293,6 +334,7 @@ void GLSpectrumWidget::resizeGL (int w, int h)
 void GLSpectrumWidget::initializeGL ()
 {
     initializeOpenGLFunctions ();
+    glGenBuffers (1, & m_vbo);
 }
 
 void * GLSpectrumQt::get_qt_widget ()
@@ -37,7 +37,11 @@
 PlaylistWidget::PlaylistWidget(QWidget * parent, Playlist playlist)
     : audqt::TreeView(parent), m_playlist(playlist),
       model(new PlaylistModel(this, playlist)),
-      proxyModel(new PlaylistProxyModel(this, playlist))
+      proxyModel(new PlaylistProxyModel(this, playlist)),
+      m_filter(playlist,
+               [this](Index<String> && terms, Index<char> && matches) {
+                   applyFilter(std::move(terms), std::move(matches));
+               })
 {
     model->setFont(font());
 
@@ -193,6 +197,15 @@ void PlaylistWidget::mouseMoveEvent(QMouseEvent * event)
     audqt::TreeView::mouseMoveEvent(event);
 }
 
+void PlaylistWidget::paintEvent(QPaintEvent * event)
+{
+    audqt::TreeView::paintEvent(event);
+
+    int fetches = model->takeTupleFetches();
+    if (fetches)
+        AUDDBG("%d tuple fetches for paint\n", fetches);
+}
+
 void PlaylistWidget::leaveEvent(QEvent * event)
 {
     hidePopup();
@@ -430,11 +443,24 @@ void PlaylistWidget::playlistUpdate()
         else if (currentPos >= update.before)
             currentPos = -1;
 
+        proxyModel->entriesRemoved(update.before, removed);
+        m_filter.entriesRemoved(update.before, removed);
         model->entriesRemoved(update.before, removed);
+
+        proxyModel->entriesAdded(update.before, changed);
+        m_filter.entriesAdded(update.before, changed);
         model->entriesAdded(update.before, changed);
     }
     else if (update.level == Playlist::Metadata || update.queue_changed)
+    {
+        if (update.level == Playlist::Metadata)
+        {
+            proxyModel->entriesChanged(update.before, changed);
+            m_filter.entriesChanged(update.before, changed);
+        }
+
         model->entriesChanged(update.before, changed);
+    }
 
     if (update.queue_changed)
     {
@@ -464,6 +490,22 @@ void PlaylistWidget::playlistUpdate()
 }
 
 void PlaylistWidget::setFilter(const char * text)
+{
+    auto terms = str_list_to_index(str_tolower_utf8(text), " ");
+
+    // Searching a large playlist can take a while, so it is done in the
+    // background; the result is applied once it is complete.
+    if (terms.len())
+        m_filter.search(std::move(terms));
+    else
+    {
+        m_filter.cancel();
+        applyFilter(std::move(terms), Index<char>());
+    }
+}
+
+void PlaylistWidget::applyFilter(Index<String> && terms,
+                                 Index<char> && matches)
 {
     // Save the current focus before filtering
     int focus = m_playlist.get_focus();
@@ -471,13 +513,14 @@ void PlaylistWidget::setFilter(const char * text)
     // Empty the model before updating the filter.  This prevents Qt from
     // performing a series of "rows added" or "rows deleted" updates, which can
     // be very slow (worst case O(N^2) complexity) on a large playlist.
-    model->entriesRemoved(0, model->rowCount());
+    int rows = model->rowCount();
+    model->entriesRemoved(0, rows);
 
     // Update the filter
-    proxyModel->setFilter(text);
+    proxyModel->setFilter(std::move(terms), std::move(matches));
 
     // Repopulate the model
-    model->entriesAdded(0, m_playlist.n_entries());
+    model->entriesAdded(0, rows);
 
     // If the previously focused row is no longer visible with the new filter,
     // try to find a nearby one that is, and focus it.
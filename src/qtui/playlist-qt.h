@@ -25,6 +25,8 @@
 #include <libaudcore/playlist.h>
 #include <libaudqt/treeview.h>
 
+#include "playlist_filter.h"
+
 class PlaylistModel;
 class PlaylistProxyModel;
 class QContextMenuEvent;
@@ -52,6 +54,7 @@ private:
     Playlist m_playlist;
     PlaylistModel * model;
     PlaylistProxyModel * proxyModel;
+    PlaylistFilter m_filter;
     QMenu * contextMenu = nullptr;
 
     int currentPos = -1;
@@ -69,11 +72,13 @@ private:
                            QItemSelection & selected,
                            QItemSelection & deselected);
     void updateSelection(int rowsBefore, int rowsAfter);
+    void applyFilter(Index<String> && terms, Index<char> && matches);
 
     void changeEvent(QEvent * event);
     void contextMenuEvent(QContextMenuEvent * event);
     void keyPressEvent(QKeyEvent * event);
     void mouseMoveEvent(QMouseEvent * event);
+    void paintEvent(QPaintEvent * event);
     void leaveEvent(QEvent * event);
     void dragMoveEvent(QDragMoveEvent * event);
     void dropEvent(QDropEvent * event);
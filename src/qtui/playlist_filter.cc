@@ -0,0 +1,312 @@
+/*
+ * playlist_filter.cc
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <chrono>
+#include <string.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/tuple.h>
+
+#include "playlist_filter.h"
+
+static String fold_entry(const Tuple & tuple)
+{
+    String fields[] = {tuple.get_str(Tuple::Title),
+                       tuple.get_str(Tuple::Artist),
+                       tuple.get_str(Tuple::Album),
+                       tuple.get_str(Tuple::Basename)};
+
+    /* the fields are separated by newlines, which never appear in search
+     * terms, so that a term cannot match across two fields */
+    StringBuf text(0);
+    for (auto & s : fields)
+    {
+        if (s)
+        {
+            text.insert(-1, s);
+            text.insert(-1, "\n");
+        }
+    }
+
+    return str_tolower_utf8(text);
+}
+
+PlaylistFilter::PlaylistFilter(Playlist playlist, ResultFunc result_func)
+    : m_playlist(playlist), m_result_func(result_func)
+{
+    /* the index must follow the rows of the model, not the playlist itself,
+     * since the model may lag behind the playlist while an update is queued */
+    m_index.insert(0, playlist.n_entries());
+}
+
+PlaylistFilter::~PlaylistFilter()
+{
+    m_abort = true;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        m_cond.notify_one();
+    }
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void PlaylistFilter::search(Index<String> && terms)
+{
+    m_abort = true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_abort = false;
+
+    m_terms = std::move(terms);
+    m_query_serial++;
+    m_query_pending = true;
+
+    m_result_query = -1;
+    m_result.clear();
+
+    if (!m_thread.joinable())
+        m_thread = std::thread(&PlaylistFilter::run, this);
+
+    m_cond.notify_one();
+}
+
+void PlaylistFilter::cancel()
+{
+    m_abort = true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_abort = false;
+
+    m_terms.clear();
+    m_query_serial++;
+    m_query_pending = false;
+
+    m_result_query = -1;
+    m_result.clear();
+
+    m_cond.notify_one();
+}
+
+/* A result that is waiting to be published is kept in step with the rows
+ * of the model; changed rows are marked Unknown so that the proxy model
+ * matches them directly. */
+
+void PlaylistFilter::entriesAdded(int row, int count)
+{
+    if (count < 1)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_index.insert(row, count);
+    m_index_serial++;
+
+    if (m_result_query >= 0)
+    {
+        m_result.insert(row, count);
+        for (int i = row; i < row + count; i++)
+            m_result[i] = Unknown;
+    }
+
+    m_cond.notify_one();
+}
+
+void PlaylistFilter::entriesRemoved(int row, int count)
+{
+    if (count < 1)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_index.remove(row, count);
+    m_index_serial++;
+
+    if (m_result_query >= 0)
+        m_result.remove(row, count);
+
+    m_cond.notify_one();
+}
+
+void PlaylistFilter::entriesChanged(int row, int count)
+{
+    if (count < 1)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (int i = row; i < row + count; i++)
+        m_index[i] = String();
+
+    m_index_serial++;
+
+    if (m_result_query >= 0)
+    {
+        for (int i = row; i < row + count; i++)
+            m_result[i] = Unknown;
+    }
+
+    m_cond.notify_one();
+}
+
+void PlaylistFilter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_quit)
+    {
+        if (!m_query_pending || m_abort)
+        {
+            m_cond.wait(lock);
+            continue;
+        }
+
+        if (!updateIndex(lock))
+            continue;
+
+        auto start = std::chrono::steady_clock::now();
+
+        Index<char> matches;
+        if (!evaluate(matches))
+            continue;
+
+        auto time = std::chrono::steady_clock::now() - start;
+        AUDDBG("Filtered %d entries in %d ms\n", m_index.len(),
+               (int)std::chrono::duration_cast<std::chrono::milliseconds>(time)
+                   .count());
+
+        m_query_pending = false;
+
+        m_result_terms.clear();
+        for (auto & term : m_terms)
+            m_result_terms.append(term);
+
+        m_result = std::move(matches);
+        m_result_query = m_query_serial;
+
+        m_publish.queue([this]() { publish(); });
+    }
+}
+
+/* Called with the lock held.  Tuples are fetched with the lock released, in
+ * chunks, so that the main thread is never blocked for long. */
+bool PlaylistFilter::updateIndex(std::unique_lock<std::mutex> & lock)
+{
+    int row = 0;
+
+    while (true)
+    {
+        if (m_quit || m_abort)
+            return false;
+
+        while (row < m_index.len() && m_index[row])
+            row++;
+
+        if (row == m_index.len())
+            return true;
+
+        /* wait until the model has caught up with the playlist, so that a
+         * row number refers to the same entry in both */
+        if (m_playlist.update_pending())
+        {
+            m_cond.wait_for(lock, std::chrono::milliseconds(50));
+            row = 0;
+            continue;
+        }
+
+        int end = aud::min(row + chunk_rows, m_index.len());
+        int serial = m_index_serial;
+
+        lock.unlock();
+
+        Index<String> folded;
+        for (int i = row; i < end; i++)
+            folded.append(
+                fold_entry(m_playlist.entry_tuple(i, Playlist::NoWait)));
+
+        bool moved = m_playlist.update_pending();
+
+        lock.lock();
+
+        /* discard the chunk if the rows changed while we were reading */
+        if (moved || m_index_serial != serial)
+        {
+            row = 0;
+            continue;
+        }
+
+        for (int i = row; i < end; i++)
+            m_index[i] = std::move(folded[i - row]);
+
+        row = end;
+    }
+}
+
+/* Called with the lock held. */
+bool PlaylistFilter::evaluate(Index<char> & matches)
+{
+    int rows = m_index.len();
+    matches.insert(0, rows);
+
+    for (int row = 0; row < rows; row++)
+    {
+        if (!(row % cancel_check_rows) && (m_quit || m_abort))
+            return false;
+
+        const char * text = m_index[row];
+
+        if (!text)
+        {
+            matches[row] = Unknown;
+            continue;
+        }
+
+        bool found = true;
+
+        for (auto & term : m_terms)
+        {
+            if (!strstr(text, term))
+            {
+                found = false;
+                break;
+            }
+        }
+
+        matches[row] = found ? Shown : Hidden;
+    }
+
+    return true;
+}
+
+void PlaylistFilter::publish()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_result_query < 0 || m_result_query != m_query_serial)
+        return;
+
+    auto terms = std::move(m_result_terms);
+    auto matches = std::move(m_result);
+    m_result_query = -1;
+
+    lock.unlock();
+
+    m_result_func(std::move(terms), std::move(matches));
+}
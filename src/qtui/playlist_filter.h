@@ -0,0 +1,98 @@
+/*
+ * playlist_filter.h
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef PLAYLIST_FILTER_H
+#define PLAYLIST_FILTER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <libaudcore/index.h>
+#include <libaudcore/mainloop.h>
+#include <libaudcore/objects.h>
+#include <libaudcore/playlist.h>
+
+/* Background search engine for the playlist search bar.  A folded
+ * (lowercase) copy of the searchable text of each entry is kept in an index
+ * that mirrors the rows of the PlaylistModel.  Queries are evaluated against
+ * the index on a worker thread; a query still running when the next one
+ * arrives is cancelled.  The matching rows are handed back in the main
+ * thread in a single batch. */
+
+class PlaylistFilter
+{
+public:
+    enum : char
+    {
+        Hidden,
+        Shown,
+        Unknown /* not indexed yet, must be matched directly */
+    };
+
+    typedef std::function<void(Index<String> && terms, Index<char> && matches)>
+        ResultFunc;
+
+    PlaylistFilter(Playlist playlist, ResultFunc result_func);
+    ~PlaylistFilter();
+
+    /* terms must be folded with str_tolower_utf8() */
+    void search(Index<String> && terms);
+    void cancel();
+
+    /* must be called along with the corresponding PlaylistModel calls */
+    void entriesAdded(int row, int count);
+    void entriesRemoved(int row, int count);
+    void entriesChanged(int row, int count);
+
+private:
+    static constexpr int chunk_rows = 256;
+    static constexpr int cancel_check_rows = 4096;
+
+    void run();
+    bool updateIndex(std::unique_lock<std::mutex> & lock);
+    bool evaluate(Index<char> & matches);
+    void publish();
+
+    const Playlist m_playlist;
+    const ResultFunc m_result_func;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    bool m_quit = false;
+    std::atomic<bool> m_abort{false};
+
+    Index<String> m_index;  /* null entries are out of date */
+    int m_index_serial = 0; /* bumped on any change to the rows */
+
+    Index<String> m_terms;
+    int m_query_serial = 0;
+    bool m_query_pending = false;
+
+    Index<String> m_result_terms;
+    Index<char> m_result;
+    int m_result_query = -1; /* -1 if no result is waiting */
+
+    QueuedFunc m_publish;
+};
+
+#endif
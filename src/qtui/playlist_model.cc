@@ -27,6 +27,7 @@
 #include <libaudcore/i18n.h>
 #include <libaudqt/libaudqt.h>
 
+#include "playlist_filter.h"
 #include "playlist_model.h"
 
 const char * const PlaylistModel::labels[] = {
@@ -50,8 +51,10 @@ static_assert(aud::n_elems(s_fields) == PlaylistModel::n_cols,
 
 PlaylistModel::PlaylistModel(QObject * parent, Playlist playlist)
     : QAbstractListModel(parent), m_playlist(playlist),
-      m_rows(playlist.n_entries())
+      m_rows(playlist.n_entries()), m_position(playlist.get_position())
 {
+    for (int & row : m_cache_row)
+        row = -1;
 }
 
 int PlaylistModel::rowCount(const QModelIndex & parent) const
@@ -95,44 +98,19 @@ QVariant PlaylistModel::data(const QModelIndex & index, int role) const
     if (col < 0 || col >= n_cols)
         return QVariant();
 
-    Tuple tuple;
-    int val = -1;
-
     switch (role)
     {
     case Qt::DisplayRole:
-        if (s_fields[col] != Tuple::Invalid)
-        {
-            tuple = m_playlist.entry_tuple(index.row(), Playlist::NoWait);
-
-            switch (tuple.get_value_type(s_fields[col]))
-            {
-            case Tuple::Empty:
-                return QVariant();
-            case Tuple::String:
-                return QString(tuple.get_str(s_fields[col]));
-            case Tuple::Int:
-                val = tuple.get_int(s_fields[col]);
-                break;
-            }
-        }
+    {
+        auto & text = m_cache_text[col][cacheRow(index.row())];
+        if (text.isNull())
+            return QVariant();
 
-        switch (col)
-        {
-        case EntryNumber:
-            return QString("%1").arg(index.row() + 1);
-        case QueuePos:
-            return queuePos(index.row());
-        case Length:
-            return QString(str_format_time(val));
-        case Bitrate:
-            return QString("%1 kbit/s").arg(val);
-        default:
-            return QString("%1").arg(val);
-        }
+        return text;
+    }
 
     case Qt::FontRole:
-        if (index.row() == m_playlist.get_position())
+        if (index.row() == m_position)
             return m_bold;
         break;
 
@@ -140,7 +118,7 @@ QVariant PlaylistModel::data(const QModelIndex & index, int role) const
         return alignment(col);
 
     case Qt::DecorationRole:
-        if (col == m_playing_col && index.row() == m_playlist.get_position())
+        if (col == m_playing_col && index.row() == m_position)
         {
             const char * icon_name = "media-playback-stop";
 
@@ -260,6 +238,9 @@ void PlaylistModel::entriesAdded(int row, int count)
     if (count < 1)
         return;
 
+    invalidateCache(row, m_rows - row);
+    m_position = m_playlist.get_position();
+
     int last = row + count - 1;
     beginInsertRows(QModelIndex(), row, last);
     m_rows += count;
@@ -271,6 +252,9 @@ void PlaylistModel::entriesRemoved(int row, int count)
     if (count < 1)
         return;
 
+    invalidateCache(row, m_rows - row);
+    m_position = m_playlist.get_position();
+
     int last = row + count - 1;
     beginRemoveRows(QModelIndex(), row, last);
     m_rows -= count;
@@ -282,6 +266,9 @@ void PlaylistModel::entriesChanged(int row, int count)
     if (count < 1)
         return;
 
+    invalidateCache(row, count);
+    m_position = m_playlist.get_position();
+
     int bottom = row + count - 1;
     auto topLeft = createIndex(row, 0);
     auto bottomRight = createIndex(bottom, columnCount() - 1);
@@ -297,20 +284,132 @@ QString PlaylistModel::queuePos(int row) const
         return QString("#%1").arg(at + 1);
 }
 
+int PlaylistModel::cacheRow(int row) const
+{
+    int slot = row % cache_rows;
+    if (m_cache_row[slot] != row)
+        fillCache(slot, row);
+
+    return slot;
+}
+
+void PlaylistModel::fillCache(int slot, int row) const
+{
+    Tuple tuple = m_playlist.entry_tuple(row, Playlist::NoWait);
+    m_tuple_fetches++;
+
+    for (int col = 0; col < n_cols; col++)
+    {
+        QString & text = m_cache_text[col][slot];
+        int val = -1;
+
+        text = QString();
+
+        if (s_fields[col] != Tuple::Invalid)
+        {
+            switch (tuple.get_value_type(s_fields[col]))
+            {
+            case Tuple::Empty:
+                continue;
+            case Tuple::String:
+                text = QString(tuple.get_str(s_fields[col]));
+                continue;
+            case Tuple::Int:
+                val = tuple.get_int(s_fields[col]);
+                break;
+            }
+        }
+
+        switch (col)
+        {
+        case EntryNumber:
+            text = QString("%1").arg(row + 1);
+            break;
+        case QueuePos:
+            text = queuePos(row);
+            break;
+        case Length:
+            text = QString(str_format_time(val));
+            break;
+        case Bitrate:
+            text = QString("%1 kbit/s").arg(val);
+            break;
+        default:
+            text = QString("%1").arg(val);
+            break;
+        }
+    }
+
+    m_cache_row[slot] = row;
+}
+
+void PlaylistModel::invalidateCache(int row, int count)
+{
+    for (int & cached : m_cache_row)
+    {
+        if (cached >= row && cached - row < count)
+            cached = -1;
+    }
+}
+
 /* ---------------------------------- */
 
-void PlaylistProxyModel::setFilter(const char * filter)
+void PlaylistProxyModel::setFilter(Index<String> && terms,
+                                   Index<char> && matches)
 {
-    m_searchTerms = str_list_to_index(filter, " ");
+    m_searchTerms = std::move(terms);
+    m_matches = std::move(matches);
     invalidateFilter();
 }
 
+void PlaylistProxyModel::entriesAdded(int row, int count)
+{
+    if (count < 1 || !m_matches.len())
+        return;
+
+    m_matches.insert(row, count);
+    for (int i = row; i < row + count; i++)
+        m_matches[i] = PlaylistFilter::Unknown;
+}
+
+void PlaylistProxyModel::entriesRemoved(int row, int count)
+{
+    if (count < 1 || !m_matches.len())
+        return;
+
+    m_matches.remove(row, count);
+}
+
+void PlaylistProxyModel::entriesChanged(int row, int count)
+{
+    if (count < 1 || !m_matches.len())
+        return;
+
+    for (int i = row; i < row + count; i++)
+        m_matches[i] = PlaylistFilter::Unknown;
+}
+
 bool PlaylistProxyModel::filterAcceptsRow(int source_row,
                                           const QModelIndex &) const
 {
     if (!m_searchTerms.len())
         return true;
 
+    if (source_row < m_matches.len())
+    {
+        char & match = m_matches[source_row];
+        if (match == PlaylistFilter::Unknown)
+            match = matchRow(source_row) ? PlaylistFilter::Shown
+                                         : PlaylistFilter::Hidden;
+
+        return match == PlaylistFilter::Shown;
+    }
+
+    return matchRow(source_row);
+}
+
+bool PlaylistProxyModel::matchRow(int source_row) const
+{
     Tuple tuple = m_playlist.entry_tuple(source_row);
 
     String strings[] = {tuple.get_str(Tuple::Title),
@@ -75,14 +75,38 @@ public:
     void setFont(const QFont & font);
     void setPlayingCol(int playing_col);
 
+    /* returns (and resets) the number of tuples fetched from the core since
+     * the last call; used to verify that painting hits the row cache */
+    int takeTupleFetches()
+    {
+        int fetches = m_tuple_fetches;
+        m_tuple_fetches = 0;
+        return fetches;
+    }
+
 private:
+    /* Display strings are cached for a window of recently painted rows so
+     * that painting a row costs one tuple fetch rather than one per column.
+     * The cache is direct-mapped (row % cache_rows), which means that any
+     * contiguous screenful of rows occupies distinct slots. */
+    static constexpr int cache_rows = 512;
+
     Playlist m_playlist;
     int m_rows;
     QFont m_bold;
     int m_playing_col = -1;
+    int m_position;
+
+    mutable int m_cache_row[cache_rows];
+    mutable QString m_cache_text[n_cols][cache_rows];
+    mutable int m_tuple_fetches = 0;
 
     QVariant alignment(int col) const;
     QString queuePos(int row) const;
+
+    int cacheRow(int row) const;
+    void fillCache(int slot, int row) const;
+    void invalidateCache(int row, int count);
 };
 
 class PlaylistProxyModel : public QSortFilterProxyModel
@@ -93,13 +117,21 @@ public:
     {
     }
 
-    void setFilter(const char * filter);
+    /* matches comes from PlaylistFilter and may be empty, in which case all
+     * rows are matched directly */
+    void setFilter(Index<String> && terms, Index<char> && matches);
+
+    void entriesAdded(int row, int count);
+    void entriesRemoved(int row, int count);
+    void entriesChanged(int row, int count);
 
 private:
     bool filterAcceptsRow(int source_row, const QModelIndex &) const;
+    bool matchRow(int source_row) const;
 
     Playlist m_playlist;
     Index<String> m_searchTerms;
+    mutable Index<char> m_matches;
 };
 
 #endif
@@ -126,158 +126,235 @@ void PlaylistWidget::cancel_all ()
 
     if (m_hover != -1)
     {
+        queue_draw_rows (m_hover - 1, 2);
         m_hover = -1;
-        queue_draw ();
     }
 
     popup_hide ();
 }
 
-void PlaylistWidget::draw (cairo_t * cr)
+PangoLayout * PlaylistWidget::create_layout (const char * text)
 {
-    int active_entry = m_playlist.get_position ();
-    int left = 3, right = 3;
-    PangoLayout * layout;
-    int width;
+    PangoLayout * layout = gtk_widget_create_pango_layout (gtk_dr (), text);
+    pango_layout_set_font_description (layout, m_font.get ());
+    return layout;
+}
 
-    /* background */
+static int layout_width (PangoLayout * layout)
+{
+    PangoRectangle rect;
+    pango_layout_get_pixel_extents (layout, nullptr, & rect);
+    return rect.width;
+}
 
-    set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMALBG]);
-    cairo_paint (cr);
+PlaylistWidget::RowCache & PlaylistWidget::cache_row (int entry)
+{
+    RowCache & row = m_cache[entry % cache_rows];
+    if (row.entry == entry)
+        return row;
 
-    /* playlist title */
+    Tuple tuple = m_playlist.entry_tuple (entry, Playlist::NoWait);
+    int len = tuple.get_int (Tuple::Length);
 
-    if (m_offset)
+    if (len >= 0)
     {
-        layout = gtk_widget_create_pango_layout (gtk_dr (), m_title_text);
-        pango_layout_set_font_description (layout, m_font.get ());
-        pango_layout_set_width (layout, PANGO_SCALE * (m_width - left - right));
-        pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
-        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_MIDDLE);
-
-        cairo_move_to (cr, left, 0);
-        set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMAL]);
-        pango_cairo_show_layout (cr, layout);
-        g_object_unref (layout);
+        row.length.capture (create_layout (str_format_time (len)));
+        row.length_width = layout_width (row.length.get ());
+    }
+    else
+    {
+        row.length.clear ();
+        row.length_width = 0;
     }
 
-    /* selection highlight */
+    row.title.capture (create_layout (tuple.get_str (Tuple::FormattedTitle)));
+    pango_layout_set_ellipsize (row.title.get (), PANGO_ELLIPSIZE_END);
+    row.title_width = -1;
 
-    for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
-    {
-        if (! m_playlist.entry_selected (i))
-            continue;
+    /* created when first needed */
+    row.number.clear ();
+    row.queue.clear ();
+    row.queue_pos = -1;
+
+    row.entry = entry;
+    return row;
+}
 
-        cairo_rectangle (cr, 0, m_offset + m_row_height * (i - m_first), m_width, m_row_height);
-        set_cairo_color (cr, skin.colors[SKIN_PLEDIT_SELECTEDBG]);
-        cairo_fill (cr);
+void PlaylistWidget::invalidate_rows (int row, int count)
+{
+    for (RowCache & cached : m_cache)
+    {
+        if (cached.entry >= row && cached.entry - row < count)
+            cached.entry = -1;
     }
+}
 
-    /* entry numbers */
+void PlaylistWidget::queue_draw_rows (int row, int count)
+{
+    int top = aud::max (row, m_first);
+    int bottom = aud::min (row + count, m_first + m_rows);
 
-    if (aud_get_bool ("show_numbers_in_pl"))
+    /* one pixel extra on each side for the hover line */
+    if (top < bottom)
+        queue_draw_area (0, m_offset + m_row_height * (top - m_first) - 1,
+         m_width, m_row_height * (bottom - top) + 2);
+}
+
+void PlaylistWidget::draw (cairo_t * cr)
+{
+    int active_entry = m_playlist.get_position ();
+    int last = aud::min (m_first + m_rows, m_length);
+    bool show_numbers = aud_get_bool ("show_numbers_in_pl");
+    bool show_queue = m_playlist.n_queued () > 0;
+    int left = 3, right = 3;
+
+    /* column widths depend on all the visible rows, including those that
+     * are not being repainted */
+
+    int number_width = 0, length_width = 0, queue_width = 0;
+
+    for (int i = m_first; i < last; i ++)
     {
-        width = 0;
+        RowCache & row = cache_row (i);
 
-        for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
+        if (show_numbers)
         {
-            char buf[16];
-            snprintf (buf, sizeof buf, "%d.", 1 + i);
+            if (! row.number)
+            {
+                char buf[16];
+                snprintf (buf, sizeof buf, "%d.", 1 + i);
+                row.number.capture (create_layout (buf));
+                row.number_width = layout_width (row.number.get ());
+            }
 
-            layout = gtk_widget_create_pango_layout (gtk_dr (), buf);
-            pango_layout_set_font_description (layout, m_font.get ());
+            number_width = aud::max (number_width, row.number_width);
+        }
 
-            PangoRectangle rect;
-            pango_layout_get_pixel_extents (layout, nullptr, & rect);
-            width = aud::max (width, rect.width);
+        length_width = aud::max (length_width, row.length_width);
 
-            cairo_move_to (cr, left, m_offset + m_row_height * (i - m_first));
-            set_cairo_color (cr, skin.colors[(i == active_entry) ?
-             SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
-            pango_cairo_show_layout (cr, layout);
-            g_object_unref (layout);
-        }
+        if (show_queue)
+        {
+            int pos = m_playlist.queue_find_entry (i);
 
-        left += width + 4;
+            if (pos != row.queue_pos)
+            {
+                if (pos >= 0)
+                {
+                    char buf[16];
+                    snprintf (buf, sizeof buf, "(#%d)", 1 + pos);
+                    row.queue.capture (create_layout (buf));
+                    row.queue_width = layout_width (row.queue.get ());
+                }
+                else
+                {
+                    row.queue.clear ();
+                    row.queue_width = 0;
+                }
+
+                row.queue_pos = pos;
+            }
+
+            queue_width = aud::max (queue_width, row.queue_width);
+        }
     }
 
-    /* entry lengths */
+    if (show_numbers)
+        left += number_width + 4;
 
-    width = 0;
+    right += length_width + 6;
 
-    for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
+    if (show_queue)
+        right += queue_width + 6;
+
+    /* if the columns moved, every row has to be repainted */
+    if (left != m_drawn_left || right != m_drawn_right)
     {
-        Tuple tuple = m_playlist.entry_tuple (i, Playlist::NoWait);
-        int len = tuple.get_int (Tuple::Length);
-        if (len < 0)
-            continue;
+        m_drawn_left = left;
+        m_drawn_right = right;
+        queue_draw ();
+    }
 
-        layout = gtk_widget_create_pango_layout (gtk_dr (), str_format_time (len));
-        pango_layout_set_font_description (layout, m_font.get ());
+    /* rows inside the area being repainted */
 
-        PangoRectangle rect;
-        pango_layout_get_pixel_extents (layout, nullptr, & rect);
-        width = aud::max (width, rect.width);
+    double x1, y1, x2, y2;
+    cairo_clip_extents (cr, & x1, & y1, & x2, & y2);
 
-        cairo_move_to (cr, m_width - right - rect.width, m_offset + m_row_height * (i - m_first));
-        set_cairo_color (cr, skin.colors[(i == active_entry) ?
-         SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
+    int first = aud::max (m_first, m_first + ((int) y1 - m_offset) / m_row_height);
+    int end = aud::min (last, m_first + ((int) y2 - m_offset) / m_row_height + 1);
+
+    /* background */
+
+    set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMALBG]);
+    cairo_paint (cr);
+
+    /* playlist title */
+
+    if (m_offset && y1 < m_offset)
+    {
+        PangoLayout * layout = create_layout (m_title_text);
+        pango_layout_set_width (layout, PANGO_SCALE * (m_width - 6));
+        pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
+        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_MIDDLE);
+
+        cairo_move_to (cr, 3, 0);
+        set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMAL]);
         pango_cairo_show_layout (cr, layout);
         g_object_unref (layout);
     }
 
-    right += width + 6;
-
-    /* queue positions */
-
-    if (m_playlist.n_queued ())
+    for (int i = first; i < end; i ++)
     {
-        width = 0;
+        RowCache & row = cache_row (i);
+        int y = m_offset + m_row_height * (i - m_first);
+
+        /* selection highlight */
 
-        for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
+        if (m_playlist.entry_selected (i))
         {
-            int pos = m_playlist.queue_find_entry (i);
-            if (pos < 0)
-                continue;
+            cairo_rectangle (cr, 0, y, m_width, m_row_height);
+            set_cairo_color (cr, skin.colors[SKIN_PLEDIT_SELECTEDBG]);
+            cairo_fill (cr);
+        }
 
-            char buf[16];
-            snprintf (buf, sizeof buf, "(#%d)", 1 + pos);
+        set_cairo_color (cr, skin.colors[(i == active_entry) ?
+         SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
 
-            layout = gtk_widget_create_pango_layout (gtk_dr (), buf);
-            pango_layout_set_font_description (layout, m_font.get ());
+        /* entry number */
+
+        if (show_numbers && row.number)
+        {
+            cairo_move_to (cr, 3, y);
+            pango_cairo_show_layout (cr, row.number.get ());
+        }
 
-            PangoRectangle rect;
-            pango_layout_get_pixel_extents (layout, nullptr, & rect);
-            width = aud::max (width, rect.width);
+        /* entry length */
 
-            cairo_move_to (cr, m_width - right - rect.width, m_offset +
-             m_row_height * (i - m_first));
-            set_cairo_color (cr, skin.colors[(i == active_entry) ?
-             SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
-            pango_cairo_show_layout (cr, layout);
-            g_object_unref (layout);
+        if (row.length)
+        {
+            cairo_move_to (cr, m_width - 3 - row.length_width, y);
+            pango_cairo_show_layout (cr, row.length.get ());
         }
 
-        right += width + 6;
-    }
+        /* queue position */
 
-    /* titles */
+        if (show_queue && row.queue)
+        {
+            cairo_move_to (cr, m_width - 9 - length_width - row.queue_width, y);
+            pango_cairo_show_layout (cr, row.queue.get ());
+        }
 
-    for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
-    {
-        Tuple tuple = m_playlist.entry_tuple (i, Playlist::NoWait);
-        String title = tuple.get_str (Tuple::FormattedTitle);
+        /* title */
 
-        layout = gtk_widget_create_pango_layout (gtk_dr (), title);
-        pango_layout_set_font_description (layout, m_font.get ());
-        pango_layout_set_width (layout, PANGO_SCALE * (m_width - left - right));
-        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+        int title_width = m_width - left - right;
 
-        cairo_move_to (cr, left, m_offset + m_row_height * (i - m_first));
-        set_cairo_color (cr, skin.colors[(i == active_entry) ?
-         SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
-        pango_cairo_show_layout (cr, layout);
-        g_object_unref (layout);
+        if (row.title_width != title_width)
+        {
+            pango_layout_set_width (row.title.get (), PANGO_SCALE * title_width);
+            row.title_width = title_width;
+        }
+
+        cairo_move_to (cr, left, y);
+        pango_cairo_show_layout (cr, row.title.get ());
     }
 
     /* focus rectangle */
@@ -340,12 +417,18 @@ void PlaylistWidget::set_font (const char * font)
     m_row_height = aud::max (rect.height, 1);
 
     g_object_unref (layout);
+
+    invalidate_rows (0, m_length);
+    queue_draw ();
     refresh ();
 }
 
 void PlaylistWidget::refresh ()
 {
     auto prev_playlist = m_playlist;
+    String prev_title = m_title_text;
+    int prev_length = m_length, prev_first = m_first, prev_rows = m_rows;
+
     m_playlist = Playlist::active_playlist ();
     m_length = m_playlist.n_entries ();
 
@@ -357,14 +440,70 @@ void PlaylistWidget::refresh ()
         cancel_all ();
         m_first = 0;
         ensure_visible (m_playlist.get_focus ());
+        invalidate_rows (0, prev_length);
     }
 
-    queue_draw ();
+    int position = m_playlist.get_position ();
+    int focus = m_playlist.get_focus ();
+
+    /* repaint everything if the rows moved, otherwise only the rows whose
+     * highlighting changed; other changes are handled in playlist_update() */
+    if (m_playlist != prev_playlist || m_length != prev_length ||
+        m_first != prev_first || m_rows != prev_rows ||
+        strcmp_safe (m_title_text, prev_title))
+    {
+        queue_draw ();
+    }
+    else
+    {
+        if (position != m_position)
+        {
+            queue_draw_rows (m_position, 1);
+            queue_draw_rows (position, 1);
+        }
+
+        if (focus != m_focus)
+        {
+            queue_draw_rows (m_focus, 1);
+            queue_draw_rows (focus, 1);
+        }
+    }
+
+    m_position = position;
+    m_focus = focus;
 
     if (m_slider)
         m_slider->refresh ();
 }
 
+void PlaylistWidget::playlist_update ()
+{
+    auto update = m_playlist.update_detail ();
+
+    if (update.level >= Playlist::Metadata)
+    {
+        /* with a structural change, all the following rows have moved */
+        int count = (update.level == Playlist::Structure) ? m_length :
+         m_playlist.n_entries () - update.before - update.after;
+
+        invalidate_rows (update.before, count);
+        queue_draw_rows (update.before, count);
+    }
+    else if (update.level == Playlist::Selection)
+    {
+        queue_draw_rows (update.before,
+         m_playlist.n_entries () - update.before - update.after);
+
+        /* the focus rectangle depends on the number of selected entries */
+        queue_draw_rows (m_playlist.get_focus (), 1);
+    }
+
+    if (update.queue_changed)
+        queue_draw ();
+
+    refresh ();
+}
+
 void PlaylistWidget::ensure_visible (int position)
 {
     if (position < m_first || position >= m_first + m_rows)
@@ -618,8 +757,9 @@ void PlaylistWidget::hover (int x, int y)
 
     if (row != m_hover)
     {
+        queue_draw_rows (m_hover - 1, 2);
+        queue_draw_rows (row - 1, 2);
         m_hover = row;
-        queue_draw ();
     }
 }
 
@@ -628,7 +768,7 @@ int PlaylistWidget::hover_end ()
     int temp = m_hover;
     m_hover = -1;
 
-    queue_draw ();
+    queue_draw_rows (temp - 1, 2);
     return temp;
 }
 
@@ -38,6 +38,11 @@ class PlaylistSlider;
 
 typedef SmartPtr<PangoFontDescription, pango_font_description_free> PangoFontDescPtr;
 
+inline void unref_pango_layout (PangoLayout * layout)
+    { g_object_unref (layout); }
+
+typedef SmartPtr<PangoLayout, unref_pango_layout> PangoLayoutPtr;
+
 class PlaylistWidget : public Widget
 {
 public:
@@ -48,6 +53,7 @@ public:
     void resize (int width, int height);
     void set_font (const char * font);
     void refresh ();
+    void playlist_update ();
     bool handle_keypress (GdkEventKey * event);
     void row_info (int * rows, int * first);
     void scroll_to (int row);
@@ -56,6 +62,19 @@ public:
     int hover_end ();
 
 private:
+    /* shaped layouts of one entry, kept between redraws */
+    struct RowCache {
+        int entry = -1;
+        PangoLayoutPtr number, length, title, queue;
+        int number_width = 0, length_width = 0, queue_width = 0;
+        int title_width = -1;  /* width the title is ellipsized to */
+        int queue_pos = -1;    /* position shown in the queue layout */
+    };
+
+    /* Direct-mapped by entry number, so any window of up to cache_rows
+     * consecutive entries is held without collisions. */
+    static constexpr int cache_rows = 256;
+
     void draw (cairo_t * cr);
     bool button_press (GdkEventButton * event);
     bool button_release (GdkEventButton * event);
@@ -65,6 +84,11 @@ private:
     void update_title ();
     void calc_layout ();
 
+    PangoLayout * create_layout (const char * text);
+    RowCache & cache_row (int entry);
+    void invalidate_rows (int row, int count);
+    void queue_draw_rows (int row, int count);
+
     int calc_position (int y) const;
     int adjust_position (bool relative, int position) const;
 
@@ -93,7 +117,10 @@ private:
     int m_length = 0;
     int m_width = 0, m_height = 0, m_row_height = 1, m_offset = 0, m_rows = 0, m_first = 0;
     int m_scroll = 0, m_hover = -1, m_drag = 0, m_popup_pos = -1;
+    int m_position = -1, m_focus = -1, m_drawn_left = 0, m_drawn_right = 0;
     QueuedFunc m_popup_timer;
+
+    RowCache m_cache[cache_rows];
 };
 
 #endif
@@ -211,6 +211,7 @@ void SkinnedUI::cleanup ()
     audgui_cleanup ();
 
     skin = Skin ();
+    skin_cache_clear ();
 
     user_skin_dir = String ();
     skin_thumb_dir = String ();
@@ -28,6 +28,7 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 
 #include <libaudcore/audstrings.h>
@@ -93,18 +94,29 @@ static const uint32_t default_vis_colors[24] = {
 
 Skin skin;
 
-static bool skin_load_pixmap_id (SkinPixmapId id, const char * path)
+/* recently loaded skins, least recently used first */
+#define SKIN_CACHE_SIZE 4
+
+struct CachedSkin {
+    String path;
+    int64_t mtime;
+    Skin skin;
+};
+
+static Index<CachedSkin> skin_cache;
+
+static bool skin_load_pixmap_id (SkinPixmapId id, SkinFiles & files)
 {
-    StringBuf filename = skin_pixmap_locate (path, skin_pixmap_id_map[id].name,
-     skin_pixmap_id_map[id].alt_name);
+    const char * name = skin_pixmap_id_map[id].name;
+    const Index<char> * data = files.get_pixmap (name, skin_pixmap_id_map[id].alt_name);
 
-    if (! filename)
+    if (! data)
     {
-        AUDERR ("Skin does not contain a \"%s\" pixmap.\n", skin_pixmap_id_map[id].name);
+        AUDERR ("Skin does not contain a \"%s\" pixmap.\n", name);
         return false;
     }
 
-    skin.pixmaps[id].capture (surface_new_from_file (filename));
+    skin.pixmaps[id].capture (surface_new_from_data (name, * data));
     return skin.pixmaps[id] ? true : false;
 }
 
@@ -149,18 +161,17 @@ static void skin_get_eq_spline_colors (cairo_surface_t * s)
         skin.eq_spline_colors[i] = surface_get_pixel (s, 115, i + 294);
 }
 
-static void skin_load_viscolor (const char * path)
+static void skin_load_viscolor (SkinFiles & files)
 {
     memcpy (skin.vis_colors, default_vis_colors, sizeof skin.vis_colors);
 
-    VFSFile file = open_local_file_nocase (path, "viscolor.txt");
-    if (! file)
+    const Index<char> * data = files.get ("viscolor.txt");
+    if (! data)
         return;
 
-    Index<char> buffer = file.read_all ();
-    buffer.append (0);  /* null-terminated */
+    StringBuf buffer = str_copy (data->begin (), data->len ());  /* null-terminated */
 
-    char * string = buffer.begin ();
+    char * string = buffer;
 
     for (int line = 0; string && line < 24; line ++)
     {
@@ -190,13 +201,11 @@ static void skin_numbers_generate_dash (CairoSurfacePtr & s)
     s.capture (surface);
 }
 
-static bool skin_load_pixmaps (const char * path)
+static bool skin_load_pixmaps (SkinFiles & files)
 {
-    AUDDBG ("Loading pixmaps in %s\n", path);
-
     /* eq_ex.bmp was added after Winamp 2.0 so some skins do not include it */
     for (int i = 0; i < SKIN_PIXMAP_COUNT; i ++)
-        if (! skin_load_pixmap_id ((SkinPixmapId) i, path) && i != SKIN_EQ_EX)
+        if (! skin_load_pixmap_id ((SkinPixmapId) i, files) && i != SKIN_EQ_EX)
             return false;
 
     skin_get_textcolors (skin.pixmaps[SKIN_TEXT].get ());
@@ -206,44 +215,131 @@ static bool skin_load_pixmaps (const char * path)
     return true;
 }
 
-static bool skin_load_data (const char * path)
+/* The pixmaps are never modified once loaded, so they are shared between
+ * the copies rather than duplicated. */
+static void skin_copy (Skin & dest, const Skin & src)
 {
-    AUDDBG ("Attempt to load skin \"%s\"\n", path);
+    dest.hints = src.hints;
 
-    if (! g_file_test (path, G_FILE_TEST_EXISTS))
-        return false;
+    memcpy (dest.colors, src.colors, sizeof dest.colors);
+    memcpy (dest.eq_spline_colors, src.eq_spline_colors, sizeof dest.eq_spline_colors);
+    memcpy (dest.vis_colors, src.vis_colors, sizeof dest.vis_colors);
 
-    StringBuf archive_path;
-    if (file_is_archive (path))
+    for (int i = 0; i < SKIN_PIXMAP_COUNT; i ++)
     {
-        AUDDBG ("Attempt to load archive\n");
-        archive_path = archive_decompress (path);
+        if (src.pixmaps[i])
+            dest.pixmaps[i].capture (cairo_surface_reference (src.pixmaps[i].get ()));
+        else
+            dest.pixmaps[i].clear ();
+    }
 
-        if (! archive_path)
+    for (int i = 0; i < SKIN_MASK_COUNT; i ++)
+    {
+        dest.masks[i].clear ();
+        for (const GdkRectangle & rect : src.masks[i])
+            dest.masks[i].append (rect);
+    }
+}
+
+static bool skin_cache_lookup (const char * path, int64_t mtime)
+{
+    for (int i = 0; i < skin_cache.len (); i ++)
+    {
+        if (strcmp (skin_cache[i].path, path) || skin_cache[i].mtime != mtime)
+            continue;
+
+        skin_copy (skin, skin_cache[i].skin);
+
+        /* move to the most recently used end */
+        CachedSkin entry = std::move (skin_cache[i]);
+        skin_cache.remove (i, 1);
+        skin_cache.append (std::move (entry));
+
+        return true;
+    }
+
+    return false;
+}
+
+static void skin_cache_add (const char * path, int64_t mtime)
+{
+    for (int i = 0; i < skin_cache.len (); i ++)
+    {
+        if (! strcmp (skin_cache[i].path, path))
         {
-            AUDDBG ("Unable to extract skin archive (%s)\n", path);
-            return false;
+            skin_cache.remove (i, 1);
+            break;
         }
+    }
 
-        path = archive_path;
+    if (skin_cache.len () >= SKIN_CACHE_SIZE)
+        skin_cache.remove (0, 1);
+
+    CachedSkin & entry = skin_cache.append ();
+    entry.path = String (path);
+    entry.mtime = mtime;
+    skin_copy (entry.skin, skin);
+}
+
+/* Editing a file inside a folder does not change the folder's modification
+ * time, so a folder skin is stamped with the newest of its files instead. */
+static int64_t skin_stamp (const char * path, const GStatBuf & info)
+{
+    int64_t stamp = info.st_mtime;
+
+    GDir * dir;
+    if (! S_ISDIR (info.st_mode) || ! (dir = g_dir_open (path, 0, nullptr)))
+        return stamp;
+
+    const char * name;
+    while ((name = g_dir_read_name (dir)))
+    {
+        GStatBuf file_info;
+        if (g_stat (filename_build ({path, name}), & file_info) == 0 &&
+         file_info.st_mtime > stamp)
+            stamp = file_info.st_mtime;
     }
 
-    bool success = skin_load_pixmaps (path);
+    g_dir_close (dir);
+    return stamp;
+}
+
+static bool skin_load_data (const char * path)
+{
+    AUDDBG ("Attempt to load skin \"%s\"\n", path);
+
+    GStatBuf info;
+    if (g_stat (path, & info) < 0)
+        return false;
+
+    int64_t stamp = skin_stamp (path, info);
 
-    if (success)
+    if (skin_cache_lookup (path, stamp))
     {
-        skin_load_hints (path);
-        skin_load_pl_colors (path);
-        skin_load_viscolor (path);
-        skin_load_masks (path);
+        AUDDBG ("Skin found in cache\n");
+        return true;
     }
-    else
+
+    SkinFiles files;
+    if (! files.load (path))
+    {
+        AUDDBG ("Unable to read skin (%s)\n", path);
+        return false;
+    }
+
+    if (! skin_load_pixmaps (files))
+    {
         AUDDBG ("Skin loading failed\n");
+        return false;
+    }
 
-    if (archive_path)
-        del_directory (archive_path);
+    skin_load_hints (files);
+    skin_load_pl_colors (files);
+    skin_load_viscolor (files);
+    skin_load_masks (files);
 
-    return success;
+    skin_cache_add (path, stamp);
+    return true;
 }
 
 bool skin_load (const char * path)
@@ -267,6 +363,11 @@ bool skin_load (const char * path)
     return false;
 }
 
+void skin_cache_clear ()
+{
+    skin_cache.clear ();
+}
+
 void skin_install_skin (const char * path)
 {
     GError * err = nullptr;
@@ -186,6 +186,7 @@ struct Skin {
 extern Skin skin;
 
 bool skin_load (const char * path);
+void skin_cache_clear ();
 
 void skin_draw_pixbuf (cairo_t * cr, SkinPixmapId id, int xsrc, int ysrc,
  int xdest, int ydest, int width, int height);
@@ -196,10 +197,12 @@ void skin_draw_playlistwin_shaded (cairo_t * cr, int width, bool focus);
 void skin_draw_playlistwin_frame (cairo_t * cr, int width, int height, bool focus);
 void skin_draw_mainwin_titlebar (cairo_t * cr, bool shaded, bool focus);
 
-/* ui_skin_load_ini.c */
-void skin_load_hints (const char * path);
-void skin_load_pl_colors (const char * path);
-void skin_load_masks (const char * path);
+/* skin-ini.cc */
+class SkinFiles;
+
+void skin_load_hints (SkinFiles & files);
+void skin_load_pl_colors (SkinFiles & files);
+void skin_load_masks (SkinFiles & files);
 
 static inline void set_cairo_color (cairo_t * cr, uint32_t c)
 {
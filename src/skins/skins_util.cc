@@ -30,6 +30,7 @@
 #include <unistd.h>
 
 #include <glib/gstdio.h>
+#include <zlib.h>
 
 #include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
@@ -77,26 +78,6 @@ StringBuf find_file_case_path (const char * folder, const char * basename)
     return StringBuf ();
 }
 
-VFSFile open_local_file_nocase (const char * folder, const char * basename)
-{
-    StringBuf path = find_file_case_path (folder, basename);
-    return path ? VFSFile (path, "r") : VFSFile ();
-}
-
-StringBuf skin_pixmap_locate (const char * folder, const char * basename, const char * altname)
-{
-    static const char * const exts[] = {".bmp", ".png", ".xpm"};
-
-    for (const char * ext : exts)
-    {
-        StringBuf name = find_file_case_path (folder, str_concat ({basename, ext}));
-        if (name)
-            return name.settle ();
-    }
-
-    return altname ? skin_pixmap_locate (folder, altname) : StringBuf ();
-}
-
 char * text_parse_line (char * text)
 {
     char * newline = strchr (text, '\n');
@@ -345,3 +326,382 @@ void make_directory (const char * path)
     if (g_mkdir_with_parents (path, DIRMODE) != 0)
         AUDWARN ("Error creating %s: %s\n", path, strerror (errno));
 }
+
+/* upper limit on the unpacked size of a single file in a skin archive */
+#define MAX_SKIN_FILE_SIZE (16 << 20)
+
+static String skin_file_key (const char * name)
+{
+    const char * slash = strrchr (name, '/');
+    return String (str_tolower (slash ? slash + 1 : name));
+}
+
+static unsigned get_le16 (const unsigned char * p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned get_le32 (const unsigned char * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned) p[3] << 24);
+}
+
+static bool inflate_raw (const unsigned char * in, unsigned in_len,
+ Index<char> & out, unsigned out_len)
+{
+    z_stream z {};
+    if (inflateInit2 (& z, -MAX_WBITS) != Z_OK)
+        return false;
+
+    out.insert (0, out_len);
+
+    z.next_in = (Bytef *) in;
+    z.avail_in = in_len;
+    z.next_out = (Bytef *) out.begin ();
+    z.avail_out = out_len;
+
+    int ret = inflate (& z, Z_FINISH);
+    bool success = (ret == Z_STREAM_END && z.total_out == out_len);
+
+    inflateEnd (& z);
+    return success;
+}
+
+static bool read_zip (const Index<char> & archive, SimpleHash<String, Index<char>> & files)
+{
+    auto data = (const unsigned char *) archive.begin ();
+    unsigned len = archive.len ();
+
+    /* find the end of central directory record, which may be followed by a
+     * comment of up to 64 KiB */
+    const unsigned char * end = nullptr;
+    for (int pos = archive.len () - 22; pos >= 0 && archive.len () - pos <= 22 + 0xffff; pos --)
+    {
+        if (get_le32 (data + pos) == 0x06054b50)
+        {
+            end = data + pos;
+            break;
+        }
+    }
+
+    if (! end)
+    {
+        AUDWARN ("Zip end of central directory not found.\n");
+        return false;
+    }
+
+    unsigned n_entries = get_le16 (end + 10);
+    unsigned dir_size = get_le32 (end + 12);
+    unsigned dir_offset = get_le32 (end + 16);
+
+    if (dir_offset > len || dir_size > len - dir_offset)
+        return false;
+
+    const unsigned char * entry = data + dir_offset;
+    const unsigned char * dir_end = entry + dir_size;
+
+    for (unsigned i = 0; i < n_entries; i ++)
+    {
+        if (dir_end - entry < 46 || get_le32 (entry) != 0x02014b50)
+            return false;
+
+        unsigned method = get_le16 (entry + 10);
+        unsigned packed_size = get_le32 (entry + 20);
+        unsigned size = get_le32 (entry + 24);
+        unsigned name_len = get_le16 (entry + 28);
+        unsigned extra_len = get_le16 (entry + 30);
+        unsigned comment_len = get_le16 (entry + 32);
+        unsigned header_offset = get_le32 (entry + 42);
+
+        if ((unsigned) (dir_end - entry) < 46 + name_len + extra_len + comment_len)
+            return false;
+
+        StringBuf name = str_copy ((const char *) entry + 46, name_len);
+        entry += 46 + name_len + extra_len + comment_len;
+
+        /* skip folders */
+        if (! name_len || name[name_len - 1] == '/')
+            continue;
+
+        if (size > MAX_SKIN_FILE_SIZE || (uint64_t) header_offset + 30 > len ||
+         get_le32 (data + header_offset) != 0x04034b50)
+        {
+            AUDWARN ("Skipping %s in zip archive.\n", (const char *) name);
+            continue;
+        }
+
+        unsigned data_offset = header_offset + 30 +
+         get_le16 (data + header_offset + 26) + get_le16 (data + header_offset + 28);
+
+        if (data_offset > len || packed_size > len - data_offset)
+            return false;
+
+        Index<char> buf;
+
+        if (method == 0 && packed_size == size)
+        {
+            buf.insert (0, size);
+            memcpy (buf.begin (), data + data_offset, size);
+        }
+        else if (method != 8 || ! inflate_raw (data + data_offset, packed_size, buf, size))
+        {
+            AUDWARN ("Unable to decompress %s in zip archive.\n", (const char *) name);
+            continue;
+        }
+
+        files.add (skin_file_key (name), std::move (buf));
+    }
+
+    return true;
+}
+
+static bool gunzip (const Index<char> & in, Index<char> & out)
+{
+    z_stream z {};
+    if (inflateInit2 (& z, 16 + MAX_WBITS) != Z_OK)
+        return false;
+
+    z.next_in = (Bytef *) in.begin ();
+    z.avail_in = in.len ();
+
+    int ret = Z_OK;
+    while (ret == Z_OK || ret == Z_BUF_ERROR)
+    {
+        if (out.len () >= MAX_SKIN_FILE_SIZE * 4)
+            break;
+
+        int pos = out.len ();
+        out.resize (aud::max (2 * pos, 65536));
+
+        z.next_out = (Bytef *) out.begin () + pos;
+        z.avail_out = out.len () - pos;
+
+        ret = inflate (& z, Z_NO_FLUSH);
+
+        out.resize (out.len () - z.avail_out);
+
+        /* a stalled stream means the input was truncated */
+        if (ret == Z_BUF_ERROR && ! z.avail_in)
+            break;
+
+        /* concatenated gzip members */
+        if (ret == Z_STREAM_END && z.avail_in)
+            ret = inflateReset (& z);
+    }
+
+    inflateEnd (& z);
+    return (ret == Z_STREAM_END);
+}
+
+static int64_t parse_tar_number (const char * field, int size)
+{
+    StringBuf str = str_copy (field, strnlen (field, size));
+    return strtoll (str, nullptr, 8);
+}
+
+static bool read_tar (const Index<char> & archive, SimpleHash<String, Index<char>> & files)
+{
+    const char * data = archive.begin ();
+    int64_t len = archive.len ();
+    String long_name;
+
+    for (int64_t pos = 0; pos + 512 <= len; )
+    {
+        const char * header = data + pos;
+
+        /* a zero block marks the end of the archive */
+        if (! header[0])
+            break;
+
+        int64_t size = parse_tar_number (header + 124, 12);
+        char type = header[156];
+
+        pos += 512;
+
+        if (size < 0 || size > len - pos)
+            return false;
+
+        if (type == 'L')  /* GNU long name for the next entry */
+            long_name = String (str_copy (data + pos, strnlen (data + pos, size)));
+        else if (type == '0' || type == '\0' || type == '7')
+        {
+            StringBuf name = long_name ? str_copy (long_name) :
+             str_copy (header, strnlen (header, 100));
+
+            if (size <= MAX_SKIN_FILE_SIZE)
+            {
+                Index<char> buf;
+                buf.insert (0, size);
+                memcpy (buf.begin (), data + pos, size);
+                files.add (skin_file_key (name), std::move (buf));
+            }
+
+            long_name = String ();
+        }
+        else if (type != 'x' && type != 'g')
+            long_name = String ();
+
+        pos += (size + 511) & ~(int64_t) 511;
+    }
+
+    return true;
+}
+
+/* bzip2 is not handled in-process; the archive is extracted to a temporary
+ * folder as before and its contents read into memory */
+static bool read_extracted (const char * path, SimpleHash<String, Index<char>> & files)
+{
+    StringBuf tmpdir = archive_decompress (path);
+    if (! tmpdir)
+        return false;
+
+    GDir * dir = g_dir_open (tmpdir, 0, nullptr);
+    if (dir)
+    {
+        const char * name;
+        while ((name = g_dir_read_name (dir)))
+        {
+            StringBuf file_path = filename_build ({tmpdir, name});
+            if (g_file_test (file_path, G_FILE_TEST_IS_REGULAR))
+            {
+                VFSFile file (file_path, "r");
+                if (file)
+                    files.add (skin_file_key (name), file.read_all ());
+            }
+        }
+
+        g_dir_close (dir);
+    }
+
+    del_directory (tmpdir);
+    return true;
+}
+
+bool SkinFiles::load (const char * path)
+{
+    m_folder = String ();
+    m_files.clear ();
+
+    ArchiveType type = archive_get_type (path);
+
+    if (type == ARCHIVE_UNKNOWN)
+    {
+        m_folder = String (path);
+        return true;
+    }
+
+    if (type == ARCHIVE_TBZ2)
+        return read_extracted (path, m_files);
+
+    VFSFile file (path, "r");
+    if (! file)
+        return false;
+
+    Index<char> archive = file.read_all ();
+    bool success = false;
+
+    if (type == ARCHIVE_ZIP)
+        success = read_zip (archive, m_files);
+    else if (type == ARCHIVE_TAR)
+        success = read_tar (archive, m_files);
+    else if (type == ARCHIVE_TGZ)
+    {
+        Index<char> unpacked;
+        success = gunzip (archive, unpacked) && read_tar (unpacked, m_files);
+    }
+
+    if (! success)
+        AUDWARN ("Unable to read skin archive %s\n", path);
+
+    return success;
+}
+
+const Index<char> * SkinFiles::get (const char * basename)
+{
+    String key = skin_file_key (basename);
+    Index<char> * data = m_files.lookup (key);
+
+    /* files in a folder are read on demand */
+    if (data || ! m_folder)
+        return data;
+
+    StringBuf path = find_file_case_path (m_folder, basename);
+    if (! path)
+        return nullptr;
+
+    VFSFile file (path, "r");
+    if (! file)
+        return nullptr;
+
+    return m_files.add (key, file.read_all ());
+}
+
+const Index<char> * SkinFiles::get_pixmap (const char * basename, const char * altname)
+{
+    static const char * const exts[] = {".bmp", ".png", ".xpm"};
+
+    for (const char * ext : exts)
+    {
+        const Index<char> * data = get (str_concat ({basename, ext}));
+        if (data)
+            return data;
+    }
+
+    return altname ? get_pixmap (altname) : nullptr;
+}
+
+class MemoryFile : public VFSImpl
+{
+public:
+    MemoryFile (const Index<char> & data) :
+        m_data (data) {}
+
+    int64_t fread (void * ptr, int64_t size, int64_t nmemb)
+    {
+        if (size <= 0)
+            return 0;
+
+        int64_t n = aud::min (nmemb, (m_data.len () - m_pos) / size);
+        memcpy (ptr, m_data.begin () + m_pos, n * size);
+        m_pos += n * size;
+        return n;
+    }
+
+    int64_t fwrite (const void * ptr, int64_t size, int64_t nmemb)
+        { return 0; }
+
+    int fseek (int64_t offset, VFSSeekType whence)
+    {
+        if (whence == VFS_SEEK_CUR)
+            offset += m_pos;
+        else if (whence == VFS_SEEK_END)
+            offset += m_data.len ();
+
+        if (offset < 0 || offset > m_data.len ())
+            return -1;
+
+        m_pos = offset;
+        return 0;
+    }
+
+    int64_t ftell ()
+        { return m_pos; }
+    int64_t fsize ()
+        { return m_data.len (); }
+    bool feof ()
+        { return m_pos >= m_data.len (); }
+    int ftruncate (int64_t length)
+        { return -1; }
+    int fflush ()
+        { return 0; }
+
+private:
+    const Index<char> & m_data;
+    int64_t m_pos = 0;
+};
+
+VFSFile SkinFiles::open (const char * basename)
+{
+    const Index<char> * data = get (basename);
+    return data ? VFSFile (basename, new MemoryFile (* data)) : VFSFile ();
+}
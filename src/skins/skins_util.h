@@ -26,16 +26,13 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <libaudcore/multihash.h>
 #include <libaudcore/vfs.h>
 
 typedef void (* DirForeachFunc) (const char * path, const char * basename);
 
 StringBuf find_file_case_path (const char * folder, const char * basename);
 
-VFSFile open_local_file_nocase (const char * folder, const char * basename);
-StringBuf skin_pixmap_locate (const char * folder, const char * basename,
- const char * altname = nullptr);
-
 char * text_parse_line (char * text);
 
 void make_directory (const char * path);
@@ -49,4 +46,22 @@ bool file_is_archive (const char * filename);
 StringBuf archive_basename (const char * str);
 StringBuf archive_decompress (const char * path);
 
+/* The files making up a skin, which may be either a folder or an archive.
+ * Zip and tar (optionally gzipped) archives are read straight into memory;
+ * as with "unzip -j", any folders within the archive are ignored.  Files are
+ * looked up by basename without regard to case. */
+class SkinFiles
+{
+public:
+    bool load (const char * path);
+
+    const Index<char> * get (const char * basename);
+    const Index<char> * get_pixmap (const char * basename, const char * altname = nullptr);
+    VFSFile open (const char * basename);
+
+private:
+    String m_folder;
+    SimpleHash<String, Index<char>> m_files;
+};
+
 #endif
@@ -33,6 +33,7 @@
 #include "skin.h"
 #include "skinselector.h"
 #include "skins_util.h"
+#include "surface.h"
 #include "view.h"
 
 enum SkinViewCols {
@@ -53,23 +54,14 @@ static void skin_view_on_cursor_changed (GtkTreeView * treeview);
 static AudguiPixbuf skin_get_preview (const char * path)
 {
     AudguiPixbuf preview;
+    SkinFiles files;
 
-    StringBuf archive_path;
-    if (file_is_archive (path))
-    {
-        archive_path = archive_decompress (path);
-        if (! archive_path)
-            return preview;
-
-        path = archive_path;
-    }
-
-    StringBuf preview_path = skin_pixmap_locate (path, "main");
-    if (preview_path)
-        preview.capture (gdk_pixbuf_new_from_file (preview_path, nullptr));
+    if (! files.load (path))
+        return preview;
 
-    if (archive_path)
-        del_directory (archive_path);
+    const Index<char> * data = files.get_pixmap ("main");
+    if (data)
+        preview.capture (pixbuf_new_from_data ("main", * data));
 
     return preview;
 }
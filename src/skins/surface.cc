@@ -31,28 +31,48 @@ cairo_surface_t * surface_new (int w, int h)
     return cairo_image_surface_create (CAIRO_FORMAT_RGB24, w, h);
 }
 
-cairo_surface_t * surface_new_from_file (const char * name)
+static cairo_surface_t * surface_new_from_pixbuf (GdkPixbuf * p)
+{
+    cairo_surface_t * surface = surface_new (gdk_pixbuf_get_width (p),
+     gdk_pixbuf_get_height (p));
+    cairo_t * cr = cairo_create (surface);
+
+    gdk_cairo_set_source_pixbuf (cr, p, 0, 0);
+    cairo_paint (cr);
+
+    cairo_destroy (cr);
+    return surface;
+}
+
+GdkPixbuf * pixbuf_new_from_data (const char * name, const Index<char> & data)
 {
     GError * error = nullptr;
-    AudguiPixbuf p (gdk_pixbuf_new_from_file (name, & error));
+    GdkPixbufLoader * loader = gdk_pixbuf_loader_new ();
+
+    if (gdk_pixbuf_loader_write (loader, (const unsigned char *) data.begin (),
+     data.len (), & error))
+        gdk_pixbuf_loader_close (loader, & error);
+    else
+        gdk_pixbuf_loader_close (loader, nullptr);
+
+    GdkPixbuf * p = nullptr;
 
     if (error)
     {
         AUDERR ("Error loading %s: %s.\n", name, error->message);
         g_error_free (error);
     }
+    else if ((p = gdk_pixbuf_loader_get_pixbuf (loader)))
+        g_object_ref (p);
 
-    if (! p)
-        return nullptr;
-
-    cairo_surface_t * surface = surface_new (p.width (), p.height ());
-    cairo_t * cr = cairo_create (surface);
-
-    gdk_cairo_set_source_pixbuf (cr, p.get (), 0, 0);
-    cairo_paint (cr);
+    g_object_unref (loader);
+    return p;
+}
 
-    cairo_destroy (cr);
-    return surface;
+cairo_surface_t * surface_new_from_data (const char * name, const Index<char> & data)
+{
+    AudguiPixbuf p (pixbuf_new_from_data (name, data));
+    return p ? surface_new_from_pixbuf (p.get ()) : nullptr;
 }
 
 uint32_t surface_get_pixel (cairo_surface_t * s, int x, int y)
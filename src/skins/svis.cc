@@ -42,7 +42,7 @@ static const int svis_vu_normal_colors[] = {16, 14, 12, 10, 8, 6, 4, 2};
 #define RGB_SET_INDEX(c) RGB_SET (skin.vis_colors[c])
 #define RGB_SET_INDEX_Y(c) RGB_SET_Y (skin.vis_colors[c])
 
-void SmallVis::draw (cairo_t * cr)
+void SmallVis::rasterize ()
 {
     uint32_t rgb[38 * 5];
     uint32_t * set;
@@ -173,15 +173,22 @@ void SmallVis::draw (cairo_t * cr)
     }
 
 DRAW:
-    cairo_surface_t * surf = cairo_image_surface_create_for_data
-     ((unsigned char *) rgb, CAIRO_FORMAT_RGB24, 38, 5, 4 * 38);
-    cairo_set_source_surface (cr, surf, 0, 0);
-    cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_NEAREST);
-    cairo_paint (cr);
-    cairo_surface_destroy (surf);
+    m_surface.update (rgb);
+}
+
+void SmallVis::draw (cairo_t * cr)
+{
+    /* after render(), only the changed columns need to be repainted */
+    if (m_rendered)
+        m_surface.clip_dirty (cr);
+    else
+        rasterize ();
+
+    m_surface.paint (cr);
 }
 
-SmallVis::SmallVis ()
+SmallVis::SmallVis () :
+    m_surface (38, 5, config.scale)
 {
     set_scale (config.scale);
     add_drawable (38, 5);
@@ -209,5 +216,12 @@ void SmallVis::render (const unsigned char * data)
     }
 
     m_active = true;
-    draw_now ();
+    rasterize ();
+
+    if (m_surface.dirty ())
+    {
+        m_rendered = true;
+        draw_now ();
+        m_rendered = false;
+    }
 }
@@ -42,6 +42,99 @@ static const int vis_scope_colors[16] = {22, 22, 21, 21, 20, 10, 19, 19, 18,
 #define RGB_SET_INDEX(c) RGB_SET (skin.vis_colors[c])
 #define RGB_SET_INDEX_Y(c) RGB_SET_Y (skin.vis_colors[c])
 
+VisSurface::VisSurface (int width, int height, int scale) :
+    m_width (width),
+    m_height (height),
+    m_scale (scale),
+    m_surface (cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+     width * scale, height * scale))
+{
+    m_prev.insert (0, width * height);
+}
+
+void VisSurface::update (const uint32_t * rgb)
+{
+    int start = m_width, end = 0;
+
+    if (m_valid)
+    {
+        /* find the range of columns that changed */
+        for (int y = 0; y < m_height; y ++)
+        {
+            const uint32_t * a = rgb + m_width * y;
+            const uint32_t * b = & m_prev[m_width * y];
+
+            int x = 0;
+            while (x < start && a[x] == b[x])
+                x ++;
+
+            start = x;
+
+            x = m_width;
+            while (x > end && a[x - 1] == b[x - 1])
+                x --;
+
+            end = x;
+        }
+    }
+    else
+    {
+        start = 0;
+        end = m_width;
+        m_valid = true;
+    }
+
+    m_dirty_start = start;
+    m_dirty_end = end;
+
+    if (start >= end)
+        return;
+
+    memcpy (m_prev.begin (), rgb, sizeof (uint32_t) * m_width * m_height);
+
+    cairo_surface_flush (m_surface.get ());
+
+    unsigned char * data = cairo_image_surface_get_data (m_surface.get ());
+    int stride = cairo_image_surface_get_stride (m_surface.get ());
+    int run = (end - start) * m_scale;
+
+    for (int y = 0; y < m_height; y ++)
+    {
+        const uint32_t * in = rgb + m_width * y + start;
+        uint32_t * out = (uint32_t *) (data + stride * m_scale * y) + start * m_scale;
+
+        if (m_scale == 1)
+            memcpy (out, in, sizeof (uint32_t) * run);
+        else
+        {
+            for (int x = 0; x < run; x ++)
+                out[x] = in[x / m_scale];
+        }
+
+        /* the remaining lines of a scaled row are identical */
+        for (int i = 1; i < m_scale; i ++)
+            memcpy ((unsigned char *) out + stride * i, out, sizeof (uint32_t) * run);
+    }
+
+    cairo_surface_mark_dirty_rectangle (m_surface.get (), start * m_scale, 0,
+     run, m_height * m_scale);
+}
+
+void VisSurface::clip_dirty (cairo_t * cr)
+{
+    cairo_rectangle (cr, m_dirty_start, 0, m_dirty_end - m_dirty_start, m_height);
+    cairo_clip (cr);
+}
+
+void VisSurface::paint (cairo_t * cr)
+{
+    /* undo the scaling of the widget so that the surface is copied
+     * pixel for pixel */
+    cairo_scale (cr, 1.0 / m_scale, 1.0 / m_scale);
+    cairo_set_source_surface (cr, m_surface.get (), 0, 0);
+    cairo_paint (cr);
+}
+
 void SkinnedVis::set_colors ()
 {
     uint32_t fgc = skin.colors[SKIN_TEXTFG];
@@ -83,7 +176,7 @@ void SkinnedVis::set_colors ()
     }
 }
 
-void SkinnedVis::draw (cairo_t * cr)
+void SkinnedVis::rasterize ()
 {
     uint32_t rgb[76 * 16];
     uint32_t * set;
@@ -142,16 +235,6 @@ void SkinnedVis::draw (cairo_t * cr)
     }
     case VIS_VOICEPRINT:
     {
-        if (m_voiceprint_advance)
-        {
-            m_voiceprint_advance = false;
-            memmove (m_voiceprint_data, m_voiceprint_data + 1, sizeof
-             m_voiceprint_data - 1);
-
-            for (int y = 0; y < 16; y ++)
-                m_voiceprint_data[76 * y + 75] = m_data[y];
-        }
-
         unsigned char * get = m_voiceprint_data;
         uint32_t * colors = (config.voiceprint_mode == VOICEPRINT_NORMAL) ?
          m_voice_color : (config.voiceprint_mode == VOICEPRINT_FIRE) ?
@@ -229,15 +312,22 @@ void SkinnedVis::draw (cairo_t * cr)
     }
 
 DRAW:
-    cairo_surface_t * surf = cairo_image_surface_create_for_data
-     ((unsigned char *) rgb, CAIRO_FORMAT_RGB24, 76, 16, 4 * 76);
-    cairo_set_source_surface (cr, surf, 0, 0);
-    cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_NEAREST);
-    cairo_paint (cr);
-    cairo_surface_destroy (surf);
+    m_surface.update (rgb);
 }
 
-SkinnedVis::SkinnedVis ()
+void SkinnedVis::draw (cairo_t * cr)
+{
+    /* after render(), only the changed columns need to be repainted */
+    if (m_rendered)
+        m_surface.clip_dirty (cr);
+    else
+        rasterize ();
+
+    m_surface.paint (cr);
+}
+
+SkinnedVis::SkinnedVis () :
+    m_surface (76, 16, config.scale)
 {
     set_scale (config.scale);
     add_drawable (76, 16);
@@ -247,7 +337,6 @@ SkinnedVis::SkinnedVis ()
 void SkinnedVis::clear ()
 {
     m_active = false;
-    m_voiceprint_advance = false;
 
     memset (m_data, 0, sizeof m_data);
     memset (m_peak, 0, sizeof m_peak);
@@ -309,7 +398,11 @@ void SkinnedVis::render (const unsigned char * data)
         for (int i = 0; i < 16; i ++)
             m_data[i] = data[15 - i];
 
-        m_voiceprint_advance = true;
+        memmove (m_voiceprint_data, m_voiceprint_data + 1, sizeof
+         m_voiceprint_data - 1);
+
+        for (int y = 0; y < 16; y ++)
+            m_voiceprint_data[76 * y + 75] = m_data[y];
     }
     else
     {
@@ -318,5 +411,12 @@ void SkinnedVis::render (const unsigned char * data)
     }
 
     m_active = true;
-    draw_now ();
+    rasterize ();
+
+    if (m_surface.dirty ())
+    {
+        m_rendered = true;
+        draw_now ();
+        m_rendered = false;
+    }
 }
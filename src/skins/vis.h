@@ -22,8 +22,13 @@
 #define SKINS_UI_VIS_H
 
 #include <stdint.h>
+#include <libaudcore/index.h>
+#include <libaudcore/objects.h>
+
 #include "widget.h"
 
+typedef SmartPtr<cairo_surface_t, cairo_surface_destroy> CairoSurfacePtr;
+
 typedef enum {
     VIS_ANALYZER, VIS_SCOPE, VIS_VOICEPRINT, VIS_OFF
 } VisType;
@@ -52,6 +57,36 @@ typedef enum {
     FALLOFF_SLOWEST, FALLOFF_SLOW, FALLOFF_MEDIUM, FALLOFF_FAST, FALLOFF_FASTEST
 } FalloffSpeed;
 
+/* Persistent image of a visualization, kept at the scale of the screen.
+ * Each frame is rasterized into a small unscaled buffer; only the columns
+ * that differ from the previous frame are scaled up into the surface. */
+class VisSurface
+{
+public:
+    VisSurface (int width, int height, int scale);
+
+    void update (const uint32_t * rgb);
+    bool dirty () const
+        { return m_dirty_end > m_dirty_start; }
+
+    /* cr is expected to be scaled as for the widget */
+    void clip_dirty (cairo_t * cr);
+    void paint (cairo_t * cr);
+
+    int dirty_x () const
+        { return m_dirty_start; }
+    int dirty_width () const
+        { return m_dirty_end - m_dirty_start; }
+
+private:
+    int m_width, m_height, m_scale;
+    int m_dirty_start = 0, m_dirty_end = 0;
+    bool m_valid = false;
+
+    Index<uint32_t> m_prev;
+    CairoSurfacePtr m_surface;
+};
+
 class SkinnedVis : public Widget
 {
 public:
@@ -62,13 +97,17 @@ public:
 
 private:
     void draw (cairo_t * cr);
+    void rasterize ();
+
+    VisSurface m_surface;
+    bool m_rendered = false;
 
     uint32_t m_voice_color[256];
     uint32_t m_voice_color_fire[256];
     uint32_t m_voice_color_ice[256];
     uint32_t m_pattern_fill[76 * 2];
 
-    bool m_active, m_voiceprint_advance;
+    bool m_active;
     float m_data[75], m_peak[75], m_peak_speed[75];
     unsigned char m_voiceprint_data[76 * 16];
 };
@@ -82,6 +121,10 @@ public:
 
 private:
     void draw (cairo_t * cr);
+    void rasterize ();
+
+    VisSurface m_surface;
+    bool m_rendered = false;
 
     bool m_active;
     int m_data[75];
@@ -0,0 +1,319 @@
+/*
+ * Spectrum analysis shared by the spectrum visualizers
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include <libaudcore/drct.h>
+#include <libaudcore/templates.h>
+
+#include "spectrum.h"
+
+/* lowest frequency shown; below this a 512-sample block holds less than one
+ * period, so there is nothing meaningful to show */
+#define MIN_FREQ 40.0f
+
+static int round_fft_size (int size)
+{
+    int n = SpectrumAnalyzer::min_fft_size;
+    while (n < size && n < SpectrumAnalyzer::max_fft_size)
+        n <<= 1;
+
+    return n;
+}
+
+void SpectrumAnalyzer::configure (int bands, int fft_size, Scale scale, float db_range)
+{
+    fft_size = round_fft_size (fft_size);
+    bands = aud::max (bands, 1);
+
+    m_db_range = db_range;
+
+    if (fft_size != m_fft_size)
+    {
+        m_fft_size = fft_size;
+        make_fft_tables ();
+        m_rate = 0; /* the band tables depend on the FFT size */
+    }
+
+    if (bands != m_bands || scale != m_scale)
+    {
+        m_bands = bands;
+        m_scale = scale;
+        m_rate = 0;
+
+        m_level.resize (bands);
+        m_delay.resize (bands);
+        clear ();
+    }
+}
+
+void SpectrumAnalyzer::set_smoothing (int hold, float falloff)
+{
+    m_hold = hold;
+    m_falloff = falloff;
+}
+
+void SpectrumAnalyzer::clear ()
+{
+    for (float & level : m_level)
+        level = 0;
+    for (int & delay : m_delay)
+        delay = 0;
+}
+
+void SpectrumAnalyzer::make_fft_tables ()
+{
+    int n = m_fft_size;
+
+    int bits = 0;
+    while ((1 << bits) < n)
+        bits ++;
+
+    m_bitrev.resize (n);
+    for (int i = 0; i < n; i ++)
+    {
+        int r = 0;
+        for (int b = 0; b < bits; b ++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+
+        m_bitrev[i] = r;
+    }
+
+    m_cos.resize (n / 2);
+    m_sin.resize (n / 2);
+
+    for (int i = 0; i < n / 2; i ++)
+    {
+        m_cos[i] = cos (2 * M_PI * i / n);
+        m_sin[i] = -sin (2 * M_PI * i / n);
+    }
+
+    m_window.resize (block_size);
+    for (int i = 0; i < block_size; i ++)
+        m_window[i] = 0.5 - 0.5 * cos (2 * M_PI * (i + 0.5) / block_size);
+
+    m_re.resize (n);
+    m_im.resize (n);
+    m_mag.resize (n / 2);
+}
+
+/* Builds the bin weights of each band.  The weights include the scaling that
+ * makes the output independent of the FFT size: a band sums what would be the
+ * magnitudes of the unpadded spectrum, as the older log-scale code did. */
+void SpectrumAnalyzer::make_band_tables ()
+{
+    int bins = m_fft_size / 2;
+    float bins_per_hz = (float) m_fft_size / m_rate;
+    float padding = (float) block_size / m_fft_size;
+
+    /* band edges (or centers, for constant Q) as fractional bin positions */
+    float lo_freq = MIN_FREQ, hi_freq = m_rate * 0.5f;
+    Index<float> edges;
+    edges.resize (m_bands + 1);
+
+    for (int i = 0; i <= m_bands; i ++)
+        edges[i] = lo_freq * powf (hi_freq / lo_freq, (float) i / m_bands) * bins_per_hz;
+
+    m_start.resize (m_bands);
+    m_len.resize (m_bands);
+    m_offset.resize (m_bands);
+    m_weights.clear ();
+
+    for (int b = 0; b < m_bands; b ++)
+    {
+        float lo = edges[b], hi = edges[b + 1];
+        float center = sqrtf (lo * hi);
+
+        /* a constant-Q band reaches to the centers of its neighbours */
+        if (m_scale == ConstantQ)
+        {
+            float ratio = hi / lo;
+            lo = center / ratio;
+            hi = center * ratio;
+        }
+
+        int first = aud::clamp ((int) floorf (lo), 1, bins - 1);
+        int last = aud::clamp ((int) ceilf (hi), first + 1, bins);
+
+        m_start[b] = first;
+        m_len[b] = last - first;
+        m_offset[b] = m_weights.len ();
+
+        float total = 0;
+
+        for (int k = first; k < last; k ++)
+        {
+            float w;
+
+            if (m_scale == ConstantQ)
+            {
+                /* triangle, measured on a log scale */
+                float pos = logf ((k + 0.5f) / center) / logf (hi / center);
+                w = aud::max (0.0f, 1 - fabsf (pos));
+            }
+            else
+            {
+                /* part of the bin [k, k + 1) that lies within the band */
+                w = aud::max (0.0f, aud::min (hi, k + 1.0f) - aud::max (lo, (float) k));
+            }
+
+            m_weights.append (w);
+            total += w;
+        }
+
+        /* a constant-Q band weighs as much in total as a log-scale band of the
+         * same width would */
+        if (m_scale == ConstantQ && total > 0)
+        {
+            float scale = (edges[b + 1] - edges[b]) / total;
+            for (int k = 0; k < m_len[b]; k ++)
+                m_weights[m_offset[b] + k] *= scale;
+        }
+
+        for (int k = 0; k < m_len[b]; k ++)
+            m_weights[m_offset[b] + k] *= padding;
+    }
+}
+
+/* iterative radix-2 FFT of m_re and m_im, in place */
+void SpectrumAnalyzer::fft ()
+{
+    int n = m_fft_size;
+    float * re = m_re.begin ();
+    float * im = m_im.begin ();
+
+    for (int i = 0; i < n; i ++)
+    {
+        int j = m_bitrev[i];
+        if (j > i)
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (int half = 1; half < n; half <<= 1)
+    {
+        int step = n / (half << 1);
+
+        for (int start = 0; start < n; start += half << 1)
+        {
+            for (int k = 0; k < half; k ++)
+            {
+                float wr = m_cos[k * step], wi = m_sin[k * step];
+                int a = start + k, b = a + half;
+
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+static float dot (const float * a, const float * b, int len)
+{
+    float sum = 0;
+    int i = 0;
+
+#ifdef __SSE__
+    __m128 vsum = _mm_setzero_ps ();
+
+    for (; i + 4 <= len; i += 4)
+        vsum = _mm_add_ps (vsum, _mm_mul_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+
+    float lanes[4];
+    _mm_storeu_ps (lanes, vsum);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+    for (; i < len; i ++)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+void SpectrumAnalyzer::analyze (const float * pcm, float * out)
+{
+    if (! m_bands)
+        return;
+
+    int bitrate, rate, channels;
+    aud_drct_get_info (bitrate, rate, channels);
+    if (rate <= 0)
+        rate = 44100;
+
+    if (rate != m_rate)
+    {
+        m_rate = rate;
+        make_band_tables ();
+    }
+
+    for (int i = 0; i < block_size; i ++)
+        m_re[i] = pcm[i] * m_window[i];
+    for (int i = block_size; i < m_fft_size; i ++)
+        m_re[i] = 0;
+    for (float & x : m_im)
+        x = 0;
+
+    fft ();
+
+    /* a full-scale sine peaks at 1 */
+    float scale = 4.0f / block_size;
+    for (int k = 0; k < m_fft_size / 2; k ++)
+        m_mag[k] = scale * sqrtf (m_re[k] * m_re[k] + m_im[k] * m_im[k]);
+
+    for (int b = 0; b < m_bands; b ++)
+    {
+        float sum = dot (m_mag.begin () + m_start[b], m_weights.begin () + m_offset[b], m_len[b]);
+
+        /* fudge factor to make the graph have the same overall height as a
+         * 12-band one no matter how many bands there are */
+        sum *= (float) m_bands / 12;
+
+        float val = 1 + 20 * log10f (sum) / m_db_range;
+        val = aud::clamp (val, 0.0f, 1.0f);
+
+        if (m_falloff > 0)
+        {
+            if (m_delay[b] > 0)
+                m_delay[b] --;
+            else
+                m_level[b] = aud::max (0.0f, m_level[b] - m_falloff);
+
+            if (val > m_level[b])
+            {
+                m_level[b] = val;
+                m_delay[b] = m_hold;
+            }
+
+            val = m_level[b];
+        }
+
+        out[b] = val;
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Spectrum analysis shared by the spectrum visualizers
+ * Copyright 2026 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef SPECTRUM_COMMON_H
+#define SPECTRUM_COMMON_H
+
+#include <libaudcore/index.h>
+
+/* Turns the 512-sample mono blocks of a MonoPCM visualizer into a number of
+ * logarithmically spaced bands.
+ *
+ * The block is Hann-windowed and zero-padded to the FFT size.  The core only
+ * sends disjoint snapshots of the output, so a larger FFT cannot see more of
+ * the signal than one block; the padding instead interpolates the spectrum,
+ * so that the narrow bands at the low end each get their own value rather
+ * than sharing one coarse bin.
+ *
+ * The band edges are turned into a table of bin weights whenever the band
+ * count, FFT size or sample rate changes, so that each frame costs one FFT
+ * and one dot product per band. */
+
+class SpectrumAnalyzer
+{
+public:
+    enum Scale {
+        LogScale,  /* each band sums the bins between its edges */
+        ConstantQ  /* overlapping triangular bands of constant Q */
+    };
+
+    static constexpr int block_size = 512;
+    static constexpr int min_fft_size = 512;
+    static constexpr int max_fft_size = 8192;
+
+    /* fft_size is rounded to a power of two within the limits above; the
+     * output covers db_range decibels below full scale */
+    void configure (int bands, int fft_size, Scale scale, float db_range);
+
+    /* bars fall by falloff (on a scale of 0 to 1) per frame, after staying
+     * at a peak for hold frames; a falloff of 0 turns smoothing off */
+    void set_smoothing (int hold, float falloff);
+
+    /* pcm holds block_size samples; out receives one value from 0 to 1 for
+     * each band */
+    void analyze (const float * pcm, float * out);
+
+    /* forgets the smoothing state */
+    void clear ();
+
+private:
+    void make_fft_tables ();
+    void make_band_tables ();
+    void fft ();
+
+    int m_bands = 0, m_fft_size = 0, m_rate = 0;
+    Scale m_scale = LogScale;
+    float m_db_range = 40;
+
+    int m_hold = 0;
+    float m_falloff = 0;
+
+    /* FFT tables and work space */
+    Index<int> m_bitrev;
+    Index<float> m_cos, m_sin, m_window;
+    Index<float> m_re, m_im, m_mag;
+
+    /* weights of the bins m_start[b] to m_start[b] + m_len[b] - 1 for band b,
+     * stored one band after another from m_offset[b] */
+    Index<int> m_start, m_len, m_offset;
+    Index<float> m_weights;
+
+    /* smoothing state */
+    Index<float> m_level;
+    Index<int> m_delay;
+};
+
+#endif
@@ -96,21 +96,108 @@ bool VTXPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Inde
     return true;
 }
 
+/* Seeking restores a checkpoint of the emulator taken before the target and
+ * runs the emulator from there.  This way the tone, noise and envelope
+ * generators end up exactly as if the song had been played through, and the
+ * output after a seek is identical to that of linear playback.  The emulator
+ * state is plain data, so a checkpoint is just a copy of it.  Checkpoints are
+ * taken at every CHECKPOINT_FRAMES register frames as they are reached. */
+#define CHECKPOINT_FRAMES 250
+
+class VTXRenderer
+{
+public:
+    VTXRenderer(ayemu_vtx_t &vtx, ayemu_ay_t &ay) :
+        m_vtx(vtx),
+        m_ay(ay),
+        m_numframes(vtx.hdr.regdata_size / 14),
+        m_per_frame(aud::max(freq / aud::max(vtx.hdr.playerFreq, 1), 1)) {}
+
+    /* renders up to count sound frames, returns how many were rendered */
+    int render(char *buf, int count);
+
+    /* moves to the given sound frame */
+    void seek(int64_t target);
+
+    int64_t position() const
+        { return (int64_t)m_vtx.pos * m_per_frame - m_left; }
+
+private:
+    ayemu_vtx_t &m_vtx;
+    ayemu_ay_t &m_ay;
+    const int m_numframes;
+    const int m_per_frame;     /* sound frames per AY register frame */
+
+    int m_left = 0;            /* sound frames left in the current register frame */
+    Index<ayemu_ay_t> m_checkpoints;  /* states at multiples of CHECKPOINT_FRAMES */
+};
+
+int VTXRenderer::render(char *buf, int count)
+{
+    int rate = chans * (bits / 8);
+    int done = 0;
+
+    while (done < count)
+    {
+        if (m_left > 0)
+        {                       /* use current AY register frame */
+            int donow = aud::min(count - done, m_left);
+            ayemu_gen_sound(&m_ay, buf + done * rate, donow * rate);
+            m_left -= donow;
+            done += donow;
+            continue;
+        }
+
+        if (m_vtx.pos % CHECKPOINT_FRAMES == 0 &&
+            m_vtx.pos / CHECKPOINT_FRAMES == m_checkpoints.len())
+            m_checkpoints.append(m_ay);
+
+        /* get next AY register frame */
+        unsigned char regs[14];
+        if (!m_vtx.get_next_frame(regs))
+            break;
+
+        ayemu_set_regs(&m_ay, regs);
+        m_left = m_per_frame;
+    }
+
+    return done;
+}
+
+void VTXRenderer::seek(int64_t target)
+{
+    target = aud::clamp(target, (int64_t)0, (int64_t)m_numframes * m_per_frame);
+
+    int frame = target / m_per_frame;
+    int cp = aud::min(frame / CHECKPOINT_FRAMES, m_checkpoints.len() - 1);
+
+    /* go back to a checkpoint, unless the current state is nearer */
+    int64_t pos = position();
+    if (cp >= 0 && (pos > target || pos < (int64_t)cp * CHECKPOINT_FRAMES * m_per_frame))
+    {
+        m_ay = m_checkpoints[cp];
+        m_vtx.pos = cp * CHECKPOINT_FRAMES;
+        m_left = 0;
+    }
+
+    /* run ahead, taking any new checkpoints on the way */
+    char discard[SNDBUFSIZE];
+    int rate = chans * (bits / 8);
+
+    while ((pos = position()) < target)
+    {
+        int count = aud::min(target - pos, (int64_t)(SNDBUFSIZE / rate));
+        if (!render(discard, count))
+            break;
+    }
+}
+
 bool VTXPlugin::play(const char *filename, VFSFile &file)
 {
     ayemu_ay_t ay;
     ayemu_vtx_t vtx;
 
-    bool eof = false;
-    void *stream;               /* pointer to current position in sound buffer */
-    unsigned char regs[14];
-    int need;
-    int left;                   /* how many sound frames can play with current AY register frame */
-    int donow;
-    int rate;
-
-    left = 0;
-    rate = chans * (bits / 8);
+    int rate = chans * (bits / 8);
 
     memset(&ay, 0, sizeof(ay));
 
@@ -130,45 +217,23 @@ bool VTXPlugin::play(const char *filename, VFSFile &file)
     ayemu_set_chip_freq(&ay, vtx.hdr.chipFreq);
     ayemu_set_stereo(&ay, (ayemu_stereo_t) vtx.hdr.stereo, nullptr);
 
+    VTXRenderer renderer(vtx, ay);
+
     set_stream_bitrate(14 * 50 * 8);
     open_audio(FMT_S16_NE, freq, chans);
 
-    while (!check_stop() && !eof)
+    while (!check_stop())
     {
-        /* (time in sec) * 50 = offset in AY register data frames */
         int seek_value = check_seek();
         if (seek_value >= 0)
-            vtx.pos = seek_value / 20;
+            renderer.seek(aud::rescale<int64_t>(seek_value, 1000, freq));
 
         /* fill sound buffer */
-        stream = sndbuf;
-
-        for (need = SNDBUFSIZE / rate; need > 0; need -= donow)
-        {
-            if (left > 0)
-            {                   /* use current AY register frame */
-                donow = (need > left) ? left : need;
-                left -= donow;
-                stream = ayemu_gen_sound(&ay, (char *)stream, donow * rate);
-            }
-            else
-            {                   /* get next AY register frame */
-                if (!vtx.get_next_frame(regs))
-                {
-                    donow = need;
-                    memset(stream, 0, donow * rate);
-                    eof = true;
-                }
-                else
-                {
-                    left = freq / vtx.hdr.playerFreq;
-                    ayemu_set_regs(&ay, regs);
-                    donow = 0;
-                }
-            }
-        }
+        int done = renderer.render(sndbuf, SNDBUFSIZE / rate);
+        if (!done)
+            break;
 
-        write_audio(sndbuf, SNDBUFSIZE);
+        write_audio(sndbuf, done * rate);
     }
 
     return true;
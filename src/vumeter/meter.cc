@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2026 Audacious development team.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include <libaudcore/templates.h>
+
+#include "meter.h"
+
+#define MOMENTARY_TIME 400000  /* microseconds */
+#define SHORT_TERM_TIME 3000000
+#define GATE_STEP 100000       /* gating blocks overlap by 75% */
+#define ABSOLUTE_GATE -70
+#define RELATIVE_GATE -10
+
+/* 4x oversampling filter for the true peak: a windowed sinc, 12 taps for each
+ * of the 4 phases */
+#define TP_PHASES 4
+#define TP_TAPS 12
+
+static float tp_coefs[TP_PHASES][TP_TAPS];
+
+static void init_tp_coefs ()
+{
+    static bool done = false;
+    if (done)
+        return;
+
+    constexpr int len = TP_PHASES * TP_TAPS;
+
+    for (int p = 0; p < TP_PHASES; p ++)
+    {
+        double sum = 0;
+
+        for (int j = 0; j < TP_TAPS; j ++)
+        {
+            int n = j * TP_PHASES + p;
+            double x = (n - (len - 1) * 0.5) / TP_PHASES;
+            double sinc = (x == 0) ? 1 : sin (M_PI * x) / (M_PI * x);
+            double window = 0.5 - 0.5 * cos (2 * M_PI * (n + 0.5) / len);
+
+            tp_coefs[p][j] = sinc * window;
+            sum += tp_coefs[p][j];
+        }
+
+        /* unity gain at DC for each phase */
+        for (int j = 0; j < TP_TAPS; j ++)
+            tp_coefs[p][j] /= sum;
+    }
+
+    done = true;
+}
+
+static double to_lufs (double power)
+{
+    return (power > 0) ? -0.691 + 10 * log10 (power) : -HUGE_VAL;
+}
+
+LevelMeter::LevelMeter ()
+{
+    init_tp_coefs ();
+    reset ();
+}
+
+void LevelMeter::reset ()
+{
+    for (int c = 0; c < METER_MAX_CHANNELS; c ++)
+        peak[c] = rms[c] = true_peak[c] = 0;
+
+    memset (m_state, 0, sizeof m_state);
+
+    m_history_pos = m_history_count = 0;
+    m_last_gate = 0;
+
+    memset (m_hist_count, 0, sizeof m_hist_count);
+    memset (m_hist_power, 0, sizeof m_hist_power);
+}
+
+/* The K-weighting filter of BS.1770 is a high shelf followed by a high-pass.
+ * The standard gives the coefficients for 48 kHz only; these are derived from
+ * the analog prototypes, so that they fit any sample rate. */
+void LevelMeter::set_format (int channels, int rate)
+{
+    channels = aud::clamp (channels, 1, METER_MAX_CHANNELS);
+
+    if (channels == m_channels && rate == m_rate)
+        return;
+
+    m_channels = channels;
+    m_rate = rate;
+
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+
+    double k = tan (M_PI * f0 / rate);
+    double vh = pow (10, gain / 20);
+    double vb = pow (vh, 0.4996667741545416);
+    double a0 = 1 + k / q + k * k;
+
+    m_shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    m_shelf.b1 = 2 * (k * k - vh) / a0;
+    m_shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    m_shelf.a1 = 2 * (k * k - 1) / a0;
+    m_shelf.a2 = (1 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+
+    k = tan (M_PI * f0 / rate);
+    a0 = 1 + k / q + k * k;
+
+    m_highpass.b0 = 1;
+    m_highpass.b1 = -2;
+    m_highpass.b2 = 1;
+    m_highpass.a1 = 2 * (k * k - 1) / a0;
+    m_highpass.a2 = (1 - k / q + k * k) / a0;
+
+    /* channel weights for the usual layouts; in 5.1 the fourth channel is
+     * the LFE, which is left out, and the surrounds count 1.41 times */
+    for (int c = 0; c < channels; c ++)
+        m_weight[c] = 1;
+
+    if (channels == 6)
+    {
+        m_weight[3] = 0;
+        m_weight[4] = m_weight[5] = 1.41;
+    }
+
+    reset ();
+}
+
+void LevelMeter::process (const float * pcm, int frames, int64_t time)
+{
+    if (! m_channels || frames < 1)
+        return;
+
+    measure_levels (pcm, frames);
+    measure_true_peak (pcm, frames);
+
+    Block & block = m_history[m_history_pos];
+    block.time = time;
+    block.power = measure_power (pcm, frames);
+
+    m_history_pos = (m_history_pos + 1) % history_len;
+    m_history_count = aud::min (m_history_count + 1, history_len);
+
+    if (time - m_last_gate >= GATE_STEP)
+    {
+        add_gating_block (time);
+        m_last_gate = time;
+    }
+}
+
+/* Sample peak and RMS.  With 1, 2 or 4 channels, each lane of a vector always
+ * holds the same channel, so whole vectors can be accumulated at once. */
+void LevelMeter::measure_levels (const float * pcm, int frames)
+{
+    int samples = frames * m_channels;
+    float max[METER_MAX_CHANNELS] = {}, sum[METER_MAX_CHANNELS] = {};
+    int i = 0;
+
+#ifdef __SSE__
+    if (4 % m_channels == 0)
+    {
+        const __m128 sign = _mm_set1_ps (-0.0f);
+        __m128 vmax = _mm_setzero_ps ();
+        __m128 vsum = _mm_setzero_ps ();
+
+        for (; i + 4 <= samples; i += 4)
+        {
+            __m128 x = _mm_loadu_ps (pcm + i);
+            vmax = _mm_max_ps (vmax, _mm_andnot_ps (sign, x));
+            vsum = _mm_add_ps (vsum, _mm_mul_ps (x, x));
+        }
+
+        float lane_max[4], lane_sum[4];
+        _mm_storeu_ps (lane_max, vmax);
+        _mm_storeu_ps (lane_sum, vsum);
+
+        for (int l = 0; l < 4; l ++)
+        {
+            int c = l % m_channels;
+            max[c] = aud::max (max[c], lane_max[l]);
+            sum[c] += lane_sum[l];
+        }
+    }
+#endif
+
+    for (; i < samples; i ++)
+    {
+        int c = i % m_channels;
+        max[c] = aud::max (max[c], fabsf (pcm[i]));
+        sum[c] += pcm[i] * pcm[i];
+    }
+
+    for (int c = 0; c < m_channels; c ++)
+    {
+        peak[c] = max[c];
+        rms[c] = sqrtf (sum[c] / frames);
+    }
+}
+
+/* The blocks are not contiguous, so the interpolation only covers the part of
+ * each block where the filter has a full history.  The sample peak is taken
+ * as a lower bound. */
+void LevelMeter::measure_true_peak (const float * pcm, int frames)
+{
+    for (int c = 0; c < m_channels; c ++)
+    {
+        float max = peak[c];
+
+        for (int i = TP_TAPS - 1; i < frames; i ++)
+        {
+            const float * x = pcm + i * m_channels + c;
+
+            for (int p = 0; p < TP_PHASES; p ++)
+            {
+                float y = 0;
+                for (int j = 0; j < TP_TAPS; j ++)
+                    y += tp_coefs[p][j] * x[-j * m_channels];
+
+                max = aud::max (max, fabsf (y));
+            }
+        }
+
+        true_peak[c] = max;
+    }
+}
+
+double LevelMeter::measure_power (const float * pcm, int frames)
+{
+    double power = 0;
+
+    for (int c = 0; c < m_channels; c ++)
+    {
+        if (! m_weight[c])
+            continue;
+
+        const Biquad & s = m_shelf, & h = m_highpass;
+        double * d = m_state[c];
+        double sum = 0;
+
+        /* transposed direct form II */
+        for (int i = 0; i < frames; i ++)
+        {
+            double x = pcm[i * m_channels + c];
+
+            double y = s.b0 * x + d[0];
+            d[0] = s.b1 * x - s.a1 * y + d[1];
+            d[1] = s.b2 * x - s.a2 * y;
+
+            double z = h.b0 * y + d[2];
+            d[2] = h.b1 * y - h.a1 * z + d[3];
+            d[3] = h.b2 * y - h.a2 * z;
+
+            sum += z * z;
+        }
+
+        power += m_weight[c] * sum / frames;
+    }
+
+    return power;
+}
+
+/* mean power of the blocks in the last span microseconds */
+double LevelMeter::window_power (int64_t span) const
+{
+    if (! m_history_count)
+        return 0;
+
+    int last = (m_history_pos + history_len - 1) % history_len;
+    int64_t start = m_history[last].time - span;
+
+    double sum = 0;
+    int count = 0;
+
+    for (int n = 0; n < m_history_count; n ++)
+    {
+        const Block & block = m_history[(last + history_len - n) % history_len];
+        if (block.time <= start)
+            break;
+
+        sum += block.power;
+        count ++;
+    }
+
+    return count ? sum / count : 0;
+}
+
+void LevelMeter::add_gating_block (int64_t time)
+{
+    double power = window_power (MOMENTARY_TIME);
+    double lufs = to_lufs (power);
+
+    if (lufs < ABSOLUTE_GATE)
+        return;
+
+    int bin = aud::clamp ((int) ((lufs - ABSOLUTE_GATE) * 10), 0, hist_bins - 1);
+    m_hist_count[bin] ++;
+    m_hist_power[bin] += power;
+}
+
+float LevelMeter::momentary () const
+{
+    return to_lufs (window_power (MOMENTARY_TIME));
+}
+
+float LevelMeter::short_term () const
+{
+    return to_lufs (window_power (SHORT_TERM_TIME));
+}
+
+float LevelMeter::integrated () const
+{
+    int64_t count = 0;
+    double sum = 0;
+
+    for (int b = 0; b < hist_bins; b ++)
+    {
+        count += m_hist_count[b];
+        sum += m_hist_power[b];
+    }
+
+    if (! count)
+        return -HUGE_VAL;
+
+    double gate = to_lufs (sum / count) + RELATIVE_GATE;
+    int first = aud::clamp ((int) ceil ((gate - ABSOLUTE_GATE) * 10), 0, hist_bins);
+
+    count = 0;
+    sum = 0;
+
+    for (int b = first; b < hist_bins; b ++)
+    {
+        count += m_hist_count[b];
+        sum += m_hist_power[b];
+    }
+
+    return count ? to_lufs (sum / count) : -HUGE_VAL;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 Audacious development team.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VUMETER_METER_H
+#define VUMETER_METER_H
+
+#include <stdint.h>
+
+#define METER_MAX_CHANNELS 20
+
+/* Level and loudness measurement for the VU meter.
+ *
+ * Each block of audio yields the sample peak, the RMS level and the true
+ * peak (4x oversampled, as in ITU-R BS.1770 annex 2) of every channel.
+ * Loudness follows BS.1770: the channels are K-weighted, their mean squares
+ * summed with the channel weights, and averaged over 400 ms (momentary) and
+ * 3 s (short-term) windows.  The integrated loudness is gated at -70 LUFS
+ * and then at 10 LU below the ungated mean.
+ *
+ * The visualization gets snapshots of the audio rather than all of it, so
+ * the windows are measured in real time and averaged over the blocks that
+ * fall into them.  For program material this gives nearly the same figures
+ * as a meter that sees every sample. */
+
+class LevelMeter
+{
+public:
+    LevelMeter ();
+
+    void reset ();
+    void set_format (int channels, int rate);
+
+    /* pcm holds frames of interleaved audio; time is in microseconds */
+    void process (const float * pcm, int frames, int64_t time);
+
+    /* levels of the last block, as linear amplitudes */
+    float peak[METER_MAX_CHANNELS];
+    float rms[METER_MAX_CHANNELS];
+    float true_peak[METER_MAX_CHANNELS];
+
+    /* in LUFS, or -HUGE_VAL if there is nothing to measure yet */
+    float momentary () const;
+    float short_term () const;
+    float integrated () const;
+
+private:
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    struct Block
+    {
+        int64_t time;
+        double power; /* weighted sum of the K-weighted mean squares */
+    };
+
+    /* enough for the 3 s window at up to 80 blocks a second (the core sends
+     * about 30) */
+    static constexpr int history_len = 256;
+    static constexpr int hist_bins = 750; /* -70 to +5 LUFS in 0.1 LU steps */
+
+    void measure_levels (const float * pcm, int frames);
+    void measure_true_peak (const float * pcm, int frames);
+    double measure_power (const float * pcm, int frames);
+    double window_power (int64_t span) const;
+    void add_gating_block (int64_t time);
+
+    int m_channels = 0, m_rate = 0;
+
+    Biquad m_shelf, m_highpass;
+    double m_state[METER_MAX_CHANNELS][4]; /* filter delays, two per stage */
+    float m_weight[METER_MAX_CHANNELS];
+
+    Block m_history[history_len]; /* ring buffer of recent blocks */
+    int m_history_pos = 0, m_history_count = 0;
+
+    /* histogram of the gating blocks above the absolute gate */
+    int64_t m_last_gate = 0;
+    int m_hist_count[hist_bins];
+    double m_hist_power[hist_bins];
+};
+
+#endif
@@ -25,16 +25,25 @@
 #include <gtk/gtk.h>
 
 #include <libaudcore/audstrings.h>
+#include <libaudcore/drct.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 #include <libaudcore/runtime.h>
 #include <libaudgui/gtk-compat.h>
 
+#include "meter.h"
+
 #define CFG_ID "vumeter"
-#define MAX_CHANNELS 20
+#define MAX_CHANNELS METER_MAX_CHANNELS
 #define DB_RANGE 96
 
+enum {
+    MODE_PEAK,
+    MODE_RMS,
+    MODE_TRUE_PEAK
+};
+
 class VUMeter : public VisPlugin
 {
 public:
@@ -61,6 +70,7 @@ public:
 
 private:
     static void toggle_display_legend ();
+    static const ComboItem mode_items[];
 };
 
 EXPORT VUMeter aud_plugin_instance;
@@ -69,8 +79,19 @@ const char VUMeter::about[] =
  N_("VU Meter Plugin for Audacious\n"
     "Copyright 2017-2019 Marc Sánchez Fauste");
 
+const ComboItem VUMeter::mode_items[] = {
+    ComboItem (N_("Sample peak"), MODE_PEAK),
+    ComboItem (N_("RMS"), MODE_RMS),
+    ComboItem (N_("True peak"), MODE_TRUE_PEAK)
+};
+
 const PreferencesWidget VUMeter::widgets[] = {
     WidgetLabel (N_("<b>VU Meter Settings</b>")),
+    WidgetCombo (
+        N_("Level:"),
+        WidgetInt (CFG_ID, "meter_mode"),
+        {{mode_items}}
+    ),
     WidgetSpin (
         N_("Peak hold time:"),
         WidgetFloat (CFG_ID, "peak_hold_time"),
@@ -84,6 +105,10 @@ const PreferencesWidget VUMeter::widgets[] = {
     WidgetCheck (
         N_("Display legend"),
         WidgetBool (CFG_ID, "display_legend", toggle_display_legend)
+    ),
+    WidgetCheck (
+        N_("Display loudness (LUFS)"),
+        WidgetBool (CFG_ID, "display_loudness", toggle_display_legend)
     )
 };
 
@@ -93,6 +118,8 @@ const char * const VUMeter::prefs_defaults[] = {
     "peak_hold_time", "1.6",
     "falloff", "13.3",
     "display_legend", "TRUE",
+    "display_loudness", "FALSE",
+    "meter_mode", aud::numeric_string<MODE_PEAK>::str,
     nullptr
 };
 
@@ -107,6 +134,7 @@ static float channels_db_level[MAX_CHANNELS];
 static float channels_peaks[MAX_CHANNELS];
 static gint64 last_peak_times[MAX_CHANNELS]; // Time elapsed since peak was set
 static gint64 last_render_time = 0;
+static LevelMeter meter;
 
 static void update_sizes ()
 {
@@ -116,7 +144,6 @@ static void update_sizes ()
         vumeter_top_padding = height * 0.04f;
         vumeter_bottom_padding = height * 0.015f;
         vumeter_width = width * 0.4f / nchannels;
-        vumeter_height = height - vumeter_top_padding - vumeter_bottom_padding;
     }
     else
     {
@@ -124,8 +151,12 @@ static void update_sizes ()
         vumeter_top_padding = 0;
         vumeter_bottom_padding = 0;
         vumeter_width = width / nchannels;
-        vumeter_height = height;
     }
+
+    if (aud_get_bool (CFG_ID, "display_loudness"))
+        vumeter_bottom_padding = height * 0.06f;
+
+    vumeter_height = height - vumeter_top_padding - vumeter_bottom_padding;
 }
 
 static float get_db_on_range (float db)
@@ -182,20 +213,19 @@ void VUMeter::render_multi_pcm (const float * pcm, int channels)
         update_sizes ();
     }
 
-    float * peaks = new float[nchannels];
-    for (int channel = 0; channel < nchannels; channel ++)
-        peaks[channel] = aud::abs (pcm[channel]);
+    int bitrate, samplerate, output_channels;
+    aud_drct_get_info (bitrate, samplerate, output_channels);
 
-    for (int i = 0; i < 512 * nchannels;)
-    {
-        for (int channel = 0; channel < nchannels; channel ++)
-            peaks[channel] = aud::max (peaks[channel], aud::abs (pcm[i ++]));
-    }
+    meter.set_format (nchannels, (samplerate > 0) ? samplerate : 44100);
+    meter.process (pcm, 512, current_time);
+
+    int mode = aud_get_int (CFG_ID, "meter_mode");
+    const float * levels = (mode == MODE_RMS) ? meter.rms :
+     (mode == MODE_TRUE_PEAK) ? meter.true_peak : meter.peak;
 
     for (int i = 0; i < nchannels; i ++)
     {
-        float n = peaks[i];
-        float db = get_db_on_range (20 * log10f (n));
+        float db = get_db_on_range (20 * log10f (levels[i]));
 
         channels_db_level[i] = get_db_on_range (channels_db_level[i] - elapsed_render_time * falloff);
         if (db > channels_db_level[i])
@@ -209,8 +239,6 @@ void VUMeter::render_multi_pcm (const float * pcm, int channels)
         }
     }
 
-    delete[] peaks;
-
     if (spect_widget)
         gtk_widget_queue_draw (spect_widget);
 }
@@ -236,6 +264,7 @@ bool VUMeter::init ()
 void VUMeter::clear ()
 {
     reset_variables ();
+    meter.reset ();
 
     if (spect_widget)
         gtk_widget_queue_draw (spect_widget);
@@ -394,6 +423,28 @@ static void draw_visualizer_peak_legend (cairo_t * cr)
     }
 }
 
+static StringBuf format_lufs (float val)
+{
+    return (val > -DB_RANGE) ? str_printf ("%.1f", val) : str_printf ("-inf");
+}
+
+static void draw_loudness (cairo_t * cr)
+{
+    StringBuf text = str_printf (_("M %s   S %s   I %s LUFS"),
+     (const char *) format_lufs (meter.momentary ()),
+     (const char *) format_lufs (meter.short_term ()),
+     (const char *) format_lufs (meter.integrated ()));
+
+    cairo_set_font_size (cr, aud::min (vumeter_bottom_padding * 0.6f, width / 20.0f));
+    cairo_set_source_rgb (cr, 1, 1, 1);
+
+    cairo_text_extents_t extents;
+    cairo_text_extents (cr, text, & extents);
+    cairo_move_to (cr, (width - extents.width) / 2.0f,
+        height - (vumeter_bottom_padding - extents.height) / 2.0f);
+    cairo_show_text (cr, text);
+}
+
 static gboolean configure_event (GtkWidget * widget, GdkEventConfigure * event)
 {
     width = event->width;
@@ -418,6 +469,8 @@ static gboolean draw_event (GtkWidget * widget)
         draw_legend (cr);
         draw_visualizer_peak_legend (cr);
     }
+    if (aud_get_bool (CFG_ID, "display_loudness"))
+        draw_loudness (cr);
     draw_visualizer (cr);
 #ifndef USE_GTK3
     cairo_destroy (cr);
@@ -25,46 +25,44 @@
 #include "NDSSystem.h"
 
 // ========================================================= IPC FIFO
-IPC_FIFO ipc_fifo[2]; // 0 - ARM9, 1 - ARM7
-
 void IPC_FIFOinit(uint8_t proc)
 {
-	memset(&ipc_fifo[proc], 0, sizeof(IPC_FIFO));
-	T1WriteWord(MMU.MMU_MEM[proc][0x40], 0x184, 0x00000101);
+	memset(&mmu->ipc_fifo[proc], 0, sizeof(IPC_FIFO));
+	T1WriteWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184, 0x00000101);
 }
 
 void IPC_FIFOsend(uint8_t proc, uint32_t val)
 {
-	uint16_t cnt_l = T1ReadWord(MMU.MMU_MEM[proc][0x40], 0x184);
+	uint16_t cnt_l = T1ReadWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184);
 	if (!(cnt_l & IPCFIFOCNT_FIFOENABLE))
 		return; // FIFO disabled
 	uint8_t proc_remote = proc ^ 1;
 
-	if (ipc_fifo[proc].size > 15)
+	if (mmu->ipc_fifo[proc].size > 15)
 	{
 		cnt_l |= IPCFIFOCNT_FIFOERROR;
-		T1WriteWord(MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
+		T1WriteWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
 		return;
 	}
 
-	uint16_t cnt_r = T1ReadWord(MMU.MMU_MEM[proc_remote][0x40], 0x184);
+	uint16_t cnt_r = T1ReadWord(mmu->MMU.MMU_MEM[proc_remote][0x40], 0x184);
 
 	cnt_l &= 0xBFFC; // clear send empty bit & full
 	cnt_r &= 0xBCFF; // set recv empty bit & full
-	ipc_fifo[proc].buf[ipc_fifo[proc].tail] = val;
-	++ipc_fifo[proc].tail;
-	++ipc_fifo[proc].size;
-	if (ipc_fifo[proc].tail > 15)
-		ipc_fifo[proc].tail = 0;
+	mmu->ipc_fifo[proc].buf[mmu->ipc_fifo[proc].tail] = val;
+	++mmu->ipc_fifo[proc].tail;
+	++mmu->ipc_fifo[proc].size;
+	if (mmu->ipc_fifo[proc].tail > 15)
+		mmu->ipc_fifo[proc].tail = 0;
 
-	if (ipc_fifo[proc].size > 15)
+	if (mmu->ipc_fifo[proc].size > 15)
 	{
 		cnt_l |= IPCFIFOCNT_SENDFULL; // set send full bit
 		cnt_r |= IPCFIFOCNT_RECVFULL; // set recv full bit
 	}
 
-	T1WriteWord(MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
-	T1WriteWord(MMU.MMU_MEM[proc_remote][0x40], 0x184, cnt_r);
+	T1WriteWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
+	T1WriteWord(mmu->MMU.MMU_MEM[proc_remote][0x40], 0x184, cnt_r);
 
 	if (cnt_r & IPCFIFOCNT_RECVIRQEN)
 		NDS_makeIrq(proc_remote, IRQ_BIT_IPCFIFO_RECVNONEMPTY);
@@ -74,32 +72,32 @@ void IPC_FIFOsend(uint8_t proc, uint32_t val)
 
 uint32_t IPC_FIFOrecv(uint8_t proc)
 {
-	uint16_t cnt_l = T1ReadWord(MMU.MMU_MEM[proc][0x40], 0x184);
+	uint16_t cnt_l = T1ReadWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184);
 	if (!(cnt_l & IPCFIFOCNT_FIFOENABLE))
 		return 0; // FIFO disabled
 	uint8_t proc_remote = proc ^ 1;
 
 	uint32_t val = 0;
 
-	if (!ipc_fifo[proc_remote].size) // remote FIFO error
+	if (!mmu->ipc_fifo[proc_remote].size) // remote FIFO error
 	{
 		cnt_l |= IPCFIFOCNT_FIFOERROR;
-		T1WriteWord(MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
+		T1WriteWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
 		return 0;
 	}
 
-	uint16_t cnt_r = T1ReadWord(MMU.MMU_MEM[proc_remote][0x40], 0x184);
+	uint16_t cnt_r = T1ReadWord(mmu->MMU.MMU_MEM[proc_remote][0x40], 0x184);
 
 	cnt_l &= 0xBCFF; // clear send full bit & empty
 	cnt_r &= 0xBFFC; // set recv full bit & empty
 
-	val = ipc_fifo[proc_remote].buf[ipc_fifo[proc_remote].head];
-	++ipc_fifo[proc_remote].head;
-	--ipc_fifo[proc_remote].size;
-	if (ipc_fifo[proc_remote].head > 15)
-		ipc_fifo[proc_remote].head = 0;
+	val = mmu->ipc_fifo[proc_remote].buf[mmu->ipc_fifo[proc_remote].head];
+	++mmu->ipc_fifo[proc_remote].head;
+	--mmu->ipc_fifo[proc_remote].size;
+	if (mmu->ipc_fifo[proc_remote].head > 15)
+		mmu->ipc_fifo[proc_remote].head = 0;
 
-	if (!ipc_fifo[proc_remote].size) // FIFO empty
+	if (!mmu->ipc_fifo[proc_remote].size) // FIFO empty
 	{
 		cnt_l |= IPCFIFOCNT_RECVEMPTY;
 		cnt_r |= IPCFIFOCNT_SENDEMPTY;
@@ -108,8 +106,8 @@ uint32_t IPC_FIFOrecv(uint8_t proc)
 			NDS_makeIrq(proc_remote, IRQ_BIT_IPCFIFO_SENDEMPTY);
 	}
 
-	T1WriteWord(MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
-	T1WriteWord(MMU.MMU_MEM[proc_remote][0x40], 0x184, cnt_r);
+	T1WriteWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
+	T1WriteWord(mmu->MMU.MMU_MEM[proc_remote][0x40], 0x184, cnt_r);
 
 	NDS_Reschedule();
 
@@ -118,8 +116,8 @@ uint32_t IPC_FIFOrecv(uint8_t proc)
 
 void IPC_FIFOcnt(uint8_t proc, uint16_t val)
 {
-	uint16_t cnt_l = T1ReadWord(MMU.MMU_MEM[proc][0x40], 0x184);
-	uint16_t cnt_r = T1ReadWord(MMU.MMU_MEM[proc^1][0x40], 0x184);
+	uint16_t cnt_l = T1ReadWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184);
+	uint16_t cnt_r = T1ReadWord(mmu->MMU.MMU_MEM[proc^1][0x40], 0x184);
 
 	if (val & IPCFIFOCNT_FIFOERROR)
 		// at least SPP uses this, maybe every retail game
@@ -127,9 +125,9 @@ void IPC_FIFOcnt(uint8_t proc, uint16_t val)
 
 	if (val & IPCFIFOCNT_SENDCLEAR)
 	{
-		ipc_fifo[proc].head = 0;
-		ipc_fifo[proc].tail = 0;
-		ipc_fifo[proc].size = 0;
+		mmu->ipc_fifo[proc].head = 0;
+		mmu->ipc_fifo[proc].tail = 0;
+		mmu->ipc_fifo[proc].size = 0;
 
 		cnt_l |= IPCFIFOCNT_SENDEMPTY;
 		cnt_r |= IPCFIFOCNT_RECVEMPTY;
@@ -150,8 +148,8 @@ void IPC_FIFOcnt(uint8_t proc, uint16_t val)
 	if ((cnt_l & IPCFIFOCNT_RECVIRQEN) && !(cnt_l & IPCFIFOCNT_RECVEMPTY))
 		NDS_makeIrq(proc, IRQ_BIT_IPCFIFO_RECVNONEMPTY);
 
-	T1WriteWord(MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
-	T1WriteWord(MMU.MMU_MEM[proc^1][0x40], 0x184, cnt_r);
+	T1WriteWord(mmu->MMU.MMU_MEM[proc][0x40], 0x184, cnt_l);
+	T1WriteWord(mmu->MMU.MMU_MEM[proc^1][0x40], 0x184, cnt_r);
 
 	NDS_Reschedule();
 }
@@ -64,59 +64,8 @@ static uint64_t isqrt(uint64_t x)
 	return root;
 }
 
-uint32_t partie = 1;
-uint32_t _MMU_MAIN_MEM_MASK = 0x3FFFFF;
-uint32_t _MMU_MAIN_MEM_MASK16 = 0x3FFFFF & ~1;
-uint32_t _MMU_MAIN_MEM_MASK32 = 0x3FFFFF & ~3;
-
-MMU_struct MMU;
-MMU_struct_new MMU_new;
-MMU_struct_timing MMU_timing;
-
-uint8_t *MMU_struct::MMU_MEM[2][256] =
-{
-	//arm9
-	{
-		/* 0X*/	DUP16(MMU.ARM9_ITCM),
-		/* 1X*/	//DUP16(MMU.ARM9_ITCM)
-		/* 1X*/	DUP16(MMU.UNUSED_RAM),
-		/* 2X*/	DUP16(MMU.MAIN_MEM),
-		/* 3X*/	DUP16(MMU.SWIRAM),
-		/* 4X*/	DUP16(MMU.ARM9_REG),
-		/* 5X*/	DUP16(MMU.ARM9_VMEM),
-		/* 6X*/	DUP16(MMU.ARM9_LCD),
-		/* 7X*/	DUP16(MMU.ARM9_OAM),
-		/* 8X*/	DUP16(nullptr),
-		/* 9X*/	DUP16(nullptr),
-		/* AX*/	DUP16(MMU.UNUSED_RAM),
-		/* BX*/	DUP16(MMU.UNUSED_RAM),
-		/* CX*/	DUP16(MMU.UNUSED_RAM),
-		/* DX*/	DUP16(MMU.UNUSED_RAM),
-		/* EX*/	DUP16(MMU.UNUSED_RAM),
-		/* FX*/	DUP16(MMU.ARM9_BIOS)
-	},
-	//arm7
-	{
-		/* 0X*/	DUP16(MMU.ARM7_BIOS),
-		/* 1X*/	DUP16(MMU.UNUSED_RAM),
-		/* 2X*/	DUP16(MMU.MAIN_MEM),
-		/* 3X*/	DUP8(MMU.SWIRAM),
-				DUP8(MMU.ARM7_ERAM),
-		/* 4X*/	DUP8(MMU.ARM7_REG),
-				DUP8(MMU.ARM7_WIRAM),
-		/* 5X*/	DUP16(MMU.UNUSED_RAM),
-		/* 6X*/	DUP16(MMU.ARM9_LCD),
-		/* 7X*/	DUP16(MMU.UNUSED_RAM),
-		/* 8X*/	DUP16(nullptr),
-		/* 9X*/	DUP16(nullptr),
-		/* AX*/	DUP16(MMU.UNUSED_RAM),
-		/* BX*/	DUP16(MMU.UNUSED_RAM),
-		/* CX*/	DUP16(MMU.UNUSED_RAM),
-		/* DX*/	DUP16(MMU.UNUSED_RAM),
-		/* EX*/	DUP16(MMU.UNUSED_RAM),
-		/* FX*/	DUP16(MMU.UNUSED_RAM)
-	}
-};
+THREADLOCAL mmu_context *mmu;
+THREADLOCAL MMU_struct_timing *MMU_timing;
 
 uint32_t MMU_struct::MMU_MASK[2][256] =
 {
@@ -173,16 +122,6 @@ uint32_t MMU_struct::MMU_MASK[2][256] =
 // for all of the below, values = 41 indicate unmapped memory
 static const uint8_t VRAM_PAGE_UNMAPPED = 41;
 
-static const unsigned VRAM_LCDC_PAGES = 41;
-static uint8_t vram_lcdc_map[VRAM_LCDC_PAGES];
-
-// in the range of 0x06000000 - 0x06800000 in 16KB pages (the ARM9 vram mappable area)
-// this maps to 16KB pages in the LCDC buffer which is what will actually contain the data
-uint8_t vram_arm9_map[VRAM_ARM9_PAGES];
-
-// this chooses which banks are mapped in the 128K banks starting at 0x06000000 in ARM7
-static uint8_t vram_arm7_map[2];
-
 struct TVramBankInfo
 {
 	uint8_t page_addr, num_pages;
@@ -252,7 +191,7 @@ static inline uint32_t MMU_LCDmap(int PROCNUM, uint32_t addr, bool &unmapped, bo
 			int block = (addr >> 14) & 3;
 			assert(region < 2);
 			assert(block < 4);
-			iwram_block_16k = arm7_siwram_blocks[region][MMU.WRAMCNT][block];
+			iwram_block_16k = arm7_siwram_blocks[region][mmu->MMU.WRAMCNT][block];
 		} //PROCNUM == ARMCPU_ARM7
 		else
 		{
@@ -266,7 +205,7 @@ static inline uint32_t MMU_LCDmap(int PROCNUM, uint32_t addr, bool &unmapped, bo
 			};
 			int block = (addr >> 14) & 3;
 			assert(block < 4);
-			iwram_block_16k = arm9_siwram_blocks[MMU.WRAMCNT][block];
+			iwram_block_16k = arm9_siwram_blocks[mmu->MMU.WRAMCNT][block];
 		}
 
 		switch (iwram_block_16k >> 2)
@@ -309,14 +248,14 @@ static inline uint32_t MMU_LCDmap(int PROCNUM, uint32_t addr, bool &unmapped, bo
 		// already in LCDC range. just look it up to see whether it is unmapped
 		vram_page = (addr >> 14) & 63;
 		assert(vram_page < VRAM_LCDC_PAGES);
-		vram_page = vram_lcdc_map[vram_page];
+		vram_page = mmu->vram_lcdc_map[vram_page];
 	}
 	else
 	{
 		// map addresses in BG/OBJ range to an LCDC range
 		vram_page = (addr >> 14) & (VRAM_ARM9_PAGES - 1);
 		assert(vram_page < VRAM_ARM9_PAGES);
-		vram_page = vram_arm9_map[vram_page];
+		vram_page = mmu->vram_arm9_map[vram_page];
 	}
 
 	if (vram_page == VRAM_PAGE_UNMAPPED)
@@ -328,7 +267,6 @@ static inline uint32_t MMU_LCDmap(int PROCNUM, uint32_t addr, bool &unmapped, bo
 		return LCDC_HACKY_LOCATION + (vram_page << 14) + ofs;
 }
 
-VramConfiguration vramConfiguration;
 
 // maps the specified bank to LCDC
 static inline void MMU_vram_lcdc(int bank)
@@ -336,7 +274,7 @@ static inline void MMU_vram_lcdc(int bank)
 	for (int i = 0; i < vram_bank_info[bank].num_pages; ++i)
 	{
 		int page = vram_bank_info[bank].page_addr + i;
-		vram_lcdc_map[page] = page;
+		mmu->vram_lcdc_map[page] = page;
 	}
 }
 
@@ -344,12 +282,12 @@ static inline void MMU_vram_lcdc(int bank)
 static inline void MMU_vram_arm9(int bank, int offset)
 {
 	for (int i = 0; i < vram_bank_info[bank].num_pages; ++i)
-		vram_arm9_map[i + offset] = vram_bank_info[bank].page_addr + i;
+		mmu->vram_arm9_map[i + offset] = vram_bank_info[bank].page_addr + i;
 }
 
 static inline uint8_t *MMU_vram_physical(int page)
 {
-	return MMU.ARM9_LCD + (page/**ADDRESS_STEP_16KB*/);
+	return mmu->MMU.ARM9_LCD + (page/**ADDRESS_STEP_16KB*/);
 }
 
 // todo - templateize
@@ -359,7 +297,7 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 	if (bank >= VRAM_BANK_H)
 		++block;
 
-	uint8_t VRAMBankCnt = T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x240 + block);
+	uint8_t VRAMBankCnt = T1ReadByte(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x240 + block);
 
 	// do nothing if the bank isnt enabled
 	uint8_t en = VRAMBankCnt & 0x80;
@@ -376,15 +314,15 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 			switch (mst)
 			{
 				case 0: // LCDC
-					vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
 					MMU_vram_lcdc(bank);
 					break;
 				case 1: // ABG
-					vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
 					MMU_vram_arm9(bank, VRAM_PAGE_ABG + ofs * 8);
 					break;
 				case 2: // AOBJ
-					vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJ;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJ;
 					switch (ofs)
 					{
 						case 0:
@@ -393,8 +331,8 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 					}
 					break;
 				case 3: // texture
-					vramConfiguration.banks[bank].purpose = VramConfiguration::TEX;
-					MMU.texInfo.textureSlotAddr[ofs] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::TEX;
+					mmu->MMU.texInfo.textureSlotAddr[ofs] = MMU_vram_physical(vram_bank_info[bank].page_addr);
 					break;
 				default:
 					goto unsupported_mst;
@@ -408,39 +346,39 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 			switch (mst)
 			{
 				case 0: // LCDC
-					vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
 					MMU_vram_lcdc(bank);
 					break;
 				case 1: // ABG
-					vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
 					MMU_vram_arm9(bank, VRAM_PAGE_ABG + ofs * 8);
 					break;
 				case 2: // arm7
-					vramConfiguration.banks[bank].purpose = VramConfiguration::ARM7;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::ARM7;
 					if (bank == 2)
-						T1WriteByte(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240, T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240) | 1);
+						T1WriteByte(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240, T1ReadByte(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240) | 1);
 					if (bank == 3)
-						T1WriteByte(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240, T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240) | 2);
+						T1WriteByte(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240, T1ReadByte(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240) | 2);
 					switch (ofs)
 					{
 						case 0:
 						case 1:
-							vram_arm7_map[ofs] = vram_bank_info[bank].page_addr;
+							mmu->vram_arm7_map[ofs] = vram_bank_info[bank].page_addr;
 					}
 					break;
 				case 3: // texture
-					vramConfiguration.banks[bank].purpose = VramConfiguration::TEX;
-					MMU.texInfo.textureSlotAddr[ofs] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::TEX;
+					mmu->MMU.texInfo.textureSlotAddr[ofs] = MMU_vram_physical(vram_bank_info[bank].page_addr);
 					break;
 				case 4: // BGB or BOBJ
 					if (bank == VRAM_BANK_C)
 					{
-						vramConfiguration.banks[bank].purpose = VramConfiguration::BBG;
+						mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::BBG;
 						MMU_vram_arm9(bank, VRAM_PAGE_BBG); // BBG
 					}
 					else
 					{
-						vramConfiguration.banks[bank].purpose = VramConfiguration::BOBJ;
+						mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::BOBJ;
 						MMU_vram_arm9(bank, VRAM_PAGE_BOBJ); // BOBJ
 					}
 					break;
@@ -454,30 +392,30 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 			switch (mst)
 			{
 				case 0: // LCDC
-					vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
 					MMU_vram_lcdc(bank);
 					break;
 				case 1: // ABG
-					vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
 					MMU_vram_arm9(bank, VRAM_PAGE_ABG);
 					break;
 				case 2: // AOBJ
-					vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJ;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJ;
 					MMU_vram_arm9(bank, VRAM_PAGE_AOBJ);
 					break;
 				case 3: // texture palette
-					vramConfiguration.banks[bank].purpose = VramConfiguration::TEXPAL;
-					MMU.texInfo.texPalSlot[0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
-					MMU.texInfo.texPalSlot[1] = MMU_vram_physical(vram_bank_info[bank].page_addr + 1);
-					MMU.texInfo.texPalSlot[2] = MMU_vram_physical(vram_bank_info[bank].page_addr + 2);
-					MMU.texInfo.texPalSlot[3] = MMU_vram_physical(vram_bank_info[bank].page_addr + 3);
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::TEXPAL;
+					mmu->MMU.texInfo.texPalSlot[0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->MMU.texInfo.texPalSlot[1] = MMU_vram_physical(vram_bank_info[bank].page_addr + 1);
+					mmu->MMU.texInfo.texPalSlot[2] = MMU_vram_physical(vram_bank_info[bank].page_addr + 2);
+					mmu->MMU.texInfo.texPalSlot[3] = MMU_vram_physical(vram_bank_info[bank].page_addr + 3);
 					break;
 				case 4: // ABG extended palette
-					vramConfiguration.banks[bank].purpose = VramConfiguration::ABGEXTPAL;
-					MMU.ExtPal[0][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
-					MMU.ExtPal[0][1] = MMU.ExtPal[0][0]/* + ADDRESS_STEP_8KB*/;
-					MMU.ExtPal[0][2] = MMU.ExtPal[0][1]/* + ADDRESS_STEP_8KB*/;
-					MMU.ExtPal[0][3] = MMU.ExtPal[0][2]/* + ADDRESS_STEP_8KB*/;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::ABGEXTPAL;
+					mmu->MMU.ExtPal[0][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->MMU.ExtPal[0][1] = mmu->MMU.ExtPal[0][0]/* + ADDRESS_STEP_8KB*/;
+					mmu->MMU.ExtPal[0][2] = mmu->MMU.ExtPal[0][1]/* + ADDRESS_STEP_8KB*/;
+					mmu->MMU.ExtPal[0][3] = mmu->MMU.ExtPal[0][2]/* + ADDRESS_STEP_8KB*/;
 					break;
 				default:
 					goto unsupported_mst;
@@ -494,40 +432,40 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 			switch (mst)
 			{
 				case 0: // LCDC
-					vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
 					MMU_vram_lcdc(bank);
 					break;
 				case 1: // ABG
-					vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::ABG;
 					MMU_vram_arm9(bank, VRAM_PAGE_ABG + pageofs);
 					MMU_vram_arm9(bank, VRAM_PAGE_ABG + pageofs + 2); // unexpected mirroring (required by spyro eternal night)
 					break;
 				case 2: // AOBJ
-					vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJ;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJ;
 					MMU_vram_arm9(bank, VRAM_PAGE_AOBJ + pageofs);
 					MMU_vram_arm9(bank, VRAM_PAGE_AOBJ + pageofs + 2); // unexpected mirroring - I have no proof, but it is inferred from the ABG above
 					break;
 				case 3: // texture palette
-					vramConfiguration.banks[bank].purpose = VramConfiguration::TEXPAL;
-					MMU.texInfo.texPalSlot[pageofs] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::TEXPAL;
+					mmu->MMU.texInfo.texPalSlot[pageofs] = MMU_vram_physical(vram_bank_info[bank].page_addr);
 					break;
 				case 4: // ABG extended palette
 					switch (ofs)
 					{
 						case 0:
 						case 1:
-							vramConfiguration.banks[bank].purpose = VramConfiguration::ABGEXTPAL;
-							MMU.ExtPal[0][ofs * 2] = MMU_vram_physical(vram_bank_info[bank].page_addr);
-							MMU.ExtPal[0][ofs * 2 + 1] = MMU.ExtPal[0][ofs * 2]/* + ADDRESS_STEP_8KB*/;
+							mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::ABGEXTPAL;
+							mmu->MMU.ExtPal[0][ofs * 2] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+							mmu->MMU.ExtPal[0][ofs * 2 + 1] = mmu->MMU.ExtPal[0][ofs * 2]/* + ADDRESS_STEP_8KB*/;
 							break;
 						default:
-							vramConfiguration.banks[bank].purpose = VramConfiguration::INVALID;
+							mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::INVALID;
 					}
 					break;
 				case 5: // AOBJ extended palette
-					vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJEXTPAL;
-					MMU.ObjExtPal[0][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
-					MMU.ObjExtPal[0][1] = MMU.ObjExtPal[0][1]/* + ADDRESS_STEP_8KB*/;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::AOBJEXTPAL;
+					mmu->MMU.ObjExtPal[0][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->MMU.ObjExtPal[0][1] = mmu->MMU.ObjExtPal[0][1]/* + ADDRESS_STEP_8KB*/;
 					break;
 				default:
 					goto unsupported_mst;
@@ -540,20 +478,20 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 			switch (mst)
 			{
 				case 0: // LCDC
-					vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
 					MMU_vram_lcdc(bank);
 					break;
 				case 1: // BBG
-					vramConfiguration.banks[bank].purpose = VramConfiguration::BBG;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::BBG;
 					MMU_vram_arm9(bank, VRAM_PAGE_BBG);
 					MMU_vram_arm9(bank, VRAM_PAGE_BBG + 4); // unexpected mirroring
 					break;
 				case 2: // BBG extended palette
-					vramConfiguration.banks[bank].purpose = VramConfiguration::BBGEXTPAL;
-					MMU.ExtPal[1][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
-					MMU.ExtPal[1][1] = MMU.ExtPal[1][0]/* + ADDRESS_STEP_8KB*/;
-					MMU.ExtPal[1][2] = MMU.ExtPal[1][1]/* + ADDRESS_STEP_8KB*/;
-					MMU.ExtPal[1][3] = MMU.ExtPal[1][2]/* + ADDRESS_STEP_8KB*/;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::BBGEXTPAL;
+					mmu->MMU.ExtPal[1][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->MMU.ExtPal[1][1] = mmu->MMU.ExtPal[1][0]/* + ADDRESS_STEP_8KB*/;
+					mmu->MMU.ExtPal[1][2] = mmu->MMU.ExtPal[1][1]/* + ADDRESS_STEP_8KB*/;
+					mmu->MMU.ExtPal[1][3] = mmu->MMU.ExtPal[1][2]/* + ADDRESS_STEP_8KB*/;
 					break;
 				default:
 					goto unsupported_mst;
@@ -565,23 +503,23 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 			switch (mst)
 			{
 				case 0: // LCDC
-					vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::LCDC;
 					MMU_vram_lcdc(bank);
 					break;
 				case 1: // BBG
-					vramConfiguration.banks[bank].purpose = VramConfiguration::BBG;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::BBG;
 					MMU_vram_arm9(bank, VRAM_PAGE_BBG + 2);
 					MMU_vram_arm9(bank, VRAM_PAGE_BBG + 3); // unexpected mirroring
 					break;
 				case 2: // BOBJ
-					vramConfiguration.banks[bank].purpose = VramConfiguration::BOBJ;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::BOBJ;
 					MMU_vram_arm9(bank, VRAM_PAGE_BOBJ);
 					MMU_vram_arm9(bank, VRAM_PAGE_BOBJ + 1); // FF3 end scene (lens flare sprite) needs this as it renders a sprite off the end of the 16KB and back around
 					break;
 				case 3: // BOBJ extended palette
-					vramConfiguration.banks[bank].purpose = VramConfiguration::BOBJEXTPAL;
-					MMU.ObjExtPal[1][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
-					MMU.ObjExtPal[1][1] = MMU.ObjExtPal[1][1]/* + ADDRESS_STEP_8KB*/;
+					mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::BOBJEXTPAL;
+					mmu->MMU.ObjExtPal[1][0] = MMU_vram_physical(vram_bank_info[bank].page_addr);
+					mmu->MMU.ObjExtPal[1][1] = mmu->MMU.ObjExtPal[1][1]/* + ADDRESS_STEP_8KB*/;
 					break;
 				default:
 					goto unsupported_mst;
@@ -589,42 +527,42 @@ static inline void MMU_VRAMmapRefreshBank(int bank)
 			break;
 	} // switch(bank)
 
-	vramConfiguration.banks[bank].ofs = ofs;
+	mmu->vramConfiguration.banks[bank].ofs = ofs;
 
 	return;
 
 unsupported_mst:
-	vramConfiguration.banks[bank].purpose = VramConfiguration::INVALID;
+	mmu->vramConfiguration.banks[bank].purpose = VramConfiguration::INVALID;
 }
 
 void MMU_VRAM_unmap_all()
 {
-	vramConfiguration.clear();
+	mmu->vramConfiguration.clear();
 
-	vram_arm7_map[0] = VRAM_PAGE_UNMAPPED;
-	vram_arm7_map[1] = VRAM_PAGE_UNMAPPED;
+	mmu->vram_arm7_map[0] = VRAM_PAGE_UNMAPPED;
+	mmu->vram_arm7_map[1] = VRAM_PAGE_UNMAPPED;
 
 	for (unsigned i = 0; i < VRAM_LCDC_PAGES; ++i)
-		vram_lcdc_map[i] = VRAM_PAGE_UNMAPPED;
+		mmu->vram_lcdc_map[i] = VRAM_PAGE_UNMAPPED;
 	for (int i = 0; i < VRAM_ARM9_PAGES; ++i)
-		vram_arm9_map[i] = VRAM_PAGE_UNMAPPED;
+		mmu->vram_arm9_map[i] = VRAM_PAGE_UNMAPPED;
 
 	for (int i = 0; i < 4; ++i)
 	{
-		MMU.ExtPal[0][i] = MMU.blank_memory;
-		MMU.ExtPal[1][i] = MMU.blank_memory;
+		mmu->MMU.ExtPal[0][i] = mmu->MMU.blank_memory;
+		mmu->MMU.ExtPal[1][i] = mmu->MMU.blank_memory;
 	}
 
-	MMU.ObjExtPal[0][0] = MMU.blank_memory;
-	MMU.ObjExtPal[0][1] = MMU.blank_memory;
-	MMU.ObjExtPal[1][0] = MMU.blank_memory;
-	MMU.ObjExtPal[1][1] = MMU.blank_memory;
+	mmu->MMU.ObjExtPal[0][0] = mmu->MMU.blank_memory;
+	mmu->MMU.ObjExtPal[0][1] = mmu->MMU.blank_memory;
+	mmu->MMU.ObjExtPal[1][0] = mmu->MMU.blank_memory;
+	mmu->MMU.ObjExtPal[1][1] = mmu->MMU.blank_memory;
 
 	for (int i = 0; i < 6; ++i)
-		MMU.texInfo.texPalSlot[i] = MMU.blank_memory;
+		mmu->MMU.texInfo.texPalSlot[i] = mmu->MMU.blank_memory;
 
 	for (int i = 0; i < 4; ++i)
-		MMU.texInfo.textureSlotAddr[i] = MMU.blank_memory;
+		mmu->MMU.texInfo.textureSlotAddr[i] = mmu->MMU.blank_memory;
 }
 
 static inline void MMU_VRAMmapControl(uint8_t block, uint8_t VRAMBankCnt)
@@ -632,7 +570,7 @@ static inline void MMU_VRAMmapControl(uint8_t block, uint8_t VRAMBankCnt)
 	// handle WRAM, first of all
 	if (block == 7)
 	{
-		MMU.WRAMCNT = VRAMBankCnt & 3;
+		mmu->MMU.WRAMCNT = VRAMBankCnt & 3;
 		return;
 	}
 
@@ -643,10 +581,10 @@ static inline void MMU_VRAMmapControl(uint8_t block, uint8_t VRAMBankCnt)
 	MMU_VRAM_unmap_all();
 
 	// unmap VRAM_BANK_C and VRAM_BANK_D from arm7. theyll get mapped again in a moment if necessary
-	T1WriteByte(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240, 0);
+	T1WriteByte(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x240, 0);
 
 	// write the new value to the reg
-	T1WriteByte(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x240 + block, VRAMBankCnt);
+	T1WriteByte(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x240 + block, VRAMBankCnt);
 
 	// refresh all bank settings
 	// zero XX-XX-200X (long before jun 2012)
@@ -704,7 +642,7 @@ static inline void MMU_VRAMmapControl(uint8_t block, uint8_t VRAMBankCnt)
 		for (int i = size; i < 128; ++i)
 		{
 			int page = type + i;
-			vram_arm9_map[page] = vram_arm9_map[type + (i & mask)];
+			mmu->vram_arm9_map[page] = mmu->vram_arm9_map[type + (i & mask)];
 		}
 	}
 }
@@ -715,166 +653,213 @@ static inline void MMU_VRAMmapControl(uint8_t block, uint8_t VRAMBankCnt)
 
 void MMU_Init()
 {
-	memset((void*)&MMU, 0, sizeof(MMU_struct));
+	memset((void*)&mmu->MMU, 0, sizeof(MMU_struct));
+
+	// the memory map points into the memory of this context
+	uint8_t *const mem[2][256] =
+	{
+		//arm9
+		{
+			/* 0X*/	DUP16(mmu->MMU.ARM9_ITCM),
+			/* 1X*/	//DUP16(MMU.ARM9_ITCM)
+			/* 1X*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* 2X*/	DUP16(mmu->MMU.MAIN_MEM),
+			/* 3X*/	DUP16(mmu->MMU.SWIRAM),
+			/* 4X*/	DUP16(mmu->MMU.ARM9_REG),
+			/* 5X*/	DUP16(mmu->MMU.ARM9_VMEM),
+			/* 6X*/	DUP16(mmu->MMU.ARM9_LCD),
+			/* 7X*/	DUP16(mmu->MMU.ARM9_OAM),
+			/* 8X*/	DUP16(nullptr),
+			/* 9X*/	DUP16(nullptr),
+			/* AX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* BX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* CX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* DX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* EX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* FX*/	DUP16(mmu->MMU.ARM9_BIOS)
+		},
+		//arm7
+		{
+			/* 0X*/	DUP16(mmu->MMU.ARM7_BIOS),
+			/* 1X*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* 2X*/	DUP16(mmu->MMU.MAIN_MEM),
+			/* 3X*/	DUP8(mmu->MMU.SWIRAM),
+					DUP8(mmu->MMU.ARM7_ERAM),
+			/* 4X*/	DUP8(mmu->MMU.ARM7_REG),
+					DUP8(mmu->MMU.ARM7_WIRAM),
+			/* 5X*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* 6X*/	DUP16(mmu->MMU.ARM9_LCD),
+			/* 7X*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* 8X*/	DUP16(nullptr),
+			/* 9X*/	DUP16(nullptr),
+			/* AX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* BX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* CX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* DX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* EX*/	DUP16(mmu->MMU.UNUSED_RAM),
+			/* FX*/	DUP16(mmu->MMU.UNUSED_RAM)
+		}
+	};
+	memcpy(mmu->MMU.MMU_MEM, mem, sizeof(mem));
 
-	MMU.CART_ROM = MMU.UNUSED_RAM;
+	mmu->MMU.CART_ROM = mmu->MMU.UNUSED_RAM;
 
 	// even though apps may change dtcm immediately upon startup, this is the correct hardware starting value:
-	MMU.DTCMRegion = 0x08000000;
-	MMU.ITCMRegion = 0x00000000;
+	mmu->MMU.DTCMRegion = 0x08000000;
+	mmu->MMU.ITCMRegion = 0x00000000;
 
 	IPC_FIFOinit(ARMCPU_ARM9);
 	IPC_FIFOinit(ARMCPU_ARM7);
-	new(&MMU_new) MMU_struct_new;
+	new(&mmu->MMU_new) MMU_struct_new;
 
-	mc_init(&MMU.fw, MC_TYPE_FLASH); /* init fw device */
-	mc_alloc(&MMU.fw, NDS_FW_SIZE_V1);
-	MMU.fw.fp = nullptr;
-	MMU.fw.isFirmware = true;
+	mc_init(&mmu->MMU.fw, MC_TYPE_FLASH); /* init fw device */
+	mc_alloc(&mmu->MMU.fw, NDS_FW_SIZE_V1);
+	mmu->MMU.fw.fp = nullptr;
+	mmu->MMU.fw.isFirmware = true;
 }
 
 void MMU_DeInit()
 {
-	mc_free(&MMU.fw);
+	mc_free(&mmu->MMU.fw);
 }
 
 void MMU_Reset()
 {
-	memset(MMU.ARM9_DTCM, 0, sizeof(MMU.ARM9_DTCM));
-	memset(MMU.ARM9_ITCM, 0, sizeof(MMU.ARM9_ITCM));
-	memset(MMU.ARM9_LCD, 0, sizeof(MMU.ARM9_LCD));
-	memset(MMU.ARM9_OAM, 0, sizeof(MMU.ARM9_OAM));
-	memset(MMU.ARM9_REG, 0, sizeof(MMU.ARM9_REG));
-	memset(MMU.ARM9_VMEM, 0, sizeof(MMU.ARM9_VMEM));
-	memset(MMU.MAIN_MEM, 0, sizeof(MMU.MAIN_MEM));
-
-	memset(MMU.blank_memory, 0, sizeof(MMU.blank_memory));
-	memset(MMU.UNUSED_RAM, 0, sizeof(MMU.UNUSED_RAM));
-	memset(MMU.MORE_UNUSED_RAM, 0, sizeof(MMU.UNUSED_RAM));
-
-	memset(MMU.ARM7_ERAM, 0, sizeof(MMU.ARM7_ERAM));
-	memset(MMU.ARM7_REG, 0, sizeof(MMU.ARM7_REG));
-	memset(MMU.ARM7_WIRAM, 0, sizeof(MMU.ARM7_WIRAM));
-	memset(MMU.SWIRAM, 0, sizeof(MMU.SWIRAM));
+	memset(mmu->MMU.ARM9_DTCM, 0, sizeof(mmu->MMU.ARM9_DTCM));
+	memset(mmu->MMU.ARM9_ITCM, 0, sizeof(mmu->MMU.ARM9_ITCM));
+	memset(mmu->MMU.ARM9_LCD, 0, sizeof(mmu->MMU.ARM9_LCD));
+	memset(mmu->MMU.ARM9_OAM, 0, sizeof(mmu->MMU.ARM9_OAM));
+	memset(mmu->MMU.ARM9_REG, 0, sizeof(mmu->MMU.ARM9_REG));
+	memset(mmu->MMU.ARM9_VMEM, 0, sizeof(mmu->MMU.ARM9_VMEM));
+	memset(mmu->MMU.MAIN_MEM, 0, sizeof(mmu->MMU.MAIN_MEM));
+
+	memset(mmu->MMU.blank_memory, 0, sizeof(mmu->MMU.blank_memory));
+	memset(mmu->MMU.UNUSED_RAM, 0, sizeof(mmu->MMU.UNUSED_RAM));
+	memset(mmu->MMU.MORE_UNUSED_RAM, 0, sizeof(mmu->MMU.UNUSED_RAM));
+
+	memset(mmu->MMU.ARM7_ERAM, 0, sizeof(mmu->MMU.ARM7_ERAM));
+	memset(mmu->MMU.ARM7_REG, 0, sizeof(mmu->MMU.ARM7_REG));
+	memset(mmu->MMU.ARM7_WIRAM, 0, sizeof(mmu->MMU.ARM7_WIRAM));
+	memset(mmu->MMU.SWIRAM, 0, sizeof(mmu->MMU.SWIRAM));
 
 	IPC_FIFOinit(ARMCPU_ARM9);
 	IPC_FIFOinit(ARMCPU_ARM7);
 
-	MMU.DTCMRegion = 0x027C0000;
-	MMU.ITCMRegion = 0x00000000;
+	mmu->MMU.DTCMRegion = 0x027C0000;
+	mmu->MMU.ITCMRegion = 0x00000000;
 
-	memset(MMU.timer, 0, sizeof(uint16_t) * 8);
-	memset(MMU.timerMODE, 0, sizeof(int32_t) * 8);
-	memset(MMU.timerON, 0, sizeof(uint32_t) * 8);
-	memset(MMU.timerRUN, 0, sizeof(uint32_t) * 8);
-	memset(MMU.timerReload, 0, sizeof(uint16_t) * 8);
+	memset(mmu->MMU.timer, 0, sizeof(uint16_t) * 8);
+	memset(mmu->MMU.timerMODE, 0, sizeof(int32_t) * 8);
+	memset(mmu->MMU.timerON, 0, sizeof(uint32_t) * 8);
+	memset(mmu->MMU.timerRUN, 0, sizeof(uint32_t) * 8);
+	memset(mmu->MMU.timerReload, 0, sizeof(uint16_t) * 8);
 
-	memset(MMU.reg_IME, 0, sizeof(uint32_t) * 2);
-	memset(MMU.reg_IE, 0, sizeof(uint32_t) * 2);
-	memset(MMU.reg_IF_bits, 0, sizeof(uint32_t) * 2);
-	memset(MMU.reg_IF_pending, 0, sizeof(uint32_t) * 2);
+	memset(mmu->MMU.reg_IME, 0, sizeof(uint32_t) * 2);
+	memset(mmu->MMU.reg_IE, 0, sizeof(uint32_t) * 2);
+	memset(mmu->MMU.reg_IF_bits, 0, sizeof(uint32_t) * 2);
+	memset(mmu->MMU.reg_IF_pending, 0, sizeof(uint32_t) * 2);
 
-	memset(MMU.dscard, 0, sizeof(nds_dscard) * 2);
+	memset(mmu->MMU.dscard, 0, sizeof(nds_dscard) * 2);
 
-	MMU.divRunning = 0;
-	MMU.divResult = 0;
-	MMU.divMod = 0;
-	MMU.divCycles = 0;
+	mmu->MMU.divRunning = 0;
+	mmu->MMU.divResult = 0;
+	mmu->MMU.divMod = 0;
+	mmu->MMU.divCycles = 0;
 
-	MMU.sqrtRunning = 0;
-	MMU.sqrtResult = 0;
-	MMU.sqrtCycles = 0;
+	mmu->MMU.sqrtRunning = 0;
+	mmu->MMU.sqrtResult = 0;
+	mmu->MMU.sqrtCycles = 0;
 
-	MMU.SPI_CNT = 0;
-	MMU.AUX_SPI_CNT = 0;
+	mmu->MMU.SPI_CNT = 0;
+	mmu->MMU.AUX_SPI_CNT = 0;
 
-	MMU.WRAMCNT = 0;
+	mmu->MMU.WRAMCNT = 0;
 
 	// Enable the sound speakers
-	T1WriteWord(MMU.ARM7_REG, 0x304, 0x0001);
+	T1WriteWord(mmu->MMU.ARM7_REG, 0x304, 0x0001);
 
 	MMU_VRAM_unmap_all();
 
-	MMU.powerMan_CntReg = 0x00;
-	MMU.powerMan_CntRegWritten = false;
-	MMU.powerMan_Reg[0] = 0x0B;
-	MMU.powerMan_Reg[1] = 0x00;
-	MMU.powerMan_Reg[2] = 0x01;
-	MMU.powerMan_Reg[3] = 0x00;
+	mmu->MMU.powerMan_CntReg = 0x00;
+	mmu->MMU.powerMan_CntRegWritten = false;
+	mmu->MMU.powerMan_Reg[0] = 0x0B;
+	mmu->MMU.powerMan_Reg[1] = 0x00;
+	mmu->MMU.powerMan_Reg[2] = 0x01;
+	mmu->MMU.powerMan_Reg[3] = 0x00;
 
-	partie = 1;
+	mmu->partie = 1;
 
-	memset(MMU.dscard[ARMCPU_ARM9].command, 0, 8);
-	MMU.dscard[ARMCPU_ARM9].address = 0;
-	MMU.dscard[ARMCPU_ARM9].transfer_count = 0;
-	MMU.dscard[ARMCPU_ARM9].mode = CardMode_Normal;
+	memset(mmu->MMU.dscard[ARMCPU_ARM9].command, 0, 8);
+	mmu->MMU.dscard[ARMCPU_ARM9].address = 0;
+	mmu->MMU.dscard[ARMCPU_ARM9].transfer_count = 0;
+	mmu->MMU.dscard[ARMCPU_ARM9].mode = CardMode_Normal;
 
-	memset(MMU.dscard[ARMCPU_ARM7].command, 0, 8);
-	MMU.dscard[ARMCPU_ARM7].address = 0;
-	MMU.dscard[ARMCPU_ARM7].transfer_count = 0;
-	MMU.dscard[ARMCPU_ARM7].mode = CardMode_Normal;
+	memset(mmu->MMU.dscard[ARMCPU_ARM7].command, 0, 8);
+	mmu->MMU.dscard[ARMCPU_ARM7].address = 0;
+	mmu->MMU.dscard[ARMCPU_ARM7].transfer_count = 0;
+	mmu->MMU.dscard[ARMCPU_ARM7].mode = CardMode_Normal;
 
 	// HACK!!!
 	// until we improve all our session tracking stuff, we need to save the backup memory filename
-	std::string bleh = MMU_new.backupDevice.getFilename();
+	std::string bleh = mmu->MMU_new.backupDevice.getFilename();
 	BackupDevice tempBackupDevice;
-	reconstruct(&MMU_new);
-	MMU_new.backupDevice.load_rom(bleh);
-
-	MMU_timing.arm7codeFetch.Reset();
-	MMU_timing.arm7dataFetch.Reset();
-	MMU_timing.arm9codeFetch.Reset();
-	MMU_timing.arm9dataFetch.Reset();
-	MMU_timing.arm9codeCache.Reset();
-	MMU_timing.arm9dataCache.Reset();
+	reconstruct(&mmu->MMU_new);
+	mmu->MMU_new.backupDevice.load_rom(bleh);
+
+	MMU_timing->arm7codeFetch.Reset();
+	MMU_timing->arm7dataFetch.Reset();
+	MMU_timing->arm9codeFetch.Reset();
+	MMU_timing->arm9dataFetch.Reset();
+	MMU_timing->arm9codeCache.Reset();
+	MMU_timing->arm9dataCache.Reset();
 }
 
 void SetupMMU(bool debugConsole, bool dsi)
 {
 	if (debugConsole)
-		_MMU_MAIN_MEM_MASK = 0x7FFFFF;
+		mmu->_MMU_MAIN_MEM_MASK = 0x7FFFFF;
 	else
-		_MMU_MAIN_MEM_MASK = 0x3FFFFF;
+		mmu->_MMU_MAIN_MEM_MASK = 0x3FFFFF;
 	if (dsi)
-		_MMU_MAIN_MEM_MASK = 0xFFFFFF;
-	_MMU_MAIN_MEM_MASK16 = _MMU_MAIN_MEM_MASK & ~1;
-	_MMU_MAIN_MEM_MASK32 = _MMU_MAIN_MEM_MASK & ~3;
+		mmu->_MMU_MAIN_MEM_MASK = 0xFFFFFF;
+	mmu->_MMU_MAIN_MEM_MASK16 = mmu->_MMU_MAIN_MEM_MASK & ~1;
+	mmu->_MMU_MAIN_MEM_MASK32 = mmu->_MMU_MAIN_MEM_MASK & ~3;
 }
 
 void MMU_setRom(uint8_t *rom, uint32_t)
 {
-	MMU.CART_ROM = rom;
+	mmu->MMU.CART_ROM = rom;
 }
 
 void MMU_unsetRom()
 {
-	MMU.CART_ROM = MMU.UNUSED_RAM;
+	mmu->MMU.CART_ROM = mmu->MMU.UNUSED_RAM;
 }
 
 static void execsqrt()
 {
 	uint32_t ret;
-	uint8_t mode = MMU_new.sqrt.mode;
-	MMU_new.sqrt.busy = 1;
+	uint8_t mode = mmu->MMU_new.sqrt.mode;
+	mmu->MMU_new.sqrt.busy = 1;
 
 	if (mode)
 	{
-		uint64_t v = T1ReadQuad(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B8);
+		uint64_t v = T1ReadQuad(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B8);
 		ret = isqrt(v) & 0xFFFFFFFF;
 	}
 	else
 	{
-		uint32_t v = T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B8);
+		uint32_t v = T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B8);
 		ret = isqrt(v) & 0xFFFFFFFF;
 	}
 
 	// clear the result while the sqrt unit is busy
 	// todo - is this right? is it reasonable?
-	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B4, 0);
+	T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B4, 0);
 
-	MMU.sqrtCycles = nds_timer + 26;
-	MMU.sqrtResult = ret;
-	MMU.sqrtRunning = true;
+	mmu->MMU.sqrtCycles = ds->nds_timer + 26;
+	mmu->MMU.sqrtResult = ret;
+	mmu->MMU.sqrtRunning = true;
 	NDS_Reschedule();
 }
 
@@ -882,28 +867,28 @@ static void execdiv()
 {
 	int64_t num, den;
 	int64_t res, mod;
-	uint8_t mode = MMU_new.div.mode;
-	MMU_new.div.busy = 1;
-	MMU_new.div.div0 = 0;
+	uint8_t mode = mmu->MMU_new.div.mode;
+	mmu->MMU_new.div.busy = 1;
+	mmu->MMU_new.div.div0 = 0;
 
 	switch (mode)
 	{
 		case 0: // 32/32
-			num = T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290);
-			den = T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298);
-			MMU.divCycles = nds_timer + 36;
+			num = T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290);
+			den = T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298);
+			mmu->MMU.divCycles = ds->nds_timer + 36;
 			break;
 		case 1: // 64/32
 		case 3: // gbatek says this is same as mode 1
-			num = T1ReadQuad(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290);
-			den = T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298);
-			MMU.divCycles = nds_timer + 68;
+			num = T1ReadQuad(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290);
+			den = T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298);
+			mmu->MMU.divCycles = ds->nds_timer + 68;
 			break;
 		case 2: // 64/64
 		default:
-			num = T1ReadQuad(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290);
-			den = T1ReadQuad(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298);
-			MMU.divCycles = nds_timer + 68;
+			num = T1ReadQuad(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290);
+			den = T1ReadQuad(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298);
+			mmu->MMU.divCycles = ds->nds_timer + 68;
 	}
 
 	if (!den)
@@ -912,8 +897,8 @@ static void execdiv()
 		mod = num;
 
 		// the DIV0 flag in DIVCNT is set only if the full 64bit DIV_DENOM value is zero, even in 32bit mode
-		if (!T1ReadQuad(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298))
-			MMU_new.div.div0 = 1;
+		if (!T1ReadQuad(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298))
+			mmu->MMU_new.div.div0 = 1;
 	}
 	else
 	{
@@ -921,14 +906,14 @@ static void execdiv()
 		mod = num % den;
 	}
 
-	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A0, 0);
-	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A4, 0);
-	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A8, 0);
-	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2AC, 0);
+	T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A0, 0);
+	T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A4, 0);
+	T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A8, 0);
+	T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2AC, 0);
 
-	MMU.divResult = res;
-	MMU.divMod = mod;
-	MMU.divRunning = true;
+	mmu->MMU.divResult = res;
+	mmu->MMU.divMod = mod;
+	mmu->MMU.divRunning = true;
 	NDS_Reschedule();
 }
 
@@ -991,9 +976,9 @@ uint16_t DSI_TSC::read16()
 void FASTCALL MMU_writeToGCControl(int PROCNUM, uint32_t val)
 {
 	int TEST_PROCNUM = PROCNUM;
-	nds_dscard &card = MMU.dscard[TEST_PROCNUM];
+	nds_dscard &card = mmu->MMU.dscard[TEST_PROCNUM];
 
-	memcpy(&card.command[0], &MMU.MMU_MEM[TEST_PROCNUM][0x40][0x1A8], 8);
+	memcpy(&card.command[0], &mmu->MMU.MMU_MEM[TEST_PROCNUM][0x40][0x1A8], 8);
 
 	card.blocklen = 0;
 	slot1_device.write32(PROCNUM, 0xFFFFFFFF, val); // Special case for some flashcarts
@@ -1006,7 +991,7 @@ void FASTCALL MMU_writeToGCControl(int PROCNUM, uint32_t val)
 		card.transfer_count = 0;
 
 		val &= 0x7F7FFFFF;
-		T1WriteLong(MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
+		T1WriteLong(mmu->MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
 		return;
 	}
 
@@ -1031,7 +1016,7 @@ void FASTCALL MMU_writeToGCControl(int PROCNUM, uint32_t val)
 			card.transfer_count = 0;
 
 			val &= 0x7F7FFFFF;
-			T1WriteLong(MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
+			T1WriteLong(mmu->MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
 			return;
 		case CardMode_KEY2:
 			//INFO("Cartridge: KEY2 mode unsupported.\n");
@@ -1057,12 +1042,12 @@ void FASTCALL MMU_writeToGCControl(int PROCNUM, uint32_t val)
 	if (!card.transfer_count)
 	{
 		val &= 0x7F7FFFFF;
-		T1WriteLong(MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
+		T1WriteLong(mmu->MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
 		return;
 	}
 
 	val |= 0x00800000;
-	T1WriteLong(MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
+	T1WriteLong(mmu->MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, val);
 
 	// Launch DMA if start flag was set to "DS Cart"
 	//fprintf(stderr, "triggering card dma\n");
@@ -1073,7 +1058,7 @@ uint32_t MMU_readFromGC(int PROCNUM)
 {
 	int TEST_PROCNUM = PROCNUM;
 
-	nds_dscard& card = MMU.dscard[TEST_PROCNUM];
+	nds_dscard& card = mmu->MMU.dscard[TEST_PROCNUM];
 	uint32_t val = 0;
 
 	if (!card.transfer_count)
@@ -1100,10 +1085,10 @@ uint32_t MMU_readFromGC(int PROCNUM)
 		return val; // return data
 
 	// transfer is done
-	T1WriteLong(MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, T1ReadLong(MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4) & 0x7F7FFFFF);
+	T1WriteLong(mmu->MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4, T1ReadLong(mmu->MMU.MMU_MEM[TEST_PROCNUM][0x40], 0x1A4) & 0x7F7FFFFF);
 
 	// if needed, throw irq for the end of transfer
-	if (MMU.AUX_SPI_CNT & 0x4000)
+	if (mmu->MMU.AUX_SPI_CNT & 0x4000)
 		NDS_makeIrq(TEST_PROCNUM, IRQ_BIT_GC_TRANSFER_COMPLETE);
 
 	return val;
@@ -1128,7 +1113,7 @@ static void REG_IF_WriteByte(int PROCNUM, uint32_t addr, uint8_t val)
 	// ZERO 01-dec-2010 : I am no longer sure this approach is correct.. it proved to be wrong for IPC fifo.......
 	// it seems as if IF bits should always be cached (only the user can clear them)
 
-	MMU.reg_IF_bits[PROCNUM] &= ~(val << (addr << 3));
+	mmu->MMU.reg_IF_bits[PROCNUM] &= ~(val << (addr << 3));
 	NDS_Reschedule();
 }
 
@@ -1153,16 +1138,16 @@ template<int PROCNUM> uint32_t MMU_struct::gen_IF()
 
 static inline void MMU_IPCSync(uint8_t proc, uint32_t val)
 {
-	uint32_t sync_l = T1ReadLong(MMU.MMU_MEM[proc][0x40], 0x180) & 0xFFFF;
-	uint32_t sync_r = T1ReadLong(MMU.MMU_MEM[proc ^ 1][0x40], 0x180) & 0xFFFF;
+	uint32_t sync_l = T1ReadLong(mmu->MMU.MMU_MEM[proc][0x40], 0x180) & 0xFFFF;
+	uint32_t sync_r = T1ReadLong(mmu->MMU.MMU_MEM[proc ^ 1][0x40], 0x180) & 0xFFFF;
 
 	sync_l = (sync_l & 0x000F) | (val & 0x0F00);
 	sync_r = (sync_r & 0x6F00) | ((val >> 8) & 0x000F);
 
 	sync_l |= val & 0x6000;
 
-	T1WriteLong(MMU.MMU_MEM[proc][0x40], 0x180, sync_l);
-	T1WriteLong(MMU.MMU_MEM[proc ^ 1][0x40], 0x180, sync_r);
+	T1WriteLong(mmu->MMU.MMU_MEM[proc][0x40], 0x180, sync_l);
+	T1WriteLong(mmu->MMU.MMU_MEM[proc ^ 1][0x40], 0x180, sync_r);
 
 	if ((sync_l & IPCSYNC_IRQ_SEND) && (sync_r & IPCSYNC_IRQ_RECV))
 		NDS_makeIrq(proc ^ 1, IRQ_BIT_IPCSYNC);
@@ -1173,21 +1158,21 @@ static inline void MMU_IPCSync(uint8_t proc, uint32_t val)
 static inline uint16_t read_timer(int proc, int timerIndex)
 {
 	// chained timers are always up to date
-	if (MMU.timerMODE[proc][timerIndex] == 0xFFFF)
-		return MMU.timer[proc][timerIndex];
+	if (mmu->MMU.timerMODE[proc][timerIndex] == 0xFFFF)
+		return mmu->MMU.timer[proc][timerIndex];
 
 	// sometimes a timer will be read when it is not enabled.
 	// we should have the value cached
-	if (!MMU.timerON[proc][timerIndex])
-		return MMU.timer[proc][timerIndex];
+	if (!mmu->MMU.timerON[proc][timerIndex])
+		return mmu->MMU.timer[proc][timerIndex];
 
 	// for unchained timers, we do not keep the timer up to date. its value will need to be calculated here
-	int32_t diff = (nds.timerCycle[proc][timerIndex] - nds_timer) & 0xFFFFFFFF;
+	int32_t diff = (ds->nds.timerCycle[proc][timerIndex] - ds->nds_timer) & 0xFFFFFFFF;
 	assert(diff >= 0);
 	if (diff < 0)
-		fprintf(stderr, "NEW EMULOOP BAD NEWS PLEASE REPORT: TIME READ DIFF < 0 (%d) (%d) (%d)\n", diff, timerIndex, MMU.timerMODE[proc][timerIndex]);
+		fprintf(stderr, "NEW EMULOOP BAD NEWS PLEASE REPORT: TIME READ DIFF < 0 (%d) (%d) (%d)\n", diff, timerIndex, mmu->MMU.timerMODE[proc][timerIndex]);
 
-	int32_t units = diff / (1 << MMU.timerMODE[proc][timerIndex]);
+	int32_t units = diff / (1 << mmu->MMU.timerMODE[proc][timerIndex]);
 	int32_t ret;
 
 	if (units == 65536)
@@ -1207,35 +1192,35 @@ static inline uint16_t read_timer(int proc, int timerIndex)
 static inline void write_timer(int proc, int timerIndex, uint16_t val)
 {
 	if (val & 0x80)
-		MMU.timer[proc][timerIndex] = MMU.timerReload[proc][timerIndex];
-	else if (MMU.timerON[proc][timerIndex])
+		mmu->MMU.timer[proc][timerIndex] = mmu->MMU.timerReload[proc][timerIndex];
+	else if (mmu->MMU.timerON[proc][timerIndex])
 		// read the timer value one last time
-		MMU.timer[proc][timerIndex] = read_timer(proc, timerIndex);
+		mmu->MMU.timer[proc][timerIndex] = read_timer(proc, timerIndex);
 
-	MMU.timerON[proc][timerIndex] = val & 0x80;
+	mmu->MMU.timerON[proc][timerIndex] = val & 0x80;
 
 	switch (val & 7)
 	{
 		case 0:
-			MMU.timerMODE[proc][timerIndex] = 1;
+			mmu->MMU.timerMODE[proc][timerIndex] = 1;
 			break;
 		case 1:
-			MMU.timerMODE[proc][timerIndex] = 7;
+			mmu->MMU.timerMODE[proc][timerIndex] = 7;
 			break;
 		case 2:
-			MMU.timerMODE[proc][timerIndex] = 9;
+			mmu->MMU.timerMODE[proc][timerIndex] = 9;
 			break;
 		case 3:
-			MMU.timerMODE[proc][timerIndex] = 11;
+			mmu->MMU.timerMODE[proc][timerIndex] = 11;
 			break;
 		default:
-			MMU.timerMODE[proc][timerIndex] = 0xFFFF;
+			mmu->MMU.timerMODE[proc][timerIndex] = 0xFFFF;
 	}
 
-	int remain = 65536 - MMU.timerReload[proc][timerIndex];
-	nds.timerCycle[proc][timerIndex] = nds_timer + (remain << MMU.timerMODE[proc][timerIndex]);
+	int remain = 65536 - mmu->MMU.timerReload[proc][timerIndex];
+	ds->nds.timerCycle[proc][timerIndex] = ds->nds_timer + (remain << mmu->MMU.timerMODE[proc][timerIndex]);
 
-	T1WriteWord(MMU.MMU_MEM[proc][0x40], 0x102 + timerIndex * 4, val);
+	T1WriteWord(mmu->MMU.MMU_MEM[proc][0x40], 0x102 + timerIndex * 4, val);
 	NDS_RescheduleTimers();
 }
 
@@ -1277,7 +1262,7 @@ void MMU_struct_new::write_dma(int proc, int size, uint32_t _adr, uint32_t val)
 	uint32_t chan = adr / 12;
 	uint32_t regnum = (adr - chan * 12) >> 2;
 
-	MMU_new.dma[proc][chan].regs[regnum]->write(size, adr, val);
+	mmu->MMU_new.dma[proc][chan].regs[regnum]->write(size, adr, val);
 }
 
 // this could be inlined...
@@ -1287,7 +1272,7 @@ uint32_t MMU_struct_new::read_dma(int proc, int size, uint32_t _adr)
 	uint32_t chan = adr / 12;
 	uint32_t regnum = (adr - chan * 12) >> 2;
 
-	uint32_t temp = MMU_new.dma[proc][chan].regs[regnum]->read(size, adr);
+	uint32_t temp = mmu->MMU_new.dma[proc][chan].regs[regnum]->read(size, adr);
 	//fprintf(stderr, "%08lld --  read_dma: %d %d %08X = %08X\n",nds_timer,proc,size,_adr,temp);
 
 	return temp;
@@ -1361,7 +1346,7 @@ void DmaController::exec()
 
 	// we'll need to unfreeze the arm9 bus now
 	if (this->procnum == ARMCPU_ARM9)
-		nds.freezeBus &= ~(1 << (this->chan + 1));
+		ds->nds.freezeBus &= ~(1 << (this->chan + 1));
 
 	this->dmaCheck = false;
 
@@ -1421,7 +1406,7 @@ template<int PROCNUM> void DmaController::doCopy()
 		todo = 128; // this is a hack. maybe an alright one though. it should be 4 words at a time. this is a whole scanline
 
 		// apparently this dma turns off after it finishes a frame
-		if (nds.VCount == 191)
+		if (ds->nds.VCount == 191)
 			this->enable = 0;
 	}
 	if (this->startmode == EDMAMode_Card)
@@ -1527,7 +1512,7 @@ void triggerDma(EDMAMode mode)
 		int i = X;
 		MACRODO4(0, {
 			int j = X;
-			MMU_new.dma[i][j].tryTrigger(mode);
+			mmu->MMU_new.dma[i][j].tryTrigger(mode);
 		});
 	});
 }
@@ -1550,7 +1535,7 @@ void DmaController::tryTrigger(EDMAMode mode)
 void DmaController::doSchedule()
 {
 	this->dmaCheck = true;
-	this->nextEvent = nds_timer;
+	this->nextEvent = ds->nds_timer;
 	NDS_RescheduleDMA();
 }
 
@@ -1594,7 +1579,7 @@ void FASTCALL _MMU_ARM9_write08(uint32_t adr, uint8_t val)
 
 	if (adr < 0x02000000)
 	{
-		T1WriteByte(MMU.ARM9_ITCM, adr & 0x7FFF, val);
+		T1WriteByte(mmu->MMU.ARM9_ITCM, adr & 0x7FFF, val);
 		return;
 	}
 
@@ -1609,9 +1594,9 @@ void FASTCALL _MMU_ARM9_write08(uint32_t adr, uint8_t val)
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
+		if (mmu->MMU_new.is_dma(adr))
 		{
-			MMU_new.write_dma(ARMCPU_ARM9, 8, adr, val);
+			mmu->MMU_new.write_dma(ARMCPU_ARM9, 8, adr, val);
 			return;
 		}
 
@@ -1671,12 +1656,12 @@ void FASTCALL _MMU_ARM9_write08(uint32_t adr, uint8_t val)
 				MMU_VRAMmapControl(adr - REG_VRAMCNTA, val);
 		}
 
-		MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20][adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]] = val;
+		mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20][adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]] = val;
 		return;
 	}
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
-	MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20][adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]] = val;
+	mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20][adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]] = val;
 }
 
 // ================================================= MMU ARM9 write 16
@@ -1686,7 +1671,7 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 
 	if (adr < 0x02000000)
 	{
-		T1WriteWord(MMU.ARM9_ITCM, adr & 0x7FFF, val);
+		T1WriteWord(mmu->MMU.ARM9_ITCM, adr & 0x7FFF, val);
 		return;
 	}
 
@@ -1695,9 +1680,9 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
+		if (mmu->MMU_new.is_dma(adr))
 		{
-			MMU_new.write_dma(ARMCPU_ARM9, 16, adr, val);
+			mmu->MMU_new.write_dma(ARMCPU_ARM9, 16, adr, val);
 			return;
 		}
 
@@ -1708,14 +1693,14 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 			case 0x0400039:
 			case 0x040003A:
 			case 0x040003B:
-				reinterpret_cast<uint16_t *>(MMU.MMU_MEM[ARMCPU_ARM9][0x40])[(adr & 0xFFF) >> 1] = val;
+				reinterpret_cast<uint16_t *>(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40])[(adr & 0xFFF) >> 1] = val;
 				return;
 		}
 		// Address is an IO register
 		switch (adr)
 		{
 			case REG_DIVCNT:
-				MMU_new.div.write16(val);
+				mmu->MMU_new.div.write16(val);
 				execdiv();
 				return;
 
@@ -1732,15 +1717,15 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 				break;
 #endif
 			case REG_SQRTCNT:
-				MMU_new.sqrt.write16(val);
+				mmu->MMU_new.sqrt.write16(val);
 				execsqrt();
 				return;
 
 			case REG_EXMEMCNT:
 			{
-				uint16_t remote_proc = T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x204);
-				T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x204, val);
-				T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x204, (val & 0xFF80) | (remote_proc & 0x7F));
+				uint16_t remote_proc = T1ReadWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x204);
+				T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x204, val);
+				T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x204, (val & 0xFF80) | (remote_proc & 0x7F));
 				return;
 			}
 
@@ -1755,16 +1740,16 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 
 			case REG_IME:
 				NDS_Reschedule();
-				MMU.reg_IME[ARMCPU_ARM9] = val & 0x01;
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x208, val);
+				mmu->MMU.reg_IME[ARMCPU_ARM9] = val & 0x01;
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x208, val);
 				return;
 			case REG_IE:
 				NDS_Reschedule();
-				MMU.reg_IE[ARMCPU_ARM9] = (MMU.reg_IE[ARMCPU_ARM9] & 0xFFFF0000) | val;
+				mmu->MMU.reg_IE[ARMCPU_ARM9] = (mmu->MMU.reg_IE[ARMCPU_ARM9] & 0xFFFF0000) | val;
 				return;
 			case REG_IE + 2:
 				NDS_Reschedule();
-				MMU.reg_IE[ARMCPU_ARM9] = (MMU.reg_IE[ARMCPU_ARM9] & 0xFFFF) | (val << 16);
+				mmu->MMU.reg_IE[ARMCPU_ARM9] = (mmu->MMU.reg_IE[ARMCPU_ARM9] & 0xFFFF) | (val << 16);
 				return;
 			case REG_IF:
 				REG_IF_WriteWord(ARMCPU_ARM9, 0, val);
@@ -1784,7 +1769,7 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 			case REG_TM1CNTL:
 			case REG_TM2CNTL:
 			case REG_TM3CNTL:
-				MMU.timerReload[ARMCPU_ARM9][(adr >> 2) & 3] = val;
+				mmu->MMU.timerReload[ARMCPU_ARM9][(adr >> 2) & 3] = val;
 				return;
 			case REG_TM0CNTH:
 			case REG_TM1CNTH:
@@ -1797,14 +1782,14 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 			}
 
 			case REG_GCROMCTRL:
-				MMU_writeToGCControl(ARMCPU_ARM9, (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x1A4) & 0xFFFF0000) | val);
+				MMU_writeToGCControl(ARMCPU_ARM9, (T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x1A4) & 0xFFFF0000) | val);
 				return;
 			case REG_GCROMCTRL + 2:
-				MMU_writeToGCControl(ARMCPU_ARM9, (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x1A4) & 0xFFFF) | (val << 16));
+				MMU_writeToGCControl(ARMCPU_ARM9, (T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x1A4) & 0xFFFF) | (val << 16));
 				return;
 		}
 
-		T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
+		T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
 		return;
 	}
 
@@ -1814,7 +1799,7 @@ void FASTCALL _MMU_ARM9_write16(uint32_t adr, uint16_t val)
 		return;
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
-	T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
+	T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
 }
 
 // ================================================= MMU ARM9 write 32
@@ -1824,7 +1809,7 @@ void FASTCALL _MMU_ARM9_write32(uint32_t adr, uint32_t val)
 
 	if (adr < 0x02000000)
 	{
-		T1WriteLong(MMU.ARM9_ITCM, adr & 0x7FFF, val);
+		T1WriteLong(mmu->MMU.ARM9_ITCM, adr & 0x7FFF, val);
 		return;
 	}
 
@@ -1833,19 +1818,19 @@ void FASTCALL _MMU_ARM9_write32(uint32_t adr, uint32_t val)
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
+		if (mmu->MMU_new.is_dma(adr))
 		{
-			MMU_new.write_dma(ARMCPU_ARM9, 32, adr, val);
+			mmu->MMU_new.write_dma(ARMCPU_ARM9, 32, adr, val);
 			return;
 		}
 
 		switch (adr)
 		{
 			case REG_SQRTCNT:
-				MMU_new.sqrt.write16(val & 0xFFFF);
+				mmu->MMU_new.sqrt.write16(val & 0xFFFF);
 				return;
 			case REG_DIVCNT:
-				MMU_new.div.write16(val & 0xFFFF);
+				mmu->MMU_new.div.write16(val & 0xFFFF);
 				return;
 
 			case REG_VRAMCNTA:
@@ -1862,13 +1847,13 @@ void FASTCALL _MMU_ARM9_write32(uint32_t adr, uint32_t val)
 
 			case REG_IME:
 				NDS_Reschedule();
-				MMU.reg_IME[ARMCPU_ARM9] = val & 0x01;
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x208, val);
+				mmu->MMU.reg_IME[ARMCPU_ARM9] = val & 0x01;
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x208, val);
 				return;
 
 			case REG_IE:
 				NDS_Reschedule();
-				MMU.reg_IE[ARMCPU_ARM9] = val;
+				mmu->MMU.reg_IE[ARMCPU_ARM9] = val;
 				return;
 
 			case REG_IF:
@@ -1881,43 +1866,43 @@ void FASTCALL _MMU_ARM9_write32(uint32_t adr, uint32_t val)
 			case REG_TM3CNTL:
 			{
 				int timerIndex = (adr >> 2) & 0x3;
-				MMU.timerReload[ARMCPU_ARM9][timerIndex] = val & 0xFFFF;
-				T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM9][0x40], adr & 0xFFF, val & 0xFFFF);
+				mmu->MMU.timerReload[ARMCPU_ARM9][timerIndex] = val & 0xFFFF;
+				T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], adr & 0xFFF, val & 0xFFFF);
 				write_timer(ARMCPU_ARM9, timerIndex, val >> 16);
 				return;
 			}
 
 			case REG_DIVNUMER:
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290, val);
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x290, val);
 				execdiv();
 				return;
 			case REG_DIVNUMER + 4:
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x294, val);
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x294, val);
 				execdiv();
 				return;
 
 			case REG_DIVDENOM:
 			{
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298, val);
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x298, val);
 				execdiv();
 				return;
 			}
 			case REG_DIVDENOM + 4:
 			{
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x29C, val);
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x29C, val);
 				execdiv();
 				return;
 			}
 
 			case REG_SQRTPARAM:
 			{
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B8, val);
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B8, val);
 				execsqrt();
 				return;
 			}
 			case REG_SQRTPARAM + 4:
 			{
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2BC, val);
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2BC, val);
 				execsqrt();
 				return;
 			}
@@ -1936,7 +1921,7 @@ void FASTCALL _MMU_ARM9_write32(uint32_t adr, uint32_t val)
 				MMU_writeToGCControl(ARMCPU_ARM9, val);
 				return;
 			case REG_DISPA_DISPCAPCNT:
-				T1WriteLong(MMU.ARM9_REG, 0x64, val);
+				T1WriteLong(mmu->MMU.ARM9_REG, 0x64, val);
 				return;
 
 			case REG_GCDATAIN:
@@ -1944,7 +1929,7 @@ void FASTCALL _MMU_ARM9_write32(uint32_t adr, uint32_t val)
 				return;
 		}
 
-		T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
+		T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
 		return;
 	}
 
@@ -1954,7 +1939,7 @@ void FASTCALL _MMU_ARM9_write32(uint32_t adr, uint32_t val)
 		return;
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
-	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
+	T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20], val);
 }
 
 // ================================================= MMU ARM9 read 08
@@ -1963,7 +1948,7 @@ uint8_t FASTCALL _MMU_ARM9_read08(uint32_t adr)
 	adr &= 0x0FFFFFFF;
 
 	if (adr<0x02000000)
-		return T1ReadByte(MMU.ARM9_ITCM, adr & 0x7FFF);
+		return T1ReadByte(mmu->MMU.ARM9_ITCM, adr & 0x7FFF);
 
 	if (adr >= 0x08000000 && adr < 0x0A010000)
 		return 0;
@@ -1972,27 +1957,27 @@ uint8_t FASTCALL _MMU_ARM9_read08(uint32_t adr)
 	{
 		//Address is an IO register
 
-		if (MMU_new.is_dma(adr))
-			return MMU_new.read_dma(ARMCPU_ARM9, 8, adr) & 0xFF;
+		if (mmu->MMU_new.is_dma(adr))
+			return mmu->MMU_new.read_dma(ARMCPU_ARM9, 8, adr) & 0xFF;
 
 		switch (adr)
 		{
 			case REG_IF:
-				return MMU.gen_IF<ARMCPU_ARM9>() & 0xFF;
+				return mmu->MMU.gen_IF<ARMCPU_ARM9>() & 0xFF;
 			case REG_IF + 1:
-				return (MMU.gen_IF<ARMCPU_ARM9>() >> 8) & 0xFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM9>() >> 8) & 0xFF;
 			case REG_IF + 2:
-				return (MMU.gen_IF<ARMCPU_ARM9>() >> 16) & 0xFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM9>() >> 16) & 0xFF;
 			case REG_IF + 3:
-				return (MMU.gen_IF<ARMCPU_ARM9>() >> 24) & 0xFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM9>() >> 24) & 0xFF;
 
 			case REG_WRAMCNT:
-				return MMU.WRAMCNT;
+				return mmu->MMU.WRAMCNT;
 
 			case REG_SQRTCNT:
-				return MMU_new.sqrt.read16() & 0xFF;
+				return mmu->MMU_new.sqrt.read16() & 0xFF;
 			case REG_SQRTCNT + 1:
-				return (MMU_new.sqrt.read16() >> 8) & 0xFF;
+				return (mmu->MMU_new.sqrt.read16() >> 8) & 0xFF;
 
 			// sqrtcnt isnt big enough for these to exist. but they'd probably return 0 so its ok
 			case REG_SQRTCNT + 2:
@@ -2004,9 +1989,9 @@ uint8_t FASTCALL _MMU_ARM9_read08(uint32_t adr)
 
 			// Nostalgia's options menu requires that these work
 			case REG_DIVCNT:
-				return MMU_new.div.read16() & 0xFF;
+				return mmu->MMU_new.div.read16() & 0xFF;
 			case REG_DIVCNT + 1:
-				return (MMU_new.div.read16() >> 8) & 0xFF;
+				return (mmu->MMU_new.div.read16() >> 8) & 0xFF;
 
 			// divcnt isnt big enough for these to exist. but they'd probably return 0 so its ok
 			case REG_DIVCNT + 2:
@@ -2023,7 +2008,7 @@ uint8_t FASTCALL _MMU_ARM9_read08(uint32_t adr)
 	if (unmapped)
 		return 0;
 
-	return MMU.MMU_MEM[ARMCPU_ARM9][(adr >> 20) & 0xFF][adr & MMU.MMU_MASK[ARMCPU_ARM9][(adr >> 20) & 0xFF]];
+	return mmu->MMU.MMU_MEM[ARMCPU_ARM9][(adr >> 20) & 0xFF][adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][(adr >> 20) & 0xFF]];
 }
 
 // ================================================= MMU ARM9 read 16
@@ -2032,49 +2017,49 @@ uint16_t FASTCALL _MMU_ARM9_read16(uint32_t adr)
 	adr &= 0x0FFFFFFE;
 
 	if (adr < 0x02000000)
-		return T1ReadWord_guaranteedAligned(MMU.ARM9_ITCM, adr & 0x7FFE);
+		return T1ReadWord_guaranteedAligned(mmu->MMU.ARM9_ITCM, adr & 0x7FFE);
 
 	if (adr >= 0x08000000 && adr < 0x0A010000)
 		return 0;
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
-			return MMU_new.read_dma(ARMCPU_ARM9, 16, adr) & 0xFFFF;
+		if (mmu->MMU_new.is_dma(adr))
+			return mmu->MMU_new.read_dma(ARMCPU_ARM9, 16, adr) & 0xFFFF;
 
 		// Address is an IO register
 		switch (adr)
 		{
 			case REG_SQRTCNT:
-				return MMU_new.sqrt.read16();
+				return mmu->MMU_new.sqrt.read16();
 			// sqrtcnt isnt big enough for this to exist. but it'd probably return 0 so its ok
 			case REG_SQRTCNT + 2:
 				fprintf(stderr, "ERROR 16bit SQRTCNT+2 READ\n");
 				return 0;
 
 			case REG_DIVCNT:
-				return MMU_new.div.read16();
+				return mmu->MMU_new.div.read16();
 			// divcnt isnt big enough for this to exist. but it'd probably return 0 so its ok
 			case REG_DIVCNT + 2:
 				fprintf(stderr, "ERROR 16bit DIVCNT+2 READ\n");
 				return 0;
 
 			case REG_IME:
-				return MMU.reg_IME[ARMCPU_ARM9] & 0xFFFF;
+				return mmu->MMU.reg_IME[ARMCPU_ARM9] & 0xFFFF;
 
 			// WRAMCNT is readable but VRAMCNT is not, so just return WRAM's value
 			case REG_VRAMCNTG:
-				return MMU.WRAMCNT << 8;
+				return mmu->MMU.WRAMCNT << 8;
 
 			case REG_IE:
-				return MMU.reg_IE[ARMCPU_ARM9] & 0xFFFF;
+				return mmu->MMU.reg_IE[ARMCPU_ARM9] & 0xFFFF;
 			case REG_IE + 2:
-				return (MMU.reg_IE[ARMCPU_ARM9] >> 16) & 0xFFFF;
+				return (mmu->MMU.reg_IE[ARMCPU_ARM9] >> 16) & 0xFFFF;
 
 			case REG_IF:
-				return MMU.gen_IF<ARMCPU_ARM9>() & 0xFFFF;
+				return mmu->MMU.gen_IF<ARMCPU_ARM9>() & 0xFFFF;
 			case REG_IF + 2:
-				return (MMU.gen_IF<ARMCPU_ARM9>() >> 16) & 0xFFFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM9>() >> 16) & 0xFFFF;
 
 			case REG_TM0CNTL:
 			case REG_TM1CNTL:
@@ -2083,14 +2068,14 @@ uint16_t FASTCALL _MMU_ARM9_read16(uint32_t adr)
 				return read_timer(ARMCPU_ARM9, (adr & 0xF) >> 2);
 
 			case REG_AUXSPICNT:
-				return MMU.AUX_SPI_CNT;
+				return mmu->MMU.AUX_SPI_CNT;
 		}
 
-		return T1ReadWord_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
+		return T1ReadWord_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
 	}
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF
-	return T1ReadWord_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
+	return T1ReadWord_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
 }
 
 // ================================================= MMU ARM9 read 32
@@ -2099,7 +2084,7 @@ uint32_t FASTCALL _MMU_ARM9_read32(uint32_t adr)
 	adr &= 0x0FFFFFFC;
 
 	if (adr < 0x02000000)
-		return T1ReadLong_guaranteedAligned(MMU.ARM9_ITCM, adr & 0x7FFC);
+		return T1ReadLong_guaranteedAligned(mmu->MMU.ARM9_ITCM, adr & 0x7FFC);
 
 	if (adr >= 0x08000000 && adr < 0x0A010000)
 		return 0;
@@ -2107,39 +2092,39 @@ uint32_t FASTCALL _MMU_ARM9_read32(uint32_t adr)
 	// Address is an IO register
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
-			return MMU_new.read_dma(ARMCPU_ARM9, 32, adr);
+		if (mmu->MMU_new.is_dma(adr))
+			return mmu->MMU_new.read_dma(ARMCPU_ARM9, 32, adr);
 
 		switch (adr)
 		{
 			case REG_DSIMODE:
-				if (!nds.Is_DSI())
+				if (!ds->nds.Is_DSI())
 					break;
 				return 1;
 			case 0x04004008:
-				if (!nds.Is_DSI())
+				if (!ds->nds.Is_DSI())
 					break;
 				return 0x8000;
 
 			// WRAMCNT is readable but VRAMCNT is not, so just return WRAM's value
 			case REG_VRAMCNTE:
-				return MMU.WRAMCNT << 24;
+				return mmu->MMU.WRAMCNT << 24;
 
 			// despite these being 16bit regs,
 			// Dolphin Island Underwater Adventures uses this amidst seemingly reasonable divs so we're going to emulate it.
 			// well, it's pretty reasonable to read them as 32bits though, isnt it?
 			case REG_DIVCNT:
-				return MMU_new.div.read16();
+				return mmu->MMU_new.div.read16();
 			case REG_SQRTCNT:
-				return MMU_new.sqrt.read16(); // I guess we'll do this also
+				return mmu->MMU_new.sqrt.read16(); // I guess we'll do this also
 
 			case REG_IME:
-				return MMU.reg_IME[ARMCPU_ARM9];
+				return mmu->MMU.reg_IME[ARMCPU_ARM9];
 			case REG_IE:
-				return MMU.reg_IE[ARMCPU_ARM9];
+				return mmu->MMU.reg_IE[ARMCPU_ARM9];
 
 			case REG_IF:
-				return MMU.gen_IF<ARMCPU_ARM9>();
+				return mmu->MMU.gen_IF<ARMCPU_ARM9>();
 
 			case REG_IPCFIFORECV:
 				return IPC_FIFOrecv(ARMCPU_ARM9);
@@ -2148,18 +2133,18 @@ uint32_t FASTCALL _MMU_ARM9_read32(uint32_t adr)
 			case REG_TM2CNTL:
 			case REG_TM3CNTL:
 			{
-				uint32_t val = T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x40], (adr + 2) & 0xFFF);
-				return MMU.timer[ARMCPU_ARM9][(adr & 0xF) >> 2] | (val << 16);
+				uint32_t val = T1ReadWord(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], (adr + 2) & 0xFFF);
+				return mmu->MMU.timer[ARMCPU_ARM9][(adr & 0xF) >> 2] | (val << 16);
 			}
 
 			case REG_GCDATAIN:
 				return MMU_readFromGC(ARMCPU_ARM9);
 		}
-		return T1ReadLong_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
+		return T1ReadLong_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
 	}
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [zeromus, inspired by shash]
-	return T1ReadLong_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
+	return T1ReadLong_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM9][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM9][adr >> 20]);
 }
 
 // ================================================================================================== ARM7 *
@@ -2190,9 +2175,9 @@ void FASTCALL _MMU_ARM7_write08(uint32_t adr, uint8_t val)
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
+		if (mmu->MMU_new.is_dma(adr))
 		{
-			MMU_new.write_dma(ARMCPU_ARM7, 8, adr, val);
+			mmu->MMU_new.write_dma(ARMCPU_ARM7, 8, adr, val);
 			return;
 		}
 
@@ -2213,7 +2198,7 @@ void FASTCALL _MMU_ARM7_write08(uint32_t adr, uint8_t val)
 
 			case REG_POSTFLG:
 				// The NDS7 register can be written to only from code executed in BIOS.
-				if (NDS_ARM7.instruct_adr > 0x3FFF)
+				if (NDS_ARM7->instruct_adr > 0x3FFF)
 					return;
 
 				// hack for patched firmwares
@@ -2221,8 +2206,8 @@ void FASTCALL _MMU_ARM7_write08(uint32_t adr, uint8_t val)
 				{
 					if (_MMU_ARM7_read08(REG_POSTFLG))
 						break;
-					_MMU_write32<ARMCPU_ARM9>(0x27FFE24, gameInfo.header.ARM9exe);
-					_MMU_write32<ARMCPU_ARM7>(0x27FFE34, gameInfo.header.ARM7exe);
+					_MMU_write32<ARMCPU_ARM9>(0x27FFE24, ds->gameInfo.header.ARM9exe);
+					_MMU_write32<ARMCPU_ARM7>(0x27FFE34, ds->gameInfo.header.ARM7exe);
 				}
 				break;
 
@@ -2234,16 +2219,16 @@ void FASTCALL _MMU_ARM7_write08(uint32_t adr, uint8_t val)
 						NDS_Sleep();
 						break;
 					case 0x80:
-						armcpu_Wait4IRQ(&NDS_ARM7);
+						armcpu_Wait4IRQ(NDS_ARM7);
 				}
 				break;
 		}
-		MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]] = val;
+		mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]] = val;
 		return;
 	}
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
-	MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]] = val;
+	mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]] = val;
 }
 
 // ================================================= MMU ARM7 write 16
@@ -2265,9 +2250,9 @@ void FASTCALL _MMU_ARM7_write16(uint32_t adr, uint16_t val)
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
+		if (mmu->MMU_new.is_dma(adr))
 		{
-			MMU_new.write_dma(ARMCPU_ARM7, 16, adr, val);
+			mmu->MMU_new.write_dma(ARMCPU_ARM7, 16, adr, val);
 			return;
 		}
 
@@ -2275,19 +2260,19 @@ void FASTCALL _MMU_ARM7_write16(uint32_t adr, uint16_t val)
 		switch (adr)
 		{
 			case REG_DISPA_VCOUNT:
-				if (nds.VCount >= 202 && nds.VCount <= 212)
+				if (ds->nds.VCount >= 202 && ds->nds.VCount <= 212)
 				{
-					fprintf(stderr, "VCOUNT set to %i (previous value %i)\n", val, nds.VCount);
-					nds.VCount = val;
+					fprintf(stderr, "VCOUNT set to %i (previous value %i)\n", val, ds->nds.VCount);
+					ds->nds.VCount = val;
 				}
 				else
-					fprintf(stderr, "Attempt to set VCOUNT while not within 202-212 (%i), ignored\n", nds.VCount);
+					fprintf(stderr, "Attempt to set VCOUNT while not within 202-212 (%i), ignored\n", ds->nds.VCount);
 				return;
 
 			case REG_EXMEMCNT:
 			{
-				uint16_t remote_proc = T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x204);
-				T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x204, (val & 0x7F) | (remote_proc & 0xFF80));
+				uint16_t remote_proc = T1ReadWord(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x204);
+				T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x204, (val & 0x7F) | (remote_proc & 0xFF80));
 				return;
 			}
 
@@ -2295,63 +2280,63 @@ void FASTCALL _MMU_ARM7_write16(uint32_t adr, uint16_t val)
 			{
 				bool reset_firmware = true;
 
-				if (((MMU.SPI_CNT >> 8) & 0x3) == 1 && ((val >> 8) & 0x3) == 1 && BIT11(MMU.SPI_CNT))
+				if (((mmu->MMU.SPI_CNT >> 8) & 0x3) == 1 && ((val >> 8) & 0x3) == 1 && BIT11(mmu->MMU.SPI_CNT))
 					// select held
 					reset_firmware = false;
 
 				//MMU.fw.com == 0; // reset fw device communication
 				if (reset_firmware)
 					// reset fw device communication
-					fw_reset_com(&MMU.fw);
-				MMU.SPI_CNT = val;
+					fw_reset_com(&mmu->MMU.fw);
+				mmu->MMU.SPI_CNT = val;
 
-				T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPICNT >> 20) & 0xff], REG_SPICNT & 0xfff, val);
+				T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPICNT >> 20) & 0xff], REG_SPICNT & 0xfff, val);
 				return;
 			}
 
 			case REG_SPIDATA:
 			{
 				if (val)
-					MMU.SPI_CMD = val;
+					mmu->MMU.SPI_CMD = val;
 
-				uint16_t spicnt = T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPICNT >> 20) & 0xff], REG_SPICNT & 0xfff);
+				uint16_t spicnt = T1ReadWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPICNT >> 20) & 0xff], REG_SPICNT & 0xfff);
 
 				switch ((spicnt >> 8) & 0x3)
 				{
 					case 0:
 					{
-						if (!MMU.powerMan_CntRegWritten)
+						if (!mmu->MMU.powerMan_CntRegWritten)
 						{
-							MMU.powerMan_CntReg = val & 0xFF;
-							MMU.powerMan_CntRegWritten = true;
+							mmu->MMU.powerMan_CntReg = val & 0xFF;
+							mmu->MMU.powerMan_CntRegWritten = true;
 						}
 						else
 						{
-							uint16_t reg = MMU.powerMan_CntReg & 0x7F;
+							uint16_t reg = mmu->MMU.powerMan_CntReg & 0x7F;
 							reg &= 0x7;
 							if (reg == 5 || reg == 6 || reg == 7)
 								reg = 4;
 
 							// (let's start with emulating a DS lite, since it is the more complex case)
-							if (MMU.powerMan_CntReg & 0x80)
+							if (mmu->MMU.powerMan_CntReg & 0x80)
 								// read
-								val = MMU.powerMan_Reg[reg];
+								val = mmu->MMU.powerMan_Reg[reg];
 							else
 							{
 								// write
-								MMU.powerMan_Reg[reg] = val & 0xFF;
+								mmu->MMU.powerMan_Reg[reg] = val & 0xFF;
 
 								static const uint32_t PM_SYSTEM_PWR = BIT(6); /*!< \brief  Turn the power *off* if set */
 
 								// our totally pathetic register handling, only the one thing we've wanted so far
-								if (MMU.powerMan_Reg[0] & PM_SYSTEM_PWR)
+								if (mmu->MMU.powerMan_Reg[0] & PM_SYSTEM_PWR)
 								{
 									fprintf(stderr, "SYSTEM POWERED OFF VIA ARM7 SPI POWER DEVICE\n");
-									execute = false;
+									ds->execute = false;
 								}
 							}
 
-							MMU.powerMan_CntRegWritten = false;
+							mmu->MMU.powerMan_CntRegWritten = false;
 						}
 						break;
 					}
@@ -2359,124 +2344,124 @@ void FASTCALL _MMU_ARM7_write16(uint32_t adr, uint16_t val)
 					case 1: /* firmware memory device */
 						if (spicnt & 0x3) /* check SPI baudrate (must be 4mhz) */
 						{
-							T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPIDATA >> 20) & 0xff], REG_SPIDATA & 0xfff, 0);
+							T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPIDATA >> 20) & 0xff], REG_SPIDATA & 0xfff, 0);
 							break;
 						}
-						T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPIDATA >> 20) & 0xff], REG_SPIDATA & 0xfff, fw_transfer(&MMU.fw, val & 0xFF));
+						T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPIDATA >> 20) & 0xff], REG_SPIDATA & 0xfff, fw_transfer(&mmu->MMU.fw, val & 0xFF));
 						return;
 
 					case 2:
 					{
-						if (nds.Is_DSI())
+						if (ds->nds.Is_DSI())
 						{
 							// pass data to TSC
-							val = MMU_new.dsi_tsc.write16(val);
+							val = mmu->MMU_new.dsi_tsc.write16(val);
 
 							// apply reset command if appropriate
-							if (!BIT11(MMU.SPI_CNT))
-								MMU_new.dsi_tsc.reset_command();
+							if (!BIT11(mmu->MMU.SPI_CNT))
+								mmu->MMU_new.dsi_tsc.reset_command();
 
 							break;
 						}
 
-						int channel = (MMU.SPI_CMD & 0x70) >> 4;
+						int channel = (mmu->MMU.SPI_CMD & 0x70) >> 4;
 						//fprintf(stderr, "%08X\n",channel);
 						switch (channel)
 						{
 							case TSC_MEASURE_TEMP1:
 								if (spicnt & 0x800)
 								{
-									if (partie)
+									if (mmu->partie)
 									{
 										val = 1632;
-										partie = 0;
+										mmu->partie = 0;
 										break;
 									}
 									val = 716 >> 5;
-									partie = 1;
+									mmu->partie = 1;
 									break;
 								}
 								val = 1632;
-								partie = 1;
+								mmu->partie = 1;
 								break;
 							case TSC_MEASURE_TEMP2:
 								if(spicnt & 0x800)
 								{
-									if(partie)
+									if(mmu->partie)
 									{
 										val = 776;
-										partie = 0;
+										mmu->partie = 0;
 										break;
 									}
 									val = 865 >> 5;
-									partie = 1;
+									mmu->partie = 1;
 									break;
 								}
 								val = 776;
-								partie = 1;
+								mmu->partie = 1;
 								break;
 							case TSC_MEASURE_Y:
-								if (MMU.SPI_CNT & (1 << 11))
+								if (mmu->MMU.SPI_CNT & (1 << 11))
 								{
-									if (partie)
+									if (mmu->partie)
 									{
-										partie = 0;
+										mmu->partie = 0;
 										break;
 									}
-									partie = 1;
+									mmu->partie = 1;
 									break;
 								}
-								partie = 1;
+								mmu->partie = 1;
 								break;
 							case TSC_MEASURE_Z1: // Z1
 								if (spicnt & 0x800)
 								{
-									if (partie)
+									if (mmu->partie)
 									{
 										val = (val << 3) & 0x7FF;
-										partie = 0;
+										mmu->partie = 0;
 										break;
 									}
 									val >>= 5;
-									partie = 1;
+									mmu->partie = 1;
 									break;
 								}
 								val = (val << 3) & 0x7FF;
-								partie = 1;
+								mmu->partie = 1;
 								break;
 							case TSC_MEASURE_Z2: // Z2
 								if (spicnt & 0x800)
 								{
-									if (partie)
+									if (mmu->partie)
 									{
 										val = (val << 3) & 0x7FF;
-										partie = 0;
+										mmu->partie = 0;
 										break;
 									}
 									val >>= 5;
-									partie = 1;
+									mmu->partie = 1;
 									break;
 								}
 								val = (val << 3) & 0x7FF;
-								partie = 1;
+								mmu->partie = 1;
 								break;
 							case TSC_MEASURE_X:
 								if (spicnt & 0x800)
 								{
-									if (partie)
+									if (mmu->partie)
 									{
-										partie = 0;
+										mmu->partie = 0;
 										break;
 									}
-									partie = 1;
+									mmu->partie = 1;
 									break;
 								}
-								partie = 1;
+								mmu->partie = 1;
 						}
 					}
 				}
 
-				T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPIDATA >> 20) & 0xff], REG_SPIDATA & 0xfff, val);
+				T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][(REG_SPIDATA >> 20) & 0xff], REG_SPIDATA & 0xfff, val);
 				return;
 			}
 
@@ -2484,16 +2469,16 @@ void FASTCALL _MMU_ARM7_write16(uint32_t adr, uint16_t val)
 
 			case REG_IME:
 				NDS_Reschedule();
-				MMU.reg_IME[ARMCPU_ARM7] = val & 0x01;
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x208, val);
+				mmu->MMU.reg_IME[ARMCPU_ARM7] = val & 0x01;
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x208, val);
 				return;
 			case REG_IE:
 				NDS_Reschedule();
-				MMU.reg_IE[ARMCPU_ARM7] = (MMU.reg_IE[ARMCPU_ARM7] & 0xFFFF0000) | val;
+				mmu->MMU.reg_IE[ARMCPU_ARM7] = (mmu->MMU.reg_IE[ARMCPU_ARM7] & 0xFFFF0000) | val;
 				return;
 			case REG_IE + 2:
 				NDS_Reschedule();
-				MMU.reg_IE[ARMCPU_ARM7] = (MMU.reg_IE[ARMCPU_ARM7] & 0xFFFF) | (val << 16);
+				mmu->MMU.reg_IE[ARMCPU_ARM7] = (mmu->MMU.reg_IE[ARMCPU_ARM7] & 0xFFFF) | (val << 16);
 				return;
 
 			case REG_IF:
@@ -2514,7 +2499,7 @@ void FASTCALL _MMU_ARM7_write16(uint32_t adr, uint16_t val)
 			case REG_TM1CNTL:
 			case REG_TM2CNTL:
 			case REG_TM3CNTL:
-				MMU.timerReload[ARMCPU_ARM7][(adr >> 2) & 3] = val;
+				mmu->MMU.timerReload[ARMCPU_ARM7][(adr >> 2) & 3] = val;
 				return;
 			case REG_TM0CNTH:
 			case REG_TM1CNTH:
@@ -2527,19 +2512,19 @@ void FASTCALL _MMU_ARM7_write16(uint32_t adr, uint16_t val)
 			}
 
 			case REG_GCROMCTRL:
-				MMU_writeToGCControl(ARMCPU_ARM7, (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x1A4) & 0xFFFF0000) | val);
+				MMU_writeToGCControl(ARMCPU_ARM7, (T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x1A4) & 0xFFFF0000) | val);
 				return;
 			case REG_GCROMCTRL + 2:
-				MMU_writeToGCControl(ARMCPU_ARM7, (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x1A4) & 0xFFFF) | (val << 16));
+				MMU_writeToGCControl(ARMCPU_ARM7, (T1ReadLong(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x1A4) & 0xFFFF) | (val << 16));
 				return;
 		}
 
-		T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
+		T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
 		return;
 	}
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
-	T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
+	T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
 }
 
 // ================================================= MMU ARM7 write 32
@@ -2561,9 +2546,9 @@ void FASTCALL _MMU_ARM7_write32(uint32_t adr, uint32_t val)
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
+		if (mmu->MMU_new.is_dma(adr))
 		{
-			MMU_new.write_dma(ARMCPU_ARM7, 32, adr, val);
+			mmu->MMU_new.write_dma(ARMCPU_ARM7, 32, adr, val);
 			return;
 		}
 
@@ -2571,13 +2556,13 @@ void FASTCALL _MMU_ARM7_write32(uint32_t adr, uint32_t val)
 		{
 			case REG_IME:
 				NDS_Reschedule();
-				MMU.reg_IME[ARMCPU_ARM7] = val & 0x01;
-				T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x208, val);
+				mmu->MMU.reg_IME[ARMCPU_ARM7] = val & 0x01;
+				T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x208, val);
 				return;
 
 			case REG_IE:
 				NDS_Reschedule();
-				MMU.reg_IE[ARMCPU_ARM7] = val;
+				mmu->MMU.reg_IE[ARMCPU_ARM7] = val;
 				return;
 
 			case REG_IF:
@@ -2590,8 +2575,8 @@ void FASTCALL _MMU_ARM7_write32(uint32_t adr, uint32_t val)
 			case REG_TM3CNTL:
 			{
 				int timerIndex = (adr >> 2) & 0x3;
-				MMU.timerReload[ARMCPU_ARM7][timerIndex] = val & 0xFFFF;
-				T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][0x40], adr & 0xFFF, val & 0xFFFF);
+				mmu->MMU.timerReload[ARMCPU_ARM7][timerIndex] = val & 0xFFFF;
+				T1WriteWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], adr & 0xFFF, val & 0xFFFF);
 				write_timer(ARMCPU_ARM7, timerIndex, val >> 16);
 				return;
 			}
@@ -2614,12 +2599,12 @@ void FASTCALL _MMU_ARM7_write32(uint32_t adr, uint32_t val)
 				slot1_device.write32(ARMCPU_ARM7, REG_GCDATAIN,val);
 				return;
 		}
-		T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
+		T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
 		return;
 	}
 
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
-	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
+	T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20], val);
 }
 
 // ================================================= MMU ARM7 read 08
@@ -2631,7 +2616,7 @@ uint8_t FASTCALL _MMU_ARM7_read08(uint32_t adr)
 	{
 		// How accurate is this? our R[15] may not be exactly what the hardware uses (may use something less by up to 0x08)
 		// This may be inaccurate at the very edge cases.
-		if (NDS_ARM7.instruct_adr > 0x3FFF)
+		if (NDS_ARM7->instruct_adr > 0x3FFF)
 			return 0xFF;
 	}
 
@@ -2643,30 +2628,30 @@ uint8_t FASTCALL _MMU_ARM7_read08(uint32_t adr)
 
 	if ((adr >> 24) == 4)
 	{
-		if (MMU_new.is_dma(adr))
-			return MMU_new.read_dma(ARMCPU_ARM7, 8, adr) & 0xFF;
+		if (mmu->MMU_new.is_dma(adr))
+			return mmu->MMU_new.read_dma(ARMCPU_ARM7, 8, adr) & 0xFF;
 
 		// Address is an IO register
 
 		switch (adr)
 		{
 			case REG_IF:
-				return MMU.gen_IF<ARMCPU_ARM7>() & 0xFF;
+				return mmu->MMU.gen_IF<ARMCPU_ARM7>() & 0xFF;
 			case REG_IF + 1:
-				return (MMU.gen_IF<ARMCPU_ARM7>() >> 8) & 0xFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM7>() >> 8) & 0xFF;
 			case REG_IF + 2:
-				return (MMU.gen_IF<ARMCPU_ARM7>() >> 16) & 0xFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM7>() >> 16) & 0xFF;
 			case REG_IF + 3:
-				return (MMU.gen_IF<ARMCPU_ARM7>() >> 24) & 0xFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM7>() >> 24) & 0xFF;
 
 			case REG_WRAMSTAT:
-				return MMU.WRAMCNT;
+				return mmu->MMU.WRAMCNT;
 		}
 
-		return MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]];
+		return mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]];
 	}
 
-	return MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]];
+	return mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20][adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]];
 }
 
 // ================================================= MMU ARM7 read 16
@@ -2676,7 +2661,7 @@ uint16_t FASTCALL _MMU_ARM7_read16(uint32_t adr)
 
 	if (adr < 0x4000)
 	{
-		if (NDS_ARM7.instruct_adr > 0x3FFF)
+		if (NDS_ARM7->instruct_adr > 0x3FFF)
 			return 0xFFFF;
 	}
 
@@ -2690,23 +2675,23 @@ uint16_t FASTCALL _MMU_ARM7_read16(uint32_t adr)
 	{
 		// Address is an IO register
 
-		if (MMU_new.is_dma(adr))
-			return MMU_new.read_dma(ARMCPU_ARM7, 16, adr) & 0xFFFF;
+		if (mmu->MMU_new.is_dma(adr))
+			return mmu->MMU_new.read_dma(ARMCPU_ARM7, 16, adr) & 0xFFFF;
 
 		switch (adr)
 		{
 			case REG_IME:
-				return MMU.reg_IME[ARMCPU_ARM7] & 0xFFFF;
+				return mmu->MMU.reg_IME[ARMCPU_ARM7] & 0xFFFF;
 
 			case REG_IE:
-				return MMU.reg_IE[ARMCPU_ARM7] & 0xFFFF;
+				return mmu->MMU.reg_IE[ARMCPU_ARM7] & 0xFFFF;
 			case REG_IE + 2:
-				return (MMU.reg_IE[ARMCPU_ARM7] >> 16) & 0xFFFF;
+				return (mmu->MMU.reg_IE[ARMCPU_ARM7] >> 16) & 0xFFFF;
 
 			case REG_IF:
-				return MMU.gen_IF<ARMCPU_ARM7>() & 0xFFFF;
+				return mmu->MMU.gen_IF<ARMCPU_ARM7>() & 0xFFFF;
 			case REG_IF + 2:
-				return (MMU.gen_IF<ARMCPU_ARM7>() >> 16) & 0xFFFF;
+				return (mmu->MMU.gen_IF<ARMCPU_ARM7>() >> 16) & 0xFFFF;
 
 			case REG_TM0CNTL:
 			case REG_TM1CNTL:
@@ -2716,15 +2701,15 @@ uint16_t FASTCALL _MMU_ARM7_read16(uint32_t adr)
 
 			case REG_VRAMSTAT:
 				// make sure WRAMSTAT is stashed and then fallthrough to return the value from memory. i know, gross.
-				T1WriteByte(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x241, MMU.WRAMCNT);
+				T1WriteByte(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x241, mmu->MMU.WRAMCNT);
 				break;
 		}
-		return T1ReadWord_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
+		return T1ReadWord_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
 	}
 
 	/* Returns data from memory */
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF
-	return T1ReadWord_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
+	return T1ReadWord_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
 }
 
 // ================================================= MMU ARM7 read 32
@@ -2734,7 +2719,7 @@ uint32_t FASTCALL _MMU_ARM7_read32(uint32_t adr)
 
 	if (adr < 0x4000)
 	{
-		if (NDS_ARM7.instruct_adr > 0x3FFF)
+		if (NDS_ARM7->instruct_adr > 0x3FFF)
 			return 0xFFFFFFFF;
 	}
 
@@ -2748,17 +2733,17 @@ uint32_t FASTCALL _MMU_ARM7_read32(uint32_t adr)
 	{
 		// Address is an IO register
 
-		if (MMU_new.is_dma(adr))
-			return MMU_new.read_dma(ARMCPU_ARM7, 32, adr);
+		if (mmu->MMU_new.is_dma(adr))
+			return mmu->MMU_new.read_dma(ARMCPU_ARM7, 32, adr);
 
 		switch (adr)
 		{
 			case REG_IME:
-				return MMU.reg_IME[ARMCPU_ARM7];
+				return mmu->MMU.reg_IME[ARMCPU_ARM7];
 			case REG_IE:
-				return MMU.reg_IE[ARMCPU_ARM7];
+				return mmu->MMU.reg_IE[ARMCPU_ARM7];
 			case REG_IF:
-				return MMU.gen_IF<ARMCPU_ARM7>();
+				return mmu->MMU.gen_IF<ARMCPU_ARM7>();
 			case REG_IPCFIFORECV:
 				return IPC_FIFOrecv(ARMCPU_ARM7);
 			case REG_TM0CNTL:
@@ -2766,8 +2751,8 @@ uint32_t FASTCALL _MMU_ARM7_read32(uint32_t adr)
 			case REG_TM2CNTL:
 			case REG_TM3CNTL:
 			{
-				uint32_t val = T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM7][0x40], (adr + 2) & 0xFFF);
-				return MMU.timer[ARMCPU_ARM7][(adr & 0xF) >> 2] | (val << 16);
+				uint32_t val = T1ReadWord(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], (adr + 2) & 0xFFF);
+				return mmu->MMU.timer[ARMCPU_ARM7][(adr & 0xF) >> 2] | (val << 16);
 			}
 			case REG_GCROMCTRL:
 				break;
@@ -2776,16 +2761,16 @@ uint32_t FASTCALL _MMU_ARM7_read32(uint32_t adr)
 
 			case REG_VRAMSTAT:
 				// make sure WRAMSTAT is stashed and then fallthrough return the value from memory. i know, gross.
-				T1WriteByte(MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x241, MMU.WRAMCNT);
+				T1WriteByte(mmu->MMU.MMU_MEM[ARMCPU_ARM7][0x40], 0x241, mmu->MMU.WRAMCNT);
 				break;
 		}
 
-		return T1ReadLong_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
+		return T1ReadLong_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
 	}
 
 	// Returns data from memory
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [zeromus, inspired by shash]
-	return T1ReadLong_guaranteedAligned(MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
+	return T1ReadLong_guaranteedAligned(mmu->MMU.MMU_MEM[ARMCPU_ARM7][adr >> 20], adr & mmu->MMU.MMU_MASK[ARMCPU_ARM7][adr >> 20]);
 }
 
 // =========================================================================================================
@@ -32,7 +32,7 @@
 
 #define ARMCPU_ARM7 1
 #define ARMCPU_ARM9 0
-#define ARMPROC (PROCNUM ? NDS_ARM7 : NDS_ARM9)
+#define ARMPROC (*(PROCNUM ? NDS_ARM7 : NDS_ARM9))
 
 typedef const uint8_t TWaitState;
 
@@ -358,7 +358,7 @@ struct MMU_struct
 	// (also since the emulator doesn't prevent unaligned accesses)
 	uint8_t MORE_UNUSED_RAM[4];
 
-	static uint8_t *MMU_MEM[2][256];
+	uint8_t *MMU_MEM[2][256];
 	static uint32_t MMU_MASK[2][256];
 
 	uint8_t ARM9_RW_MODE;
@@ -444,9 +444,6 @@ struct MMU_struct_new
 	bool is_dma(uint32_t adr) { return adr >= _REG_DMA_CONTROL_MIN && adr <= _REG_DMA_CONTROL_MAX; }
 };
 
-extern MMU_struct MMU;
-extern MMU_struct_new MMU_new;
-
 void MMU_Init();
 void MMU_DeInit();
 
@@ -507,10 +504,8 @@ struct VramConfiguration
 	}
 };
 
-extern VramConfiguration vramConfiguration;
-
+const unsigned VRAM_LCDC_PAGES = 41;
 const int VRAM_ARM9_PAGES = 512;
-extern uint8_t vram_arm9_map[VRAM_ARM9_PAGES];
 
 template<int PROCNUM, MMU_ACCESS_TYPE AT> uint8_t _MMU_read08(uint32_t addr);
 template<int PROCNUM, MMU_ACCESS_TYPE AT> uint16_t _MMU_read16(uint32_t addr);
@@ -540,13 +535,34 @@ uint8_t  FASTCALL _MMU_ARM7_read08(uint32_t adr);
 uint16_t FASTCALL _MMU_ARM7_read16(uint32_t adr);
 uint32_t FASTCALL _MMU_ARM7_read32(uint32_t adr);
 
-extern uint32_t partie;
-
-extern uint32_t _MMU_MAIN_MEM_MASK;
-extern uint32_t _MMU_MAIN_MEM_MASK16;
-extern uint32_t _MMU_MAIN_MEM_MASK32;
 void SetupMMU(bool debugConsole, bool dsi);
 
+// the memory and the hardware registers of an emulated system
+struct mmu_context
+{
+	uint32_t partie = 1;
+	uint32_t _MMU_MAIN_MEM_MASK = 0x3FFFFF;
+	uint32_t _MMU_MAIN_MEM_MASK16 = 0x3FFFFF & ~1;
+	uint32_t _MMU_MAIN_MEM_MASK32 = 0x3FFFFF & ~3;
+
+	MMU_struct MMU;
+	MMU_struct_new MMU_new;
+
+	VramConfiguration vramConfiguration;
+	uint8_t vram_lcdc_map[VRAM_LCDC_PAGES];
+
+	// in the range of 0x06000000 - 0x06800000 in 16KB pages (the ARM9 vram mappable area)
+	// this maps to 16KB pages in the LCDC buffer which is what will actually contain the data
+	uint8_t vram_arm9_map[VRAM_ARM9_PAGES];
+
+	// this chooses which banks are mapped in the 128K banks starting at 0x06000000 in ARM7
+	uint8_t vram_arm7_map[2];
+
+	IPC_FIFO ipc_fifo[2]; // 0 - ARM9, 1 - ARM7
+};
+
+extern THREADLOCAL mmu_context *mmu;
+
 // ALERT!!!!!!!!!!!!!!
 // the following inline functions dont do the 0x0FFFFFFF mask.
 // this may result in some unexpected behavior
@@ -558,7 +574,7 @@ inline uint8_t _MMU_read08(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr)
 	{
 		if (addr < 0x02000000)
 			return 0; // itcm
-		if ((addr & ~0x3FFF) == MMU.DTCMRegion)
+		if ((addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 			return 0; // dtcm
 	}
 
@@ -566,12 +582,12 @@ inline uint8_t _MMU_read08(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr)
 	CallRegisteredLuaMemHook(addr, 1, /*FIXME*/ 0, LUAMEMHOOK_READ);
 #endif
 
-	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == MMU.DTCMRegion)
+	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 		// Returns data from DTCM (ARM9 only)
-		return T1ReadByte(MMU.ARM9_DTCM, addr & 0x3FFF);
+		return T1ReadByte(mmu->MMU.ARM9_DTCM, addr & 0x3FFF);
 
 	if ((addr & 0x0F000000) == 0x02000000)
-		return T1ReadByte(MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK);
+		return T1ReadByte(mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK);
 
 	if (PROCNUM == ARMCPU_ARM9)
 		return _MMU_ARM9_read08(addr);
@@ -586,7 +602,7 @@ inline uint16_t _MMU_read16(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr)
 	{
 		if (addr < 0x02000000)
 			return 0; // itcm
-		if ((addr & ~0x3FFF) == MMU.DTCMRegion)
+		if ((addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 			return 0; // dtcm
 	}
 
@@ -598,20 +614,20 @@ inline uint16_t _MMU_read16(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr)
 	if (PROCNUM == ARMCPU_ARM9 && AT == MMU_AT_CODE)
 	{
 		if ((addr & 0x0F000000) == 0x02000000)
-			return T1ReadWord_guaranteedAligned(MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK16);
+			return T1ReadWord_guaranteedAligned(mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK16);
 
 		if (addr < 0x02000000)
-			return T1ReadWord_guaranteedAligned(MMU.ARM9_ITCM, addr&0x7FFE);
+			return T1ReadWord_guaranteedAligned(mmu->MMU.ARM9_ITCM, addr&0x7FFE);
 
 		goto dunno;
 	}
 
-	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == MMU.DTCMRegion)
+	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 		// Returns data from DTCM (ARM9 only)
-		return T1ReadWord_guaranteedAligned(MMU.ARM9_DTCM, addr & 0x3FFE);
+		return T1ReadWord_guaranteedAligned(mmu->MMU.ARM9_DTCM, addr & 0x3FFE);
 
 	if ((addr & 0x0F000000) == 0x02000000)
-		return T1ReadWord_guaranteedAligned(MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK16);
+		return T1ReadWord_guaranteedAligned(mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK16);
 
 dunno:
 	if (PROCNUM == ARMCPU_ARM9)
@@ -627,7 +643,7 @@ inline uint32_t _MMU_read32(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr)
 	{
 		if (addr < 0x02000000)
 			return 0; // itcm
-		if ((addr & ~0x3FFF) == MMU.DTCMRegion)
+		if ((addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 			return 0; // dtcm
 	}
 
@@ -639,10 +655,10 @@ inline uint32_t _MMU_read32(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr)
 	if (PROCNUM == ARMCPU_ARM9 && AT == MMU_AT_CODE)
 	{
 		if ((addr & 0x0F000000) == 0x02000000)
-			return T1ReadLong_guaranteedAligned(MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK32);
+			return T1ReadLong_guaranteedAligned(mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK32);
 
 		if (addr < 0x02000000)
-			return T1ReadLong_guaranteedAligned(MMU.ARM9_ITCM, addr&0x7FFC);
+			return T1ReadLong_guaranteedAligned(mmu->MMU.ARM9_ITCM, addr&0x7FFC);
 
 		// what happens when we execute from DTCM? nocash makes it look like we get 0xFFFFFFFF but i can't seem to verify it
 		// historically, desmume would fall through to its old memory map struct
@@ -655,17 +671,17 @@ inline uint32_t _MMU_read32(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr)
 
 	// special handling for execution from arm7. try reading from main memory first
 	if (PROCNUM == ARMCPU_ARM7 && (addr & 0x0F000000) == 0x02000000)
-		return T1ReadLong_guaranteedAligned(MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK32);
+		return T1ReadLong_guaranteedAligned(mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK32);
 
 	// for other arm9 cases, we have to check from dtcm first because it is patched on top of the main memory range
 	if (PROCNUM == ARMCPU_ARM9)
 	{
-		if ((addr & ~0x3FFF) == MMU.DTCMRegion)
+		if ((addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 			// Returns data from DTCM (ARM9 only)
-			return T1ReadLong_guaranteedAligned(MMU.ARM9_DTCM, addr & 0x3FFC);
+			return T1ReadLong_guaranteedAligned(mmu->MMU.ARM9_DTCM, addr & 0x3FFC);
 
 		if ((addr & 0x0F000000) == 0x02000000)
-			return T1ReadLong_guaranteedAligned(MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK32);
+			return T1ReadLong_guaranteedAligned(mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK32);
 	}
 
 dunno:
@@ -682,13 +698,13 @@ inline void _MMU_write08(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr, uint8_t
 	{
 		if (addr < 0x02000000)
 			return; // itcm
-		if ((addr & ~0x3FFF) == MMU.DTCMRegion)
+		if ((addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 			return; // dtcm
 	}
 
-	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == MMU.DTCMRegion)
+	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 	{
-		T1WriteByte(MMU.ARM9_DTCM, addr & 0x3FFF, val);
+		T1WriteByte(mmu->MMU.ARM9_DTCM, addr & 0x3FFF, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 1, val, LUAMEMHOOK_WRITE);
 #endif
@@ -697,7 +713,7 @@ inline void _MMU_write08(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr, uint8_t
 
 	if ((addr & 0x0F000000) == 0x02000000)
 	{
-		T1WriteByte( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK, val);
+		T1WriteByte( mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 1, val, LUAMEMHOOK_WRITE);
 #endif
@@ -720,13 +736,13 @@ inline void _MMU_write16(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr, uint16_
 	{
 		if (addr < 0x02000000)
 			return; // itcm
-		if ((addr & ~0x3FFF) == MMU.DTCMRegion)
+		if ((addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 			return; // dtcm
 	}
 
-	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == MMU.DTCMRegion)
+	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 	{
-		T1WriteWord(MMU.ARM9_DTCM, addr & 0x3FFE, val);
+		T1WriteWord(mmu->MMU.ARM9_DTCM, addr & 0x3FFE, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 2, val, LUAMEMHOOK_WRITE);
 #endif
@@ -735,7 +751,7 @@ inline void _MMU_write16(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr, uint16_
 
 	if ((addr & 0x0F000000) == 0x02000000)
 	{
-		T1WriteWord( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK16, val);
+		T1WriteWord( mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK16, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 2, val, LUAMEMHOOK_WRITE);
 #endif
@@ -758,13 +774,13 @@ inline void _MMU_write32(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr, uint32_
 	{
 		if (addr < 0x02000000)
 			return; // itcm
-		if ((addr & ~0x3FFF) == MMU.DTCMRegion)
+		if ((addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 			return; // dtcm
 	}
 
-	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == MMU.DTCMRegion)
+	if (PROCNUM == ARMCPU_ARM9 && (addr & ~0x3FFF) == mmu->MMU.DTCMRegion)
 	{
-		T1WriteLong(MMU.ARM9_DTCM, addr & 0x3FFC, val);
+		T1WriteLong(mmu->MMU.ARM9_DTCM, addr & 0x3FFC, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 4, val, LUAMEMHOOK_WRITE);
 #endif
@@ -773,7 +789,7 @@ inline void _MMU_write32(int PROCNUM, MMU_ACCESS_TYPE AT, uint32_t addr, uint32_
 
 	if ((addr & 0x0F000000) == 0x02000000)
 	{
-		T1WriteLong( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK32, val);
+		T1WriteLong( mmu->MMU.MAIN_MEM, addr & mmu->_MMU_MAIN_MEM_MASK32, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 4, val, LUAMEMHOOK_WRITE);
 #endif
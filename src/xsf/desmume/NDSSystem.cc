@@ -23,6 +23,7 @@
 #include <zlib.h>
 #include "NDSSystem.h"
 #include "MMU.h"
+#include "MMU_timing.h"
 #include "cp15.h"
 #include "bios.h"
 #include "readwrite.h"
@@ -31,20 +32,15 @@
 
 // ===============================================================
 
-TCommonSettings CommonSettings;
-
-GameInfo gameInfo;
-NDSSystem nds;
-static std::unique_ptr<CFIRMWARE> firmware;
-volatile bool execute = false;
+THREADLOCAL nds_context *ds;
 
 int NDS_Init()
 {
 	MMU_Init();
-	nds.VCount = 0;
+	ds->nds.VCount = 0;
 
-	armcpu_new(&NDS_ARM7, 1);
-	armcpu_new(&NDS_ARM9, 0);
+	armcpu_new(NDS_ARM7, 1);
+	armcpu_new(NDS_ARM9, 0);
 
 	if (SPU_Init(SNDCORE_DUMMY, 740))
 		return -1;
@@ -54,7 +50,7 @@ int NDS_Init()
 
 void NDS_DeInit()
 {
-	if (MMU.CART_ROM != MMU.UNUSED_RAM)
+	if (mmu->MMU.CART_ROM != mmu->MMU.UNUSED_RAM)
 		NDS_FreeROM();
 
 	SPU_DeInit();
@@ -70,50 +66,50 @@ bool NDS_SetROM(uint8_t *rom, uint32_t mask)
 
 std::unique_ptr<NDS_header> NDS_getROMHeader()
 {
-	if (MMU.CART_ROM == MMU.UNUSED_RAM)
+	if (mmu->MMU.CART_ROM == mmu->MMU.UNUSED_RAM)
 		return std::unique_ptr<NDS_header>();
 	auto header = std::unique_ptr<NDS_header>(new NDS_header);
 
-	memcpy(header->gameTile, MMU.CART_ROM, 12);
-	memcpy(header->gameCode, MMU.CART_ROM + 12, 4);
-	header->makerCode = T1ReadWord(MMU.CART_ROM, 16);
-	header->unitCode = MMU.CART_ROM[18];
-	header->deviceCode = MMU.CART_ROM[19];
-	header->cardSize = MMU.CART_ROM[20];
-	memcpy(header->cardInfo, MMU.CART_ROM + 21, 8);
-	header->flags = MMU.CART_ROM[29];
-	header->romversion = MMU.CART_ROM[30];
-	header->ARM9src = T1ReadLong(MMU.CART_ROM, 32);
-	header->ARM9exe = T1ReadLong(MMU.CART_ROM, 36);
-	header->ARM9cpy = T1ReadLong(MMU.CART_ROM, 40);
-	header->ARM9binSize = T1ReadLong(MMU.CART_ROM, 44);
-	header->ARM7src = T1ReadLong(MMU.CART_ROM, 48);
-	header->ARM7exe = T1ReadLong(MMU.CART_ROM, 52);
-	header->ARM7cpy = T1ReadLong(MMU.CART_ROM, 56);
-	header->ARM7binSize = T1ReadLong(MMU.CART_ROM, 60);
-	header->FNameTblOff = T1ReadLong(MMU.CART_ROM, 64);
-	header->FNameTblSize = T1ReadLong(MMU.CART_ROM, 68);
-	header->FATOff = T1ReadLong(MMU.CART_ROM, 72);
-	header->FATSize = T1ReadLong(MMU.CART_ROM, 76);
-	header->ARM9OverlayOff = T1ReadLong(MMU.CART_ROM, 80);
-	header->ARM9OverlaySize = T1ReadLong(MMU.CART_ROM, 84);
-	header->ARM7OverlayOff = T1ReadLong(MMU.CART_ROM, 88);
-	header->ARM7OverlaySize = T1ReadLong(MMU.CART_ROM, 92);
-	header->unknown2a = T1ReadLong(MMU.CART_ROM, 96);
-	header->unknown2b = T1ReadLong(MMU.CART_ROM, 100);
-	header->IconOff = T1ReadLong(MMU.CART_ROM, 104);
-	header->CRC16 = T1ReadWord(MMU.CART_ROM, 108);
-	header->ROMtimeout = T1ReadWord(MMU.CART_ROM, 110);
-	header->ARM9unk = T1ReadLong(MMU.CART_ROM, 112);
-	header->ARM7unk = T1ReadLong(MMU.CART_ROM, 116);
-	memcpy(header->unknown3c, MMU.CART_ROM + 120, 8);
-	header->ROMSize = T1ReadLong(MMU.CART_ROM, 128);
-	header->HeaderSize = T1ReadLong(MMU.CART_ROM, 132);
-	memcpy(header->unknown5, MMU.CART_ROM + 136, 56);
-	memcpy(header->logo, MMU.CART_ROM + 192, 156);
-	header->logoCRC16 = T1ReadWord(MMU.CART_ROM, 348);
-	header->headerCRC16 = T1ReadWord(MMU.CART_ROM, 350);
-	memcpy(header->reserved, MMU.CART_ROM + 352, std::min<size_t>(160, gameInfo.romsize - 352));
+	memcpy(header->gameTile, mmu->MMU.CART_ROM, 12);
+	memcpy(header->gameCode, mmu->MMU.CART_ROM + 12, 4);
+	header->makerCode = T1ReadWord(mmu->MMU.CART_ROM, 16);
+	header->unitCode = mmu->MMU.CART_ROM[18];
+	header->deviceCode = mmu->MMU.CART_ROM[19];
+	header->cardSize = mmu->MMU.CART_ROM[20];
+	memcpy(header->cardInfo, mmu->MMU.CART_ROM + 21, 8);
+	header->flags = mmu->MMU.CART_ROM[29];
+	header->romversion = mmu->MMU.CART_ROM[30];
+	header->ARM9src = T1ReadLong(mmu->MMU.CART_ROM, 32);
+	header->ARM9exe = T1ReadLong(mmu->MMU.CART_ROM, 36);
+	header->ARM9cpy = T1ReadLong(mmu->MMU.CART_ROM, 40);
+	header->ARM9binSize = T1ReadLong(mmu->MMU.CART_ROM, 44);
+	header->ARM7src = T1ReadLong(mmu->MMU.CART_ROM, 48);
+	header->ARM7exe = T1ReadLong(mmu->MMU.CART_ROM, 52);
+	header->ARM7cpy = T1ReadLong(mmu->MMU.CART_ROM, 56);
+	header->ARM7binSize = T1ReadLong(mmu->MMU.CART_ROM, 60);
+	header->FNameTblOff = T1ReadLong(mmu->MMU.CART_ROM, 64);
+	header->FNameTblSize = T1ReadLong(mmu->MMU.CART_ROM, 68);
+	header->FATOff = T1ReadLong(mmu->MMU.CART_ROM, 72);
+	header->FATSize = T1ReadLong(mmu->MMU.CART_ROM, 76);
+	header->ARM9OverlayOff = T1ReadLong(mmu->MMU.CART_ROM, 80);
+	header->ARM9OverlaySize = T1ReadLong(mmu->MMU.CART_ROM, 84);
+	header->ARM7OverlayOff = T1ReadLong(mmu->MMU.CART_ROM, 88);
+	header->ARM7OverlaySize = T1ReadLong(mmu->MMU.CART_ROM, 92);
+	header->unknown2a = T1ReadLong(mmu->MMU.CART_ROM, 96);
+	header->unknown2b = T1ReadLong(mmu->MMU.CART_ROM, 100);
+	header->IconOff = T1ReadLong(mmu->MMU.CART_ROM, 104);
+	header->CRC16 = T1ReadWord(mmu->MMU.CART_ROM, 108);
+	header->ROMtimeout = T1ReadWord(mmu->MMU.CART_ROM, 110);
+	header->ARM9unk = T1ReadLong(mmu->MMU.CART_ROM, 112);
+	header->ARM7unk = T1ReadLong(mmu->MMU.CART_ROM, 116);
+	memcpy(header->unknown3c, mmu->MMU.CART_ROM + 120, 8);
+	header->ROMSize = T1ReadLong(mmu->MMU.CART_ROM, 128);
+	header->HeaderSize = T1ReadLong(mmu->MMU.CART_ROM, 132);
+	memcpy(header->unknown5, mmu->MMU.CART_ROM + 136, 56);
+	memcpy(header->logo, mmu->MMU.CART_ROM + 192, 156);
+	header->logoCRC16 = T1ReadWord(mmu->MMU.CART_ROM, 348);
+	header->headerCRC16 = T1ReadWord(mmu->MMU.CART_ROM, 350);
+	memcpy(header->reserved, mmu->MMU.CART_ROM + 352, std::min<size_t>(160, ds->gameInfo.romsize - 352));
 
 	return header;
 }
@@ -133,23 +129,20 @@ RomBanner::RomBanner(bool defaultInit)
 
 void NDS_FreeROM()
 {
-	if (MMU.CART_ROM == reinterpret_cast<uint8_t *>(&gameInfo.romdata[0]))
-		gameInfo.romdata.reset();
-	if (MMU.CART_ROM != MMU.UNUSED_RAM)
-		delete [] MMU.CART_ROM;
+	if (mmu->MMU.CART_ROM == reinterpret_cast<uint8_t *>(&ds->gameInfo.romdata[0]))
+		ds->gameInfo.romdata.reset();
+	if (mmu->MMU.CART_ROM != mmu->MMU.UNUSED_RAM)
+		delete [] mmu->MMU.CART_ROM;
 	MMU_unsetRom();
 }
 
-void NDS_Sleep() { nds.sleeping = true; }
+void NDS_Sleep() { ds->nds.sleeping = true; }
 
 enum ESI_DISPCNT
 {
 	ESI_DISPCNT_HStart, ESI_DISPCNT_HStartIRQ, ESI_DISPCNT_HDraw, ESI_DISPCNT_HBlank
 };
 
-uint64_t nds_timer;
-static uint64_t nds_arm9_timer, nds_arm7_timer;
-
 struct TSequenceItem
 {
 	uint64_t timestamp;
@@ -160,7 +153,7 @@ struct TSequenceItem
 
 	virtual bool isTriggered() const
 	{
-		return this->enabled && nds_timer >= this->timestamp;
+		return this->enabled && ds->nds_timer >= this->timestamp;
 	}
 
 	virtual uint64_t next() const
@@ -173,34 +166,34 @@ template<int procnum, int num> struct TSequenceItem_Timer : public TSequenceItem
 {
 	bool isTriggered() const
 	{
-		return this->enabled && nds_timer >= nds.timerCycle[procnum][num];
+		return this->enabled && ds->nds_timer >= ds->nds.timerCycle[procnum][num];
 	}
 
 	void schedule()
 	{
-		this->enabled = MMU.timerON[procnum][num] && MMU.timerMODE[procnum][num] != 0xFFFF;
+		this->enabled = mmu->MMU.timerON[procnum][num] && mmu->MMU.timerMODE[procnum][num] != 0xFFFF;
 	}
 
 	uint64_t next() const
 	{
-		return nds.timerCycle[procnum][num];
+		return ds->nds.timerCycle[procnum][num];
 	}
 
 	void exec()
 	{
-		uint8_t *regs = !procnum ? MMU.ARM9_REG : MMU.ARM7_REG;
+		uint8_t *regs = !procnum ? mmu->MMU.ARM9_REG : mmu->MMU.ARM7_REG;
 		bool first = true, over;
 		// we'll need to check chained timers..
 		for (int i = num; i < 4; ++i)
 		{
 			// maybe too many checks if this is here, but we need it here for now
-			if (!MMU.timerON[procnum][i])
+			if (!mmu->MMU.timerON[procnum][i])
 				return;
 
-			if (MMU.timerMODE[procnum][i] == 0xFFFF)
+			if (mmu->MMU.timerMODE[procnum][i] == 0xFFFF)
 			{
-				++MMU.timer[procnum][i];
-				over = !MMU.timer[procnum][i];
+				++mmu->MMU.timer[procnum][i];
+				over = !mmu->MMU.timer[procnum][i];
 			}
 			else
 			{
@@ -209,11 +202,11 @@ template<int procnum, int num> struct TSequenceItem_Timer : public TSequenceItem
 				first = false;
 
 				over = true;
-				int remain = 65536 - MMU.timerReload[procnum][i];
+				int remain = 65536 - mmu->MMU.timerReload[procnum][i];
 				int ctr = 0;
-				while (nds.timerCycle[procnum][i] <= nds_timer)
+				while (ds->nds.timerCycle[procnum][i] <= ds->nds_timer)
 				{
-					nds.timerCycle[procnum][i] += remain << MMU.timerMODE[procnum][i];
+					ds->nds.timerCycle[procnum][i] += remain << mmu->MMU.timerMODE[procnum][i];
 					++ctr;
 				}
 #ifndef NDEBUG
@@ -224,7 +217,7 @@ template<int procnum, int num> struct TSequenceItem_Timer : public TSequenceItem
 
 			if (over)
 			{
-				MMU.timer[procnum][i] = MMU.timerReload[procnum][i];
+				mmu->MMU.timer[procnum][i] = mmu->MMU.timerReload[procnum][i];
 				if (T1ReadWord(regs, 0x102 + i * 4) & 0x40)
 					NDS_makeIrq(procnum, IRQ_BIT_TIMER_0 + i);
 			}
@@ -240,7 +233,7 @@ template<int procnum, int chan> struct TSequenceItem_DMA : public TSequenceItem
 
 	bool isTriggered() const
 	{
-		return this->controller->dmaCheck && nds_timer>= this->controller->nextEvent;
+		return this->controller->dmaCheck && ds->nds_timer>= this->controller->nextEvent;
 	}
 
 	bool isEnabled() const
@@ -264,32 +257,32 @@ struct TSequenceItem_divider : public TSequenceItem
 {
 	bool isTriggered() const
 	{
-		return MMU.divRunning && nds_timer >= MMU.divCycles;
+		return mmu->MMU.divRunning && ds->nds_timer >= mmu->MMU.divCycles;
 	}
 
 	bool isEnabled()
 	{
-		return MMU.divRunning;
+		return mmu->MMU.divRunning;
 	}
 
 	uint64_t next() const
 	{
-		return MMU.divCycles;
+		return mmu->MMU.divCycles;
 	}
 
 	void exec()
 	{
-		MMU_new.div.busy = 0;
+		mmu->MMU_new.div.busy = 0;
 #ifdef _WIN64
-		T1WriteQuad(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A0, MMU.divResult);
-		T1WriteQuad(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A8, MMU.divMod);
+		T1WriteQuad(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A0, mmu->MMU.divResult);
+		T1WriteQuad(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A8, mmu->MMU.divMod);
 #else
-		T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A0, MMU.divResult & 0xFFFFFFFF);
-		T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A4, (MMU.divResult >> 32) & 0xFFFFFFFF);
-		T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A8, MMU.divMod & 0xFFFFFFFF);
-		T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2AC, (MMU.divMod >> 32) & 0xFFFFFFFF);
+		T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A0, mmu->MMU.divResult & 0xFFFFFFFF);
+		T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A4, (mmu->MMU.divResult >> 32) & 0xFFFFFFFF);
+		T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2A8, mmu->MMU.divMod & 0xFFFFFFFF);
+		T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2AC, (mmu->MMU.divMod >> 32) & 0xFFFFFFFF);
 #endif
-		MMU.divRunning = false;
+		mmu->MMU.divRunning = false;
 	}
 };
 
@@ -297,28 +290,28 @@ struct TSequenceItem_sqrtunit : public TSequenceItem
 {
 	bool isTriggered() const
 	{
-		return MMU.sqrtRunning && nds_timer >= MMU.sqrtCycles;
+		return mmu->MMU.sqrtRunning && ds->nds_timer >= mmu->MMU.sqrtCycles;
 	}
 
 	bool isEnabled()
 	{
-		return MMU.sqrtRunning;
+		return mmu->MMU.sqrtRunning;
 	}
 
 	uint64_t next() const
 	{
-		return MMU.sqrtCycles;
+		return mmu->MMU.sqrtCycles;
 	}
 
 	void exec()
 	{
-		MMU_new.sqrt.busy = 0;
-		T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B4, MMU.sqrtResult);
-		MMU.sqrtRunning = false;
+		mmu->MMU_new.sqrt.busy = 0;
+		T1WriteLong(mmu->MMU.MMU_MEM[ARMCPU_ARM9][0x40], 0x2B4, mmu->MMU.sqrtResult);
+		mmu->MMU.sqrtRunning = false;
 	}
 };
 
-static struct Sequencer
+struct Sequencer
 {
 	bool nds_vblankEnded;
 	bool reschedule;
@@ -340,11 +333,13 @@ static struct Sequencer
 
 	void execHardware();
 	uint64_t findNext();
-} sequencer;
+};
+
+static THREADLOCAL Sequencer *sequencer;
 
 void NDS_RescheduleTimers()
 {
-#define check(X, Y) sequencer.timer_##X##_##Y .schedule();
+#define check(X, Y) sequencer->timer_##X##_##Y .schedule();
 	check(0, 0); check(0, 1); check(0, 2); check(0, 3);
 	check(1, 0); check(1, 1); check(1, 2); check(1, 3);
 #undef check
@@ -360,13 +355,13 @@ void NDS_RescheduleDMA()
 
 static void initSchedule()
 {
-	sequencer.init();
+	sequencer->init();
 
 	// begin at the very end of the last scanline
 	// so that at t=0 we can increment to scanline=0
-	nds.VCount = 262;
+	ds->nds.VCount = 262;
 
-	sequencer.nds_vblankEnded = false;
+	sequencer->nds_vblankEnded = false;
 }
 
 // 2196372 ~= (ARM7_CLOCK << 16) / 1000000
@@ -383,22 +378,22 @@ void Sequencer::init()
 	NDS_RescheduleDMA();
 
 	this->reschedule = false;
-	nds_timer = 0;
-	nds_arm9_timer = 0;
-	nds_arm7_timer = 0;
+	ds->nds_timer = 0;
+	ds->nds_arm9_timer = 0;
+	ds->nds_arm7_timer = 0;
 
 	this->dispcnt.enabled = true;
 	this->dispcnt.param = ESI_DISPCNT_HStart;
 	this->dispcnt.timestamp = 0;
 
-	this->dma_0_0.controller = &MMU_new.dma[0][0];
-	this->dma_0_1.controller = &MMU_new.dma[0][1];
-	this->dma_0_2.controller = &MMU_new.dma[0][2];
-	this->dma_0_3.controller = &MMU_new.dma[0][3];
-	this->dma_1_0.controller = &MMU_new.dma[1][0];
-	this->dma_1_1.controller = &MMU_new.dma[1][1];
-	this->dma_1_2.controller = &MMU_new.dma[1][2];
-	this->dma_1_3.controller = &MMU_new.dma[1][3];
+	this->dma_0_0.controller = &mmu->MMU_new.dma[0][0];
+	this->dma_0_1.controller = &mmu->MMU_new.dma[0][1];
+	this->dma_0_2.controller = &mmu->MMU_new.dma[0][2];
+	this->dma_0_3.controller = &mmu->MMU_new.dma[0][3];
+	this->dma_1_0.controller = &mmu->MMU_new.dma[1][0];
+	this->dma_1_1.controller = &mmu->MMU_new.dma[1][1];
+	this->dma_1_2.controller = &mmu->MMU_new.dma[1][2];
+	this->dma_1_3.controller = &mmu->MMU_new.dma[1][3];
 }
 
 static void execHardware_hblank()
@@ -408,20 +403,20 @@ static void execHardware_hblank()
 	// by drawing scanline N at the end of drawing time (but before subsequent interrupt or hdma-driven events happen)
 	// don't try to do this at the end of the scanline, because some games (sonic classics) may use hblank IRQ to set
 	// scroll regs for the next scanline
-	if (nds.VCount < 192)
+	if (ds->nds.VCount < 192)
 		// trigger hblank dmas
 		// but notice, we do that just after we finished drawing the line
 		// (values copied by this hdma should not be used until the next scanline)
 		triggerDma(EDMAMode_HBlank);
 
 	// turn on hblank status bit
-	T1WriteWord(MMU.ARM9_REG, 4, T1ReadWord(MMU.ARM9_REG, 4) | 2);
-	T1WriteWord(MMU.ARM7_REG, 4, T1ReadWord(MMU.ARM7_REG, 4) | 2);
+	T1WriteWord(mmu->MMU.ARM9_REG, 4, T1ReadWord(mmu->MMU.ARM9_REG, 4) | 2);
+	T1WriteWord(mmu->MMU.ARM7_REG, 4, T1ReadWord(mmu->MMU.ARM7_REG, 4) | 2);
 
 	// fire hblank interrupts if necessary
-	if (T1ReadWord(MMU.ARM9_REG, 4) & 0x10)
+	if (T1ReadWord(mmu->MMU.ARM9_REG, 4) & 0x10)
 		NDS_makeIrq(ARMCPU_ARM9, IRQ_BIT_LCD_HBLANK);
-	if (T1ReadWord(MMU.ARM7_REG, 4) & 0x10)
+	if (T1ReadWord(mmu->MMU.ARM7_REG, 4) & 0x10)
 		NDS_makeIrq(ARMCPU_ARM7, IRQ_BIT_LCD_HBLANK);
 
 	// emulation housekeeping. for some reason we always do this at hblank,
@@ -431,12 +426,12 @@ static void execHardware_hblank()
 
 static void execHardware_hstart_vblankEnd()
 {
-	sequencer.nds_vblankEnded = true;
-	sequencer.reschedule = true;
+	sequencer->nds_vblankEnded = true;
+	sequencer->reschedule = true;
 
 	// turn off vblank status bit
-	T1WriteWord(MMU.ARM9_REG, 4, T1ReadWord(MMU.ARM9_REG, 4) & ~1);
-	T1WriteWord(MMU.ARM7_REG, 4, T1ReadWord(MMU.ARM7_REG, 4) & ~1);
+	T1WriteWord(mmu->MMU.ARM9_REG, 4, T1ReadWord(mmu->MMU.ARM9_REG, 4) & ~1);
+	T1WriteWord(mmu->MMU.ARM7_REG, 4, T1ReadWord(mmu->MMU.ARM7_REG, 4) & ~1);
 }
 
 static void execHardware_hstart_vblankStart()
@@ -445,9 +440,9 @@ static void execHardware_hstart_vblankStart()
 
 	// fire vblank interrupts if necessary
 	for (int i = 0; i < 2; ++i)
-		if (MMU.reg_IF_pending[i] & (1 << IRQ_BIT_LCD_VBLANK))
+		if (mmu->MMU.reg_IF_pending[i] & (1 << IRQ_BIT_LCD_VBLANK))
 		{
-			MMU.reg_IF_pending[i] &= ~(1 << IRQ_BIT_LCD_VBLANK);
+			mmu->MMU.reg_IF_pending[i] &= ~(1 << IRQ_BIT_LCD_VBLANK);
 			NDS_makeIrq(i, IRQ_BIT_LCD_VBLANK);
 		}
 
@@ -457,7 +452,7 @@ static void execHardware_hstart_vblankStart()
 
 static uint16_t execHardware_gen_vmatch_goal()
 {
-	uint16_t vmatch = T1ReadWord(MMU.ARM9_REG, 4);
+	uint16_t vmatch = T1ReadWord(mmu->MMU.ARM9_REG, 4);
 	vmatch = (vmatch >> 8) | ((vmatch << 1) & (1 << 8));
 	return vmatch;
 }
@@ -465,14 +460,14 @@ static uint16_t execHardware_gen_vmatch_goal()
 static void execHardware_hstart_vcount_irq()
 {
 	// trigger pending VMATCH irqs
-	if (MMU.reg_IF_pending[ARMCPU_ARM9] & (1 << IRQ_BIT_LCD_VMATCH))
+	if (mmu->MMU.reg_IF_pending[ARMCPU_ARM9] & (1 << IRQ_BIT_LCD_VMATCH))
 	{
-		MMU.reg_IF_pending[ARMCPU_ARM9] &= ~(1 << IRQ_BIT_LCD_VMATCH);
+		mmu->MMU.reg_IF_pending[ARMCPU_ARM9] &= ~(1 << IRQ_BIT_LCD_VMATCH);
 		NDS_makeIrq(ARMCPU_ARM9, IRQ_BIT_LCD_VMATCH);
 	}
-	if(MMU.reg_IF_pending[ARMCPU_ARM7] & (1 << IRQ_BIT_LCD_VMATCH))
+	if(mmu->MMU.reg_IF_pending[ARMCPU_ARM7] & (1 << IRQ_BIT_LCD_VMATCH))
 	{
-		MMU.reg_IF_pending[ARMCPU_ARM7] &= ~(1 << IRQ_BIT_LCD_VMATCH);
+		mmu->MMU.reg_IF_pending[ARMCPU_ARM7] &= ~(1 << IRQ_BIT_LCD_VMATCH);
 		NDS_makeIrq(ARMCPU_ARM7, IRQ_BIT_LCD_VMATCH);
 	}
 }
@@ -480,27 +475,27 @@ static void execHardware_hstart_vcount_irq()
 static void execHardware_hstart_vcount()
 {
 	uint16_t vmatch = execHardware_gen_vmatch_goal();
-	if (nds.VCount == vmatch)
+	if (ds->nds.VCount == vmatch)
 	{
 		// arm9 vmatch
-		T1WriteWord(MMU.ARM9_REG, 4, T1ReadWord(MMU.ARM9_REG, 4) | 4);
-		if (T1ReadWord(MMU.ARM9_REG, 4) & 32)
-			MMU.reg_IF_pending[ARMCPU_ARM9] |= 1 << IRQ_BIT_LCD_VMATCH;
+		T1WriteWord(mmu->MMU.ARM9_REG, 4, T1ReadWord(mmu->MMU.ARM9_REG, 4) | 4);
+		if (T1ReadWord(mmu->MMU.ARM9_REG, 4) & 32)
+			mmu->MMU.reg_IF_pending[ARMCPU_ARM9] |= 1 << IRQ_BIT_LCD_VMATCH;
 	}
 	else
-		T1WriteWord(MMU.ARM9_REG, 4, T1ReadWord(MMU.ARM9_REG, 4) & 0xFFFB);
+		T1WriteWord(mmu->MMU.ARM9_REG, 4, T1ReadWord(mmu->MMU.ARM9_REG, 4) & 0xFFFB);
 
-	vmatch = T1ReadWord(MMU.ARM7_REG, 4);
+	vmatch = T1ReadWord(mmu->MMU.ARM7_REG, 4);
 	vmatch = (vmatch >> 8) | ((vmatch << 1) & (1 << 8));
-	if (nds.VCount == vmatch)
+	if (ds->nds.VCount == vmatch)
 	{
 		// arm7 vmatch
-		T1WriteWord(MMU.ARM7_REG, 4, T1ReadWord(MMU.ARM7_REG, 4) | 4);
-		if (T1ReadWord(MMU.ARM7_REG, 4) & 32)
-			MMU.reg_IF_pending[ARMCPU_ARM7] |= 1 << IRQ_BIT_LCD_VMATCH;
+		T1WriteWord(mmu->MMU.ARM7_REG, 4, T1ReadWord(mmu->MMU.ARM7_REG, 4) | 4);
+		if (T1ReadWord(mmu->MMU.ARM7_REG, 4) & 32)
+			mmu->MMU.reg_IF_pending[ARMCPU_ARM7] |= 1 << IRQ_BIT_LCD_VMATCH;
 	}
 	else
-		T1WriteWord(MMU.ARM7_REG, 4, T1ReadWord(MMU.ARM7_REG, 4) & 0xFFFB);
+		T1WriteWord(mmu->MMU.ARM7_REG, 4, T1ReadWord(mmu->MMU.ARM7_REG, 4) & 0xFFFB);
 }
 
 static void execHardware_hstart_irq()
@@ -510,8 +505,8 @@ static void execHardware_hstart_irq()
 	// 100% accurate emulation would require the read of VCOUNT to be in the pipeline already with the irq coming in behind it, thus
 	// allowing the vcount to register as 192 occasionally (maybe about 1 out of 28 frames)
 	// the actual length of the delay is in execHardware() where the events are scheduled
-	sequencer.reschedule = true;
-	if (nds.VCount == 192)
+	sequencer->reschedule = true;
+	if (ds->nds.VCount == 192)
 		// when the vcount hits 192, vblank begins
 		execHardware_hstart_vblankStart();
 
@@ -520,36 +515,36 @@ static void execHardware_hstart_irq()
 
 static void execHardware_hstart()
 {
-	++nds.VCount;
+	++ds->nds.VCount;
 
-	if (nds.VCount == 263)
+	if (ds->nds.VCount == 263)
 		// when the vcount hits 263 it rolls over to 0
-		nds.VCount = 0;
-	if (nds.VCount == 262)
+		ds->nds.VCount = 0;
+	if (ds->nds.VCount == 262)
 		// when the vcount hits 262, vblank ends (oam pre-renders by one scanline)
 		execHardware_hstart_vblankEnd();
-	else if (nds.VCount == 192)
+	else if (ds->nds.VCount == 192)
 	{
 		// turn on vblank status bit
-		T1WriteWord(MMU.ARM9_REG, 4, T1ReadWord(MMU.ARM9_REG, 4) | 1);
-		T1WriteWord(MMU.ARM7_REG, 4, T1ReadWord(MMU.ARM7_REG, 4) | 1);
+		T1WriteWord(mmu->MMU.ARM9_REG, 4, T1ReadWord(mmu->MMU.ARM9_REG, 4) | 1);
+		T1WriteWord(mmu->MMU.ARM7_REG, 4, T1ReadWord(mmu->MMU.ARM7_REG, 4) | 1);
 
 		// check whether we'll need to fire vblank irqs
-		if (T1ReadWord(MMU.ARM9_REG, 4) & 0x8)
-			MMU.reg_IF_pending[ARMCPU_ARM9] |= 1 << IRQ_BIT_LCD_VBLANK;
-		if (T1ReadWord(MMU.ARM7_REG, 4) & 0x8)
-			MMU.reg_IF_pending[ARMCPU_ARM7] |= 1 << IRQ_BIT_LCD_VBLANK;
+		if (T1ReadWord(mmu->MMU.ARM9_REG, 4) & 0x8)
+			mmu->MMU.reg_IF_pending[ARMCPU_ARM9] |= 1 << IRQ_BIT_LCD_VBLANK;
+		if (T1ReadWord(mmu->MMU.ARM7_REG, 4) & 0x8)
+			mmu->MMU.reg_IF_pending[ARMCPU_ARM7] |= 1 << IRQ_BIT_LCD_VBLANK;
 	}
 
 	// write the new vcount
-	T1WriteWord(MMU.ARM9_REG, 6, nds.VCount & 0xFFFF);
-	T1WriteWord(MMU.ARM9_REG, 0x1006, nds.VCount & 0xFFFF);
-	T1WriteWord(MMU.ARM7_REG, 6, nds.VCount & 0xFFFF);
-	T1WriteWord(MMU.ARM7_REG, 0x1006, nds.VCount & 0xFFFF);
+	T1WriteWord(mmu->MMU.ARM9_REG, 6, ds->nds.VCount & 0xFFFF);
+	T1WriteWord(mmu->MMU.ARM9_REG, 0x1006, ds->nds.VCount & 0xFFFF);
+	T1WriteWord(mmu->MMU.ARM7_REG, 6, ds->nds.VCount & 0xFFFF);
+	T1WriteWord(mmu->MMU.ARM7_REG, 0x1006, ds->nds.VCount & 0xFFFF);
 
 	// turn off hblank status bit
-	T1WriteWord(MMU.ARM9_REG, 4, T1ReadWord(MMU.ARM9_REG, 4) & 0xFFFD);
-	T1WriteWord(MMU.ARM7_REG, 4, T1ReadWord(MMU.ARM7_REG, 4) & 0xFFFD);
+	T1WriteWord(mmu->MMU.ARM9_REG, 4, T1ReadWord(mmu->MMU.ARM9_REG, 4) & 0xFFFD);
+	T1WriteWord(mmu->MMU.ARM7_REG, 4, T1ReadWord(mmu->MMU.ARM7_REG, 4) & 0xFFFD);
 
 	// handle vcount status
 	execHardware_hstart_vcount();
@@ -557,7 +552,7 @@ static void execHardware_hstart()
 	// trigger hstart dmas
 	triggerDma(EDMAMode_HStart);
 
-	if (nds.VCount < 192)
+	if (ds->nds.VCount < 192)
 		// this is hacky.
 		// there is a corresponding hack in doDMA.
 		// it should be driven by a fifo (and generate just in time as the scanline is displayed)
@@ -568,7 +563,7 @@ static void execHardware_hstart()
 
 void NDS_Reschedule()
 {
-	sequencer.reschedule = true;
+	sequencer->reschedule = true;
 }
 
 static inline uint64_t _fast_min(uint64_t a, uint64_t b)
@@ -697,11 +692,11 @@ template<bool doarm9, bool doarm7>
 static std::pair<int32_t, int32_t> armInnerLoop(uint64_t nds_timer_base, int32_t s32next, int32_t arm9, int32_t arm7)
 {
 	int32_t timer = minarmtime<doarm9, doarm7>(arm9, arm7);
-	while (timer < s32next && !sequencer.reschedule && execute)
+	while (timer < s32next && !sequencer->reschedule && ds->execute)
 	{
 		if (doarm9 && (!doarm7 || arm9 <= timer))
 		{
-			if (!NDS_ARM9.waitIRQ && !nds.freezeBus)
+			if (!NDS_ARM9->waitIRQ && !ds->nds.freezeBus)
 			{
 				arm9 += armcpu_exec<ARMCPU_ARM9>();
 			}
@@ -710,7 +705,7 @@ static std::pair<int32_t, int32_t> armInnerLoop(uint64_t nds_timer_base, int32_t
 		}
 		if (doarm7 && (!doarm9 || arm7 <= timer))
 		{
-			if (!NDS_ARM7.waitIRQ && !nds.freezeBus)
+			if (!NDS_ARM7->waitIRQ && !ds->nds.freezeBus)
 			{
 				arm7 += armcpu_exec<ARMCPU_ARM7>() << 1;
 			}
@@ -719,14 +714,14 @@ static std::pair<int32_t, int32_t> armInnerLoop(uint64_t nds_timer_base, int32_t
 				arm7 = std::min(s32next, arm7 + kIrqWait);
 				if (arm7 == s32next)
 				{
-					nds_timer = nds_timer_base + minarmtime<doarm9, false>(arm9, arm7);
+					ds->nds_timer = nds_timer_base + minarmtime<doarm9, false>(arm9, arm7);
 					return armInnerLoop<doarm9, false>(nds_timer_base, s32next, arm9, arm7);
 				}
 			}
 		}
 
 		timer = minarmtime<doarm9, doarm7>(arm9, arm7);
-		nds_timer = nds_timer_base + timer;
+		ds->nds_timer = nds_timer_base + timer;
 	}
 
 	return std::make_pair(arm9, arm7);
@@ -734,69 +729,69 @@ static std::pair<int32_t, int32_t> armInnerLoop(uint64_t nds_timer_base, int32_t
 
 template<bool FORCE> void NDS_exec(int32_t)
 {
-	sequencer.nds_vblankEnded = false;
+	sequencer->nds_vblankEnded = false;
 
-	if (nds.sleeping)
+	if (ds->nds.sleeping)
 	{
 		// speculative code: if ANY irq happens, wake up the arm7.
 		// I think the arm7 program analyzes the system and may decide not to wake up
 		// if it is dissatisfied with the conditions
-		if (MMU.reg_IE[1] & MMU.gen_IF<1>())
-			nds.sleeping = false;
+		if (mmu->MMU.reg_IE[1] & mmu->MMU.gen_IF<1>())
+			ds->nds.sleeping = false;
 	}
 	else
 	{
 		for (;;)
 		{
-			sequencer.execHardware();
+			sequencer->execHardware();
 
 			// break out once per frame
-			if (sequencer.nds_vblankEnded)
+			if (sequencer->nds_vblankEnded)
 				break;
 			// it should be benign to execute execHardware in the next frame,
 			// since there won't be anything for it to do (everything should be scheduled in the future)
 
 			// bail in case the system halted
-			if (!execute)
+			if (!ds->execute)
 				break;
 
 			execHardware_interrupts();
 
 			// find next work unit:
-			uint64_t next = sequencer.findNext();
-			next = std::min(next, nds_timer + kMaxWork); // lets set an upper limit for now
+			uint64_t next = sequencer->findNext();
+			next = std::min(next, ds->nds_timer + kMaxWork); // lets set an upper limit for now
 
 			//fprintf(stderr, "%d\n", next - nds_timer);
 
-			sequencer.reschedule = false;
+			sequencer->reschedule = false;
 
 			// cast these down to 32bits so that things run faster on 32bit procs
-			uint64_t nds_timer_base = nds_timer;
-			int32_t arm9 = (nds_arm9_timer - nds_timer) & 0xFFFFFFFF;
-			int32_t arm7 = (nds_arm7_timer - nds_timer) & 0xFFFFFFFF;
-			int32_t s32next = (next - nds_timer) & 0xFFFFFFFF;
+			uint64_t nds_timer_base = ds->nds_timer;
+			int32_t arm9 = (ds->nds_arm9_timer - ds->nds_timer) & 0xFFFFFFFF;
+			int32_t arm7 = (ds->nds_arm7_timer - ds->nds_timer) & 0xFFFFFFFF;
+			int32_t s32next = (next - ds->nds_timer) & 0xFFFFFFFF;
 
 			auto arm9arm7 = armInnerLoop<true, true>(nds_timer_base, s32next, arm9, arm7);
 
 			arm9 = arm9arm7.first;
 			arm7 = arm9arm7.second;
-			nds_arm7_timer = nds_timer_base + arm7;
-			nds_arm9_timer = nds_timer_base + arm9;
+			ds->nds_arm7_timer = nds_timer_base + arm7;
+			ds->nds_arm9_timer = nds_timer_base + arm9;
 
 			// if we were waiting for an irq, don't wait too long:
 			// let's re-analyze it after this hardware event (this rolls back a big burst of irq waiting which may have been interrupted by a resynch)
-			if (NDS_ARM9.waitIRQ)
-				nds_arm9_timer = nds_timer;
-			if (NDS_ARM7.waitIRQ)
-				nds_arm7_timer = nds_timer;
+			if (NDS_ARM9->waitIRQ)
+				ds->nds_arm9_timer = ds->nds_timer;
+			if (NDS_ARM7->waitIRQ)
+				ds->nds_arm7_timer = ds->nds_timer;
 		}
 	}
 }
 
 template<int PROCNUM> static void execHardware_interrupts_core()
 {
-	uint32_t IF = MMU.gen_IF<PROCNUM>();
-	uint32_t IE = MMU.reg_IE[PROCNUM];
+	uint32_t IF = mmu->MMU.gen_IF<PROCNUM>();
+	uint32_t IE = mmu->MMU.reg_IE[PROCNUM];
 	uint32_t masked = IF & IE;
 	if (ARMPROC.halt_IE_and_IF && masked)
 	{
@@ -804,7 +799,7 @@ template<int PROCNUM> static void execHardware_interrupts_core()
 		ARMPROC.waitIRQ = false;
 	}
 
-	if (masked && MMU.reg_IME[PROCNUM] && !ARMPROC.CPSR.bits.I)
+	if (masked && mmu->MMU.reg_IME[PROCNUM] && !ARMPROC.CPSR.bits.I)
 	{
 		//fprintf(stderr, "Executing IRQ on procnum %d with IF = %08X and IE = %08X\n",PROCNUM,IF,IE);
 		armcpu_irqException(&ARMPROC);
@@ -819,81 +814,81 @@ void execHardware_interrupts()
 
 static void PrepareBiosARM7()
 {
-	NDS_ARM7.BIOS_loaded = false;
-	memset(MMU.ARM7_BIOS, 0, sizeof(MMU.ARM7_BIOS));
-	if (CommonSettings.UseExtBIOS)
+	NDS_ARM7->BIOS_loaded = false;
+	memset(mmu->MMU.ARM7_BIOS, 0, sizeof(mmu->MMU.ARM7_BIOS));
+	if (ds->CommonSettings.UseExtBIOS)
 	{
 		// read arm7 bios from inputfile and flag it if it succeeds
-		FILE *arm7inf = fopen(CommonSettings.ARM7BIOS, "rb");
-		if (fread(MMU.ARM7_BIOS, 1, 16384, arm7inf) == 16384)
-			NDS_ARM7.BIOS_loaded = true;
+		FILE *arm7inf = fopen(ds->CommonSettings.ARM7BIOS, "rb");
+		if (fread(mmu->MMU.ARM7_BIOS, 1, 16384, arm7inf) == 16384)
+			NDS_ARM7->BIOS_loaded = true;
 		fclose(arm7inf);
 	}
 
 	// choose to use SWI emulation or routines from bios
-	if (CommonSettings.SWIFromBIOS && NDS_ARM7.BIOS_loaded)
+	if (ds->CommonSettings.SWIFromBIOS && NDS_ARM7->BIOS_loaded)
 	{
-		NDS_ARM7.swi_tab = 0;
+		NDS_ARM7->swi_tab = 0;
 
 		// if we used routines from bios, apply patches
-		if (CommonSettings.PatchSWI3)
+		if (ds->CommonSettings.PatchSWI3)
 			_MMU_write16<ARMCPU_ARM7>(0x00002F08, 0x4770);
 	}
 	else
-		NDS_ARM7.swi_tab = ARM_swi_tab[ARMCPU_ARM7];
+		NDS_ARM7->swi_tab = ARM_swi_tab[ARMCPU_ARM7];
 
-	if (!NDS_ARM7.BIOS_loaded)
+	if (!NDS_ARM7->BIOS_loaded)
 	{
 		// fake bios content, critical to normal operations, since we dont have a real bios.
 
 #if 0
 		// someone please document what is in progress here
 		// TODO
-		T1WriteLong(MMU.ARM7_BIOS, 0x0000, 0xEAFFFFFE); // loop for Reset !!!
-		T1WriteLong(MMU.ARM7_BIOS, 0x0004, 0xEAFFFFFE); // loop for Undef instr expection
-		T1WriteLong(MMU.ARM7_BIOS, 0x0008, 0xEA00009C); // SWI
-		T1WriteLong(MMU.ARM7_BIOS, 0x000C, 0xEAFFFFFE); // loop for Prefetch Abort
-		T1WriteLong(MMU.ARM7_BIOS, 0x0010, 0xEAFFFFFE); // loop for Data Abort
-		T1WriteLong(MMU.ARM7_BIOS, 0x0014, 0x00000000); // Reserved
-		T1WriteLong(MMU.ARM7_BIOS, 0x001C, 0x00000000); // Fast IRQ
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0000, 0xEAFFFFFE); // loop for Reset !!!
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0004, 0xEAFFFFFE); // loop for Undef instr expection
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0008, 0xEA00009C); // SWI
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x000C, 0xEAFFFFFE); // loop for Prefetch Abort
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0010, 0xEAFFFFFE); // loop for Data Abort
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0014, 0x00000000); // Reserved
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x001C, 0x00000000); // Fast IRQ
 #endif
-		T1WriteLong(MMU.ARM7_BIOS, 0x0000, 0xE25EF002);
-		T1WriteLong(MMU.ARM7_BIOS, 0x0018, 0xEA000000);
-		T1WriteLong(MMU.ARM7_BIOS, 0x0020, 0xE92D500F);
-		T1WriteLong(MMU.ARM7_BIOS, 0x0024, 0xE3A00301);
-		T1WriteLong(MMU.ARM7_BIOS, 0x0028, 0xE28FE000);
-		T1WriteLong(MMU.ARM7_BIOS, 0x002C, 0xE510F004);
-		T1WriteLong(MMU.ARM7_BIOS, 0x0030, 0xE8BD500F);
-		T1WriteLong(MMU.ARM7_BIOS, 0x0034, 0xE25EF004);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0000, 0xE25EF002);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0018, 0xEA000000);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0020, 0xE92D500F);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0024, 0xE3A00301);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0028, 0xE28FE000);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x002C, 0xE510F004);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0030, 0xE8BD500F);
+		T1WriteLong(mmu->MMU.ARM7_BIOS, 0x0034, 0xE25EF004);
 	}
 }
 
 static void PrepareBiosARM9()
 {
-	memset(MMU.ARM9_BIOS, 0, sizeof(MMU.ARM9_BIOS));
-	NDS_ARM9.BIOS_loaded = false;
-	if (CommonSettings.UseExtBIOS)
+	memset(mmu->MMU.ARM9_BIOS, 0, sizeof(mmu->MMU.ARM9_BIOS));
+	NDS_ARM9->BIOS_loaded = false;
+	if (ds->CommonSettings.UseExtBIOS)
 	{
 		// read arm9 bios from inputfile and flag it if it succeeds
-		FILE *arm9inf = fopen(CommonSettings.ARM9BIOS, "rb");
-		if (fread(MMU.ARM9_BIOS, 1, 4096, arm9inf) == 4096)
-			NDS_ARM9.BIOS_loaded = true;
+		FILE *arm9inf = fopen(ds->CommonSettings.ARM9BIOS, "rb");
+		if (fread(mmu->MMU.ARM9_BIOS, 1, 4096, arm9inf) == 4096)
+			NDS_ARM9->BIOS_loaded = true;
 		fclose(arm9inf);
 	}
 
 	// choose to use SWI emulation or routines from bios
-	if (CommonSettings.SWIFromBIOS && NDS_ARM9.BIOS_loaded)
+	if (ds->CommonSettings.SWIFromBIOS && NDS_ARM9->BIOS_loaded)
 	{
-		NDS_ARM9.swi_tab = 0;
+		NDS_ARM9->swi_tab = 0;
 
 		// if we used routines from bios, apply patches
-		if (CommonSettings.PatchSWI3)
+		if (ds->CommonSettings.PatchSWI3)
 			_MMU_write16<ARMCPU_ARM9>(0xFFFF07CC, 0x4770);
 	}
 	else
-		NDS_ARM9.swi_tab = ARM_swi_tab[ARMCPU_ARM9];
+		NDS_ARM9->swi_tab = ARM_swi_tab[ARMCPU_ARM9];
 
-	if (!NDS_ARM9.BIOS_loaded)
+	if (!NDS_ARM9->BIOS_loaded)
 	{
 		// fake bios content, critical to normal operations, since we dont have a real bios.
 		// it'd be cool if we could write this in some kind of assembly language, inline or otherwise, without some bulky dependencies
@@ -902,15 +897,15 @@ static void PrepareBiosARM9()
 		// reminder: bios chains data abort to fast irq
 
 		// exception vectors:
-		T1WriteLong(MMU.ARM9_BIOS, 0x0000, 0xEAFFFFFE); // (infinite loop for) Reset !!!
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0000, 0xEAFFFFFE); // (infinite loop for) Reset !!!
 		//T1WriteLong(MMU.ARM9_BIOS, 0x0004, 0xEAFFFFFE); // (infinite loop for) Undefined instruction
-		T1WriteLong(MMU.ARM9_BIOS, 0x0004, 0xEA000004); // Undefined instruction -> Fast IRQ (just guessing)
-		T1WriteLong(MMU.ARM9_BIOS, 0x0008, 0xEA00009C); // SWI -> ?????
-		T1WriteLong(MMU.ARM9_BIOS, 0x000C, 0xEAFFFFFE); // (infinite loop for) Prefetch Abort
-		T1WriteLong(MMU.ARM9_BIOS, 0x0010, 0xEA000001); // Data Abort -> Fast IRQ
-		T1WriteLong(MMU.ARM9_BIOS, 0x0014, 0x00000000); // Reserved
-		T1WriteLong(MMU.ARM9_BIOS, 0x0018, 0xEA000095); // Normal IRQ -> 0x0274
-		T1WriteLong(MMU.ARM9_BIOS, 0x001C, 0xEA00009D); // Fast IRQ -> 0x0298
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0004, 0xEA000004); // Undefined instruction -> Fast IRQ (just guessing)
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0008, 0xEA00009C); // SWI -> ?????
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x000C, 0xEAFFFFFE); // (infinite loop for) Prefetch Abort
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0010, 0xEA000001); // Data Abort -> Fast IRQ
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0014, 0x00000000); // Reserved
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0018, 0xEA000095); // Normal IRQ -> 0x0274
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x001C, 0xEA00009D); // Fast IRQ -> 0x0298
 
 		static const uint8_t logo_data[] =
 		{
@@ -928,50 +923,50 @@ static void PrepareBiosARM9()
 
 		// logo (do some games fail to boot without this? example?)
 		for (int t = 0; t < 0x9C; ++t)
-			MMU.ARM9_BIOS[t + 0x20] = logo_data[t];
+			mmu->MMU.ARM9_BIOS[t + 0x20] = logo_data[t];
 
 		//...0xBC:
 
 		// (now what goes in this gap??)
 
 		// IRQ handler: get dtcm address and jump to a vector in it
-		T1WriteLong(MMU.ARM9_BIOS, 0x0274, 0xE92D500F); //STMDB SP!, {R0-R3,R12,LR}
-		T1WriteLong(MMU.ARM9_BIOS, 0x0278, 0xEE190F11); //MRC CP15, 0, R0, CR9, CR1, 0
-		T1WriteLong(MMU.ARM9_BIOS, 0x027C, 0xE1A00620); //MOV R0, R0, LSR #C
-		T1WriteLong(MMU.ARM9_BIOS, 0x0280, 0xE1A00600); //MOV R0, R0, LSL #C
-		T1WriteLong(MMU.ARM9_BIOS, 0x0284, 0xE2800C40); //ADD R0, R0, #4000
-		T1WriteLong(MMU.ARM9_BIOS, 0x0288, 0xE28FE000); //ADD LR, PC, #0
-		T1WriteLong(MMU.ARM9_BIOS, 0x028C, 0xE510F004); //LDR PC, [R0, -#4]
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0274, 0xE92D500F); //STMDB SP!, {R0-R3,R12,LR}
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0278, 0xEE190F11); //MRC CP15, 0, R0, CR9, CR1, 0
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x027C, 0xE1A00620); //MOV R0, R0, LSR #C
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0280, 0xE1A00600); //MOV R0, R0, LSL #C
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0284, 0xE2800C40); //ADD R0, R0, #4000
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0288, 0xE28FE000); //ADD LR, PC, #0
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x028C, 0xE510F004); //LDR PC, [R0, -#4]
 
 		// ????
-		T1WriteLong(MMU.ARM9_BIOS, 0x0290, 0xE8BD500F); // LDMIA SP!, {R0-R3,R12,LR}
-		T1WriteLong(MMU.ARM9_BIOS, 0x0294, 0xE25EF004); // SUBS PC, LR, #4
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0290, 0xE8BD500F); // LDMIA SP!, {R0-R3,R12,LR}
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0294, 0xE25EF004); // SUBS PC, LR, #4
 
 		// -------
 		// FIQ and abort exception handler
 		// TODO - this code is copied from the bios. refactor it
 		// friendly reminder: to calculate an immediate offset: encoded = (desired_address-cur_address-8)
 
-		T1WriteLong(MMU.ARM9_BIOS, 0x0298, 0xE10FD000); // MRS SP, CPSR
-		T1WriteLong(MMU.ARM9_BIOS, 0x029C, 0xE38DD0C0); // ORR SP, SP, #C0
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x0298, 0xE10FD000); // MRS SP, CPSR
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x029C, 0xE38DD0C0); // ORR SP, SP, #C0
 
-		T1WriteLong(MMU.ARM9_BIOS, 0x02A0, 0xE12FF00D); // MSR CPSR_fsxc, SP
-		T1WriteLong(MMU.ARM9_BIOS, 0x02A4, 0xE59FD028); // LDR SP, [FFFF02D4]
-		T1WriteLong(MMU.ARM9_BIOS, 0x02A8, 0xE28DD001); // ADD SP, SP, #1
-		T1WriteLong(MMU.ARM9_BIOS, 0x02AC, 0xE92D5000); // STMDB SP!, {R12,LR}
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02A0, 0xE12FF00D); // MSR CPSR_fsxc, SP
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02A4, 0xE59FD028); // LDR SP, [FFFF02D4]
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02A8, 0xE28DD001); // ADD SP, SP, #1
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02AC, 0xE92D5000); // STMDB SP!, {R12,LR}
 
-		T1WriteLong(MMU.ARM9_BIOS, 0x02B0, 0xE14FE000); // MRS LR, SPSR
-		T1WriteLong(MMU.ARM9_BIOS, 0x02B4, 0xEE11CF10); // MRC CP15, 0, R12, CR1, CR0, 0
-		T1WriteLong(MMU.ARM9_BIOS, 0x02B8, 0xE92D5000); // STMDB SP!, {R12,LR}
-		T1WriteLong(MMU.ARM9_BIOS, 0x02BC, 0xE3CCC001); // BIC R12, R12, #1
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02B0, 0xE14FE000); // MRS LR, SPSR
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02B4, 0xEE11CF10); // MRC CP15, 0, R12, CR1, CR0, 0
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02B8, 0xE92D5000); // STMDB SP!, {R12,LR}
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02BC, 0xE3CCC001); // BIC R12, R12, #1
 
-		T1WriteLong(MMU.ARM9_BIOS, 0x02C0, 0xEE01CF10); // MCR CP15, 0, R12, CR1, CR0, 0
-		T1WriteLong(MMU.ARM9_BIOS, 0x02C4, 0xE3CDC001); // BIC R12, SP, #1
-		T1WriteLong(MMU.ARM9_BIOS, 0x02C8, 0xE59CC010); // LDR R12, [R12, #10]
-		T1WriteLong(MMU.ARM9_BIOS, 0x02CC, 0xE35C0000); // CMP R12, #0
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02C0, 0xEE01CF10); // MCR CP15, 0, R12, CR1, CR0, 0
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02C4, 0xE3CDC001); // BIC R12, SP, #1
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02C8, 0xE59CC010); // LDR R12, [R12, #10]
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02CC, 0xE35C0000); // CMP R12, #0
 
-		T1WriteLong(MMU.ARM9_BIOS, 0x02D0, 0x112FFF3C); // BLXNE R12
-		T1WriteLong(MMU.ARM9_BIOS, 0x02D4, 0x027FFD9C); // 0x027FFD9C
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02D0, 0x112FFF3C); // BLXNE R12
+		T1WriteLong(mmu->MMU.ARM9_BIOS, 0x02D4, 0x027FFD9C); // 0x027FFD9C
 		// ---------
 	}
 }
@@ -984,13 +979,13 @@ void NDS_Reset()
 	if (!header)
 		return;
 
-	nds.sleeping = false;
-	nds.cardEjected = false;
-	nds.freezeBus = 0;
+	ds->nds.sleeping = false;
+	ds->nds.cardEjected = false;
+	ds->nds.freezeBus = 0;
 
-	nds_timer = 0;
-	nds_arm9_timer = 0;
-	nds_arm7_timer = 0;
+	ds->nds_timer = 0;
+	ds->nds_arm9_timer = 0;
+	ds->nds_arm7_timer = 0;
 
 	SPU_DeInit();
 
@@ -1006,10 +1001,10 @@ void NDS_Reset()
 	// at any, it's important that this be done long before the user code ever runs
 	_MMU_write08<ARMCPU_ARM9>(REG_WRAMCNT, 3);
 
-	firmware.reset(new CFIRMWARE());
-	fw_success = firmware->load();
+	ds->firmware.reset(new CFIRMWARE());
+	fw_success = ds->firmware->load();
 
-	if (NDS_ARM7.BIOS_loaded && NDS_ARM9.BIOS_loaded && CommonSettings.BootFromFirmware && fw_success)
+	if (NDS_ARM7->BIOS_loaded && NDS_ARM9->BIOS_loaded && ds->CommonSettings.BootFromFirmware && fw_success)
 	{
 		// Copy secure area to memory if needed.
 		// could we get a comment about what's going on here?
@@ -1025,28 +1020,28 @@ void NDS_Reset()
 
 			for (uint32_t i = 0; i < size; ++i)
 			{
-				_MMU_write32<ARMCPU_ARM9>(dst, T1ReadLong(MMU.CART_ROM, src));
+				_MMU_write32<ARMCPU_ARM9>(dst, T1ReadLong(mmu->MMU.CART_ROM, src));
 				src += 4;
 				dst += 4;
 			}
 		}
 
 		// TODO someone describe why here
-		if (firmware->patched)
+		if (ds->firmware->patched)
 		{
-			armcpu_init(&NDS_ARM7, 0x00000008);
-			armcpu_init(&NDS_ARM9, 0xFFFF0008);
+			armcpu_init(NDS_ARM7, 0x00000008);
+			armcpu_init(NDS_ARM9, 0xFFFF0008);
 		}
 		else
 		{
 			// set the cpus to an initial state with their respective firmware program entrypoints
-			armcpu_init(&NDS_ARM7, firmware->ARM7bootAddr);
-			armcpu_init(&NDS_ARM9, firmware->ARM9bootAddr);
+			armcpu_init(NDS_ARM7, ds->firmware->ARM7bootAddr);
+			armcpu_init(NDS_ARM9, ds->firmware->ARM9bootAddr);
 		}
 
 		// set REG_POSTFLG to the value indicating pre-firmware status
-		MMU.ARM9_REG[0x300] = 0;
-		MMU.ARM7_REG[0x300] = 0;
+		mmu->MMU.ARM9_REG[0x300] = 0;
+		mmu->MMU.ARM7_REG[0x300] = 0;
 	}
 	else
 	{
@@ -1057,7 +1052,7 @@ void NDS_Reset()
 		uint32_t dst = header->ARM9cpy;
 		for (uint32_t i = 0; i < (header->ARM9binSize >> 2); ++i)
 		{
-			_MMU_write32<ARMCPU_ARM9>(dst, T1ReadLong(MMU.CART_ROM, src));
+			_MMU_write32<ARMCPU_ARM9>(dst, T1ReadLong(mmu->MMU.CART_ROM, src));
 			dst += 4;
 			src += 4;
 		}
@@ -1068,45 +1063,45 @@ void NDS_Reset()
 
 		for (uint32_t i = 0; i < (header->ARM7binSize >> 2); ++i)
 		{
-			_MMU_write32<ARMCPU_ARM7>(dst, T1ReadLong(MMU.CART_ROM, src));
+			_MMU_write32<ARMCPU_ARM7>(dst, T1ReadLong(mmu->MMU.CART_ROM, src));
 			dst += 4;
 			src += 4;
 		}
 
 		// set the cpus to an initial state with their respective programs entrypoints
-		armcpu_init(&NDS_ARM7, header->ARM7exe);
-		armcpu_init(&NDS_ARM9, header->ARM9exe);
+		armcpu_init(NDS_ARM7, header->ARM7exe);
+		armcpu_init(NDS_ARM9, header->ARM9exe);
 
 		// set REG_POSTFLG to the value indicating post-firmware status
-		MMU.ARM9_REG[0x300] = 1;
-		MMU.ARM7_REG[0x300] = 1;
+		mmu->MMU.ARM9_REG[0x300] = 1;
+		mmu->MMU.ARM7_REG[0x300] = 1;
 	}
 
 	// only ARM9 have co-processor
-	reconstruct(&cp15);
-	cp15.reset(&NDS_ARM9);
+	reconstruct(cp15);
+	cp15->reset(NDS_ARM9);
 
 	// bitbox 4k demo is so stripped down it relies on default stack values
 	// otherwise the arm7 will crash before making a sound
 	// (these according to gbatek softreset bios docs)
-	NDS_ARM7.R13_svc = 0x0380FFDC;
-	NDS_ARM7.R13_irq = 0x0380FFB0;
-	NDS_ARM7.R13_usr = 0x0380FF00;
-	NDS_ARM7.R[13] = NDS_ARM7.R13_usr;
+	NDS_ARM7->R13_svc = 0x0380FFDC;
+	NDS_ARM7->R13_irq = 0x0380FFB0;
+	NDS_ARM7->R13_usr = 0x0380FF00;
+	NDS_ARM7->R[13] = NDS_ARM7->R13_usr;
 	// and let's set these for the arm9 while we're at it, though we have no proof
-	NDS_ARM9.R13_svc = 0x00803FC0;
-	NDS_ARM9.R13_irq = 0x00803FA0;
-	NDS_ARM9.R13_usr = 0x00803EC0;
-	NDS_ARM9.R13_abt = NDS_ARM9.R13_usr; // ?????
+	NDS_ARM9->R13_svc = 0x00803FC0;
+	NDS_ARM9->R13_irq = 0x00803FA0;
+	NDS_ARM9->R13_usr = 0x00803EC0;
+	NDS_ARM9->R13_abt = NDS_ARM9->R13_usr; // ?????
 	// I think it is wrong to take gbatek's "SYS" and put it in USR--maybe USR doesnt matter.
 	// i think SYS is all the misc modes. please verify by setting nonsensical stack values for USR here
-	NDS_ARM9.R[13] = NDS_ARM9.R13_usr;
+	NDS_ARM9->R[13] = NDS_ARM9->R13_usr;
 	// n.b.: im not sure about all these, I dont know enough about arm9 svc/irq/etc modes
 	// and how theyre named in desmume to match them up correctly. i just guessed.
 
-	memset(nds.timerCycle, 0, sizeof(uint64_t) * 8);
-	nds.old = 0;
-	SetupMMU(false, nds.Is_DSI());
+	memset(ds->nds.timerCycle, 0, sizeof(uint64_t) * 8);
+	ds->nds.old = 0;
+	SetupMMU(false, ds->nds.Is_DSI());
 
 	_MMU_write16<ARMCPU_ARM9>(REG_KEYINPUT, 0x3FF);
 	_MMU_write16<ARMCPU_ARM7>(REG_KEYINPUT, 0x3FF);
@@ -1117,33 +1112,33 @@ void NDS_Reset()
 	{
 		uint8_t temp_buffer[NDS_FW_USER_SETTINGS_MEM_BYTE_COUNT];
 
-		if (copy_firmware_user_data(temp_buffer, &MMU.fw.data[0]))
+		if (copy_firmware_user_data(temp_buffer, &mmu->MMU.fw.data[0]))
 			for (int fw_index = 0; fw_index < NDS_FW_USER_SETTINGS_MEM_BYTE_COUNT; ++fw_index)
 				_MMU_write08<ARMCPU_ARM9>(0x027FFC80 + fw_index, temp_buffer[fw_index]);
 	}
 
 	// Copy the whole header to Main RAM 0x27FFE00 on startup. (http://nocash.emubase.de/gbatek.htm#dscartridgeheader)
 	// once upon a time this copied 0x90 more. this was thought to be wrong, and changed.
-	if (nds.Is_DSI())
+	if (ds->nds.Is_DSI())
 	{
 		// dsi needs this copied later in memory. there are probably a number of things that  get copied to a later location in memory.. thats where the NDS consoles tend to stash stuff.
 		for (int i = 0; i < 92; ++i)
-			_MMU_write32<ARMCPU_ARM9>(0x02FFFE00 + i * 4, LE_TO_LOCAL_32(reinterpret_cast<uint32_t *>(MMU.CART_ROM)[i]));
+			_MMU_write32<ARMCPU_ARM9>(0x02FFFE00 + i * 4, LE_TO_LOCAL_32(reinterpret_cast<uint32_t *>(mmu->MMU.CART_ROM)[i]));
 	}
 	else
 	{
 		for (int i = 0; i < 92; ++i)
-			_MMU_write32<ARMCPU_ARM9>(0x027FFE00 + i * 4, LE_TO_LOCAL_32(reinterpret_cast<uint32_t *>(MMU.CART_ROM)[i]));
+			_MMU_write32<ARMCPU_ARM9>(0x027FFE00 + i * 4, LE_TO_LOCAL_32(reinterpret_cast<uint32_t *>(mmu->MMU.CART_ROM)[i]));
 	}
 
 	// Write the header checksum to memory (the firmware needs it to see the cart)
-	_MMU_write16<ARMCPU_ARM9>(0x027FF808, T1ReadWord(MMU.CART_ROM, 0x15E));
+	_MMU_write16<ARMCPU_ARM9>(0x027FF808, T1ReadWord(mmu->MMU.CART_ROM, 0x15E));
 
-	if (firmware->patched && CommonSettings.UseExtBIOS && CommonSettings.BootFromFirmware && fw_success)
+	if (ds->firmware->patched && ds->CommonSettings.UseExtBIOS && ds->CommonSettings.BootFromFirmware && fw_success)
 	{
 		// HACK! for flashme
-		_MMU_write32<ARMCPU_ARM9>(0x27FFE24, firmware->ARM9bootAddr);
-		_MMU_write32<ARMCPU_ARM7>(0x27FFE34, firmware->ARM7bootAddr);
+		_MMU_write32<ARMCPU_ARM9>(0x27FFE24, ds->firmware->ARM9bootAddr);
+		_MMU_write32<ARMCPU_ARM7>(0x27FFE34, ds->firmware->ARM7bootAddr);
 	}
 
 	// make system think it's booted from card -- EXTREMELY IMPORTANT!!! Thanks to cReDiAr
@@ -1155,6 +1150,57 @@ void NDS_Reset()
 	SPU_ReInit();
 }
 
+NDSContext::NDSContext() : nds_ctx(new nds_context())
+{
+	// the backup device of the new memory reads the settings of its own system
+	nds_context *prev = ds;
+	ds = this->nds_ctx;
+	this->mmu_ctx = new mmu_context();
+	ds = prev;
+
+	this->timing_ctx = new MMU_struct_timing();
+	this->arm7_ctx = new armcpu_t();
+	this->arm9_ctx = new armcpu_t();
+	this->cp15_ctx = new armcp15_t();
+	this->sequencer_ctx = new Sequencer();
+	this->spu_ctx = new spu_context();
+}
+
+NDSContext::~NDSContext()
+{
+	delete this->spu_ctx;
+	delete this->sequencer_ctx;
+	delete this->nds_ctx;
+	delete this->cp15_ctx;
+	delete this->arm9_ctx;
+	delete this->arm7_ctx;
+	delete this->timing_ctx;
+	delete this->mmu_ctx;
+}
+
+void NDSContext::make_current()
+{
+	mmu = this->mmu_ctx;
+	MMU_timing = this->timing_ctx;
+	NDS_ARM7 = this->arm7_ctx;
+	NDS_ARM9 = this->arm9_ctx;
+	cp15 = this->cp15_ctx;
+	ds = this->nds_ctx;
+	sequencer = this->sequencer_ctx;
+	spu = this->spu_ctx;
+}
+
+void NDSContext::release()
+{
+	mmu = nullptr;
+	MMU_timing = nullptr;
+	NDS_ARM7 = NDS_ARM9 = nullptr;
+	cp15 = nullptr;
+	ds = nullptr;
+	sequencer = nullptr;
+	spu = nullptr;
+}
+
 // these templates needed to be instantiated manually
 template void NDS_exec<false>(int32_t nb);
 template void NDS_exec<true>(int32_t nb);
@@ -56,8 +56,6 @@ template<typename Type> struct buttonstruct
 	};
 };
 
-extern volatile bool execute;
-
 struct NDS_header
 {
 	char gameTile[12];
@@ -110,7 +108,6 @@ struct NDS_header
 	uint8_t reserved[160];
 };
 
-extern uint64_t nds_timer;
 void NDS_Reschedule();
 void NDS_RescheduleDMA();
 void NDS_RescheduleTimers();
@@ -169,8 +166,6 @@ struct NDS_fw_config_data
 	uint8_t language;
 };
 
-extern NDSSystem nds;
-
 int NDS_Init ();
 
 void NDS_DeInit();
@@ -249,8 +244,6 @@ struct GameInfo
 	bool isHomebrew;
 };
 
-extern GameInfo gameInfo;
-
 struct UserButtons : buttonstruct<bool>
 {
 };
@@ -280,7 +273,7 @@ void execHardware_doAllDma(EDMAMode modeNum);
 
 template<bool FORCE> void NDS_exec(int32_t nb = 560190 << 1);
 
-extern struct TCommonSettings
+struct TCommonSettings
 {
 	TCommonSettings() : UseExtBIOS(false), SWIFromBIOS(false), PatchSWI3(false), UseExtFirmware(false), BootFromFirmware(false), ConsoleType(NDS_CONSOLE_TYPE_FAT), rigorous_timing(false), advanced_timing(true),
 		spuInterpolationMode(SPUInterpolation_Linear), manualBackupType(0), spu_captureMuted(false), spu_advanced(false)
@@ -291,8 +284,8 @@ extern struct TCommonSettings
 		NDS_FillDefaultFirmwareConfigData(&this->InternalFirmConf);
 
     bool solo = false;
-    static char* soloEnv = strdup("SOLO_2SF_n");
-    static char* muteEnv = strdup("MUTE_2SF_n");
+    char soloEnv[] = "SOLO_2SF_n";
+    char muteEnv[] = "MUTE_2SF_n";
 		for (int i = 0; i < 16; ++i) {
       if (i < 10) {
         soloEnv[9] = '0' + i;
@@ -345,4 +338,48 @@ extern struct TCommonSettings
 	bool spu_muteChannels[16];
 	bool spu_captureMuted;
 	bool spu_advanced;
-} CommonSettings;
+};
+
+// the state of the system as a whole
+struct nds_context
+{
+	TCommonSettings CommonSettings;
+
+	GameInfo gameInfo;
+	NDSSystem nds;
+	std::unique_ptr<CFIRMWARE> firmware;
+	volatile bool execute = false;
+
+	uint64_t nds_timer;
+	uint64_t nds_arm9_timer, nds_arm7_timer;
+};
+
+extern THREADLOCAL nds_context *ds;
+
+struct MMU_struct_timing;
+struct armcp15_t;
+struct Sequencer;
+
+// All of the state of one emulated system.  Any number of them can exist at
+// once; make_current() selects the one that the emulator works on in the
+// calling thread.
+struct NDSContext
+{
+	NDSContext();
+	~NDSContext();
+
+	NDSContext(const NDSContext &) = delete;
+	NDSContext &operator=(const NDSContext &) = delete;
+
+	void make_current();
+	static void release();
+
+private:
+	nds_context *nds_ctx;
+	mmu_context *mmu_ctx;
+	MMU_struct_timing *timing_ctx;
+	armcpu_t *arm7_ctx, *arm9_ctx;
+	armcp15_t *cp15_ctx;
+	Sequencer *sequencer_ctx;
+	spu_context *spu_ctx;
+};
@@ -50,18 +50,15 @@ static inline u8 read08(u32 addr) { return _MMU_read08<ARMCPU_ARM7,MMU_AT_DEBUG>
 #define K_ADPCM_LOOPING_RECOVERY_INDEX 99999
 #define COSINE_INTERPOLATION_RESOLUTION 8192
 
-SPU_struct *SPU_core = 0;
-int SPU_currentCoreNum = SNDCORE_DUMMY;
-static int volume = 100;
-SampleCache spuSampleCache;
-
-static size_t buffersize = 0;
-static ESynchMode synchmode = ESynchMode_Synchronous;
-static ESynchMethod synchmethod = ESynchMethod_0;
-static ISynchronizingAudioBuffer* synchronizer = metaspu_construct(synchmethod);
-
-static int SNDCoreId=-1;
-static SoundInterface_struct *SNDCore=NULL;
+THREADLOCAL spu_context *spu;
+
+spu_context::~spu_context()
+{
+  delete this->SPU_core;
+  delete this->synchronizer;
+  free(this->postProcessBuffer);
+}
+
 extern SoundInterface_struct *SNDCoreList[];
 
 static const int format_shift[] = { 2, 1, 3, 0 };
@@ -80,18 +77,12 @@ static const s16 wavedutytbl[8][8] = {
 
 static const double ARM7_CLOCK = 33513982;
 
-double DESMUME_SAMPLE_RATE = 48000;
-static double samples_per_hline = (DESMUME_SAMPLE_RATE / 59.8261f) / 263.0f;
-static double sampleLength = DESMUME_SAMPLE_RATE / 32728.498;
-
 void SetDesmumeSampleRate(double rate) {
-  DESMUME_SAMPLE_RATE = rate;
-  sampleLength = DESMUME_SAMPLE_RATE / 32728.498;
-  samples_per_hline = (DESMUME_SAMPLE_RATE / 59.8261f) / 263.0f;
+  spu->DESMUME_SAMPLE_RATE = rate;
+  spu->sampleLength = spu->DESMUME_SAMPLE_RATE / 32728.498;
+  spu->samples_per_hline = (spu->DESMUME_SAMPLE_RATE / 59.8261f) / 263.0f;
 }
 
-static double samples = 0;
-
 template<typename T>
 static FORCEINLINE T MinMax(T val, T min, T max)
 {
@@ -109,17 +100,17 @@ int SPU_ChangeSoundCore(int coreid, int buffersize)
 {
   int i;
 
-  ::buffersize = buffersize;
+  spu->buffersize = buffersize;
 
   // Make sure the old core is freed
-  if (SNDCore)
-    SNDCore->DeInit();
+  if (spu->SNDCore)
+    spu->SNDCore->DeInit();
 
   // So which core do we want?
   if (coreid == SNDCORE_DEFAULT)
     coreid = 0; // Assume we want the first one
 
-  SPU_currentCoreNum = coreid;
+  spu->SPU_currentCoreNum = coreid;
 
   // Go through core list and find the id
   for (i = 0; SNDCoreList[i] != NULL; i++)
@@ -127,43 +118,43 @@ int SPU_ChangeSoundCore(int coreid, int buffersize)
     if (SNDCoreList[i]->id == coreid)
     {
       // Set to current core
-      SNDCore = SNDCoreList[i];
+      spu->SNDCore = SNDCoreList[i];
       break;
     }
   }
 
-  SNDCoreId = coreid;
+  spu->SNDCoreId = coreid;
 
   //If the user picked the dummy core, disable the user spu
-  if(SNDCore == &SNDDummy)
+  if(spu->SNDCore == &SNDDummy)
     return 0;
 
   //If the core wasnt found in the list for some reason, disable the user spu
-  if (SNDCore == NULL)
+  if (spu->SNDCore == NULL)
     return -1;
 
   // Since it failed, instead of it being fatal, disable the user spu
-  if (SNDCore->Init(buffersize * 2) == -1)
+  if (spu->SNDCore->Init(buffersize * 2) == -1)
   {
-    SNDCore = 0;
+    spu->SNDCore = 0;
     return -1;
   }
 
-  SNDCore->SetVolume(volume);
+  spu->SNDCore->SetVolume(spu->volume);
 
-  SPU_SetSynchMode(synchmode,synchmethod);
+  SPU_SetSynchMode(spu->synchmode,spu->synchmethod);
 
   return 0;
 }
 
 SoundInterface_struct *SPU_SoundCore()
 {
-  return SNDCore;
+  return spu->SNDCore;
 }
 
 void SPU_ReInit(bool fakeBoot)
 {
-  SPU_Init(SNDCoreId, buffersize);
+  SPU_Init(spu->SNDCoreId, spu->buffersize);
 
   // Firmware set BIAS to 0x200
   if (fakeBoot)
@@ -172,48 +163,48 @@ void SPU_ReInit(bool fakeBoot)
 
 int SPU_Init(int coreid, int buffersize)
 {
-  SPU_core = new SPU_struct((int)ceil(samples_per_hline));
+  spu->SPU_core = new SPU_struct((int)ceil(spu->samples_per_hline));
   SPU_Reset();
 
-  SPU_SetSynchMode(synchmode, synchmethod);
+  SPU_SetSynchMode(spu->synchmode, spu->synchmethod);
 
   return SPU_ChangeSoundCore(coreid, buffersize);
 }
 
 void SPU_Pause(int pause)
 {
-  if (SNDCore == NULL) return;
+  if (spu->SNDCore == NULL) return;
 
   if(pause)
-    SNDCore->MuteAudio();
+    spu->SNDCore->MuteAudio();
   else
-    SNDCore->UnMuteAudio();
+    spu->SNDCore->UnMuteAudio();
 }
 
 void SPU_SetSynchMode(int mode, int method)
 {
-  synchmode = (ESynchMode)mode;
-  if(synchmethod != (ESynchMethod)method)
+  spu->synchmode = (ESynchMode)mode;
+  if(spu->synchmethod != (ESynchMethod)method)
   {
-    synchmethod = (ESynchMethod)method;
-    delete synchronizer;
+    spu->synchmethod = (ESynchMethod)method;
+    delete spu->synchronizer;
     //grr does this need to be locked? spu might need a lock method
     // or maybe not, maybe the platform-specific code that calls this function can deal with it.
-    synchronizer = metaspu_construct(synchmethod);
+    spu->synchronizer = metaspu_construct(spu->synchmethod);
   }
 }
 
 void SPU_ClearOutputBuffer()
 {
-  if(SNDCore && SNDCore->ClearBuffer)
-    SNDCore->ClearBuffer();
+  if(spu->SNDCore && spu->SNDCore->ClearBuffer)
+    spu->SNDCore->ClearBuffer();
 }
 
 void SPU_SetVolume(int volume)
 {
-  ::volume = volume;
-  if (SNDCore)
-    SNDCore->SetVolume(volume);
+  spu->volume = volume;
+  if (spu->SNDCore)
+    spu->SNDCore->SetVolume(volume);
 }
 
 
@@ -221,15 +212,15 @@ void SPU_Reset(void)
 {
   int i;
 
-  SPU_core->reset();
+  spu->SPU_core->reset();
 
   //zero - 09-apr-2010: this concerns me, regarding savestate synch.
   //After 0.9.6, lets experiment with removing it and just properly zapping the spu instead
   // Reset Registers
   for (i = 0x400; i < 0x51D; i++)
-    T1WriteByte(MMU.ARM7_REG, i, 0);
+    T1WriteByte(mmu->MMU.ARM7_REG, i, 0);
 
-  samples = 0;
+  spu->samples = 0;
 }
 
 //------------------------------------------
@@ -269,11 +260,11 @@ SPU_struct::~SPU_struct()
 
 void SPU_DeInit(void)
 {
-  if(SNDCore)
-    SNDCore->DeInit();
-  SNDCore = 0;
+  if(spu->SNDCore)
+    spu->SNDCore->DeInit();
+  spu->SNDCore = 0;
 
-  delete SPU_core; SPU_core=0;
+  delete spu->SPU_core; spu->SPU_core=0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -286,7 +277,7 @@ void SPU_struct::ShutUp()
 
 static FORCEINLINE void adjust_channel_timer(channel_struct *chan)
 {
-  chan->sampinc = (((double)ARM7_CLOCK) / (DESMUME_SAMPLE_RATE * 2)) / (double)(0x10000 - chan->timer);
+  chan->sampinc = (((double)ARM7_CLOCK) / (spu->DESMUME_SAMPLE_RATE * 2)) / (double)(0x10000 - chan->timer);
 }
 
 void SPU_struct::KeyProbe(int chan_num)
@@ -1049,8 +1040,8 @@ FORCEINLINE static void ____SPU_ChanUpdate(SPU_struct* const SPU, channel_struct
       } else if (FORMAT == 3) {
         FetchPSGData(chan, &data);
       } else {
-        const SampleData& sample = spuSampleCache.getSample(chan->addr, chan->loopstart, chan->length, SampleData::Format(FORMAT));
-        data = sample.sampleAt(chan->sampcnt, IInterpolator::allInterpolators[CommonSettings.spuInterpolationMode]);
+        const SampleData& sample = spu->spuSampleCache.getSample(chan->addr, chan->loopstart, chan->length, SampleData::Format(FORMAT));
+        data = sample.sampleAt(chan->sampcnt, IInterpolator::allInterpolators[ds->CommonSettings.spuInterpolationMode]);
       }
       SPU_Mix<CHANNELS>(SPU, chan, data);
     }
@@ -1138,10 +1129,10 @@ static void SPU_MixAudio_Advanced(bool actuallyMix, SPU_struct *SPU, int length)
         //output to mixer unless we are bypassed.
         //dont output to mixer if the user muted us
         bool outputToMix = true;
-        if (CommonSettings.spu_muteChannels[i]) outputToMix = false;
+        if (ds->CommonSettings.spu_muteChannels[i]) outputToMix = false;
         if (bypass) outputToMix = false;
         bool outputToCap = outputToMix;
-        if (CommonSettings.spu_captureMuted && !bypass) outputToCap = true;
+        if (ds->CommonSettings.spu_captureMuted && !bypass) outputToCap = true;
 
         //channels 1 and 3 should probably always generate their audio
         //internally at least, just in case they get used by the spu output
@@ -1312,7 +1303,7 @@ static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length)
   //in all likelihood, any game doing this probably master disabled the SPU also
   //so, optimization of this case is probably not necessary.
   //later, we'll just silence the output
-  bool speakers = T1ReadWord(MMU.ARM7_REG, 0x304) & 0x01;
+  bool speakers = T1ReadWord(mmu->MMU.ARM7_REG, 0x304) & 0x01;
 
   u8 vol = SPU->regs.mastervol;
 
@@ -1334,17 +1325,16 @@ static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length)
 //emulates one hline of the cpu core.
 //this will produce a variable number of samples, calculated to keep a 44100hz output
 //in sync with the emulator framerate
-int spu_core_samples = 0;
 void SPU_Emulate_core()
 {
   bool needToMix = true;
   SoundInterface_struct *soundProcessor = SPU_SoundCore();
 
-  samples += samples_per_hline;
-  spu_core_samples = (int)(samples);
-  samples -= spu_core_samples;
+  spu->samples += spu->samples_per_hline;
+  spu->spu_core_samples = (int)(spu->samples);
+  spu->samples -= spu->spu_core_samples;
 
-  SPU_MixAudio(needToMix, SPU_core, spu_core_samples);
+  SPU_MixAudio(needToMix, spu->SPU_core, spu->spu_core_samples);
 
   if (soundProcessor == NULL)
   {
@@ -1353,18 +1343,16 @@ void SPU_Emulate_core()
 
   if (soundProcessor->FetchSamples != NULL)
   {
-    soundProcessor->FetchSamples(SPU_core->outbuf, spu_core_samples, synchmode, synchronizer);
+    soundProcessor->FetchSamples(spu->SPU_core->outbuf, spu->spu_core_samples, spu->synchmode, spu->synchronizer);
   }
   else
   {
-    SPU_DefaultFetchSamples(SPU_core->outbuf, spu_core_samples, synchmode, synchronizer);
+    SPU_DefaultFetchSamples(spu->SPU_core->outbuf, spu->spu_core_samples, spu->synchmode, spu->synchronizer);
   }
 }
 
 void SPU_Emulate_user(bool mix)
 {
-  static s16 *postProcessBuffer = NULL;
-  static size_t postProcessBufferSize = 0;
   size_t freeSampleCount = 0;
   size_t processedSampleCount = 0;
   SoundInterface_struct *soundProcessor = SPU_SoundCore();
@@ -1382,29 +1370,29 @@ void SPU_Emulate_user(bool mix)
     return;
   }
 
-  if (freeSampleCount > buffersize)
+  if (freeSampleCount > spu->buffersize)
   {
-    freeSampleCount = buffersize;
+    freeSampleCount = spu->buffersize;
   }
 
   // If needed, resize the post-process buffer to guarantee that
   // we can store all the sound data.
-  if (postProcessBufferSize < freeSampleCount * 2 * sizeof(s16))
+  if (spu->postProcessBufferSize < freeSampleCount * 2 * sizeof(s16))
   {
-    postProcessBufferSize = freeSampleCount * 2 * sizeof(s16);
-    postProcessBuffer = (s16 *)realloc(postProcessBuffer, postProcessBufferSize);
+    spu->postProcessBufferSize = freeSampleCount * 2 * sizeof(s16);
+    spu->postProcessBuffer = (s16 *)realloc(spu->postProcessBuffer, spu->postProcessBufferSize);
   }
 
   if (soundProcessor->PostProcessSamples != NULL)
   {
-    processedSampleCount = soundProcessor->PostProcessSamples(postProcessBuffer, freeSampleCount, synchmode, synchronizer);
+    processedSampleCount = soundProcessor->PostProcessSamples(spu->postProcessBuffer, freeSampleCount, spu->synchmode, spu->synchronizer);
   }
   else
   {
-    processedSampleCount = SPU_DefaultPostProcessSamples(postProcessBuffer, freeSampleCount, synchmode, synchronizer);
+    processedSampleCount = SPU_DefaultPostProcessSamples(spu->postProcessBuffer, freeSampleCount, spu->synchmode, spu->synchronizer);
   }
 
-  soundProcessor->UpdateAudio(postProcessBuffer, processedSampleCount);
+  soundProcessor->UpdateAudio(spu->postProcessBuffer, processedSampleCount);
 }
 
 void SPU_DefaultFetchSamples(s16 *sampleBuffer, size_t sampleCount, ESynchMode synchMode, ISynchronizingAudioBuffer *theSynchronizer)
@@ -1450,7 +1438,7 @@ SoundInterface_struct SNDDummy = {
 int SNDDummyInit(int buffersize) { return 0; }
 void SNDDummyDeInit() {}
 void SNDDummyUpdateAudio(s16 *buffer, u32 num_samples) { }
-u32 SNDDummyGetAudioSpace() { return DESMUME_SAMPLE_RATE/60 + 5; }
+u32 SNDDummyGetAudioSpace() { return spu->DESMUME_SAMPLE_RATE/60 + 5; }
 void SNDDummyMuteAudio() {}
 void SNDDummyUnMuteAudio() {}
 void SNDDummySetVolume(int volume) {}
@@ -73,7 +73,6 @@ struct SoundInterface_struct
 
 extern SoundInterface_struct SNDDummy;
 extern SoundInterface_struct SNDFile;
-extern int SPU_currentCoreNum;
 
 struct channel_struct
 {
@@ -221,8 +220,36 @@ public:
    void ShutUp();
 };
 
-extern SPU_struct *SPU_core;
-extern int spu_core_samples;
+// the sound hardware of an emulated system, and its output
+struct spu_context
+{
+	~spu_context();
+
+	SPU_struct *SPU_core = 0;
+	int SPU_currentCoreNum = SNDCORE_DUMMY;
+	int volume = 100;
+	SampleCache spuSampleCache;
+
+	size_t buffersize = 0;
+	ESynchMode synchmode = ESynchMode_Synchronous;
+	ESynchMethod synchmethod = ESynchMethod_0;
+	ISynchronizingAudioBuffer* synchronizer = metaspu_construct(synchmethod);
+
+	int SNDCoreId=-1;
+	SoundInterface_struct *SNDCore=NULL;
+
+	double DESMUME_SAMPLE_RATE = 48000;
+	double samples_per_hline = (DESMUME_SAMPLE_RATE / 59.8261f) / 263.0f;
+	double sampleLength = DESMUME_SAMPLE_RATE / 32728.498;
+
+	double samples = 0;
+	int spu_core_samples = 0;
+
+	s16 *postProcessBuffer = NULL;
+	size_t postProcessBufferSize = 0;
+};
+
+extern THREADLOCAL spu_context *spu;
 
 int SPU_ChangeSoundCore(int coreid, int buffersize);
 SoundInterface_struct *SPU_SoundCore();
@@ -240,31 +267,28 @@ static FORCEINLINE void SPU_WriteByte(u32 addr, u8 val)
 {
 	addr &= 0xFFF;
 
-	SPU_core->WriteByte(addr,val);
+	spu->SPU_core->WriteByte(addr,val);
 }
 static FORCEINLINE void SPU_WriteWord(u32 addr, u16 val)
 {
 	addr &= 0xFFF;
 
-	SPU_core->WriteWord(addr,val);
+	spu->SPU_core->WriteWord(addr,val);
 }
 static FORCEINLINE void SPU_WriteLong(u32 addr, u32 val)
 {
 	addr &= 0xFFF;
 
-	SPU_core->WriteLong(addr,val);
+	spu->SPU_core->WriteLong(addr,val);
 }
-static FORCEINLINE u8 SPU_ReadByte(u32 addr) { return SPU_core->ReadByte(addr & 0x0FFF); }
-static FORCEINLINE u16 SPU_ReadWord(u32 addr) { return SPU_core->ReadWord(addr & 0x0FFF); }
-static FORCEINLINE u32 SPU_ReadLong(u32 addr) { return SPU_core->ReadLong(addr & 0x0FFF); }
+static FORCEINLINE u8 SPU_ReadByte(u32 addr) { return spu->SPU_core->ReadByte(addr & 0x0FFF); }
+static FORCEINLINE u16 SPU_ReadWord(u32 addr) { return spu->SPU_core->ReadWord(addr & 0x0FFF); }
+static FORCEINLINE u32 SPU_ReadLong(u32 addr) { return spu->SPU_core->ReadLong(addr & 0x0FFF); }
 void SPU_Emulate_core(void);
 void SPU_Emulate_user(bool mix = true);
 void SPU_DefaultFetchSamples(s16 *sampleBuffer, size_t sampleCount, ESynchMode synchMode, ISynchronizingAudioBuffer *theSynchronizer);
 size_t SPU_DefaultPostProcessSamples(s16 *postProcessBuffer, size_t requestedSampleCount, ESynchMode synchMode, ISynchronizingAudioBuffer *theSynchronizer);
 
-extern double DESMUME_SAMPLE_RATE;
 void SetDesmumeSampleRate(double rate);
 
-extern SampleCache spuSampleCache;
-
 #endif
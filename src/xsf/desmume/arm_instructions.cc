@@ -6000,7 +6000,7 @@ TEMPLATE static uint32_t FASTCALL OP_MCR(uint32_t i)
 	if (cpnum != 15)
 		return 2;
 
-	cp15.moveARM2CP(cpu->R[REG_POS(i, 12)], REG_POS(i, 16), REG_POS(i, 0), (i >> 21) & 0x7, (i >> 5) & 0x7);
+	cp15->moveARM2CP(cpu->R[REG_POS(i, 12)], REG_POS(i, 16), REG_POS(i, 0), (i >> 21) & 0x7, (i >> 5) & 0x7);
 
 	return 2;
 }
@@ -6025,7 +6025,7 @@ TEMPLATE static uint32_t FASTCALL OP_MRC(uint32_t i)
 	//	Rd = data
 
 	uint32_t data = 0;
-	cp15.moveCP2ARM(&data, REG_POS(i, 16), REG_POS(i, 0), (i >> 21) & 0x7, (i >> 5) & 0x7);
+	cp15->moveCP2ARM(&data, REG_POS(i, 16), REG_POS(i, 0), (i >> 21) & 0x7, (i >> 5) & 0x7);
 	if (REG_POS(i, 12) == 15)
 	{
 		cpu->CPSR.bits.N = BIT31(data);
@@ -40,8 +40,8 @@ static inline uint32_t armcpu_prefetch(armcpu_t *armcpu)
 		return armcpu_prefetch<1>();
 }
 
-armcpu_t NDS_ARM7;
-armcpu_t NDS_ARM9;
+THREADLOCAL armcpu_t *NDS_ARM7;
+THREADLOCAL armcpu_t *NDS_ARM9;
 
 int armcpu_new(armcpu_t *armcpu, uint32_t id)
 {
@@ -254,7 +254,7 @@ void armcpu_exception(armcpu_t *cpu, uint32_t number)
 			cpumode = ABT;
 			break;
 		case EXCEPTION_RESERVED_0x14:
-			execute = false;
+			ds->execute = false;
 			break;
 		case EXCEPTION_IRQ:
 			cpumode = IRQ;
@@ -303,12 +303,12 @@ uint32_t TRAPUNDEF(armcpu_t *cpu)
 {
 	if (!!cpu->intVector ^ (cpu->proc_ID == ARMCPU_ARM9))
 	{
-		armcpu_exception(&NDS_ARM9, EXCEPTION_UNDEFINED_INSTRUCTION);
+		armcpu_exception(NDS_ARM9, EXCEPTION_UNDEFINED_INSTRUCTION);
 		return 4;
 	}
 	else
 	{
-		execute = false;
+		ds->execute = false;
 		return 4;
 	}
 }
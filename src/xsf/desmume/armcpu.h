@@ -222,7 +222,8 @@ void armcpu_exception(armcpu_t *cpu, uint32_t number);
 uint32_t TRAPUNDEF(armcpu_t* cpu);
 uint32_t armcpu_Wait4IRQ(armcpu_t *cpu);
 
-extern armcpu_t NDS_ARM7, NDS_ARM9;
+extern THREADLOCAL armcpu_t *NDS_ARM7;
+extern THREADLOCAL armcpu_t *NDS_ARM9;
 
 template<int PROCNUM> uint32_t armcpu_exec();
 
@@ -231,7 +232,7 @@ inline void setIF(int PROCNUM, uint32_t flag)
 	// don't set generated bits!!!
 	assert(!(flag&0x00200000));
 
-	MMU.reg_IF_bits[PROCNUM] |= flag;
+	mmu->MMU.reg_IF_bits[PROCNUM] |= flag;
 
 	extern void NDS_Reschedule();
 	NDS_Reschedule();
@@ -208,7 +208,7 @@ TEMPLATE static uint32_t WaitByLoop()
 
 	if (PROCNUM == ARMCPU_ARM9)
 	{
-		if (cp15.ctrl & ((1 << 16) | (1 << 18))) // DTCM or ITCM is on (cache)
+		if (cp15->ctrl & ((1 << 16) | (1 << 18))) // DTCM or ITCM is on (cache)
 			elapsed = cpu->R[0] * 2;
 		else
 			elapsed = cpu->R[0] * 8;
@@ -230,7 +230,7 @@ TEMPLATE static uint32_t intrWaitARM()
 {
 	// TODO - account for differences between arm7 and arm9 (according to gbatek, the "bug doesn't work")
 
-	const uint32_t intrFlagAdr = PROCNUM == ARMCPU_ARM7 ? 0x380FFF8 : (cp15.DTCMRegion & 0xFFFFF000) + 0x3FF8;
+	const uint32_t intrFlagAdr = PROCNUM == ARMCPU_ARM7 ? 0x380FFF8 : (cp15->DTCMRegion & 0xFFFFF000) + 0x3FF8;
 
 	// set IME=1
 	// without this, no irq handlers can happen (even though IF&IE waits can happily happen)
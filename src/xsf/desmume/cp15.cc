@@ -20,7 +20,7 @@
 #include "cp15.h"
 #include "MMU.h"
 
-armcp15_t cp15;
+THREADLOCAL armcp15_t *cp15;
 
 bool armcp15_t::reset(armcpu_t *c)
 {
@@ -51,7 +51,7 @@ bool armcp15_t::reset(armcpu_t *c)
 	this->DTCMRegion = 0x0080000A;
 	this->processID = 0;
 
-	MMU.ARM9_RW_MODE = BIT7(this->ctrl);
+	mmu->MMU.ARM9_RW_MODE = BIT7(this->ctrl);
 	this->cpu->intVector = 0xFFFF0000 * BIT13(this->ctrl);
 	this->cpu->LDTBit = !BIT15(this->ctrl); // TBit
 
@@ -384,7 +384,7 @@ bool armcp15_t::moveARM2CP(uint32_t val, uint8_t CRn, uint8_t CRm, uint8_t opcod
 			{
 				// On the NDS bit0,2,7,12..19 are R/W, Bit3..6 are always set, all other bits are always zero.
 				this->ctrl = (val & 0x000FF085) | 0x00000078;
-				MMU.ARM9_RW_MODE = BIT7(val);
+				mmu->MMU.ARM9_RW_MODE = BIT7(val);
 				// zero 31-jan-2010: change from 0x0FFF0000 to 0xFFFF0000 per gbatek
 				this->cpu->intVector = 0xFFFF0000 * BIT13(val);
 				this->cpu->LDTBit = !BIT15(val); // TBit
@@ -504,12 +504,12 @@ bool armcp15_t::moveARM2CP(uint32_t val, uint8_t CRn, uint8_t CRm, uint8_t opcod
 						switch (opcode2)
 						{
 							case 0:
-								MMU.DTCMRegion = this->DTCMRegion = val & 0x0FFFF000;
+								mmu->MMU.DTCMRegion = this->DTCMRegion = val & 0x0FFFF000;
 								return true;
 							case 1:
 								this->ITCMRegion = val;
 								// ITCM base is not writeable!
-								MMU.ITCMRegion = 0;
+								mmu->MMU.ITCMRegion = 0;
 								return true;
 							default:
 								return false;
@@ -528,19 +528,19 @@ void maskPrecalc()
 #define precalc(num) \
 { \
 	uint32_t mask = 0, set = 0xFFFFFFFF; /* (x & 0) == 0xFF..FF is allways false (disabled) */ \
-	if (BIT_N(cp15.protectBaseSize##num, 0)) /* if region is enabled */ \
+	if (BIT_N(cp15->protectBaseSize##num, 0)) /* if region is enabled */ \
 	{ \
 		/* reason for this define: naming includes var */ \
-		mask = MASKFROMREG(cp15.protectBaseSize##num); \
-		set = SETFROMREG(cp15.protectBaseSize##num); \
-		if (SIZEIDENTIFIER(cp15.protectBaseSize##num) == 0x1F) \
+		mask = MASKFROMREG(cp15->protectBaseSize##num); \
+		set = SETFROMREG(cp15->protectBaseSize##num); \
+		if (SIZEIDENTIFIER(cp15->protectBaseSize##num) == 0x1F) \
 		{ \
 			/* for the 4GB region, u32 suffers wraparound */ \
 			mask = 0; \
 			set = 0; /* (x & 0) == 0  is allways true (enabled) */ \
 		} \
 	} \
-	cp15.setSingleRegionAccess(cp15.DaccessPerm, cp15.IaccessPerm, num, mask, set); \
+	cp15->setSingleRegionAccess(cp15->DaccessPerm, cp15->IaccessPerm, num, mask, set); \
 }
 	precalc(0);
 	precalc(1);
@@ -107,5 +107,5 @@ public:
 	bool isAccessAllowed(uint32_t address,uint32_t access);
 };
 
-extern armcp15_t cp15;
+extern THREADLOCAL armcp15_t *cp15;
 void maskPrecalc();
@@ -25,7 +25,7 @@ static inline uint32_t DWNUM(uint32_t i) { return i >> 2; }
 
 bool CFIRMWARE::getKeyBuf()
 {
-	FILE *file = fopen(CommonSettings.ARM7BIOS, "rb");
+	FILE *file = fopen(ds->CommonSettings.ARM7BIOS, "rb");
 	if (!file)
 		return false;
 
@@ -313,12 +313,12 @@ uint32_t CFIRMWARE::decompress(const uint8_t *in, std::unique_ptr<uint8_t[]> &ou
 // ================================================================================
 bool CFIRMWARE::load()
 {
-	if (!CommonSettings.UseExtFirmware)
+	if (!ds->CommonSettings.UseExtFirmware)
 		return false;
-	if (!strlen(CommonSettings.Firmware))
+	if (!strlen(ds->CommonSettings.Firmware))
 		return false;
 
-	FILE *fp = fopen(CommonSettings.Firmware, "rb");
+	FILE *fp = fopen(ds->CommonSettings.Firmware, "rb");
 	if (!fp)
 		return false;
 	fseek(fp, 0, SEEK_END);
@@ -504,8 +504,8 @@ bool CFIRMWARE::load()
 	}
 
 	// TODO: add 512Kb support
-	memcpy(&MMU.fw.data[0], &data[0], 262144);
-	MMU.fw.fp = nullptr;
+	memcpy(&mmu->MMU.fw.data[0], &data[0], 262144);
+	mmu->MMU.fw.fp = nullptr;
 
 	return true;
 }
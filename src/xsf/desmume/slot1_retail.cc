@@ -36,7 +36,7 @@ static void write16(uint8_t, uint32_t, uint16_t) {}
 
 static void write32_GCROMCTRL(uint8_t PROCNUM, uint32_t)
 {
-	nds_dscard &card = MMU.dscard[PROCNUM];
+	nds_dscard &card = mmu->MMU.dscard[PROCNUM];
 
 	switch (card.command[0])
 	{
@@ -78,7 +78,7 @@ static uint16_t read16(uint8_t, uint32_t)
 
 static uint32_t read32_GCDATAIN(uint8_t PROCNUM)
 {
-	nds_dscard &card = MMU.dscard[PROCNUM];
+	nds_dscard &card = mmu->MMU.dscard[PROCNUM];
 
 	switch (card.command[0])
 	{
@@ -98,7 +98,7 @@ static uint32_t read32_GCDATAIN(uint8_t PROCNUM)
 				// this still works, since it will have read 00 originally and then read 00 to validate.
 
 				// staff of kings verifies this (it also uses the arm7 IRQ 20)
-				if (nds.cardEjected) // TODO - handle this with ejected card slot1 device (and verify using this case)
+				if (ds->nds.cardEjected) // TODO - handle this with ejected card slot1 device (and verify using this case)
 					return 0xFFFFFFFF;
 				else
 					return 0;
@@ -111,7 +111,7 @@ static uint32_t read32_GCDATAIN(uint8_t PROCNUM)
 				// it seems that etrian odyssey 3 doesnt work unless we mask this to cart size.
 				// but, a thought: does the internal rom address counter register wrap around? we may be making a mistake by keeping the extra precision
 				// but there is no test case yet
-				uint32_t address = card.address & gameInfo.mask;
+				uint32_t address = card.address & ds->gameInfo.mask;
 
 				// Make sure any reads below 0x8000 redirect to 0x8000+(adr&0x1FF) as on real cart
 				if (card.command[0] == 0xB7 && address < 0x8000)
@@ -126,13 +126,13 @@ static uint32_t read32_GCDATAIN(uint8_t PROCNUM)
 
 				// as a sanity measure for funny-sized roms (homebrew and perhaps truncated retail roms)
 				// we need to protect ourselves by returning 0xFF for things still out of range
-				if (address >= gameInfo.romsize)
+				if (address >= ds->gameInfo.romsize)
 				{
 					//DEBUG_Notify.ReadBeyondEndOfCart(address, gameInfo. romsize);
 					return 0xFFFFFFFF;
 				}
 
-				return T1ReadLong(MMU.CART_ROM, address);
+				return T1ReadLong(mmu->MMU.CART_ROM, address);
 			}
 		default:
 			return 0;
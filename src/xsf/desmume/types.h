@@ -94,6 +94,16 @@ using s8 = int8_t;
 # define LDM_FASTCALL
 #endif
 
+// the state of the emulator is reached through pointers of this kind, which
+// are set for the thread running it (see NDSContext).  __thread needs no
+// check for a dynamic initializer, and initial-exec no function call, on each
+// access
+#if defined(__GNUC__) && defined(__ELF__)
+# define THREADLOCAL __thread __attribute__((tls_model("initial-exec")))
+#else
+# define THREADLOCAL thread_local
+#endif
+
 /*----------------------*/
 
 #ifdef __BIG_ENDIAN__
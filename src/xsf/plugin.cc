@@ -40,6 +40,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include <memory>
 #include <sstream>
 #include <iostream>
@@ -50,18 +51,12 @@
 #include <libaudcore/audstrings.h>
 #include <libaudcore/runtime.h>
 
+#include "../length-common/lengths.h"
 #include "desmume/NDSSystem.h"
 #include "spu/samplecache.h"
 #include "sndif2sf.h"
 #include "XSFFile.h"
 
-#if _WIN32
-#include <windows.h>
-#define sleep Sleep
-#else
-#include <unistd.h>
-#endif
-
 class XSFPlugin : public InputPlugin
 {
 public:
@@ -81,6 +76,7 @@ public:
 		.with_exts(exts)) {}
 
 	bool init();
+	void cleanup();
 
 	bool is_our_file(const char *filename, VFSFile &file);
 	bool read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image);
@@ -159,16 +155,53 @@ public:
   ~vfsfile_istream() { delete rdbuf(nullptr); }
 };
 
-/* xsf_get_lib: called to load secondary files */
-static String dirpath;
+/* The state of one play() or detect_length() call.  Each call emulates its
+ * file in an NDSContext of its own, so that a song can be played while others
+ * are scanned.  xsf_get_lib() and recursiveLoad2SF() find the call running in
+ * their thread through "current". */
+struct XSFCall
+{
+  XSFCall(const char *filename);
+  ~XSFCall();
+
+  NDSContext context;
+  sndif_context output;
+  String dirpath;
+};
+
+static thread_local XSFCall *current;
+
+/* <filename> must contain a slash */
+XSFCall::XSFCall(const char *filename) :
+  dirpath(str_copy(filename, strrchr(filename, '/') + 1 - filename))
+{
+  context.make_current();
+  sndif = &output;
+  current = this;
+}
+
+XSFCall::~XSFCall()
+{
+  current = nullptr;
+  sndif = nullptr;
+  NDSContext::release();
+}
+
+/* set from the preferences, which may change them while songs play */
+static std::atomic<bool> ignore_length;
+static std::atomic<int> interp_mode;
+
+void setInterp();
+static int detect_length(const char *filename);
 
-bool ignore_length;
+static LengthCache xsf_lengths(detect_length);
 
 #define CFG_ID "xsf"
 
 const char* const XSFPlugin::defaults[] =
 {
   "ignore_length", "FALSE",
+  "detect_length", "FALSE",
   "fade", "5000",
   "sample_rate", "32728",
   "interpolation_mode", "none",
@@ -178,12 +211,19 @@ const char* const XSFPlugin::defaults[] =
 bool XSFPlugin::init()
 {
 	aud_config_set_defaults(CFG_ID, defaults);
+	setInterp();
 	return true;
 }
 
+void XSFPlugin::cleanup()
+{
+	xsf_lengths.cleanup();
+}
+
+/* xsf_get_lib: called to load secondary files */
 Index<char> xsf_get_lib(char *filename)
 {
-	VFSFile file(filename_build({dirpath, filename}), "r");
+	VFSFile file(filename_build({current->dirpath, filename}), "r");
 	return file ? file.read_all() : Index<char>();
 }
 
@@ -196,7 +236,17 @@ bool XSFPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Inde
     }
     XSFFile xsf(vs, 0, 0, true);
 
-    tuple.set_int(Tuple::Length, xsf.GetLengthMS(115000) + xsf.GetFadeMS(5000));
+    int detected = -1;
+    if (!xsf.GetTagExists("length") || aud_get_bool(CFG_ID, "ignore_length")) {
+      String key = LengthCache::make_key(file, 0);
+      if (key && !xsf_lengths.lookup(key, detected) && aud_get_bool(CFG_ID, "detect_length"))
+        xsf_lengths.queue(filename, key);
+    }
+
+    if (detected > 0)
+      tuple.set_int(Tuple::Length, detected);
+    else
+      tuple.set_int(Tuple::Length, xsf.GetLengthMS(115000) + xsf.GetFadeMS(5000));
     tuple.set_str(Tuple::Artist, xsf.GetTagValue("artist").c_str());
     tuple.set_str(Tuple::Album, xsf.GetTagValue("game").c_str());
     tuple.set_str(Tuple::Title, xsf.GetTagValue("title").c_str());
@@ -221,17 +271,17 @@ bool XSFPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Inde
 
 static void xsf_reset(int frameSkip)
 {
-  execute = false;
+  ds->execute = false;
   NDS_Reset();
-  spuSampleCache.clear();
-  execute = true;
+  spu->spuSampleCache.clear();
+  ds->execute = true;
 
   if (frameSkip > 0) {
     for (int i = 0; i < frameSkip; ++i) {
       NDS_exec<false>();
     }
   }
-  buffer_rope.clear();
+  sndif->buffer_rope.clear();
 }
 
 bool map2SF(std::vector<uint8_t>& rom, XSFFile* xsf)
@@ -255,7 +305,7 @@ bool recursiveLoad2SF(std::vector<uint8_t>& rom, XSFFile* xsf, int level)
 {
   if (level <= 10 && xsf->GetTagExists("_lib"))
   {
-    vfsfile_istream vs(filename_build({ dirpath, xsf->GetTagValue("_lib").c_str() }));
+    vfsfile_istream vs(filename_build({ current->dirpath, xsf->GetTagValue("_lib").c_str() }));
     if (!vs)
       return false;
     XSFFile libxsf(vs, 4, 8);
@@ -272,7 +322,7 @@ bool recursiveLoad2SF(std::vector<uint8_t>& rom, XSFFile* xsf, int level)
     ss << "_lib" << (n++);
     found = xsf->GetTagExists(ss.str());
     if (found) {
-      vfsfile_istream vs(filename_build({ dirpath, xsf->GetTagValue(ss.str()).c_str() }));
+      vfsfile_istream vs(filename_build({ current->dirpath, xsf->GetTagValue(ss.str()).c_str() }));
       if (!vs)
         return false;
       XSFFile libxsf(vs, 4, 8);
@@ -293,7 +343,47 @@ void setInterp() {
   } else if (interp == "sharp") {
     interpMode = 3;
   }
-  CommonSettings.spuInterpolationMode = (SPUInterpolationMode)interpMode;
+  interp_mode = interpMode;
+}
+
+/* Loads a 2SF with its libraries into rom, which must be kept for as long as
+ * the emulator runs, and starts the emulator of the current XSFCall. */
+static bool xsf_start(XSFFile &xsf, std::vector<uint8_t> &rom, int &frameSkip)
+{
+    if (!recursiveLoad2SF(rom, &xsf, 0) || !rom.size())
+      return false;
+
+    if (NDS_Init())
+      return false;
+
+    int sampleRate = aud_get_int(CFG_ID, "sample_rate");
+    if (sampleRate < 11025 || sampleRate > 96000)
+      sampleRate = 32728;
+    SetDesmumeSampleRate(sampleRate); // TODO: config
+    int BUFFERSIZE = spu->DESMUME_SAMPLE_RATE / 59.837; //truncates to 737, the traditional value, for 44100
+    SPU_ChangeSoundCore(SNDIFID_2SF, BUFFERSIZE);
+
+    ds->execute = false;
+
+    MMU_unsetRom();
+    NDS_SetROM(rom.data(), rom.size());
+    ds->gameInfo.loadData((char*)rom.data(), rom.size());
+
+    frameSkip = xsf.GetTagValue<int>("_frames", -1);
+    ds->CommonSettings.rigorous_timing = true;
+    ds->CommonSettings.spu_advanced = true;
+    ds->CommonSettings.advanced_timing = true;
+    ds->CommonSettings.spuInterpolationMode = (SPUInterpolationMode)interp_mode.load();
+
+    xsf_reset(frameSkip);
+    return true;
+}
+
+static void xsf_stop()
+{
+  MMU_unsetRom();
+  NDS_DeInit();
+  ds->execute = false;
 }
 
 bool XSFPlugin::play(const char *filename, VFSFile &file)
@@ -303,18 +393,11 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
   int fade = aud_get_int(CFG_ID, "fade");
   int frameSkip = -1;
 	float pos = 0.0;
-	setInterp();
 
-	const char * slash = strrchr(filename, '/');
-	if (!slash)
+	if (!strrchr(filename, '/'))
 		return false;
 
-  while (execute && !check_stop()) {
-    std::cerr << "waiting for thread to finish..." << std::endl;
-    sleep(100);
-  }
-
-	dirpath = String(str_copy(filename, slash + 1 - filename));
+  XSFCall call(filename);
 
 	Index<char> buf = file.read_all();
   try {
@@ -328,64 +411,51 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
     length = xsf.GetLengthMS(115000) + fade;
 
     std::vector<uint8_t> rom;
-    if (!recursiveLoad2SF(rom, &xsf, 0) || !rom.size())
+    if (!xsf_start(xsf, rom, frameSkip))
       return false;
 
-    if (NDS_Init())
-      return false;
-
-    int sampleRate = aud_get_int(CFG_ID, "sample_rate");
-    if (sampleRate < 11025 || sampleRate > 96000)
-      sampleRate = 32728;
-    SetDesmumeSampleRate(sampleRate); // TODO: config
-    int BUFFERSIZE = DESMUME_SAMPLE_RATE / 59.837; //truncates to 737, the traditional value, for 44100
-    SPU_ChangeSoundCore(SNDIFID_2SF, BUFFERSIZE);
-
-    execute = false;
-
-    MMU_unsetRom();
-    NDS_SetROM(rom.data(), rom.size());
-    gameInfo.loadData((char*)rom.data(), rom.size());
-
-    frameSkip = xsf.GetTagValue<int>("_frames", -1);
-    CommonSettings.rigorous_timing = true;
-    CommonSettings.spu_advanced = true;
-    CommonSettings.advanced_timing = true;
+    set_stream_bitrate(spu->DESMUME_SAMPLE_RATE*2*2*8);
+    open_audio(FMT_S16_NE, spu->DESMUME_SAMPLE_RATE, 2);
 
-    xsf_reset(frameSkip);
+    ignore_length = aud_get_bool(CFG_ID, "ignore_length");
 
-    set_stream_bitrate(DESMUME_SAMPLE_RATE*2*2*8);
-    open_audio(FMT_S16_NE, DESMUME_SAMPLE_RATE, 2);
+    /* songs without a usable length are ended after a run of silence, and
+     * the time of the last sound is then taken as their length */
+    bool detect = ignore_length || !xsf.GetTagExists("length");
+    SilenceDetector silence(spu->DESMUME_SAMPLE_RATE);
 
-    ignore_length = aud_get_bool(CFG_ID, "ignore_length");
-    while (!check_stop() && (pos < length || ignore_length))
+    while (!check_stop() && (pos < length || ignore_length) && !silence.ended())
     {
+      ds->CommonSettings.spuInterpolationMode = (SPUInterpolationMode)interp_mode.load();
+
       int seek_value = check_seek();
 
       if (seek_value >= 0)
       {
+        silence.seek(seek_value);
+
         if (seek_value < pos) {
           xsf_reset(frameSkip);
           pos = 0;
         }
         while (pos < seek_value)
         {
-          while (buffer_rope.size()) {
-            pos += buffer_rope.front().size() * 1000 / DESMUME_SAMPLE_RATE / 4;
-            buffer_rope.pop_front();
+          while (sndif->buffer_rope.size()) {
+            pos += sndif->buffer_rope.front().size() * 1000 / spu->DESMUME_SAMPLE_RATE / 4;
+            sndif->buffer_rope.pop_front();
           }
           NDS_exec<false>();
           SPU_Emulate_user();
         }
-        buffer_rope.clear();
+        sndif->buffer_rope.clear();
       }
 
-      while (!buffer_rope.size() && !check_stop()) {
+      while (!sndif->buffer_rope.size() && !check_stop()) {
         NDS_exec<false>();
         SPU_Emulate_user();
       }
-      while (buffer_rope.size() && !check_stop()) {
-        auto& front = buffer_rope.front();
+      while (sndif->buffer_rope.size() && !check_stop()) {
+        auto& front = sndif->buffer_rope.front();
         if (pos > length - fade && !ignore_length) {
           float fadeFactor = (length - pos) / (1.0 * fade);
           int sampleCount = front.size() / 2;
@@ -394,23 +464,88 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
             sampleBuffer[i] *= fadeFactor;
           }
         }
+        if (detect && silence.process(reinterpret_cast<const int16_t*>(front.data()), front.size() / 2))
+          break;
         write_audio(front.data(), front.size());
-        pos += front.size() * 1000 / DESMUME_SAMPLE_RATE / 4;
-        buffer_rope.pop_front();
+        pos += front.size() * 1000 / spu->DESMUME_SAMPLE_RATE / 4;
+        sndif->buffer_rope.pop_front();
       }
     }
+
+    if (silence.ended() && silence.exact()) {
+      xsf_lengths.store(LengthCache::make_key(buf, 0), silence.length());
+
+      Tuple tuple = get_playback_tuple();
+      tuple.set_int(Tuple::Length, silence.length());
+      set_playback_tuple(tuple.ref());
+    }
   } catch (std::exception& e) {
     std::cerr << "Exception: " << e.what() << std::endl;
     error = true;
   }
 
-  MMU_unsetRom();
-  NDS_DeInit();
-	dirpath = String();
-  execute = false;
+  xsf_stop();
 	return !error;
 }
 
+/* Plays the song through as fast as possible, up to LengthCache::Limit, and
+ * returns the time of the last sound before a run of silence.  This runs in
+ * an emulator of its own, next to any song that plays, and stops (to be run
+ * again later) when the plugin is unloaded. */
+static int detect_length(const char *filename)
+{
+  if (!strrchr(filename, '/'))
+    return -1;
+
+  VFSFile file(filename, "r");
+  if (!file)
+    return -1;
+
+  XSFCall call(filename);
+
+  int length = -1;
+
+  try {
+    vfsfile_istream vs(&file);
+    if (!vs)
+      return -1;
+
+    XSFFile xsf(vs, 4, 8);
+
+    std::vector<uint8_t> rom;
+    int frameSkip = -1;
+    if (!xsf_start(xsf, rom, frameSkip))
+      return -1;
+
+    SilenceDetector silence(spu->DESMUME_SAMPLE_RATE);
+
+    while (!silence.ended() && silence.position() < LengthCache::Limit) {
+      if (xsf_lengths.stopping()) {
+        length = LengthCache::Retry;
+        break;
+      }
+
+      while (!sndif->buffer_rope.size()) {
+        NDS_exec<false>();
+        SPU_Emulate_user();
+      }
+      while (sndif->buffer_rope.size()) {
+        auto& front = sndif->buffer_rope.front();
+        silence.process(reinterpret_cast<const int16_t*>(front.data()), front.size() / 2);
+        sndif->buffer_rope.pop_front();
+      }
+    }
+
+    if (silence.ended())
+      length = silence.length();
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+  }
+
+  xsf_stop();
+  return length;
+}
+
 bool XSFPlugin::is_our_file(const char *filename, VFSFile &file)
 {
 	char magic[4];
@@ -442,6 +577,7 @@ static const ComboItem interpItems[] = {
 const PreferencesWidget XSFPlugin::widgets[] = {
   WidgetLabel(N_("<b>XSF Configuration</b>")),
   WidgetCheck(N_("Ignore length from file"), WidgetBool(CFG_ID, "ignore_length", [] { ignore_length = aud_get_bool(CFG_ID, "ignore_length"); } )),
+  WidgetCheck(N_("Detect length of songs without length information"), WidgetBool(CFG_ID, "detect_length")),
   WidgetSpin(N_("Default fade time:"), WidgetInt(CFG_ID, "fade"), { 0, 15000, 100, N_("ms") }),
   WidgetCombo(N_("Sample rate:"), WidgetInt(CFG_ID, "sample_rate"), {{ sampleRateItems }}),
   WidgetCombo(N_("Interpolation mode:"), WidgetString(CFG_ID, "interpolation_mode", setInterp), {{ interpItems }})
@@ -32,31 +32,23 @@
 #include "desmume/NDSSystem.h"
 #include <vector>
 
-std::list<std::vector<std::uint8_t>> buffer_rope;
-
-static struct
-{
-  std::vector<uint8_t> buf;
-  unsigned filled, used;
-  uint32_t bufferbytes, cycles;
-  int xfs_load, sync_type;
-} sndifwork = {std::vector<uint8_t>(), 0, 0, 0, 0, 0, 0};
+THREADLOCAL sndif_context *sndif;
 
 static void SNDIFDeInit() {
-  int buffersize = sndifwork.buf.size();
-  sndifwork.buf.resize(0);
-  sndifwork.buf.resize(buffersize);
-  buffer_rope.clear();
+  int buffersize = sndif->sndifwork.buf.size();
+  sndif->sndifwork.buf.resize(0);
+  sndif->sndifwork.buf.resize(buffersize);
+  sndif->buffer_rope.clear();
 }
 
 static int SNDIFInit(int buffersize)
 {
   uint32_t bufferbytes = buffersize * sizeof(int16_t);
   SNDIFDeInit();
-  sndifwork.buf.resize(bufferbytes + 3);
-  sndifwork.bufferbytes = bufferbytes;
-  sndifwork.filled = sndifwork.used = 0;
-  sndifwork.cycles = 0;
+  sndif->sndifwork.buf.resize(bufferbytes + 3);
+  sndif->sndifwork.bufferbytes = bufferbytes;
+  sndif->sndifwork.filled = sndif->sndifwork.used = 0;
+  sndif->sndifwork.cycles = 0;
   return 0;
 }
 
@@ -66,21 +58,21 @@ static void SNDIFSetVolume(int) { }
 
 static uint32_t SNDIFGetAudioSpace()
 {
-  return sndifwork.bufferbytes >> 2; // bytes to samples
+  return sndif->sndifwork.bufferbytes >> 2; // bytes to samples
 }
 
 static void SNDIFUpdateAudio(int16_t *buffer, uint32_t num_samples)
 {
   num_samples <<= 1; // stereo
   uint32_t num_bytes = num_samples << 1;
-  if (num_bytes > sndifwork.bufferbytes) {
-    num_bytes = sndifwork.bufferbytes;
+  if (num_bytes > sndif->sndifwork.bufferbytes) {
+    num_bytes = sndif->sndifwork.bufferbytes;
     num_samples = num_bytes >> 1;
   }
-  memcpy(&sndifwork.buf[0], buffer, num_bytes);
-  buffer_rope.push_back(std::vector<uint8_t>(reinterpret_cast<uint8_t*>(buffer), reinterpret_cast<uint8_t*>(buffer) + num_bytes));
-  sndifwork.filled = num_bytes;
-  sndifwork.used = 0;
+  memcpy(&sndif->sndifwork.buf[0], buffer, num_bytes);
+  sndif->buffer_rope.push_back(std::vector<uint8_t>(reinterpret_cast<uint8_t*>(buffer), reinterpret_cast<uint8_t*>(buffer) + num_bytes));
+  sndif->sndifwork.filled = num_bytes;
+  sndif->sndifwork.used = 0;
 }
 
 const int SNDIFID_2SF = 1;
@@ -36,4 +36,19 @@
 
 extern const int SNDIFID_2SF;
 extern SoundInterface_struct SNDIF_2SF;
-extern std::list<std::vector<std::uint8_t>> buffer_rope;
+
+// the output of an emulated system, set next to its NDSContext
+struct sndif_context
+{
+  std::list<std::vector<std::uint8_t>> buffer_rope;
+
+  struct
+  {
+    std::vector<uint8_t> buf;
+    unsigned filled = 0, used = 0;
+    uint32_t bufferbytes = 0, cycles = 0;
+    int xfs_load = 0, sync_type = 0;
+  } sndifwork;
+};
+
+extern THREADLOCAL sndif_context *sndif;
@@ -26,7 +26,7 @@
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/xmlreader.h>
-#include <libxml/xmlsave.h>
+#include <libxml/xmlwriter.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 #include <libxml/uri.h>
@@ -104,99 +104,97 @@ public:
 
 EXPORT XSPFLoader aud_plugin_instance;
 
-static void xspf_add_file (xmlNode * track, const char * filename,
- const char * base, Index<PlaylistAddItem> & items)
+static String xspf_location (const char * str, const char * base)
 {
-    xmlNode *nptr;
-    String location;
-    Tuple tuple;
+    if (strstr (str, "://") != nullptr)
+        return String (str);
 
-    for (nptr = track->children; nptr != nullptr; nptr = nptr->next) {
-        if (nptr->type == XML_ELEMENT_NODE) {
-            if (!xmlStrcmp(nptr->name, (xmlChar *)"location")) {
-                /* Location is a special case */
-                char *str = (char *)xmlNodeGetContent(nptr);
-
-                if (strstr (str, "://") != nullptr)
-                    location = String (str);
-                else if (str[0] == '/' && base != nullptr)
-                {
-                    const char * colon = strstr (base, "://");
-
-                    if (colon != nullptr)
-                        location = String (str_printf ("%.*s%s",
-                         (int) (colon + 3 - base), base, str));
-                }
-                else if (base != nullptr)
-                {
-                    const char * slash = strrchr (base, '/');
-
-                    if (slash != nullptr)
-                        location = String (str_printf ("%.*s%s",
-                         (int) (slash + 1 - base), base, str));
-                }
-
-                xmlFree(str);
-            } else {
-                /* Rest of the nodes are handled here */
-                bool isMeta;
-                xmlChar *findName;
-
-                if (!xmlStrcmp(nptr->name, (xmlChar *)"meta")) {
-                    isMeta = true;
-                    findName = xmlGetProp(nptr, (xmlChar *)"rel");
-                } else {
-                    isMeta = false;
-                    findName = xmlStrdup(nptr->name);
-                }
-
-                for (const xspf_entry_t & entry : xspf_entries)
-                if ((entry.isMeta == isMeta) &&
-                    !xmlStrcmp(findName, (xmlChar *)entry.xspfName)) {
-                    xmlChar *str = xmlNodeGetContent(nptr);
-                    switch (Tuple::field_get_type (entry.tupleField)) {
-                        case Tuple::String:
-                            tuple.set_str (entry.tupleField, (char *)str);
-                            tuple.set_state (Tuple::Valid);
-                            break;
-
-                        case Tuple::Int:
-                            tuple.set_int (entry.tupleField, atol((char *)str));
-                            tuple.set_state (Tuple::Valid);
-                            break;
-
-                        default:
-                            break;
-                    }
-                    xmlFree(str);
-                    break;
-                }
-
-                xmlFree(findName);
-            }
-        }
+    if (str[0] == '/' && base != nullptr)
+    {
+        const char * colon = strstr (base, "://");
+
+        if (colon != nullptr)
+            return String (str_printf ("%.*s%s", (int) (colon + 3 - base), base, str));
     }
+    else if (base != nullptr)
+    {
+        const char * slash = strrchr (base, '/');
 
-    if (location)
+        if (slash != nullptr)
+            return String (str_printf ("%.*s%s", (int) (slash + 1 - base), base, str));
+    }
+
+    return String ();
+}
+
+static void xspf_set_field (Tuple & tuple, bool isMeta, const xmlChar * findName,
+ const char * str)
+{
+    for (const xspf_entry_t & entry : xspf_entries)
     {
-        if (tuple.valid ())
-            tuple.set_filename (location);
+        if (entry.isMeta != isMeta || xmlStrcmp (findName, (xmlChar *) entry.xspfName))
+            continue;
 
-        items.append (location, std::move (tuple));
+        switch (Tuple::field_get_type (entry.tupleField))
+        {
+        case Tuple::String:
+            tuple.set_str (entry.tupleField, str);
+            tuple.set_state (Tuple::Valid);
+            break;
+
+        case Tuple::Int:
+            tuple.set_int (entry.tupleField, atol (str));
+            tuple.set_state (Tuple::Valid);
+            break;
+
+        default:
+            break;
+        }
+
+        break;
     }
 }
 
+/* reads one child element of a track */
+static void xspf_read_track_node (xmlTextReaderPtr reader, const char * base,
+ String & location, Tuple & tuple)
+{
+    const xmlChar * name = xmlTextReaderConstLocalName (reader);
+    xmlChar * str = xmlTextReaderReadString (reader);
+    if (! str)
+        return;
+
+    if (! xmlStrcmp (name, (xmlChar *) "location"))
+    {
+        /* Location is a special case */
+        location = xspf_location ((char *) str, base);
+    }
+    else if (! xmlStrcmp (name, (xmlChar *) "meta"))
+    {
+        xmlChar * rel = xmlTextReaderGetAttribute (reader, (xmlChar *) "rel");
+        if (rel)
+            xspf_set_field (tuple, true, rel, (char *) str);
+        xmlFree (rel);
+    }
+    else
+        xspf_set_field (tuple, false, name, (char *) str);
+
+    xmlFree (str);
+}
 
-static void xspf_find_track (xmlNode * tracklist, const char * filename,
- const char * base, Index<PlaylistAddItem> & items)
+static void xspf_finish_track (String & location, Tuple & tuple,
+ Index<PlaylistAddItem> & items)
 {
-    xmlNode *nptr;
+    if (location)
+    {
+        if (tuple.valid ())
+            tuple.set_filename (location);
 
-    for (nptr = tracklist->children; nptr != nullptr; nptr = nptr->next) {
-        if (nptr->type == XML_ELEMENT_NODE &&
-         ! xmlStrcmp (nptr->name, (xmlChar *) "track"))
-            xspf_add_file (nptr, filename, base, items);
+        items.append (std::move (location), std::move (tuple));
     }
+
+    location = String ();
+    tuple = Tuple ();
 }
 
 static int read_cb (void * file, char * buf, int len)
@@ -214,45 +212,85 @@ static int close_cb (void * file)
     return 0;
 }
 
+/* The file is read with a pull parser, which does not keep the nodes it has
+ * moved past, so that memory use does not depend on the size of the
+ * playlist.  Only the elements at these depths are of interest:
+ *
+ *   0: playlist
+ *   1: title, trackList
+ *   2: track
+ *   3: location, meta, and other track fields */
 bool XSPFLoader::load (const char * filename, VFSFile & file, String & title,
  Index<PlaylistAddItem> & items)
 {
-    xmlDoc * doc = xmlReadIO (read_cb, close_cb, & file, filename, nullptr, XML_PARSE_RECOVER);
-    if (! doc)
+    xmlTextReaderPtr reader = xmlReaderForIO (read_cb, close_cb, & file,
+     filename, nullptr, XML_PARSE_RECOVER);
+    if (! reader)
         return false;
 
-    xmlNode *nptr, *nptr2;
+    bool in_playlist = false, in_tracklist = false, in_track = false;
+    xmlChar * base = nullptr;
+    String location;
+    Tuple tuple;
+    int ret;
 
-    // find trackList
-    for (nptr = doc->children; nptr != nullptr; nptr = nptr->next) {
-        if (nptr->type == XML_ELEMENT_NODE &&
-            !xmlStrcmp(nptr->name, (xmlChar *)"playlist")) {
-            char * base;
+    while ((ret = xmlTextReaderRead (reader)) == 1)
+    {
+        int type = xmlTextReaderNodeType (reader);
+        int depth = xmlTextReaderDepth (reader);
+        const xmlChar * name = xmlTextReaderConstLocalName (reader);
 
-            base = (char *)xmlNodeGetBase(doc, nptr);
+        if (type == XML_READER_TYPE_END_ELEMENT)
+        {
+            if (depth == 2 && in_track)
+            {
+                xspf_finish_track (location, tuple, items);
+                in_track = false;
+            }
+
+            continue;
+        }
 
-            for (nptr2 = nptr->children; nptr2; nptr2 = nptr2->next)
+        if (type != XML_READER_TYPE_ELEMENT)
+            continue;
+
+        if (depth == 0)
+        {
+            in_playlist = ! xmlStrcmp (name, (xmlChar *) "playlist");
+            in_tracklist = false;
+
+            if (in_playlist)
             {
-                if (nptr2->type != XML_ELEMENT_NODE)
-                    continue;
-
-                if (! xmlStrcmp (nptr2->name, (xmlChar *) "title"))
-                {
-                    xmlChar * xml_title = xmlNodeGetContent (nptr2);
-                    if (xml_title && xml_title[0])
-                        title = String ((char *) xml_title);
-                    xmlFree (xml_title);
-                }
-                else if (! xmlStrcmp (nptr2->name, (xmlChar *) "trackList"))
-                    xspf_find_track (nptr2, filename, base, items);
+                xmlFree (base);
+                base = xmlTextReaderBaseUri (reader);
             }
+        }
+        else if (depth == 1 && in_playlist)
+        {
+            in_tracklist = ! xmlStrcmp (name, (xmlChar *) "trackList");
 
-            xmlFree (base);
+            if (! xmlStrcmp (name, (xmlChar *) "title"))
+            {
+                xmlChar * xml_title = xmlTextReaderReadString (reader);
+                if (xml_title && xml_title[0])
+                    title = String ((char *) xml_title);
+                xmlFree (xml_title);
+            }
         }
+        else if (depth == 2 && in_tracklist)
+        {
+            /* an empty track has no location, so nothing is added for it */
+            in_track = ! xmlStrcmp (name, (xmlChar *) "track") &&
+             ! xmlTextReaderIsEmptyElement (reader);
+        }
+        else if (depth == 3 && in_track)
+            xspf_read_track_node (reader, (char *) base, location, tuple);
     }
 
-    xmlFreeDoc(doc);
-    return true;
+    xmlFree (base);
+    xmlFreeTextReader (reader);
+
+    return (ret == 0 || items.len ());
 }
 
 
@@ -321,91 +359,106 @@ static bool is_valid_string (const char * s, CharPtr & subst)
 }
 
 
-static void xspf_add_node (xmlNodePtr node, bool isMeta, const char * xspfName, const char * strVal)
+static int xspf_write_node (xmlTextWriterPtr writer, bool isMeta,
+ const char * xspfName, const char * strVal)
 {
-    xmlNodePtr tmp;
     CharPtr subst;
+    if (! is_valid_string (strVal, subst))
+        strVal = subst.get ();
 
-    if (isMeta) {
-        tmp = xmlNewNode(nullptr, (xmlChar *) "meta");
-        xmlSetProp(tmp, (xmlChar *) "rel", (xmlChar *) xspfName);
-    } else
-        tmp = xmlNewNode(nullptr, (xmlChar *) xspfName);
+    if (! isMeta)
+        return xmlTextWriterWriteElement (writer, (xmlChar *) xspfName, (xmlChar *) strVal);
 
-    if (is_valid_string (strVal, subst))
-        xmlAddChild (tmp, xmlNewText ((xmlChar *) strVal));
-    else
-        xmlAddChild (tmp, xmlNewText ((xmlChar *) subst.get ()));
+    if (xmlTextWriterStartElement (writer, (xmlChar *) "meta") < 0 ||
+     xmlTextWriterWriteAttribute (writer, (xmlChar *) "rel", (xmlChar *) xspfName) < 0 ||
+     xmlTextWriterWriteString (writer, (xmlChar *) strVal) < 0)
+        return -1;
 
-    xmlAddChild(node, tmp);
+    return xmlTextWriterEndElement (writer);
 }
 
-
-bool XSPFLoader::save (const char * filename, VFSFile & file,
- const char * title, const Index<PlaylistAddItem> & items)
+static bool xspf_write_track (xmlTextWriterPtr writer, const PlaylistAddItem & item)
 {
-    xmlDocPtr doc;
-    xmlNodePtr rootnode, tracklist;
+    const Tuple & tuple = item.tuple;
 
-    doc = xmlNewDoc((xmlChar *)"1.0");
-    doc->charset = XML_CHAR_ENCODING_UTF8;
-    doc->encoding = xmlStrdup((xmlChar *)"UTF-8");
+    if (xmlTextWriterStartElement (writer, (xmlChar *) "track") < 0 ||
+     xmlTextWriterWriteElement (writer, (xmlChar *) "location",
+     (xmlChar *) (const char *) item.filename) < 0)
+        return false;
 
-    rootnode = xmlNewNode(nullptr, (xmlChar *)XSPF_ROOT_NODE_NAME);
-    xmlSetProp(rootnode, (xmlChar *)"version", (xmlChar *)"1");
-    xmlSetProp(rootnode, (xmlChar *)"xmlns", (xmlChar *)XSPF_XMLNS);
+    for (auto & entry : xspf_entries)
+    {
+        int ret = 0;
 
-    /* common */
-    xmlDocSetRootElement(doc, rootnode);
+        switch (tuple.get_value_type (entry.tupleField))
+        {
+        case Tuple::String:
+            ret = xspf_write_node (writer, entry.isMeta, entry.xspfName,
+             tuple.get_str (entry.tupleField));
+            break;
+        case Tuple::Int:
+            ret = xspf_write_node (writer, entry.isMeta, entry.xspfName,
+             int_to_str (tuple.get_int (entry.tupleField)));
+            break;
+        default:
+            break;
+        }
 
-    if (title)
-        xspf_add_node (rootnode, false, "title", title);
+        if (ret < 0)
+            return false;
+    }
 
-    tracklist = xmlNewNode(nullptr, (xmlChar *)"trackList");
-    xmlAddChild(rootnode, tracklist);
+    return xmlTextWriterEndElement (writer) >= 0;
+}
 
-    for (auto & item : items)
+
+/* The playlist is written out as it is generated, without building a
+ * document tree first. */
+bool XSPFLoader::save (const char * filename, VFSFile & file,
+ const char * title, const Index<PlaylistAddItem> & items)
+{
+    xmlOutputBufferPtr out = xmlOutputBufferCreateIO (write_cb, close_cb, & file, nullptr);
+    if (! out)
+        return false;
+
+    /* the writer takes ownership of the output buffer */
+    xmlTextWriterPtr writer = xmlNewTextWriter (out);
+    if (! writer)
     {
-        const char * filename = item.filename;
-        const Tuple & tuple = item.tuple;
-        xmlNodePtr track, location;
+        xmlOutputBufferClose (out);
+        return false;
+    }
 
-        track = xmlNewNode(nullptr, (xmlChar *)"track");
-        location = xmlNewNode(nullptr, (xmlChar *)"location");
+    xmlTextWriterSetIndent (writer, 1);
+    xmlTextWriterSetIndentString (writer, (xmlChar *) "  ");
 
-        xmlAddChild(location, xmlNewText((xmlChar *)filename));
-        xmlAddChild(track, location);
-        xmlAddChild(tracklist, track);
+    bool success = false;
 
-        for (auto & entry : xspf_entries)
-        {
-            switch (tuple.get_value_type (entry.tupleField))
-            {
-            case Tuple::String:
-                xspf_add_node (track, entry.isMeta, entry.xspfName,
-                 tuple.get_str (entry.tupleField));
-                break;
-            case Tuple::Int:
-                xspf_add_node (track, entry.isMeta, entry.xspfName,
-                 int_to_str (tuple.get_int (entry.tupleField)));
-                break;
-            default:
-                break;
-            }
-        }
-    }
+    if (xmlTextWriterStartDocument (writer, "1.0", "UTF-8", nullptr) < 0 ||
+     xmlTextWriterStartElement (writer, (xmlChar *) XSPF_ROOT_NODE_NAME) < 0 ||
+     xmlTextWriterWriteAttribute (writer, (xmlChar *) "version", (xmlChar *) "1") < 0 ||
+     xmlTextWriterWriteAttribute (writer, (xmlChar *) "xmlns", (xmlChar *) XSPF_XMLNS) < 0)
+        goto ERR;
+
+    if (title && xspf_write_node (writer, false, "title", title) < 0)
+        goto ERR;
 
-    xmlSaveCtxt * save = xmlSaveToIO (write_cb, close_cb, & file, nullptr, XML_SAVE_FORMAT);
-    if (! save)
+    if (xmlTextWriterStartElement (writer, (xmlChar *) "trackList") < 0)
         goto ERR;
 
-    if (xmlSaveDoc (save, doc) < 0 || xmlSaveClose (save) < 0)
+    for (auto & item : items)
+    {
+        if (! xspf_write_track (writer, item))
+            goto ERR;
+    }
+
+    /* closes all open elements */
+    if (xmlTextWriterEndDocument (writer) < 0)
         goto ERR;
 
-    xmlFreeDoc(doc);
-    return true;
+    success = true;
 
 ERR:
-    xmlFreeDoc (doc);
-    return false;
+    xmlFreeTextWriter (writer);
+    return success;
 }